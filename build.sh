@@ -2086,17 +2086,13 @@ EOF
             # work around the fact that it is not going to be
             # installed in the usual place. While the config programs
             # are rebuilt to reflect the unusual installation
-            # directories, other programs (such as `realmd`) that
-            # use the shared core library, are not, so we have to set
-            # the runtime library path. Also, the core library will
-            # look for `realmd` in the wrong place, so we have to
-            # set `REALM_ASYNC_DAEMON` too.
+            # directories, other programs (such as `realm-import`)
+            # that use the shared core library, are not, so we have to
+            # set the runtime library path.
             if [ "$PREBUILT_CORE" ]; then
                 install_libdir="$(get_config_param "INSTALL_LIBDIR" "$TEST_PKG_DIR/realm")" || exit 1
                 path_list_prepend "$LD_LIBRARY_PATH_NAME" "$install_libdir"  || exit 1
                 export "$LD_LIBRARY_PATH_NAME"
-                install_libexecdir="$(get_config_param "INSTALL_LIBEXECDIR" "$TEST_PKG_DIR/realm")" || exit 1
-                export REALM_ASYNC_DAEMON="$install_libexecdir/realmd"
             fi
 
             log_message "Testing './build test-installed'"
@@ -2571,11 +2567,9 @@ EOF
     "dist-test"|"dist-test-debug")
         test_mode="test"
         test_msg="TESTING %s"
-        async_daemon="realmd"
         if [ "$MODE" = "dist-test-debug" ]; then
             test_mode="test-debug"
             test_msg="TESTING %s in debug mode"
-            async_daemon="realmd-dbg"
         fi
         if ! [ -e ".DIST_CORE_WAS_BUILT" ]; then
             cat 1>&2 <<EOF
@@ -2606,11 +2600,10 @@ EOF
                 ERROR="1"
             fi
         fi
-        # We set `LD_LIBRARY_PATH` and `REALM_ASAYNC_DAEMON` here to be able
-        # to test extensions before installation of the core library.
+        # We set `LD_LIBRARY_PATH` here to be able to test extensions before
+        # installation of the core library.
         path_list_prepend "$LD_LIBRARY_PATH_NAME" "$REALM_HOME/src/realm"  || exit 1
         export "$LD_LIBRARY_PATH_NAME"
-        export REALM_ASYNC_DAEMON="$REALM_HOME/src/realm/$async_daemon"
         for x in $EXTENSIONS; do
             EXT_HOME="../$(map_ext_name_to_dir "$x")" || exit 1
             if [ -e "$EXT_HOME/.DIST_WAS_BUILT" ]; then
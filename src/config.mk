@@ -0,0 +1,24 @@
+CONFIG_VERSION        = 1
+REALM_VERSION         = unknown
+INSTALL_PREFIX        = /usr/local
+INSTALL_EXEC_PREFIX   = /usr/local
+INSTALL_INCLUDEDIR    = /usr/local/include
+INSTALL_BINDIR        = /usr/local/bin
+INSTALL_LIBDIR        = /usr/local/lib
+INSTALL_LIBEXECDIR    = /usr/local/libexec
+MAX_BPNODE_SIZE       = 1000
+MAX_BPNODE_SIZE_DEBUG = 1000
+ENABLE_ASSERTIONS     = no
+ENABLE_MEMDEBUG       = no
+ENABLE_ALLOC_SET_ZERO = no
+ENABLE_ENCRYPTION     = no
+XCODE_HOME            = none
+OSX_SDKS              = none
+OSX_SDKS_AVAIL        = no
+IPHONE_SDKS           = none
+IPHONE_SDKS_AVAIL     = no
+WATCHOS_SDKS          = none
+WATCHOS_SDKS_AVAIL    = no
+TVOS_SDKS             = none
+TVOS_SDKS_AVAIL       = no
+ANDROID_NDK_HOME      = none
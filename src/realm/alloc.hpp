@@ -202,6 +202,12 @@ public:
     ///     including reshuffling instructions. This is the format used in
     ///     milestone 2.0.0.
     ///
+    ///   7 Integer leaves may be encoded as offsets from a base value, or from
+    ///     a line through the first and the last value (Array::wtype_Encoded,
+    ///     see Array::try_encode()). New files still use version 6. A file
+    ///     switches to version 7 the first time Table::encode_integer_columns()
+    ///     encodes a leaf in it, and is never switched back.
+    ///
     /// IMPORTANT: When introducing a new file format version, be sure to review
     /// the file validity checks in AllocSlab::validate_buffer(), the file
     /// format selection logic in
@@ -35,9 +35,22 @@
 #include <realm/util/miscellaneous.hpp>
 #include <realm/util/terminate.hpp>
 #include <realm/util/thread.hpp>
+#include <realm/impl/translation_cache.hpp>
 #include <realm/array.hpp>
 #include <realm/alloc_slab.hpp>
 
+#if REALM_PLATFORM_APPLE || REALM_ANDROID
+#define USE_PTHREADS_IMPL 1
+#else
+#define USE_PTHREADS_IMPL 0
+#endif
+
+#if USE_PTHREADS_IMPL
+#include <system_error>
+#include <pthread.h>
+#include <realm/util/basic_system_errors.hpp>
+#endif
+
 using namespace realm;
 using namespace realm::util;
 
@@ -48,6 +61,59 @@ namespace {
 std::map<ref_type, void*> malloc_debug_map;
 #endif
 
+// Whether the current thread holds a SlabAlloc::UncachedTranslationGuard
+
+#if !USE_PTHREADS_IMPL
+
+
+REALM_THREAD_LOCAL bool t_bypass_translation_cache = false;
+
+bool is_translation_cache_bypassed() noexcept
+{
+    return t_bypass_translation_cache;
+}
+
+void set_translation_cache_bypassed(bool value) noexcept
+{
+    t_bypass_translation_cache = value;
+}
+
+
+#else // USE_PTHREADS_IMPL
+
+
+pthread_key_t bypass_key;
+pthread_once_t bypass_key_once = PTHREAD_ONCE_INIT;
+
+void create_bypass_key() noexcept
+{
+    int ret = pthread_key_create(&bypass_key, nullptr);
+    if (REALM_UNLIKELY(ret != 0)) {
+        std::error_code ec = util::make_basic_system_error_code(errno);
+        throw std::system_error(ec); // Termination intended
+    }
+}
+
+bool is_translation_cache_bypassed() noexcept
+{
+    pthread_once(&bypass_key_once, &create_bypass_key);
+    return pthread_getspecific(bypass_key) != nullptr;
+}
+
+void set_translation_cache_bypassed(bool value) noexcept
+{
+    pthread_once(&bypass_key_once, &create_bypass_key);
+    // Any non-null value means true
+    int ret = pthread_setspecific(bypass_key, value ? &bypass_key : nullptr);
+    if (REALM_UNLIKELY(ret != 0)) {
+        std::error_code ec = util::make_basic_system_error_code(errno);
+        throw std::system_error(ec); // Termination intended
+    }
+}
+
+
+#endif // USE_PTHREADS_IMPL
+
 class InvalidFreeSpace : std::exception {
 public:
     const char* what() const noexcept override
@@ -71,6 +137,11 @@ struct SlabAlloc::MappedFile {
     size_t m_capacity_global_mappings = 0;
     std::unique_ptr<std::shared_ptr<const util::File::Map<char>>[]> m_global_mappings;
 
+    /// Translations of refs into the file, shared by all the allocators
+    /// attached to it. Null if the file is encrypted, because every access to
+    /// an encrypted file must pass through encryption_read_barrier().
+    std::unique_ptr<_impl::TranslationCache> m_translation_cache;
+
     /// Indicates if attaching to the file was succesfull
     bool m_success = false;
 
@@ -122,52 +193,63 @@ void SlabAlloc::init_streaming_header(Header* streaming_header, int file_format_
 }
 
 
-class SlabAlloc::ChunkRefEq {
-public:
-    ChunkRefEq(ref_type ref) noexcept
-        : m_ref(ref)
-    {
-    }
-    bool operator()(const Chunk& chunk) const noexcept
-    {
-        return chunk.ref == m_ref;
-    }
+SlabAlloc::FreeSpace::const_iterator SlabAlloc::FreeSpace::find_ref_end(ref_type ref_end) const noexcept
+{
+    // The chunk ending at ref_end, if any, is the last one starting before it
+    auto i = m_by_ref.lower_bound(ref_end);
+    if (i == m_by_ref.begin())
+        return m_by_ref.end();
+    --i;
+    return i->first + i->second == ref_end ? i : m_by_ref.end();
+}
 
-private:
-    ref_type m_ref;
-};
+
+SlabAlloc::FreeSpace::const_iterator SlabAlloc::FreeSpace::find_fit(size_t size) const noexcept
+{
+    auto i = m_by_size.lower_bound(std::make_pair(size, ref_type(0)));
+    if (i == m_by_size.end())
+        return m_by_ref.end();
+    return m_by_ref.find(i->second);
+}
 
 
-class SlabAlloc::ChunkRefEndEq {
-public:
-    ChunkRefEndEq(ref_type ref) noexcept
-        : m_ref(ref)
-    {
+void SlabAlloc::FreeSpace::insert(ref_type ref, size_t size)
+{
+    REALM_ASSERT_DEBUG(size > 0);
+    auto i = m_by_ref.emplace(ref, size).first; // Throws
+    try {
+        m_by_size.emplace(size, ref); // Throws
     }
-    bool operator()(const Chunk& chunk) const noexcept
-    {
-        return chunk.ref + chunk.size == m_ref;
+    catch (...) {
+        m_by_ref.erase(i);
+        throw;
     }
+    m_free_bytes += size;
+}
 
-private:
-    ref_type m_ref;
-};
 
+void SlabAlloc::FreeSpace::erase(const_iterator i) noexcept
+{
+    m_by_size.erase(std::make_pair(i->second, i->first));
+    m_free_bytes -= i->second;
+    m_by_ref.erase(i);
+}
 
-class SlabAlloc::SlabRefEndEq {
-public:
-    SlabRefEndEq(ref_type ref) noexcept
-        : m_ref(ref)
-    {
-    }
-    bool operator()(const Slab& slab) const noexcept
-    {
-        return slab.ref_end == m_ref;
-    }
 
-private:
-    ref_type m_ref;
-};
+void SlabAlloc::FreeSpace::clear() noexcept
+{
+    m_by_ref.clear();
+    m_by_size.clear();
+    m_free_bytes = 0;
+}
+
+
+bool SlabAlloc::is_slab_boundary(ref_type ref) const noexcept
+{
+    // Slabs are stored in order of ascending ref_end
+    slabs::const_iterator i = upper_bound(m_slabs.begin(), m_slabs.end(), ref, &ref_less_than_slab_ref_end);
+    return i != m_slabs.begin() && (i - 1)->ref_end == ref;
+}
 
 
 void SlabAlloc::detach() noexcept
@@ -185,6 +267,7 @@ void SlabAlloc::detach() noexcept
             m_file_mappings.reset();
             m_local_mappings.reset();
             m_num_local_mappings = 0;
+            m_translation_cache = nullptr;
             break;
         default:
             REALM_UNREACHABLE();
@@ -260,54 +343,51 @@ MemRef SlabAlloc::do_alloc(const size_t size)
 
     m_free_space_state = free_space_Dirty;
 
-    // Do we have a free space we can reuse?
+    // Do we have a free space we can reuse? Take the smallest chunk that is big
+    // enough, which keeps large chunks intact for large requests.
     {
-        typedef chunks::reverse_iterator iter;
-        iter rend = m_free_space.rend();
-        for (iter i = m_free_space.rbegin(); i != rend; ++i) {
-            if (size <= i->size) {
-
+        FreeSpace::const_iterator i = m_free_space.find_fit(size);
+        if (i != m_free_space.end()) {
 #if REALM_ENABLE_MEMDEBUG
-                // Pick a *random* match instead of just the first. This will increase the chance of catching
-                // use-after-free bugs in Core. It's chosen such that the mathematical average of all picked
-                // positions is the middle of the list.
-                iter j = i;
-                while (j != rend && (size > j->size || fastrand() % (m_free_space.size() / 2 + 1) != 0)) {
-                    j++;
+            // Pick a *random* match instead of just the best fitting one. This will increase the chance of catching
+            // use-after-free bugs in Core. Walk a random number of chunks ahead in ref order to a chunk that also
+            // fits.
+            {
+                FreeSpace::const_iterator j = i;
+                size_t steps = fastrand() % (m_free_space.size() / 2 + 1);
+                for (; j != m_free_space.end() && steps > 0; ++j) {
+                    if (size <= j->second) {
+                        i = j;
+                        --steps;
+                    }
                 }
-                if (j != rend)
-                    i = j;
+            }
 #endif
 
-                ref_type ref = i->ref;
-                size_t rest = i->size - size;
+            ref_type ref = i->first;
+            size_t rest = i->second - size;
 
-                // Update free list
-                if (rest == 0) {
-                    // Erase by "move last over"
-                    *i = m_free_space.back();
-                    m_free_space.pop_back();
-                }
-                else {
-                    i->size = rest;
-                    i->ref += size;
-                }
+            // Update free list. Insert the remainder before erasing the chunk it
+            // came from, so that a throwing insert leaves the free list intact.
+            if (rest != 0)
+                m_free_space.insert(ref + size, rest); // Throws
+            m_free_space.erase(i);
+            ++m_num_allocs;
 
 #ifdef REALM_DEBUG
-                if (REALM_COVER_NEVER(m_debug_out))
-                    std::cerr << "Alloc ref: " << ref << " size: " << size << "\n";
+            if (REALM_COVER_NEVER(m_debug_out))
+                std::cerr << "Alloc ref: " << ref << " size: " << size << "\n";
 #endif
 
-                char* addr = translate(ref);
+            char* addr = translate(ref);
 #if REALM_ENABLE_ALLOC_SET_ZERO
-                std::fill(addr, addr + size, 0);
+            std::fill(addr, addr + size, 0);
 #endif
 #ifdef REALM_SLAB_ALLOC_DEBUG
-                malloc_debug_map[ref] = malloc(1);
+            malloc_debug_map[ref] = malloc(1);
 #endif
-                REALM_ASSERT_EX(ref >= m_baseline, ref, m_baseline);
-                return MemRef(addr, ref, *this);
-            }
+            REALM_ASSERT_EX(ref >= m_baseline, ref, m_baseline);
+            return MemRef(addr, ref, *this);
         }
     }
 
@@ -363,12 +443,10 @@ MemRef SlabAlloc::do_alloc(const size_t size)
 
     // Update free list
     size_t unused = new_size - size;
-    if (0 < unused) {
-        Chunk chunk;
-        chunk.ref = ref + size;
-        chunk.size = unused;
-        m_free_space.push_back(chunk); // Throws
-    }
+    if (0 < unused)
+        m_free_space.insert(ref + size, unused); // Throws
+    ++m_num_allocs;
+    ++m_num_slab_allocs;
 
 #ifdef REALM_DEBUG
     if (REALM_COVER_NEVER(m_debug_out))
@@ -392,7 +470,6 @@ void SlabAlloc::do_free(ref_type ref, const char* addr) noexcept
 
     // Free space in read only segment is tracked separately
     bool read_only = is_read_only(ref);
-    chunks& free_space = read_only ? m_free_read_only : m_free_space;
 
 #ifdef REALM_SLAB_ALLOC_DEBUG
     free(malloc_debug_map[ref]);
@@ -416,61 +493,68 @@ void SlabAlloc::do_free(ref_type ref, const char* addr) noexcept
 
     m_free_space_state = free_space_Dirty;
 
+    if (read_only) {
 #ifdef REALM_DEBUG
-    // Check for double free
-    for (auto& c : free_space) {
-        if ((ref >= c.ref && ref < (c.ref + c.size)) || (ref < c.ref && ref_end > c.ref)) {
-            REALM_ASSERT(false && "Double Free");
-        }
-    }
-#endif
-
-    // Check if we can merge with adjacent succeeding free block
-    typedef chunks::iterator iter;
-    iter merged_with = free_space.end();
-    if (!read_only) {
-        {
-            iter i = find_if(free_space.begin(), free_space.end(), ChunkRefEq(ref_end));
-            if (i != free_space.end()) {
-                // No consolidation over slab borders
-                if (find_if(m_slabs.begin(), m_slabs.end(), SlabRefEndEq(ref_end)) == m_slabs.end()) {
-                    i->ref = ref;
-                    i->size += size;
-                    merged_with = i;
-                }
-            }
-        }
-
-        // Check if we can merge with adjacent preceeding free block (not if that
-        // would cross slab boundary)
-        if (find_if(m_slabs.begin(), m_slabs.end(), SlabRefEndEq(ref)) == m_slabs.end()) {
-            iter i = find_if(free_space.begin(), free_space.end(), ChunkRefEndEq(ref));
-            if (i != free_space.end()) {
-                if (merged_with != free_space.end()) {
-                    i->size += merged_with->size;
-                    // Erase by "move last over"
-                    *merged_with = free_space.back();
-                    free_space.pop_back();
-                }
-                else {
-                    i->size += size;
-                }
-                return;
+        // Check for double free
+        for (auto& c : m_free_read_only) {
+            if ((ref >= c.ref && ref < (c.ref + c.size)) || (ref < c.ref && ref_end > c.ref)) {
+                REALM_ASSERT(false && "Double Free");
             }
         }
-    }
-
-    // Else just add to freelist
-    if (merged_with == free_space.end()) {
+#endif
+        // Adjacent read-only chunks are merged in bulk by
+        // consolidate_free_read_only()
         try {
             Chunk chunk;
             chunk.ref = ref;
             chunk.size = size;
-            free_space.push_back(chunk); // Throws
+            m_free_read_only.push_back(chunk); // Throws
         }
         catch (...) {
             m_free_space_state = free_space_Invalid;
         }
+        return;
+    }
+
+#ifdef REALM_DEBUG
+    // Check for double free
+    for (const auto& c : m_free_space) {
+        if ((ref >= c.first && ref < (c.first + c.second)) || (ref < c.first && ref_end > c.first)) {
+            REALM_ASSERT(false && "Double Free");
+        }
+    }
+#endif
+
+    // Merge with the adjacent succeeding and preceding free chunks, but not
+    // across slab borders
+    try {
+        ref_type merged_ref = ref;
+        size_t merged_size = size;
+        FreeSpace::const_iterator next = m_free_space.end();
+        FreeSpace::const_iterator prev = m_free_space.end();
+        if (!is_slab_boundary(ref_end)) {
+            next = m_free_space.find_ref(ref_end);
+            if (next != m_free_space.end())
+                merged_size += next->second;
+        }
+        if (!is_slab_boundary(ref)) {
+            prev = m_free_space.find_ref_end(ref);
+            if (prev != m_free_space.end()) {
+                merged_ref = prev->first;
+                merged_size += prev->second;
+            }
+        }
+
+        // Erase the chunks that are merged into the new one before inserting
+        // it, since it may start where the preceding one does
+        if (next != m_free_space.end())
+            m_free_space.erase(next);
+        if (prev != m_free_space.end())
+            m_free_space.erase(prev);
+        m_free_space.insert(merged_ref, merged_size); // Throws
+    }
+    catch (...) {
+        m_free_space_state = free_space_Invalid;
     }
 }
 
@@ -547,10 +631,35 @@ char* SlabAlloc::do_translate(ref_type ref) const noexcept
     // the compiler should reduce it to a single 32 bit shift.
     cache_index = cache_index ^ (cache_index >> 16);
     cache_index = (cache_index ^ (cache_index >> 8)) & 0xFF;
+    // The local cache is only updated by threads that do not hold an
+    // UncachedTranslationGuard, and while threads that hold one read through
+    // this allocator, no other thread may use it (see
+    // SlabAlloc::UncachedTranslationGuard), so a hit can be taken without
+    // looking at the thread-specific bypass flag.
     if (cache[cache_index].ref == ref && cache[cache_index].version == version)
         return const_cast<char*>(cache[cache_index].addr);
+    bool use_cache = !is_translation_cache_bypassed();
 
     if (ref < m_baseline) {
+        // The translation of a ref into the file is the same for every
+        // allocator attached to the file, so it can be looked up in the shared
+        // cache. Unlike the local cache, the shared cache is safe for
+        // concurrent use, and is therefore also consulted while the local cache
+        // is bypassed.
+        _impl::TranslationCache* shared_cache = m_translation_cache;
+        if (shared_cache) {
+            addr = shared_cache->lookup(ref);
+            if (addr) {
+                count_translation_cache_lookup(m_num_translation_cache_hits);
+                if (use_cache) {
+                    cache[cache_index].addr = addr;
+                    cache[cache_index].ref = ref;
+                    cache[cache_index].version = version;
+                }
+                return const_cast<char*>(addr);
+            }
+            count_translation_cache_lookup(m_num_translation_cache_misses);
+        }
 
         const util::File::Map<char>* map;
 
@@ -580,6 +689,8 @@ char* SlabAlloc::do_translate(ref_type ref) const noexcept
             realm::util::encryption_read_barrier(addr, Array::header_size, map->get_encrypted_mapping(),
                                                  Array::get_byte_size_from_header);
         }
+        if (shared_cache)
+            shared_cache->insert(ref, addr);
     }
     else {
         typedef slabs::const_iterator iter;
@@ -589,14 +700,29 @@ char* SlabAlloc::do_translate(ref_type ref) const noexcept
         ref_type slab_ref = i == m_slabs.begin() ? m_baseline : (i - 1)->ref_end;
         addr = i->addr + (ref - slab_ref);
     }
-    cache[cache_index].addr = addr;
-    cache[cache_index].ref = ref;
-    cache[cache_index].version = version;
+    if (use_cache) {
+        cache[cache_index].addr = addr;
+        cache[cache_index].ref = ref;
+        cache[cache_index].version = version;
+    }
     REALM_ASSERT_DEBUG(addr != nullptr);
     return const_cast<char*>(addr);
 }
 
 
+SlabAlloc::UncachedTranslationGuard::UncachedTranslationGuard() noexcept
+    : m_prev_value(is_translation_cache_bypassed())
+{
+    set_translation_cache_bypassed(true);
+}
+
+
+SlabAlloc::UncachedTranslationGuard::~UncachedTranslationGuard() noexcept
+{
+    set_translation_cache_bypassed(m_prev_value);
+}
+
+
 int SlabAlloc::get_committed_file_format_version() const noexcept
 {
     const Header& header = *reinterpret_cast<const Header*>(m_data);
@@ -688,6 +814,7 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
         m_attach_mode = cfg.is_shared ? attach_SharedFile : attach_UnsharedFile;
         m_free_space_state = free_space_Invalid;
         m_file_on_streaming_form = false;
+        m_translation_cache = m_file_mappings->m_translation_cache.get();
         if (m_file_mappings->m_num_global_mappings > 0) {
             size_t mapping_index = m_file_mappings->m_num_global_mappings;
             size_t section_index = mapping_index + m_file_mappings->m_first_additional_mapping;
@@ -876,6 +1003,10 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
             }
         }
     }
+    if (!cfg.encryption_key) {
+        m_file_mappings->m_translation_cache.reset(new _impl::TranslationCache); // Throws
+        m_translation_cache = m_file_mappings->m_translation_cache.get();
+    }
     dg.release();  // Do not detach
     fcg.release(); // Do not close
     m_file_mappings->m_success = true;
@@ -970,25 +1101,28 @@ void SlabAlloc::validate_buffer(const char* data, size_t size, const std::string
     else if (is_shared) {
         // In shared mode (Realm file opened via a SharedGroup instance) this
         // version of the core library is able to open Realms using file format
-        // versions 2, 3, 4, 5, and 6. Version 2, 3, 4, and 5 files need to be
-        // upgraded.
+        // versions 2, 3, 4, 5, 6, and 7. Version 2, 3, 4, and 5 files need to
+        // be upgraded. Version 7 files are used as they are (see
+        // Table::encode_integer_columns()).
         switch (file_format_version) {
             case 2:
             case 3:
             case 4:
             case 5:
             case 6:
+            case 7:
                 bad_file_format = false;
         }
     }
     else {
         // In non-shared mode (Realm file opened via a Group instance) this
         // version of the core library is only able to open Realms using file
-        // format version 6. Since a Realm file cannot be upgraded when opened
-        // in this mode (we may be unable to write to the file), no earlier
-        // versions can be opened.
+        // format versions 6 and 7. Since a Realm file cannot be upgraded when
+        // opened in this mode (we may be unable to write to the file), no
+        // earlier versions can be opened.
         switch (file_format_version) {
             case 6:
+            case 7:
                 bad_file_format = false;
         }
     }
@@ -1013,15 +1147,14 @@ void SlabAlloc::reset_free_space_tracking()
     // been commited to persistent space)
     m_free_read_only.clear();
     m_free_space.clear();
+    m_num_allocs = 0;
+    m_num_slab_allocs = 0;
 
     // Rebuild free list to include all slabs
-    Chunk chunk;
-    chunk.ref = m_baseline;
-
+    ref_type ref = m_baseline;
     for (const auto& slab : m_slabs) {
-        chunk.size = slab.ref_end - chunk.ref;
-        m_free_space.push_back(chunk); // Throws
-        chunk.ref = slab.ref_end;
+        m_free_space.insert(ref, slab.ref_end - ref); // Throws
+        ref = slab.ref_end;
     }
 
 #ifdef REALM_DEBUG
@@ -1035,6 +1168,18 @@ void SlabAlloc::reset_free_space_tracking()
 void SlabAlloc::update_reader_view(size_t file_size)
 {
     internal_invalidate_cache();
+
+    // Another session may have raised the file format version of the file
+    // (see Table::encode_integer_columns()). Versions are never lowered, so
+    // the new version applies right away.
+    if (m_attach_mode == attach_SharedFile) {
+        realm::util::encryption_read_barrier(m_data, sizeof(Header),
+                                             m_file_mappings->m_initial_mapping.get_encrypted_mapping());
+        int committed_file_format_version = get_committed_file_format_version();
+        if (committed_file_format_version > m_file_format_version)
+            m_file_format_version = committed_file_format_version;
+    }
+
     if (file_size <= m_baseline) {
         return;
     }
@@ -1093,15 +1238,20 @@ void SlabAlloc::update_reader_view(size_t file_size)
     }
     // Rebase slabs and free list (assumes exactly one entry in m_free_space for
     // each entire slab in m_slabs)
-    size_t slab_ref = file_size;
-    size_t n = m_free_space.size();
-    REALM_ASSERT(m_slabs.size() == n);
-    for (size_t i = 0; i < n; ++i) {
-        Chunk& free_chunk = m_free_space[i];
-        free_chunk.ref = slab_ref;
-        ref_type slab_ref_end = slab_ref + free_chunk.size;
-        m_slabs[i].ref_end = slab_ref_end;
-        slab_ref = slab_ref_end;
+    REALM_ASSERT(m_slabs.size() == m_free_space.size());
+    ref_type old_slab_ref = m_slabs.empty() ? 0 : m_free_space.begin()->first;
+    ref_type slab_ref = file_size;
+    for (auto& slab : m_slabs) {
+        size_t slab_size = slab.ref_end - old_slab_ref;
+        old_slab_ref = slab.ref_end;
+        slab.ref_end = slab_ref + slab_size;
+        slab_ref = slab.ref_end;
+    }
+    m_free_space.clear();
+    slab_ref = file_size;
+    for (const auto& slab : m_slabs) {
+        m_free_space.insert(slab_ref, slab.ref_end - slab_ref); // Throws
+        slab_ref = slab.ref_end;
     }
 }
 
@@ -1187,6 +1337,26 @@ void SlabAlloc::resize_file(size_t new_file_size)
         m_file_mappings->m_file.sync(); // Throws
 }
 
+void SlabAlloc::shrink_file(size_t new_file_size) noexcept
+{
+    REALM_ASSERT(matches_section_boundary(new_file_size));
+#ifdef _WIN32
+    static_cast<void>(new_file_size);
+#else
+    std::lock_guard<Mutex> lock(m_file_mappings->m_mutex);
+    util::File& file = m_file_mappings->m_file;
+    if (file.get_encryption_key())
+        return;
+    try {
+        if (to_size_t(file.get_size()) > new_file_size)
+            file.resize(new_file_size); // Throws
+    }
+    catch (...) {
+        // The file just remains bigger than necessary
+    }
+#endif
+}
+
 void SlabAlloc::reserve_disk_space(size_t size)
 {
     std::lock_guard<Mutex> lock(m_file_mappings->m_mutex);
@@ -1205,17 +1375,39 @@ void SlabAlloc::set_file_format_version(int file_format_version) noexcept
 }
 
 
+SlabAlloc::TranslationCacheStats SlabAlloc::get_translation_cache_stats() const noexcept
+{
+    TranslationCacheStats stats;
+    stats.hits = m_num_translation_cache_hits.load(std::memory_order_relaxed);
+    stats.misses = m_num_translation_cache_misses.load(std::memory_order_relaxed);
+    return stats;
+}
+
+
+SlabAlloc::FreeSpaceStats SlabAlloc::get_free_space_stats() const noexcept
+{
+    FreeSpaceStats stats;
+    stats.num_chunks = m_free_space.size();
+    stats.free_bytes = m_free_space.free_bytes();
+    stats.largest_chunk = m_free_space.largest_chunk();
+    stats.slab_bytes = m_slabs.empty() ? 0 : m_slabs.back().ref_end - m_baseline;
+    stats.num_allocs = m_num_allocs;
+    stats.num_slab_allocs = m_num_slab_allocs;
+    return stats;
+}
+
+
 void SlabAlloc::verify() const
 {
 #ifdef REALM_DEBUG
     // Make sure that all free blocks fit within a slab
     for (const auto& chunk : m_free_space) {
         slabs::const_iterator slab =
-            upper_bound(m_slabs.begin(), m_slabs.end(), chunk.ref, &ref_less_than_slab_ref_end);
+            upper_bound(m_slabs.begin(), m_slabs.end(), chunk.first, &ref_less_than_slab_ref_end);
         REALM_ASSERT(slab != m_slabs.end());
 
         ref_type slab_ref_end = slab->ref_end;
-        ref_type chunk_ref_end = chunk.ref + chunk.size;
+        ref_type chunk_ref_end = chunk.first + chunk.second;
         REALM_ASSERT_3(chunk_ref_end, <=, slab_ref_end);
     }
 #endif
@@ -1232,10 +1424,10 @@ bool SlabAlloc::is_all_free() const
     ref_type slab_ref = m_baseline;
     for (const auto& slab : m_slabs) {
         size_t slab_size = slab.ref_end - slab_ref;
-        chunks::const_iterator chunk = find_if(m_free_space.begin(), m_free_space.end(), ChunkRefEq(slab_ref));
+        FreeSpace::const_iterator chunk = m_free_space.find_ref(slab_ref);
         if (chunk == m_free_space.end())
             return false;
-        if (slab_size != chunk->size)
+        if (slab_size != chunk->second)
             return false;
         slab_ref = slab.ref_end;
     }
@@ -1248,10 +1440,7 @@ void SlabAlloc::print() const
 {
     size_t allocated_for_slabs = m_slabs.empty() ? 0 : m_slabs.back().ref_end - m_baseline;
 
-    size_t free = 0;
-    for (const auto& free_block : m_free_space) {
-        free += free_block.size;
-    }
+    size_t free = m_free_space.free_bytes();
 
     size_t allocated = allocated_for_slabs - free;
     std::cout << "Attached: " << (m_data ? m_baseline : 0) << " Allocated: " << allocated << "\n";
@@ -1276,11 +1465,11 @@ void SlabAlloc::print() const
     if (!m_free_space.empty()) {
         std::cout << "FreeSpace: ";
         for (const auto& free_block : m_free_space) {
-            if (&free_block != &m_free_space.front())
+            if (&free_block != &*m_free_space.begin())
                 std::cout << ", ";
 
-            ref_type last_ref = free_block.ref + free_block.size - 1;
-            std::cout << "(" << free_block.ref << "->" << last_ref << ", size=" << free_block.size << ")";
+            ref_type last_ref = free_block.first + free_block.second - 1;
+            std::cout << "(" << free_block.first << "->" << last_ref << ", size=" << free_block.second << ")";
         }
         std::cout << "\n";
     }
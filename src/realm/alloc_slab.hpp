@@ -21,6 +21,8 @@
 
 #include <cstdint> // unint8_t etc
 #include <vector>
+#include <map>
+#include <set>
 #include <string>
 #include <atomic>
 
@@ -35,6 +37,10 @@ namespace realm {
 class Group;
 class GroupWriter;
 
+namespace _impl {
+class TranslationCache;
+}
+
 
 /// Thrown by Group and SharedGroup constructors if the specified file
 /// (or memory buffer) does not appear to contain a valid Realm
@@ -199,6 +205,16 @@ public:
 
     class DetachGuard;
 
+    /// While an instance of this class exists, the constructing thread does
+    /// not update the translation cache of any slab allocator. The cache is
+    /// not safe for concurrent modification, so every thread must hold such a
+    /// guard while it reads through an allocator that is simultaneously used
+    /// by another thread (such as the worker threads of a parallel
+    /// query). Entries that are already in the cache may still be used, as
+    /// no thread changes them during that time. Reading is only safe as long
+    /// as no thread modifies the underlying data or remaps the file.
+    class UncachedTranslationGuard;
+
     /// If a memory buffer has been attached using attach_buffer(),
     /// mark it as owned by this slab allocator. Behaviour is
     /// undefined if this function is called on a detached allocator,
@@ -234,6 +250,18 @@ public:
     /// attached to a file. Doing so will result in undefined behavior.
     void resize_file(size_t new_file_size);
 
+    /// Truncate the attached file to the specified size, which must be a
+    /// section boundary, if it is bigger than that. The caller must ensure
+    /// that the removed part of the file is not used by any snapshot that may
+    /// still be accessed, or recovered after a crash, and that it has
+    /// exclusive write access, as for resize_file().
+    ///
+    /// Truncation is only an optimization, so failures are ignored. Encrypted
+    /// files are never truncated, because other mappings of the file may hold
+    /// decrypted copies of the removed pages. On Windows, this function has no
+    /// effect, because a file cannot be truncated while it is mapped.
+    void shrink_file(size_t new_file_size) noexcept;
+
     /// Reserve disk space now to avoid allocation errors at a later point in
     /// time, and to minimize on-disk fragmentation. In some cases, less
     /// fragmentation translates into improved performance. On SSD-drives
@@ -312,6 +340,34 @@ public:
     /// \sa get_file_format_version()
     void set_file_format_version(int) noexcept;
 
+    /// Statistics about the free space in the mutable (slab) part of the
+    /// address space. A high number of chunks relative to the free bytes, or a
+    /// largest chunk much smaller than the free bytes, indicates
+    /// fragmentation. All counts are reset by reset_free_space_tracking().
+    struct FreeSpaceStats {
+        size_t num_chunks = 0;    ///< Number of separate free chunks
+        size_t free_bytes = 0;    ///< Total size of the free chunks
+        size_t largest_chunk = 0; ///< Size of the largest free chunk
+        size_t slab_bytes = 0;    ///< Total size of all slabs
+        size_t num_allocs = 0;    ///< Allocations served since the last reset
+        size_t num_slab_allocs = 0; ///< Of those, the ones that needed a new slab
+    };
+
+    FreeSpaceStats get_free_space_stats() const noexcept;
+
+    /// Hit and miss counts of the lookups by this allocator in the translation
+    /// cache that is shared by all allocators attached to the same file in
+    /// this process. Only lookups of refs that point into the file, and that
+    /// are not already satisfied by the local cache of the allocator, are
+    /// counted. The counts are zero if the allocator has never been attached
+    /// to an unencrypted file.
+    struct TranslationCacheStats {
+        uint_fast64_t hits = 0;
+        uint_fast64_t misses = 0;
+    };
+
+    TranslationCacheStats get_translation_cache_stats() const noexcept;
+
     void verify() const override;
 #ifdef REALM_DEBUG
     void enable_debug(bool enable)
@@ -420,11 +476,48 @@ private:
     /// less padding between members due to alignment requirements.
     FeeeSpaceState m_free_space_state = free_space_Clean;
 
+    // Free space in the slabs, indexed both by position and by size. The
+    // position index lets do_free() find the neighbours to merge with, and the
+    // size index lets do_alloc() find the smallest chunk that fits (ties broken
+    // by lowest ref), both in logarithmic time instead of a linear scan of all
+    // chunks. Both indexes always describe the same set of chunks. Iteration
+    // yields (ref, size) pairs in order of ascending ref.
+    class FreeSpace {
+    public:
+        typedef std::map<ref_type, size_t> by_ref_map;
+        typedef by_ref_map::const_iterator const_iterator;
+
+        const_iterator begin() const noexcept;
+        const_iterator end() const noexcept;
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+        size_t free_bytes() const noexcept;
+        size_t largest_chunk() const noexcept;
+
+        /// Returns end() if there is no chunk starting at \a ref.
+        const_iterator find_ref(ref_type ref) const noexcept;
+        /// Returns end() if there is no chunk ending at \a ref_end.
+        const_iterator find_ref_end(ref_type ref_end) const noexcept;
+        /// Returns the smallest chunk of at least \a size bytes, or end().
+        const_iterator find_fit(size_t size) const noexcept;
+
+        void insert(ref_type ref, size_t size); // Throws
+        void erase(const_iterator) noexcept;
+        void clear() noexcept;
+
+    private:
+        by_ref_map m_by_ref;
+        std::set<std::pair<size_t, ref_type>> m_by_size;
+        size_t m_free_bytes = 0;
+    };
+
     typedef std::vector<Slab> slabs;
     typedef std::vector<Chunk> chunks;
     slabs m_slabs;
-    chunks m_free_space;
+    FreeSpace m_free_space;
     chunks m_free_read_only;
+    size_t m_num_allocs = 0;
+    size_t m_num_slab_allocs = 0;
 
     bool m_debug_out = false;
     struct hash_entry {
@@ -435,6 +528,18 @@ private:
     mutable hash_entry cache[256];
     mutable size_t version = 1;
 
+    // Owned by m_file_mappings
+    _impl::TranslationCache* m_translation_cache = nullptr;
+
+    // Lookups in m_translation_cache by this allocator. The counts are
+    // incremented without a read-modify-write operation, so they may miss a
+    // few lookups when the allocator is used by several threads at once, but
+    // they never cost a locked instruction in do_translate().
+    mutable std::atomic<uint_fast64_t> m_num_translation_cache_hits{0};
+    mutable std::atomic<uint_fast64_t> m_num_translation_cache_misses{0};
+
+    static void count_translation_cache_lookup(std::atomic<uint_fast64_t>& count) noexcept;
+
     /// Throws if free-lists are no longer valid.
     void consolidate_free_read_only();
     /// Throws if free-lists are no longer valid.
@@ -449,11 +554,12 @@ private:
     /// if the buffer contains a file in streaming form
     ref_type get_top_ref(const char* data, size_t len);
 
-    class ChunkRefEq;
-    class ChunkRefEndEq;
-    class SlabRefEndEq;
     static bool ref_less_than_slab_ref_end(ref_type, const Slab&) noexcept;
 
+    /// Returns true if a slab ends at \a ref, i.e. if chunks ending and
+    /// starting at \a ref must not be merged.
+    bool is_slab_boundary(ref_type ref) const noexcept;
+
     Replication* get_replication() const noexcept
     {
         return m_replication;
@@ -516,6 +622,15 @@ private:
     SlabAlloc* m_alloc;
 };
 
+class SlabAlloc::UncachedTranslationGuard {
+public:
+    UncachedTranslationGuard() noexcept;
+    ~UncachedTranslationGuard() noexcept;
+
+private:
+    bool m_prev_value;
+};
+
 
 // Implementation:
 
@@ -573,6 +688,41 @@ inline bool SlabAlloc::ref_less_than_slab_ref_end(ref_type ref, const Slab& slab
     return ref < slab.ref_end;
 }
 
+inline SlabAlloc::FreeSpace::const_iterator SlabAlloc::FreeSpace::begin() const noexcept
+{
+    return m_by_ref.begin();
+}
+
+inline SlabAlloc::FreeSpace::const_iterator SlabAlloc::FreeSpace::end() const noexcept
+{
+    return m_by_ref.end();
+}
+
+inline size_t SlabAlloc::FreeSpace::size() const noexcept
+{
+    return m_by_ref.size();
+}
+
+inline bool SlabAlloc::FreeSpace::empty() const noexcept
+{
+    return m_by_ref.empty();
+}
+
+inline size_t SlabAlloc::FreeSpace::free_bytes() const noexcept
+{
+    return m_free_bytes;
+}
+
+inline size_t SlabAlloc::FreeSpace::largest_chunk() const noexcept
+{
+    return m_by_size.empty() ? 0 : m_by_size.rbegin()->first;
+}
+
+inline SlabAlloc::FreeSpace::const_iterator SlabAlloc::FreeSpace::find_ref(ref_type ref) const noexcept
+{
+    return m_by_ref.find(ref);
+}
+
 inline size_t SlabAlloc::get_upper_section_boundary(size_t start_pos) const noexcept
 {
     return get_section_base(1 + get_section_index(start_pos));
@@ -593,6 +743,11 @@ inline size_t SlabAlloc::get_section_base(size_t index) const noexcept
     return m_section_bases[index];
 }
 
+inline void SlabAlloc::count_translation_cache_lookup(std::atomic<uint_fast64_t>& count) noexcept
+{
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
 } // namespace realm
 
 #endif // REALM_ALLOC_SLAB_HPP
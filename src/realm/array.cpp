@@ -71,6 +71,9 @@
 //        0    |  number of bits      |  ceil(width * size / 8)
 //        1    |  number of bytes     |  width * size
 //        2    |  ignored             |  size
+//        3    |  number of bits      |  16 + ceil(width * size / 8)
+//
+//     Scheme 3 is used by encoded integer leaves (see below).
 //
 //  5: 'width_ndx' (3 bits)
 //
@@ -170,6 +173,27 @@
 // least two children, because otherwise it would be
 // superflous. However, to allow for exception safety during element
 // insertion and removal, this shall not be guaranteed.
+//
+//
+// Encoded integer leaf:
+// ---------------------
+//
+// An integer leaf with width scheme 3 stores each value as an unsigned
+// offset of 'width' bits, following two 64-bit words, `base` and
+// `delta`:
+//
+//   --> | base | delta | o_0 o_1 ... o_(size-1) |
+//
+//   value(i) = base + i * delta + o_i
+//
+// With `delta` equal to zero, this is a frame-of-reference encoding,
+// where `base` is the smallest value in the leaf. A nonzero `delta`
+// is used for ascending leaves whose values grow at a near constant
+// rate, such as auto-incremented ids and regularly sampled
+// timestamps, where the offsets then only record the deviation from
+// a straight line. Encoded leaves are never modified in place. They
+// are turned back into ordinary leaves by the first modification
+// (see Array::try_encode()). They require file format version 7.
 
 // LIMITATION: The code below makes the non-portable assumption that
 // negative number are represented using two's complement. This is not
@@ -233,7 +257,15 @@ void Array::init_from_mem(MemRef mem) noexcept
 
     m_ref = mem.get_ref();
     m_data = get_data_from_header(header);
-    set_width(m_width);
+    m_is_encoded = get_wtype_from_header(header) == wtype_Encoded;
+    if (REALM_UNLIKELY(m_is_encoded)) {
+        // Encoded arrays are never modified in place, so they have no spare capacity
+        m_capacity = m_size;
+        set_encoded_width(m_width);
+    }
+    else {
+        set_width(m_width);
+    }
 }
 
 void Array::set_type(Type type)
@@ -415,6 +447,61 @@ ref_type Array::do_write_deep(_impl::ArrayWriterBase& out, bool only_if_modified
 }
 
 
+ref_type Array::write_relocated(ref_type ref, Allocator& alloc, _impl::ArrayWriterBase& out)
+{
+    // The array is unmodified, so it is written only if it resides at or
+    // beyond the relocation threshold, or if one of its subarrays is
+    // relocated. In both cases, the original is freed.
+    bool relocate = ref >= out.get_relocation_threshold();
+    const char* header = alloc.translate(ref);
+    Array array(alloc);
+    array.init_from_mem(MemRef(const_cast<char*>(header), ref, alloc));
+
+    if (!array.m_has_refs) {
+        if (!relocate)
+            return ref;
+        ref_type new_ref = array.do_write_shallow(out); // Throws
+        alloc.free_(ref, header);
+        return new_ref;
+    }
+
+    // Temp array for updated refs, created when the first subarray moves
+    Array new_array(Allocator::get_default());
+    _impl::ShallowArrayDestroyGuard dg(&new_array);
+    size_t n = array.size();
+    for (size_t i = 0; i < n; ++i) {
+        int_fast64_t value = array.get(i);
+        bool is_ref = (value != 0 && (value & 1) == 0);
+        if (is_ref) {
+            ref_type subref = to_ref(value);
+            ref_type new_subref = write(subref, alloc, out, true); // Throws
+            if (new_subref != subref && !new_array.is_attached()) {
+                Type type = array.m_is_inner_bptree_node ? type_InnerBptreeNode : type_HasRefs;
+                new_array.create(type, array.m_context_flag); // Throws
+                for (size_t j = 0; j < i; ++j)
+                    new_array.add(array.get(j)); // Throws
+            }
+            value = from_ref(new_subref);
+        }
+        if (new_array.is_attached())
+            new_array.add(value); // Throws
+    }
+
+    ref_type new_ref;
+    if (new_array.is_attached()) {
+        new_ref = new_array.do_write_shallow(out); // Throws
+    }
+    else if (relocate) {
+        new_ref = array.do_write_shallow(out); // Throws
+    }
+    else {
+        return ref;
+    }
+    alloc.free_(ref, header);
+    return new_ref;
+}
+
+
 void Array::move(size_t begin, size_t end, size_t dest_begin)
 {
     REALM_ASSERT_3(begin, <=, end);
@@ -602,6 +689,8 @@ void Array::insert(size_t ndx, int_fast64_t value)
 {
     REALM_ASSERT_DEBUG(ndx <= m_size);
 
+    if (REALM_UNLIKELY(m_is_encoded))
+        do_decode(); // Throws
 
     Getter old_getter = m_getter; // Save old getter before potential width expansion
 
@@ -726,6 +815,12 @@ void Array::truncate_and_destroy_children(size_t new_size)
 
 void Array::do_ensure_minimum_width(int_fast64_t value)
 {
+    if (REALM_UNLIKELY(m_is_encoded)) {
+        // The decoded array may well be wide enough already
+        do_decode(); // Throws
+        ensure_minimum_width(value); // Throws
+        return;
+    }
 
     // Make room for the new value
     size_t width = bit_width(value);
@@ -746,7 +841,7 @@ void Array::do_ensure_minimum_width(int_fast64_t value)
 
 void Array::set_all_to_zero()
 {
-    if (m_size == 0 || m_width == 0)
+    if (m_size == 0 || (m_width == 0 && !m_is_encoded))
         return;
 
     copy_on_write(); // Throws
@@ -761,6 +856,8 @@ void Array::set_all_to_zero()
 void Array::adjust_ge(int_fast64_t limit, int_fast64_t diff)
 {
     if (diff != 0) {
+        if (REALM_UNLIKELY(m_is_encoded))
+            do_decode(); // Throws
         for (size_t i = 0, n = size(); i != n;) {
             REALM_TEMPEX(i = adjust_ge, m_width, (i, n, limit, diff))
         }
@@ -802,6 +899,16 @@ size_t Array::adjust_ge(size_t start, size_t end, int_fast64_t limit, int_fast64
 // This method is mostly used by query_engine to enumerate table row indexes in increasing order through a TableView
 size_t Array::find_gte(const int64_t target, size_t start, size_t end) const
 {
+    if (REALM_UNLIKELY(m_is_encoded)) {
+        REALM_ASSERT(start < size());
+        end = std::min(end, m_size);
+        for (size_t i = start; i < end; ++i) {
+            if (get(i) >= target)
+                return i;
+        }
+        return not_found;
+    }
+
     switch (m_width) {
         case 0:
             return find_gte<0>(target, start, end);
@@ -1045,6 +1152,83 @@ size_t find_zero(uint64_t v)
     return start;
 }
 
+#ifdef REALM_COMPILER_AVX2
+
+// Sums 'chunks' 32-byte vectors of signed 'w'-bit integers starting at 'data', which needs not be aligned. Lanes are
+// widened to 64 bits before accumulating, so this cannot overflow unless the true sum does.
+template <size_t w>
+REALM_TARGET_AVX2 int64_t sum_avx2(const char* data, size_t chunks)
+{
+    const __m256i* p = reinterpret_cast<const __m256i*>(data);
+    __m256i acc = _mm256_setzero_si256();
+    for (size_t t = 0; t < chunks; t++) {
+        __m256i v = _mm256_loadu_si256(p + t);
+        __m256i s32;
+        if (w == 8) {
+            __m256i lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(v));      // sign extend 8->16
+            __m256i hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(v, 1)); // sign extend 8->16
+            s32 = _mm256_madd_epi16(_mm256_add_epi16(lo, hi), _mm256_set1_epi16(1));
+        }
+        else if (w == 16) {
+            s32 = _mm256_madd_epi16(v, _mm256_set1_epi16(1)); // pairwise add 16->32
+        }
+        else {
+            s32 = v;
+        }
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(s32)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(s32, 1)));
+    }
+    __m128i s = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    return _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+}
+
+// Returns the largest (or smallest) of the signed 'w'-bit integers in 'chunks' 32-byte vectors starting at 'data'.
+// Only the value is computed; the caller must locate its index.
+template <bool find_max, size_t w>
+REALM_TARGET_AVX2 int64_t minmax_avx2(const char* data, size_t chunks)
+{
+    const __m256i* p = reinterpret_cast<const __m256i*>(data);
+    __m256i state = _mm256_loadu_si256(p);
+    for (size_t t = 1; t < chunks; t++) {
+        __m256i v = _mm256_loadu_si256(p + t);
+        if (w == 8)
+            state = find_max ? _mm256_max_epi8(state, v) : _mm256_min_epi8(state, v);
+        else if (w == 16)
+            state = find_max ? _mm256_max_epi16(state, v) : _mm256_min_epi16(state, v);
+        else
+            state = find_max ? _mm256_max_epi32(state, v) : _mm256_min_epi32(state, v);
+    }
+
+    // Same aliasing concern as in the disabled SSE minmax in Array::minmax(): read the lanes back through a char
+    // array rather than through the vector type
+    char lanes[sizeof(state)];
+    memcpy(lanes, &state, sizeof(state));
+    int64_t m = 0;
+    for (size_t t = 0; t < sizeof(state) * 8 / no0(w); t++) {
+        int64_t v;
+        if (w == 8) {
+            int8_t v8;
+            memcpy(&v8, lanes + t, 1);
+            v = v8;
+        }
+        else if (w == 16) {
+            int16_t v16;
+            memcpy(&v16, lanes + t * 2, 2);
+            v = v16;
+        }
+        else {
+            int32_t v32;
+            memcpy(&v32, lanes + t * 4, 4);
+            v = v32;
+        }
+        if (t == 0 || (find_max ? v > m : v < m))
+            m = v;
+    }
+    return m;
+}
+
+#endif // REALM_COMPILER_AVX2
+
 } // anonymous namesapce
 
 
@@ -1117,6 +1301,22 @@ bool Array::minmax(int64_t& result, size_t start, size_t end, size_t* return_ndx
 #endif
 #endif
 
+#ifdef REALM_COMPILER_AVX2
+    if ((w == 8 || w == 16 || w == 32) && sseavx<2>() && end - start > 2 * 32 * 8 / no0(w)) {
+        size_t chunks = (end - start) * w / 8 / 32;
+        int64_t v = minmax_avx2<find_max, w>(m_data + start * w / 8, chunks);
+        if (find_max ? v > m : v < m) {
+            // The vector pass only yields the value. Its first occurrence is the index the scalar loop would have
+            // reported.
+            m = v;
+            best_index = start;
+            while (get<w>(best_index) != m)
+                ++best_index;
+        }
+        start += chunks * 32 * 8 / no0(w);
+    }
+#endif
+
     for (; start < end; ++start) {
         const int64_t v = get<w>(start);
         if (find_max ? v > m : v < m) {
@@ -1133,16 +1333,25 @@ bool Array::minmax(int64_t& result, size_t start, size_t end, size_t* return_ndx
 
 bool Array::maximum(int64_t& result, size_t start, size_t end, size_t* return_ndx) const
 {
+    if (REALM_UNLIKELY(m_is_encoded)) {
+        REALM_TEMPEX2(return minmax_encoded, true, m_width, (result, start, end, return_ndx));
+    }
     REALM_TEMPEX2(return minmax, true, m_width, (result, start, end, return_ndx));
 }
 
 bool Array::minimum(int64_t& result, size_t start, size_t end, size_t* return_ndx) const
 {
+    if (REALM_UNLIKELY(m_is_encoded)) {
+        REALM_TEMPEX2(return minmax_encoded, false, m_width, (result, start, end, return_ndx));
+    }
     REALM_TEMPEX2(return minmax, false, m_width, (result, start, end, return_ndx));
 }
 
 int64_t Array::sum(size_t start, size_t end) const
 {
+    if (REALM_UNLIKELY(m_is_encoded)) {
+        REALM_TEMPEX(return sum_encoded, m_width, (start, end));
+    }
     REALM_TEMPEX(return sum, m_width, (start, end));
 }
 
@@ -1215,6 +1424,14 @@ int64_t Array::sum(size_t start, size_t end) const
         start += sizeof(int64_t) * 8 / no0(w) * chunks;
     }
 
+#ifdef REALM_COMPILER_AVX2
+    if ((w == 8 || w == 16 || w == 32) && sseavx<2>() && end - start > 2 * 32 * 8 / no0(w)) {
+        size_t chunks = (end - start) * w / 8 / 32;
+        s += sum_avx2<w>(m_data + start * w / 8, chunks);
+        start += chunks * 32 * 8 / no0(w);
+    }
+#endif
+
 #ifdef REALM_COMPILER_SSE
     if (sseavx<42>()) {
 
@@ -1314,6 +1531,10 @@ int64_t Array::sum(size_t start, size_t end) const
 
 size_t Array::count(int64_t value) const noexcept
 {
+    if (REALM_UNLIKELY(m_is_encoded)) {
+        REALM_TEMPEX(return count_encoded, m_width, (value));
+    }
+
     const uint64_t* next = reinterpret_cast<uint64_t*>(m_data);
     size_t value_count = 0;
     const size_t end = m_size;
@@ -1488,6 +1709,239 @@ size_t Array::count(int64_t value) const noexcept
     return value_count;
 }
 
+namespace {
+
+// The smallest width that can hold the specified value when it is
+// stored without a sign.
+size_t unsigned_bit_width(uint64_t value) noexcept
+{
+    if (value == 0)
+        return 0;
+    size_t width = 1;
+    while (width < 64 && value >> width != 0)
+        width *= 2;
+    return width;
+}
+
+} // anonymous namespace
+
+bool Array::try_encode()
+{
+    REALM_ASSERT(is_attached());
+
+    if (m_is_encoded || m_has_refs || m_size == 0)
+        return false;
+
+    // Older versions of the library would misinterpret an encoded array
+    if (m_alloc.get_file_format_version() < 7)
+        return false;
+
+    REALM_ASSERT_3(get_wtype_from_header(), ==, wtype_Bits);
+
+    int64_t min_value = get(0), max_value = min_value;
+    for (size_t i = 1; i < m_size; ++i) {
+        int64_t v = get(i);
+        min_value = std::min(min_value, v);
+        max_value = std::max(max_value, v);
+    }
+
+    // Frame of reference: offsets from the smallest value
+    uint64_t base = uint64_t(min_value);
+    uint64_t delta = 0;
+    size_t width = unsigned_bit_width(uint64_t(max_value) - uint64_t(min_value));
+
+    // Delta: offsets from the line through the first and the last value,
+    // which pays off for ascending sequences such as ids and
+    // timestamps. Each value is at least 'min_value - (max_value -
+    // min_value)' away from the line, so the offsets cannot overflow
+    // as long as that does not.
+    int64_t first = get(0), last = get(m_size - 1);
+    uint64_t range = uint64_t(max_value) - uint64_t(min_value);
+    uint64_t headroom = uint64_t(min_value) - uint64_t(std::numeric_limits<int64_t>::min());
+    if (width != 0 && m_size > 2 && last > first && range <= headroom) {
+        uint64_t line_delta = (uint64_t(last) - uint64_t(first)) / (m_size - 1);
+        int64_t min_residual = std::numeric_limits<int64_t>::max();
+        int64_t max_residual = std::numeric_limits<int64_t>::min();
+        for (size_t i = 0; i < m_size; ++i) {
+            int64_t residual = int64_t(uint64_t(get(i)) - i * line_delta);
+            min_residual = std::min(min_residual, residual);
+            max_residual = std::max(max_residual, residual);
+        }
+        size_t line_width = unsigned_bit_width(uint64_t(max_residual) - uint64_t(min_residual));
+        if (line_width < width) {
+            base = uint64_t(min_residual);
+            delta = line_delta;
+            width = line_width;
+        }
+    }
+
+    size_t byte_size = calc_byte_size(wtype_Encoded, m_size, uint_least8_t(width));
+    if (byte_size >= get_byte_size())
+        return false;
+
+    MemRef mem = m_alloc.alloc(byte_size); // Throws
+    char* header = mem.get_addr();
+    init_header(header, m_is_inner_bptree_node, m_has_refs, m_context_flag, wtype_Encoded, int(width), m_size,
+                byte_size);
+    char* data = get_data_from_header(header);
+    std::fill(data, header + byte_size, 0);
+    REALM_TEMPEX(encode_into, width, (data, base, delta));
+
+    ref_type old_ref = m_ref;
+    char* old_header = get_header();
+    m_ref = mem.get_ref();
+    m_data = data;
+    m_capacity = m_size;
+    m_is_encoded = true;
+    set_encoded_width(width);
+
+    update_parent(); // Throws
+
+    m_alloc.free_(old_ref, old_header);
+    return true;
+}
+
+void Array::do_decode()
+{
+    REALM_ASSERT_DEBUG(m_is_encoded);
+
+    int64_t min_value = 0, max_value = 0;
+    for (size_t i = 0; i < m_size; ++i) {
+        int64_t v = get(i);
+        min_value = std::min(min_value, v);
+        max_value = std::max(max_value, v);
+    }
+    size_t width = std::max(bit_width(min_value), bit_width(max_value));
+
+    // Leave room for growth, as the array is about to be modified
+    size_t byte_size = calc_byte_size(wtype_Bits, m_size, uint_least8_t(width)) + 64;
+    MemRef mem = m_alloc.alloc(byte_size); // Throws
+    char* header = mem.get_addr();
+    init_header(header, m_is_inner_bptree_node, m_has_refs, m_context_flag, wtype_Bits, int(width), m_size,
+                byte_size);
+    char* data = get_data_from_header(header);
+    REALM_TEMPEX(decode_into, width, (data));
+
+    ref_type old_ref = m_ref;
+    char* old_header = get_header();
+    m_ref = mem.get_ref();
+    m_data = data;
+    m_is_encoded = false;
+    set_width(width);
+    m_capacity = calc_item_count(byte_size, width);
+
+    update_parent(); // Throws
+
+    m_alloc.free_(old_ref, old_header);
+}
+
+template <size_t w>
+void Array::encode_into(char* data, uint64_t base, uint64_t delta) const noexcept
+{
+    int64_t* prefix = reinterpret_cast<int64_t*>(data);
+    prefix[0] = int64_t(base);
+    prefix[1] = int64_t(delta);
+    char* offsets = data + encoded_prefix_size;
+    for (size_t i = 0; i < m_size; ++i) {
+        uint64_t offset = uint64_t(get(i)) - base - i * delta;
+        int64_t stored = int64_t(offset);
+        // set_direct() expects widths of 8 bits and more to hold signed values
+        if (w >= 8 && w < 64) {
+            uint64_t sign = offset >> ((w - 1) % 64);
+            stored = int64_t(offset) - int64_t(sign << (w % 64));
+        }
+        set_direct<w>(offsets, i, stored);
+    }
+}
+
+template <size_t w>
+void Array::decode_into(char* data) const noexcept
+{
+    for (size_t i = 0; i < m_size; ++i)
+        set_direct<w>(data, i, get(i));
+}
+
+int64_t Array::get_encoded_direct(const char* data, size_t width, size_t ndx) noexcept
+{
+    REALM_TEMPEX(return get_encoded_direct, width, (data, ndx));
+}
+
+void Array::get_encoded_bounds(size_t begin, size_t end, int64_t& lbound, int64_t& ubound) const noexcept
+{
+    REALM_ASSERT_DEBUG(m_is_encoded && begin < end);
+
+    const int64_t* prefix = reinterpret_cast<const int64_t*>(m_data);
+    uint64_t base = uint64_t(prefix[0]);
+    uint64_t delta = uint64_t(prefix[1]);
+    uint64_t max_offset = m_width == 64 ? ~uint64_t(0) : (uint64_t(1) << m_width) - 1;
+
+    // Delta is never negative, so the line is lowest at 'begin' and
+    // highest at 'end - 1'
+    int64_t low = int64_t(base + begin * delta);
+    int64_t high = int64_t(base + (end - 1) * delta);
+    uint64_t headroom = uint64_t(std::numeric_limits<int64_t>::max()) - uint64_t(high);
+    lbound = low;
+    ubound = max_offset > headroom ? std::numeric_limits<int64_t>::max() : int64_t(uint64_t(high) + max_offset);
+}
+
+template <size_t w>
+int64_t Array::sum_encoded(size_t start, size_t end) const
+{
+    if (end == size_t(-1))
+        end = m_size;
+    REALM_ASSERT_11(start, <, m_size, &&, end, <=, m_size, &&, start, <, end);
+
+    const int64_t* prefix = reinterpret_cast<const int64_t*>(m_data);
+    uint64_t base = uint64_t(prefix[0]);
+    uint64_t delta = uint64_t(prefix[1]);
+
+    uint64_t offset_sum = 0;
+    for (size_t i = start; i < end; ++i)
+        offset_sum += get_encoded_offset<w>(i);
+
+    // The sum of the indexes in [start, end), where the halving is done
+    // on whichever factor is even
+    uint64_t n = end - start;
+    uint64_t first_plus_last = start + end - 1;
+    uint64_t index_sum = n % 2 == 0 ? n / 2 * first_plus_last : first_plus_last / 2 * n;
+
+    return int64_t(n * base + index_sum * delta + offset_sum);
+}
+
+template <bool find_max, size_t w>
+bool Array::minmax_encoded(int64_t& result, size_t start, size_t end, size_t* return_ndx) const
+{
+    if (end == size_t(-1))
+        end = m_size;
+    REALM_ASSERT_11(start, <, m_size, &&, end, <=, m_size, &&, start, <, end);
+
+    size_t best_index = start;
+    int64_t best = get_encoded<w>(start);
+    for (size_t i = start + 1; i < end; ++i) {
+        int64_t v = get_encoded<w>(i);
+        if (find_max ? v > best : v < best) {
+            best = v;
+            best_index = i;
+        }
+    }
+
+    result = best;
+    if (return_ndx)
+        *return_ndx = best_index;
+    return true;
+}
+
+template <size_t w>
+size_t Array::count_encoded(int64_t value) const noexcept
+{
+    size_t value_count = 0;
+    for (size_t i = 0; i < m_size; ++i) {
+        if (get_encoded<w>(i) == value)
+            ++value_count;
+    }
+    return value_count;
+}
+
 size_t Array::calc_aligned_byte_size(size_t size, int width)
 {
     REALM_ASSERT(width != 0 && (width & (width - 1)) == 0); // Is a power of two
@@ -1545,6 +1999,14 @@ MemRef Array::clone(MemRef mem, Allocator& alloc, Allocator& target_alloc)
 {
     const char* header = mem.get_addr();
     if (!get_hasrefs_from_header(header)) {
+        // An encoded array cannot be stored in a file whose format
+        // predates encoding, so it must be copied value by value.
+        if (get_wtype_from_header(header) == wtype_Encoded && target_alloc.get_file_format_version() < 7) {
+            Array array{alloc};
+            array.init_from_mem(mem);
+            return array.slice(0, array.size(), target_alloc); // Throws
+        }
+
         // This array has no subarrays, so we can make a byte-for-byte
         // copy, which is more efficient.
 
@@ -1695,6 +2157,8 @@ MemRef Array::create(Type type, bool context_flag, WidthType width_type, size_t
 void Array::alloc(size_t init_size, size_t width)
 {
     REALM_ASSERT(is_attached());
+    // Callers must decode first, since that changes the width
+    REALM_ASSERT_DEBUG(!m_is_encoded);
 
     size_t needed_bytes = calc_byte_len(init_size, width);
     // this method is not public and callers must (and currently do) ensure that
@@ -1868,6 +2332,46 @@ void Array::set_width() noexcept
     m_getter = m_vtable->getter;
 }
 
+template <size_t width>
+struct Array::VTableForEncoded {
+    struct PopulatedVTable : Array::VTable {
+        PopulatedVTable()
+        {
+            getter = &Array::get_encoded<width>;
+            // Encoded arrays are decoded before they are modified
+            setter = nullptr;
+            chunk_getter = &Array::get_chunk_encoded<width>;
+            finder[cond_Equal] = &Array::find<Equal, act_ReturnFirst, width>;
+            finder[cond_NotEqual] = &Array::find<NotEqual, act_ReturnFirst, width>;
+            finder[cond_Greater] = &Array::find<Greater, act_ReturnFirst, width>;
+            finder[cond_Less] = &Array::find<Less, act_ReturnFirst, width>;
+        }
+    };
+    static const PopulatedVTable vtable;
+};
+
+template <size_t width>
+const typename Array::VTableForEncoded<width>::PopulatedVTable Array::VTableForEncoded<width>::vtable;
+
+void Array::set_encoded_width(size_t width) noexcept
+{
+    REALM_TEMPEX(set_encoded_width, width, ());
+}
+
+template <size_t width>
+void Array::set_encoded_width() noexcept
+{
+    // An empty range, such that ensure_minimum_width() always takes the
+    // slow path, which decodes the array
+    m_lbound = 0;
+    m_ubound = -1;
+
+    m_width = width;
+
+    m_vtable = &VTableForEncoded<width>::vtable;
+    m_getter = m_vtable->getter;
+}
+
 // This method reads 8 concecutive values into res[8], starting from index 'ndx'. It's allowed for the 8 values to
 // exceed array length; in this case, remainder of res[8] will be left untouched.
 template <size_t w>
@@ -2347,11 +2851,39 @@ void Array::report_memory_usage_2(MemUsageHandler& handler) const
 
 size_t Array::lower_bound_int(int64_t value) const noexcept
 {
+    if (REALM_UNLIKELY(m_is_encoded)) {
+        size_t low = 0, size = m_size;
+        while (size > 0) {
+            size_t half = size / 2;
+            if (get(low + half) < value) {
+                low += half + 1;
+                size -= half + 1;
+            }
+            else {
+                size = half;
+            }
+        }
+        return low;
+    }
     REALM_TEMPEX(return lower_bound, m_width, (m_data, m_size, value));
 }
 
 size_t Array::upper_bound_int(int64_t value) const noexcept
 {
+    if (REALM_UNLIKELY(m_is_encoded)) {
+        size_t low = 0, size = m_size;
+        while (size > 0) {
+            size_t half = size / 2;
+            if (!(value < get(low + half))) {
+                low += half + 1;
+                size -= half + 1;
+            }
+            else {
+                size = half;
+            }
+        }
+        return low;
+    }
     REALM_TEMPEX(return upper_bound, m_width, (m_data, m_size, value));
 }
 
@@ -2407,6 +2939,8 @@ int_fast64_t Array::get(const char* header, size_t ndx) noexcept
 {
     const char* data = get_data_from_header(header);
     uint_least8_t width = get_width_from_header(header);
+    if (REALM_UNLIKELY(get_wtype_from_header(header) == wtype_Encoded))
+        return get_encoded_direct(data, width, ndx);
     return get_direct(data, width, ndx);
 }
 
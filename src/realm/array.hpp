@@ -56,6 +56,7 @@ Searching: The main finding function is:
 #include <realm/query_conditions.hpp>
 #include <realm/column_fwd.hpp>
 #include <realm/array_direct.hpp>
+#include <realm/impl/array_writer.hpp>
 
 /*
     MMX: mmintrin.h
@@ -72,6 +73,10 @@ Searching: The main finding function is:
 #include <realm/realm_nmmintrin.h> // SSE42
 #endif
 
+#ifdef REALM_COMPILER_AVX2
+#include <immintrin.h> // AVX2 and AVX-512, only used inside REALM_TARGET_AVX2/REALM_TARGET_AVX512 functions
+#endif
+
 namespace realm {
 
 enum Action {
@@ -112,9 +117,6 @@ class StringColumn;
 class GroupWriter;
 template <class T>
 class QueryState;
-namespace _impl {
-class ArrayWriterBase;
-}
 
 
 #ifdef REALM_DEBUG
@@ -551,6 +553,25 @@ public:
 
     bool minimum(int64_t& result, size_t start = 0, size_t end = size_t(-1), size_t* return_ndx = nullptr) const;
 
+    /// Replace the bit-packed representation of this array by a compact
+    /// encoding, if that takes less space, and the file format of the
+    /// allocator supports it. The values are stored as unsigned offsets from
+    /// the smallest value (frame of reference), or, if that gives smaller
+    /// offsets, from a line rising from its first towards its last value
+    /// (delta encoding, which suits ascending sequences). Returns true if the
+    /// array was encoded.
+    ///
+    /// An encoded array is read like any other, but it is turned back into an
+    /// ordinary array by the first modification. This must only be used on
+    /// integer leaves without refs whose elements are accessed exclusively
+    /// through the Array API, and not on arrays that are read directly from
+    /// their headers by other code, such as B+-tree offsets and string index
+    /// keys.
+    bool try_encode();
+
+    /// See try_encode().
+    bool is_encoded() const noexcept;
+
     /// This information is guaranteed to be cached in the array accessor.
     bool is_inner_bptree_node() const noexcept;
 
@@ -617,7 +638,9 @@ public:
     /// to \a only_if_modified.
     ///
     /// \param only_if_modified Set to `false` to always write, or to `true` to
-    /// only write the array if it has been modified.
+    /// only write the array if it has been modified. Unmodified arrays are
+    /// also written if they need to be relocated (see
+    /// _impl::ArrayWriterBase::get_relocation_threshold()).
     ref_type write(_impl::ArrayWriterBase& out, bool deep, bool only_if_modified) const;
 
     /// Same as non-static write() with `deep` set to true. This is for the
@@ -755,6 +778,41 @@ public:
 
 #endif
 
+// AVX2 and AVX-512 find for the four functions Equal/NotEqual/Less/Greater. find_vectorized() searches the unaligned
+// head and tail with compare() and hands the aligned middle to the kernel that matches 'vector_size' (32 bytes for
+// AVX2, 64 bytes for AVX-512). The kernels are compiled with a target attribute and must only be called after
+// sseavx<2>() or sseavx<512>() has returned true.
+#ifdef REALM_COMPILER_AVX2
+    template <class cond, Action action, size_t width, class Callback, size_t vector_size>
+    bool find_vectorized(int64_t value, size_t start, size_t end, size_t baseindex, QueryState<int64_t>* state,
+                         Callback callback) const;
+
+    template <class cond, Action action, size_t width, class Callback>
+    REALM_TARGET_AVX2 bool find_avx2(int64_t value, const char* data, size_t chunks, QueryState<int64_t>* state,
+                                     size_t baseindex, Callback callback) const;
+#endif
+
+#ifdef REALM_COMPILER_AVX512
+    template <class cond, Action action, size_t width, class Callback>
+    REALM_TARGET_AVX512 bool find_avx512(int64_t value, const char* data, size_t chunks,
+                                         QueryState<int64_t>* state, size_t baseindex, Callback callback) const;
+
+    // Horizontal sum of the lanes of 'v', and minimum or maximum of the lanes of 'v' whose bit is set in 'mask',
+    // with lanes of type T. GCC implements the _mm512_reduce_*() intrinsics (and most others) with an undefined
+    // pass-through vector, and then warns that '__Y' may be used uninitialized. The warning is located in a system
+    // header, where a diagnostic pragma cannot silence it, so the lanes are reduced by hand instead.
+    template <class T>
+    REALM_TARGET_AVX512 static int64_t sum_lanes_avx512(__m512i v) noexcept;
+    template <class T, Action action>
+    REALM_TARGET_AVX512 int64_t minmax_lanes_avx512(__m512i v, uint64_t mask) const;
+#endif
+
+    // Performs 'action' on each element of the vector chunk at 'data' whose bit is set in 'mask' (one bit per
+    // element, 'elements' elements in total). Counting consumes the whole mask at once when the limit allows it.
+    template <Action action, size_t width, class Callback>
+    REALM_FORCEINLINE bool find_action_mask(uint64_t mask, size_t elements, const char* data, size_t index,
+                                            QueryState<int64_t>* state, Callback callback) const;
+
     template <size_t width>
     inline bool test_zero(uint64_t value) const; // Tests value for 0-elements
 
@@ -815,6 +873,7 @@ public:
         wtype_Bits = 0,
         wtype_Multiply = 1,
         wtype_Ignore = 2,
+        wtype_Encoded = 3,
     };
 
     static bool get_is_inner_bptree_node_from_header(const char*) noexcept;
@@ -932,12 +991,54 @@ protected:
     template <size_t width>
     void set_width() noexcept;
     void set_width(size_t) noexcept;
+    template <size_t width>
+    void set_encoded_width() noexcept;
+    void set_encoded_width(size_t) noexcept;
     void alloc(size_t init_size, size_t width);
     void copy_on_write();
 
 private:
     void do_copy_on_write(size_t minimum_size=0);
     void do_ensure_minimum_width(int_fast64_t);
+    void do_decode();
+
+    /// Number of bytes at the start of the payload of an encoded array,
+    /// holding its base and delta.
+    static const size_t encoded_prefix_size = 16;
+
+    template <size_t w>
+    static int64_t get_encoded_direct(const char* data, size_t ndx) noexcept;
+    static int64_t get_encoded_direct(const char* data, size_t width, size_t ndx) noexcept;
+
+    template <size_t w>
+    int64_t get_encoded(size_t ndx) const noexcept;
+
+    template <size_t w>
+    void get_chunk_encoded(size_t ndx, int64_t res[8]) const noexcept;
+
+    template <size_t w>
+    uint64_t get_encoded_offset(size_t ndx) const noexcept;
+
+    void get_encoded_bounds(size_t begin, size_t end, int64_t& lbound, int64_t& ubound) const noexcept;
+
+    template <class cond, Action action, size_t bitwidth, class Callback>
+    bool find_encoded(int64_t value, size_t start, size_t end, size_t baseindex, QueryState<int64_t>* state,
+                      Callback callback, bool nullable_array, bool find_null) const;
+
+    template <size_t w>
+    int64_t sum_encoded(size_t start, size_t end) const;
+
+    template <bool max, size_t w>
+    bool minmax_encoded(int64_t& result, size_t start, size_t end, size_t* return_ndx) const;
+
+    template <size_t w>
+    size_t count_encoded(int64_t value) const noexcept;
+
+    template <size_t w>
+    void encode_into(char* data, uint64_t base, uint64_t delta) const noexcept;
+
+    template <size_t w>
+    void decode_into(char* data) const noexcept;
 
     template <size_t w>
     int64_t sum(size_t start, size_t end) const;
@@ -999,6 +1100,8 @@ protected:
     };
     template <size_t w>
     struct VTableForWidth;
+    template <size_t w>
+    struct VTableForEncoded;
 
 protected:
     /// Takes a 64-bit value and returns the minimum number of bits needed
@@ -1044,10 +1147,12 @@ protected:
     bool m_is_inner_bptree_node; // This array is an inner node of B+-tree.
     bool m_has_refs;             // Elements whose first bit is zero are refs to subarrays.
     bool m_context_flag;         // Meaning depends on context.
+    bool m_is_encoded = false;   // Values are stored as offsets (see try_encode()).
 
 private:
     ref_type do_write_shallow(_impl::ArrayWriterBase&) const;
     ref_type do_write_deep(_impl::ArrayWriterBase&, bool only_if_modified) const;
+    static ref_type write_relocated(ref_type, Allocator&, _impl::ArrayWriterBase&);
     static size_t calc_byte_size(WidthType wtype, size_t size, uint_least8_t width) noexcept;
 
     friend class SlabAlloc;
@@ -1416,6 +1521,11 @@ inline bool Array::has_refs() const noexcept
     return m_has_refs;
 }
 
+inline bool Array::is_encoded() const noexcept
+{
+    return m_is_encoded;
+}
+
 inline bool Array::get_context_flag() const noexcept
 {
     return m_context_flag;
@@ -1463,8 +1573,11 @@ inline ref_type Array::write(_impl::ArrayWriterBase& out, bool deep, bool only_i
 {
     REALM_ASSERT(is_attached());
 
-    if (only_if_modified && m_alloc.is_read_only(m_ref))
+    if (only_if_modified && m_alloc.is_read_only(m_ref)) {
+        if (deep && out.get_relocation_threshold() != 0)
+            return write_relocated(m_ref, m_alloc, out); // Throws
         return m_ref;
+    }
 
     if (!deep || !m_has_refs)
         return do_write_shallow(out); // Throws
@@ -1474,8 +1587,11 @@ inline ref_type Array::write(_impl::ArrayWriterBase& out, bool deep, bool only_i
 
 inline ref_type Array::write(ref_type ref, Allocator& alloc, _impl::ArrayWriterBase& out, bool only_if_modified)
 {
-    if (only_if_modified && alloc.is_read_only(ref))
+    if (only_if_modified && alloc.is_read_only(ref)) {
+        if (out.get_relocation_threshold() != 0)
+            return write_relocated(ref, alloc, out); // Throws
         return ref;
+    }
 
     Array array(alloc);
     array.init_from_ref(ref);
@@ -1795,6 +1911,12 @@ inline size_t Array::calc_byte_size(WidthType wtype, size_t size, uint_least8_t
         case wtype_Ignore:
             num_bytes = size;
             break;
+        case wtype_Encoded: {
+            REALM_ASSERT_3(size, <, 0x1000000);
+            size_t num_bits = size * width;
+            num_bytes = encoded_prefix_size + ((num_bits + 7) >> 3);
+            break;
+        }
     }
 
     // Ensure 8-byte alignment
@@ -1957,6 +2079,11 @@ inline bool Array::is_read_only() const noexcept
 
 inline void Array::copy_on_write()
 {
+    // Encoded arrays are never modified in place
+    if (REALM_UNLIKELY(m_is_encoded)) {
+        do_decode(); // Throws
+        return;
+    }
 #if REALM_ENABLE_MEMDEBUG
     // We want to relocate this array regardless if there is a need or not, in order to catch use-after-free bugs.
     // Only exception is inside GroupWriter::write_group() (see explanation at the definition of the m_no_relocation
@@ -1987,6 +2114,39 @@ int64_t Array::get(size_t ndx) const noexcept
     return get_universal<w>(m_data, ndx);
 }
 
+template <size_t w>
+int64_t Array::get_encoded_direct(const char* data, size_t ndx) noexcept
+{
+    const int64_t* prefix = reinterpret_cast<const int64_t*>(data);
+    uint64_t base = uint64_t(prefix[0]);
+    uint64_t delta = uint64_t(prefix[1]);
+    // Offsets are unsigned, but get_direct() sign extends widths of 8 bits and more
+    const uint64_t mask = w == 64 ? ~uint64_t(0) : (uint64_t(1) << (w % 64)) - 1;
+    uint64_t offset = uint64_t(get_direct<w>(data + encoded_prefix_size, ndx)) & mask;
+    return int64_t(base + ndx * delta + offset);
+}
+
+template <size_t w>
+int64_t Array::get_encoded(size_t ndx) const noexcept
+{
+    return get_encoded_direct<w>(m_data, ndx);
+}
+
+template <size_t w>
+uint64_t Array::get_encoded_offset(size_t ndx) const noexcept
+{
+    const uint64_t mask = w == 64 ? ~uint64_t(0) : (uint64_t(1) << (w % 64)) - 1;
+    return uint64_t(get_direct<w>(m_data + encoded_prefix_size, ndx)) & mask;
+}
+
+template <size_t w>
+void Array::get_chunk_encoded(size_t ndx, int64_t res[8]) const noexcept
+{
+    REALM_ASSERT_3(ndx, <, m_size);
+    for (size_t i = 0; i < 8 && ndx + i < m_size; ++i)
+        res[i] = get_encoded<w>(ndx + i);
+}
+
 template <size_t w>
 int64_t Array::get_universal(const char* data, size_t ndx) const
 {
@@ -2199,6 +2359,10 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
     if (end == npos)
         end = nullable_array ? size() - 1 : size();
 
+    if (REALM_UNLIKELY(m_is_encoded))
+        return find_encoded<cond, action, bitwidth, Callback>(value, start, end, baseindex, state, callback,
+                                                              nullable_array, find_null);
+
     if (nullable_array) {
         // We were called by find() of a nullable array. So skip first entry, take nulls in count, etc, etc. Fixme:
         // Huge speed optimizations are possible here! This is a very simple generic method.
@@ -2296,6 +2460,28 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
     // finder cannot handle this bitwidth
     REALM_ASSERT_3(m_width, !=, 0);
 
+#if defined(REALM_COMPILER_AVX2)
+    // Prefer the widest vector unit the CPU has. Unlike SSE, both AVX2 and AVX-512 handle all four conditions at
+    // every byte width, so there is no need to fall back to SSE once one of them is available. Only use them if the
+    // payload spans at least two vectors, otherwise the unaligned head and tail dominate.
+    //
+    // The kernels are only entered for byte widths. 'vector_width' merely keeps them from being instantiated for
+    // the packed widths, where they would not compile.
+    constexpr bool vectorizable_cond = std::is_same<cond, Equal>::value || std::is_same<cond, NotEqual>::value ||
+                                       std::is_same<cond, Greater>::value || std::is_same<cond, Less>::value;
+    constexpr size_t vector_width = bitwidth < 8 ? 8 : bitwidth;
+    if (vectorizable_cond && bitwidth >= 8) {
+#if defined(REALM_COMPILER_AVX512)
+        if (sseavx<512>() && (end - start2) * bitwidth / 8 >= 2 * 64)
+            return find_vectorized<cond, action, vector_width, Callback, 64>(value, start2, end, baseindex, state,
+                                                                             callback);
+#endif
+        if (sseavx<2>() && (end - start2) * bitwidth / 8 >= 2 * 32)
+            return find_vectorized<cond, action, vector_width, Callback, 32>(value, start2, end, baseindex, state,
+                                                                             callback);
+    }
+#endif
+
 #if defined(REALM_COMPILER_SSE)
     // Only use SSE if payload is at least one SSE chunk (128 bits) in size. Also note taht SSE doesn't support
     // Less-than comparison for 64-bit values.
@@ -2342,6 +2528,63 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
 #endif
 }
 
+// Same contract as find_optimized(), for encoded arrays. Here, 'bitwidth' is the width of the offsets.
+template <class cond, Action action, size_t bitwidth, class Callback>
+bool Array::find_encoded(int64_t value, size_t start, size_t end, size_t baseindex, QueryState<int64_t>* state,
+                         Callback callback, bool nullable_array, bool find_null) const
+{
+    cond c;
+
+    if (nullable_array) {
+        int64_t null_value = get_encoded<bitwidth>(0);
+        for (; start < end; ++start) {
+            int64_t v = get_encoded<bitwidth>(start + 1);
+            if (c(v, value, v == null_value, find_null)) {
+                util::Optional<int64_t> v2(v == null_value ? util::none : util::make_optional(v));
+                if (!find_action<action, Callback>(start + baseindex, v2, state, callback))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    if (start >= end)
+        return true;
+
+    int64_t lbound, ubound;
+    get_encoded_bounds(start, end, lbound, ubound);
+    if (!c.can_match(value, lbound, ubound))
+        return true;
+
+    // With a frame of reference, a value compares to 'value' exactly like its offset compares to the offset of
+    // 'value', as long as 'value' lies within the frame. In that case the values need not be decoded to be
+    // compared.
+    const int64_t* prefix = reinterpret_cast<const int64_t*>(m_data);
+    uint64_t base = uint64_t(prefix[0]);
+    uint64_t delta = uint64_t(prefix[1]);
+    if (bitwidth < 64 && delta == 0 && value >= lbound && value <= ubound && !c.will_match(value, lbound, ubound)) {
+        int64_t target = int64_t(uint64_t(value) - base);
+        for (; start < end; ++start) {
+            int64_t offset = int64_t(get_encoded_offset<bitwidth>(start));
+            if (c(offset, target)) {
+                if (!find_action<action, Callback>(start + baseindex, int64_t(base + uint64_t(offset)), state,
+                                                   callback))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    for (; start < end; ++start) {
+        int64_t v = get_encoded<bitwidth>(start);
+        if (c(v, value)) {
+            if (!find_action<action, Callback>(start + baseindex, v, state, callback))
+                return false;
+        }
+    }
+    return true;
+}
+
 template <size_t width>
 inline int64_t Array::lower_bits() const
 {
@@ -2668,7 +2911,7 @@ inline bool Array::compare_equality(int64_t value, size_t start, size_t end, siz
                 if (a >= 64 / no0(width))
                     break;
 
-                if (!find_action<action, Callback>(a + start + baseindex, get<width>(start + t), state, callback))
+                if (!find_action<action, Callback>(a + start + baseindex, get<width>(start + a), state, callback))
                     return false;
                 v2 >>= (t + 1) * width;
                 a += 1;
@@ -2824,6 +3067,273 @@ REALM_FORCEINLINE bool Array::find_sse_intern(__m128i* action_data, __m128i* dat
 }
 #endif // REALM_COMPILER_SSE
 
+template <Action action, size_t width, class Callback>
+REALM_FORCEINLINE bool Array::find_action_mask(uint64_t mask, size_t elements, const char* data, size_t index,
+                                               QueryState<int64_t>* state, Callback callback) const
+{
+    if (action == act_Count && state->m_match_count + elements < state->m_limit) {
+        state->m_state += fast_popcount64(mask);
+        state->m_match_count = size_t(state->m_state);
+        return true;
+    }
+
+    while (mask != 0) {
+        size_t i = first_set_bit64(mask);
+        if (!find_action<action, Callback>(index + i, get_universal<width>(data, i), state, callback))
+            return false;
+        mask &= mask - 1; // clear lowest set bit
+    }
+    return true;
+}
+
+#ifdef REALM_COMPILER_AVX2
+template <class cond, Action action, size_t width, class Callback, size_t vector_size>
+bool Array::find_vectorized(int64_t value, size_t start, size_t end, size_t baseindex, QueryState<int64_t>* state,
+                            Callback callback) const
+{
+    // The kernels use aligned loads, so search the area before the first vector boundary with compare()
+    const char* const a = static_cast<const char*>(round_up(m_data + start * width / 8, vector_size));
+    const char* const b = static_cast<const char*>(round_down(m_data + end * width / 8, vector_size));
+    size_t a_ndx = (a - m_data) * 8 / width;
+    size_t b_ndx = (b - m_data) * 8 / width;
+
+    if (!compare<cond, action, width, Callback>(value, start, a_ndx, baseindex, state, callback))
+        return false;
+
+    if (b > a) {
+        size_t chunks = (b - a) / vector_size;
+#ifdef REALM_COMPILER_AVX512
+        if (vector_size == 64) {
+            if (!find_avx512<cond, action, width, Callback>(value, a, chunks, state, baseindex + a_ndx, callback))
+                return false;
+        }
+        else
+#endif
+        {
+            if (!find_avx2<cond, action, width, Callback>(value, a, chunks, state, baseindex + a_ndx, callback))
+                return false;
+        }
+    }
+
+    return compare<cond, action, width, Callback>(value, b_ndx, end, baseindex, state, callback);
+}
+
+// 'chunks' is the number of 32-byte AVX2 vectors starting at the 32-byte aligned 'data'. 'baseindex' is the row index
+// of the first element of the first vector.
+template <class cond, Action action, size_t width, class Callback>
+REALM_TARGET_AVX2 bool Array::find_avx2(int64_t value, const char* data, size_t chunks, QueryState<int64_t>* state,
+                                        size_t baseindex, Callback callback) const
+{
+    const size_t elements = 32 * 8 / width;
+    const uint64_t all = (uint64_t(1) << elements) - 1; // elements is at most 32
+    __m256i search;
+    if (width == 8)
+        search = _mm256_set1_epi8(static_cast<char>(value));
+    else if (width == 16)
+        search = _mm256_set1_epi16(static_cast<short>(value));
+    else if (width == 32)
+        search = _mm256_set1_epi32(static_cast<int>(value));
+    else
+        search = _mm256_set1_epi64x(value);
+
+    for (size_t i = 0; i < chunks; ++i) {
+        const char* chunk = data + i * 32;
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(chunk));
+        __m256i cmp;
+
+        if (std::is_same<cond, Equal>::value || std::is_same<cond, NotEqual>::value) {
+            if (width == 8)
+                cmp = _mm256_cmpeq_epi8(v, search);
+            else if (width == 16)
+                cmp = _mm256_cmpeq_epi16(v, search);
+            else if (width == 32)
+                cmp = _mm256_cmpeq_epi32(v, search);
+            else
+                cmp = _mm256_cmpeq_epi64(v, search);
+        }
+        else {
+            // AVX2 only has signed greater-than; less-than is greater-than with the operands swapped
+            __m256i lhs = std::is_same<cond, Greater>::value ? v : search;
+            __m256i rhs = std::is_same<cond, Greater>::value ? search : v;
+            if (width == 8)
+                cmp = _mm256_cmpgt_epi8(lhs, rhs);
+            else if (width == 16)
+                cmp = _mm256_cmpgt_epi16(lhs, rhs);
+            else if (width == 32)
+                cmp = _mm256_cmpgt_epi32(lhs, rhs);
+            else
+                cmp = _mm256_cmpgt_epi64(lhs, rhs);
+        }
+
+        // Reduce the comparison result to one bit per element
+        uint64_t mask;
+        if (width == 8) {
+            mask = uint32_t(_mm256_movemask_epi8(cmp));
+        }
+        else if (width == 16) {
+            __m128i packed = _mm_packs_epi16(_mm256_castsi256_si128(cmp), _mm256_extracti128_si256(cmp, 1));
+            mask = uint32_t(_mm_movemask_epi8(packed));
+        }
+        else if (width == 32) {
+            mask = uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(cmp)));
+        }
+        else {
+            mask = uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(cmp)));
+        }
+        if (std::is_same<cond, NotEqual>::value)
+            mask = ~mask & all;
+
+        if (mask == 0)
+            continue;
+
+        size_t index = baseindex + i * elements;
+        if (action == act_Sum && state->m_match_count + elements < state->m_limit) {
+            // Zero the non-matching lanes and sum the rest horizontally in 64-bit lanes, which cannot overflow
+            // for a single vector
+            if (std::is_same<cond, NotEqual>::value)
+                cmp = _mm256_xor_si256(cmp, _mm256_set1_epi8(-1));
+            __m256i m = _mm256_and_si256(v, cmp);
+            __m256i acc;
+            if (width == 8) {
+                __m256i lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(m));
+                __m256i hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(m, 1));
+                __m256i s32 = _mm256_madd_epi16(_mm256_add_epi16(lo, hi), _mm256_set1_epi16(1));
+                acc = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(s32)),
+                                       _mm256_cvtepi32_epi64(_mm256_extracti128_si256(s32, 1)));
+            }
+            else if (width == 16) {
+                __m256i s32 = _mm256_madd_epi16(m, _mm256_set1_epi16(1));
+                acc = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(s32)),
+                                       _mm256_cvtepi32_epi64(_mm256_extracti128_si256(s32, 1)));
+            }
+            else if (width == 32) {
+                acc = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(m)),
+                                       _mm256_cvtepi32_epi64(_mm256_extracti128_si256(m, 1)));
+            }
+            else {
+                acc = m;
+            }
+            __m128i s = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            state->m_state += _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+            state->m_match_count += fast_popcount64(mask);
+            continue;
+        }
+
+        if (!find_action_mask<action, width, Callback>(mask, elements, chunk, index, state, callback))
+            return false;
+    }
+
+    return true;
+}
+#endif // REALM_COMPILER_AVX2
+
+#ifdef REALM_COMPILER_AVX512
+// Same contract as find_avx2(), but with 64-byte AVX-512 vectors. AVX-512 comparisons produce a bit mask with one
+// bit per element directly, and support all conditions natively.
+template <class cond, Action action, size_t width, class Callback>
+REALM_TARGET_AVX512 bool Array::find_avx512(int64_t value, const char* data, size_t chunks,
+                                            QueryState<int64_t>* state, size_t baseindex, Callback callback) const
+{
+    const size_t elements = 64 * 8 / width;
+    constexpr int predicate = std::is_same<cond, Equal>::value
+                              ? _MM_CMPINT_EQ
+                              : std::is_same<cond, NotEqual>::value
+                                    ? _MM_CMPINT_NE
+                                    : std::is_same<cond, Less>::value ? _MM_CMPINT_LT : _MM_CMPINT_NLE;
+    __m512i search;
+    if (width == 8)
+        search = _mm512_set1_epi8(static_cast<char>(value));
+    else if (width == 16)
+        search = _mm512_set1_epi16(static_cast<short>(value));
+    else if (width == 32)
+        search = _mm512_set1_epi32(static_cast<int>(value));
+    else
+        search = _mm512_set1_epi64(value);
+
+    for (size_t i = 0; i < chunks; ++i) {
+        const char* chunk = data + i * 64;
+        __m512i v = _mm512_load_si512(reinterpret_cast<const void*>(chunk));
+        uint64_t mask;
+        if (width == 8)
+            mask = _mm512_cmp_epi8_mask(v, search, predicate);
+        else if (width == 16)
+            mask = _mm512_cmp_epi16_mask(v, search, predicate);
+        else if (width == 32)
+            mask = _mm512_cmp_epi32_mask(v, search, predicate);
+        else
+            mask = _mm512_cmp_epi64_mask(v, search, predicate);
+
+        if (mask == 0)
+            continue;
+
+        size_t index = baseindex + i * elements;
+        if (action == act_Sum && state->m_match_count + elements < state->m_limit) {
+            // Zero the non-matching lanes, and add up the lanes as 64-bit values to avoid overflow
+            int64_t sum;
+            if (width == 8)
+                sum = sum_lanes_avx512<int8_t>(_mm512_maskz_mov_epi8(mask, v));
+            else if (width == 16)
+                sum = sum_lanes_avx512<int16_t>(_mm512_maskz_mov_epi16(__mmask32(mask), v));
+            else if (width == 32)
+                sum = sum_lanes_avx512<int32_t>(_mm512_maskz_mov_epi32(__mmask16(mask), v));
+            else
+                sum = sum_lanes_avx512<int64_t>(_mm512_maskz_mov_epi64(__mmask8(mask), v));
+            state->m_state += sum;
+            state->m_match_count += fast_popcount64(mask);
+            continue;
+        }
+
+        if ((action == act_Max || action == act_Min) && (width == 32 || width == 64) &&
+            state->m_match_count + elements < state->m_limit) {
+            // Reduce the matching lanes first, and only look for the index of the extreme value when it improves
+            // the current state, which is rare once a few chunks have been seen
+            int64_t best;
+            if (width == 32)
+                best = minmax_lanes_avx512<int32_t, action>(v, mask);
+            else
+                best = minmax_lanes_avx512<int64_t, action>(v, mask);
+            state->m_match_count += fast_popcount64(mask);
+            if (action == act_Max ? best > state->m_state : best < state->m_state) {
+                while (get_universal<width>(chunk, first_set_bit64(mask)) != best)
+                    mask &= mask - 1;
+                state->m_state = best;
+                state->m_minmax_index = index + first_set_bit64(mask);
+            }
+            continue;
+        }
+
+        if (!find_action_mask<action, width, Callback>(mask, elements, chunk, index, state, callback))
+            return false;
+    }
+
+    return true;
+}
+
+template <class T>
+REALM_TARGET_AVX512 int64_t Array::sum_lanes_avx512(__m512i v) noexcept
+{
+    alignas(64) T lanes[64 / sizeof(T)];
+    _mm512_store_si512(reinterpret_cast<void*>(lanes), v);
+    int64_t sum = 0;
+    for (T lane : lanes)
+        sum += lane;
+    return sum;
+}
+
+template <class T, Action action>
+REALM_TARGET_AVX512 int64_t Array::minmax_lanes_avx512(__m512i v, uint64_t mask) const
+{
+    alignas(64) T lanes[64 / sizeof(T)];
+    _mm512_store_si512(reinterpret_cast<void*>(lanes), v);
+    int64_t best = action == act_Max ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+    for (; mask != 0; mask &= mask - 1) {
+        int64_t lane = lanes[first_set_bit64(mask)];
+        best = action == act_Max ? std::max(best, lane) : std::min(best, lane);
+    }
+    return best;
+}
+#endif // REALM_COMPILER_AVX512
+
 template <class cond, Action action, class Callback>
 bool Array::compare_leafs(const Array* foreign, size_t start, size_t end, size_t baseindex,
                           QueryState<int64_t>* state, Callback callback) const
@@ -2867,6 +3377,17 @@ bool Array::compare_leafs(const Array* foreign, size_t start, size_t end, size_t
         return true;
     }
 
+    // The width specific versions read the payload directly, which does not work for encoded arrays
+    if (REALM_UNLIKELY(m_is_encoded || foreign->m_is_encoded)) {
+        for (; start < end; ++start) {
+            v = get(start);
+            if (c(v, foreign->get(start)))
+                if (!find_action<action, Callback>(start + baseindex, v, state, callback))
+                    return false;
+        }
+        return true;
+    }
+
     bool r;
     REALM_TEMPEX4(r = compare_leafs, cond, action, m_width, Callback,
                   (foreign, start, end, baseindex, state, callback))
@@ -276,6 +276,8 @@ public:
     void set(size_t, T value);
     void set_null(size_t);
     void insert(size_t ndx, T value, size_t num_rows = 1);
+    /// Append the specified values to the end of the tree.
+    void append(const T* values, size_t num_values);
     void erase(size_t ndx, bool is_last = false);
     void move_last_over(size_t ndx, size_t last_row_ndx);
     void clear();
@@ -304,6 +306,10 @@ public:
     void adjust(T diff);
     void adjust_ge(T limit, T diff);
 
+    /// Calls Array::try_encode() on every leaf. Only integer trees
+    /// support this. Returns true if any leaf was encoded.
+    bool encode_leaves();
+
     ref_type write(size_t slice_offset, size_t slice_size, size_t table_size, _impl::OutputStream& out) const;
 
 #if defined(REALM_DEBUG)
@@ -326,12 +332,18 @@ private:
     struct SliceHandler;
     struct AdjustHandler;
     struct AdjustGEHandler;
+    struct EncodeHandler;
 
     struct LeafValueInserter;
     struct LeafNullInserter;
 
     template <class TreeTraits>
     void bptree_insert(size_t row_ndx, BpTreeNode::TreeInsert<TreeTraits>& state, size_t num_rows);
+
+    /// Add as many of the specified values to the last leaf of the tree as
+    /// fit in it, and return how many that was.
+    size_t append_to_last_leaf(BpTreeNode& node, const T* values, size_t num_values);
+    static size_t append_to_leaf(LeafType& leaf, const T* values, size_t num_values);
 };
 
 
@@ -884,6 +896,72 @@ void BpTree<T>::insert(size_t row_ndx, T value, size_t num_rows)
     bptree_insert(row_ndx, inserter, num_rows);                            // Throws
 }
 
+template <class T>
+void BpTree<T>::append(const T* values, size_t num_values)
+{
+    BpTreeNode::TreeInsert<LeafValueInserter> inserter;
+    inserter.m_nullable = std::is_same<T, util::Optional<int64_t>>::value; // FIXME
+    for (;;) {
+        // Values are added directly to the last leaf until it is full. Only
+        // the first value of each new leaf goes through bptree_append(),
+        // which attaches the new leaf to the tree.
+        size_t num_added;
+        if (root_is_leaf()) {
+            num_added = append_to_leaf(root_as_leaf(), values, num_values); // Throws
+        }
+        else {
+            num_added = append_to_last_leaf(root_as_node(), values, num_values); // Throws
+        }
+        values += num_added;
+        num_values -= num_added;
+        if (num_values == 0)
+            break;
+
+        inserter.m_value = *values;
+        bptree_insert(npos, inserter, 1); // Throws
+        ++values;
+        --num_values;
+    }
+}
+
+template <class T>
+size_t BpTree<T>::append_to_last_leaf(BpTreeNode& node, const T* values, size_t num_values)
+{
+    Allocator& alloc = get_alloc();
+    size_t child_ref_ndx = node.size() - 2;
+    MemRef child_mem(node.get_as_ref(child_ref_ndx), alloc);
+    size_t num_added;
+    if (Array::get_is_inner_bptree_node_from_header(child_mem.get_addr())) {
+        BpTreeNode child(alloc);
+        child.init_from_mem(child_mem);
+        child.set_parent(&node, child_ref_ndx);
+        num_added = append_to_last_leaf(child, values, num_values); // Throws
+    }
+    else {
+        LeafType leaf(alloc);
+        leaf.init_from_mem(child_mem);
+        leaf.set_parent(&node, child_ref_ndx);
+        num_added = append_to_leaf(leaf, values, num_values); // Throws
+    }
+
+    // Adding elements to the last child never changes the offsets of the
+    // children, only the total, which is stored as 1 + 2*total_elems_in_subtree
+    if (num_added != 0)
+        node.adjust(node.size() - 1, int_fast64_t(2 * num_added)); // Throws
+    return num_added;
+}
+
+template <class T>
+size_t BpTree<T>::append_to_leaf(LeafType& leaf, const T* values, size_t num_values)
+{
+    size_t leaf_size = leaf.size();
+    REALM_ASSERT_DEBUG(leaf_size <= REALM_MAX_BPNODE_SIZE);
+    size_t num_added = std::min(num_values, size_t(REALM_MAX_BPNODE_SIZE) - leaf_size);
+    for (size_t i = 0; i != num_added; ++i)
+        leaf.add(values[i]); // Throws
+    return num_added;
+}
+
 template <class T>
 struct BpTree<T>::UpdateHandler : BpTreeNode::UpdateHandler {
     LeafType m_leaf;
@@ -1106,6 +1184,37 @@ void BpTree<T>::adjust_ge(T limit, T diff)
     }
 }
 
+template <class T>
+struct BpTree<T>::EncodeHandler : BpTreeNode::UpdateHandler {
+    LeafType m_leaf;
+    bool m_encoded = false;
+
+    EncodeHandler(BpTreeBase& tree)
+        : m_leaf(tree.get_alloc())
+    {
+    }
+
+    void update(MemRef mem, ArrayParent* parent, size_t ndx_in_parent, size_t) final
+    {
+        m_leaf.init_from_mem(mem);
+        m_leaf.set_parent(parent, ndx_in_parent);
+        if (m_leaf.try_encode()) // Throws
+            m_encoded = true;
+    }
+};
+
+template <class T>
+bool BpTree<T>::encode_leaves()
+{
+    static_assert(std::is_same<T, int64_t>::value, "only integer leaves can be encoded");
+    if (root_is_leaf())
+        return root_as_leaf().try_encode(); // Throws
+
+    EncodeHandler encode_leaf(*this);
+    root_as_node().update_bptree_leaves(encode_leaf); // Throws
+    return encode_leaf.m_encoded;
+}
+
 template <class T>
 struct BpTree<T>::SliceHandler : public BpTreeBase::SliceHandler {
 public:
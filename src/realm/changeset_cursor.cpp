@@ -0,0 +1,400 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/changeset_cursor.hpp>
+
+using namespace realm;
+
+using _impl::Instruction;
+using Kind = ChangesetBatch::Kind;
+
+
+// Translates instructions into batch entries. Values are ignored, so every
+// `set_*` instruction reduces to a change of a single cell.
+class ChangesetCursor::Decoder {
+public:
+    Decoder(ChangesetCursor& cursor, ChangesetBatch& batch) noexcept
+        : m_cursor(cursor)
+        , m_batch(batch)
+    {
+    }
+
+    bool select_table(size_t group_level_ndx, size_t levels, const size_t* path) noexcept
+    {
+        m_cursor.m_table = group_level_ndx;
+        m_cursor.m_subtable_col = (levels == 0 ? npos : path[0]);
+        m_cursor.m_subtable_row = (levels == 0 ? npos : path[1]);
+        m_cursor.m_descriptor_col = npos;
+        return true;
+    }
+
+    bool select_descriptor(size_t levels, const size_t* path) noexcept
+    {
+        // Schema changes of subtables are reported against the column of
+        // the root-level table that holds them.
+        m_cursor.m_descriptor_col = (levels == 0 ? npos : path[0]);
+        return true;
+    }
+
+    bool select_link_list(size_t col_ndx, size_t row_ndx, size_t) noexcept
+    {
+        m_cursor.m_link_list_col = col_ndx;
+        m_cursor.m_link_list_row = row_ndx;
+        return true;
+    }
+
+    bool insert_group_level_table(size_t table_ndx, size_t, StringData) noexcept
+    {
+        add_table_entry(Kind::insert_table, table_ndx);
+        return true;
+    }
+
+    bool erase_group_level_table(size_t table_ndx, size_t) noexcept
+    {
+        add_table_entry(Kind::erase_table, table_ndx);
+        return true;
+    }
+
+    bool rename_group_level_table(size_t table_ndx, StringData) noexcept
+    {
+        add_table_entry(Kind::rename_table, table_ndx);
+        return true;
+    }
+
+    bool move_group_level_table(size_t from_table_ndx, size_t to_table_ndx) noexcept
+    {
+        add_table_entry(Kind::move_table, from_table_ndx, to_table_ndx);
+        return true;
+    }
+
+    bool insert_empty_rows(size_t row_ndx, size_t num_rows_to_insert, size_t, bool) noexcept
+    {
+        add_row_entry(Kind::insert_rows, row_ndx, num_rows_to_insert, npos);
+        return true;
+    }
+
+    bool erase_rows(size_t row_ndx, size_t num_rows_to_erase, size_t prior_num_rows, bool unordered) noexcept
+    {
+        if (unordered) {
+            add_row_entry(Kind::move_last_over, row_ndx, 1, prior_num_rows - 1);
+        }
+        else {
+            add_row_entry(Kind::erase_rows, row_ndx, num_rows_to_erase, npos);
+        }
+        return true;
+    }
+
+    bool swap_rows(size_t row_ndx_1, size_t row_ndx_2) noexcept
+    {
+        add_row_entry(Kind::swap_rows, row_ndx_1, npos, row_ndx_2);
+        return true;
+    }
+
+    bool merge_rows(size_t row_ndx, size_t new_row_ndx) noexcept
+    {
+        add_row_entry(Kind::merge_rows, row_ndx, npos, new_row_ndx);
+        return true;
+    }
+
+    bool clear_table() noexcept
+    {
+        add_row_entry(Kind::clear_table, npos, npos, npos);
+        return true;
+    }
+
+    bool set_int(size_t col_ndx, size_t row_ndx, int_fast64_t, Instruction, size_t) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool add_int(size_t col_ndx, size_t row_ndx, int_fast64_t) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_bool(size_t col_ndx, size_t row_ndx, bool, Instruction) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_float(size_t col_ndx, size_t row_ndx, float, Instruction) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_double(size_t col_ndx, size_t row_ndx, double, Instruction) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_string(size_t col_ndx, size_t row_ndx, StringData, Instruction, size_t) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_binary(size_t col_ndx, size_t row_ndx, BinaryData, Instruction) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_olddatetime(size_t col_ndx, size_t row_ndx, OldDateTime, Instruction) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_timestamp(size_t col_ndx, size_t row_ndx, Timestamp, Instruction) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_table(size_t col_ndx, size_t row_ndx, Instruction) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_mixed(size_t col_ndx, size_t row_ndx, const Mixed&, Instruction) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_link(size_t col_ndx, size_t row_ndx, size_t, size_t, Instruction) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool set_null(size_t col_ndx, size_t row_ndx, Instruction, size_t) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool nullify_link(size_t col_ndx, size_t row_ndx, size_t) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool insert_substring(size_t col_ndx, size_t row_ndx, size_t, StringData) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+    bool erase_substring(size_t col_ndx, size_t row_ndx, size_t, size_t) noexcept
+    {
+        return set(col_ndx, row_ndx);
+    }
+
+    bool optimize_table() noexcept
+    {
+        // Not a logical change
+        return true;
+    }
+
+    bool unenumerate_string_columns() noexcept
+    {
+        // Not a logical change
+        return true;
+    }
+
+    bool insert_link_column(size_t col_ndx, DataType, StringData, size_t, size_t) noexcept
+    {
+        add_column_entry(Kind::insert_column, col_ndx, npos);
+        return true;
+    }
+    bool insert_column(size_t col_ndx, DataType, StringData, bool) noexcept
+    {
+        add_column_entry(Kind::insert_column, col_ndx, npos);
+        return true;
+    }
+    bool erase_link_column(size_t col_ndx, size_t, size_t) noexcept
+    {
+        add_column_entry(Kind::erase_column, col_ndx, npos);
+        return true;
+    }
+    bool erase_column(size_t col_ndx) noexcept
+    {
+        add_column_entry(Kind::erase_column, col_ndx, npos);
+        return true;
+    }
+    bool move_column(size_t col_ndx_1, size_t col_ndx_2) noexcept
+    {
+        add_column_entry(Kind::move_column, col_ndx_1, col_ndx_2);
+        return true;
+    }
+    bool rename_column(size_t col_ndx, StringData) noexcept
+    {
+        add_column_entry(Kind::modify_column, col_ndx, npos);
+        return true;
+    }
+    bool add_search_index(size_t col_ndx) noexcept
+    {
+        add_column_entry(Kind::modify_column, col_ndx, npos);
+        return true;
+    }
+    bool remove_search_index(size_t col_ndx) noexcept
+    {
+        add_column_entry(Kind::modify_column, col_ndx, npos);
+        return true;
+    }
+    bool add_ordered_index(size_t col_ndx) noexcept
+    {
+        add_column_entry(Kind::modify_column, col_ndx, npos);
+        return true;
+    }
+    bool remove_ordered_index(size_t col_ndx) noexcept
+    {
+        add_column_entry(Kind::modify_column, col_ndx, npos);
+        return true;
+    }
+    bool set_link_type(size_t col_ndx, LinkType) noexcept
+    {
+        add_column_entry(Kind::modify_column, col_ndx, npos);
+        return true;
+    }
+
+    bool link_list_set(size_t, size_t, size_t) noexcept
+    {
+        return link_list();
+    }
+    bool link_list_insert(size_t, size_t, size_t) noexcept
+    {
+        return link_list();
+    }
+    bool link_list_move(size_t, size_t) noexcept
+    {
+        return link_list();
+    }
+    bool link_list_swap(size_t, size_t) noexcept
+    {
+        return link_list();
+    }
+    bool link_list_erase(size_t, size_t) noexcept
+    {
+        return link_list();
+    }
+    bool link_list_nullify(size_t, size_t) noexcept
+    {
+        return link_list();
+    }
+    bool link_list_clear(size_t) noexcept
+    {
+        return link_list();
+    }
+
+private:
+    ChangesetCursor& m_cursor;
+    ChangesetBatch& m_batch;
+
+    bool in_subtable() const noexcept
+    {
+        return m_cursor.m_subtable_col != npos;
+    }
+
+    size_t last_of_kind(Kind kind) const noexcept
+    {
+        if (m_batch.size == 0)
+            return npos;
+        size_t i = m_batch.size - 1;
+        if (m_batch.kind[i] != kind || m_batch.table[i] != m_cursor.m_table)
+            return npos;
+        return i;
+    }
+
+    void add(Kind kind, size_t table, size_t col, size_t row, size_t count, size_t other) noexcept
+    {
+        // Each instruction adds at most one entry, and next() stops parsing
+        // when the batch is full.
+        REALM_ASSERT_DEBUG(m_batch.size < ChangesetBatch::capacity);
+        size_t i = m_batch.size++;
+        m_batch.kind[i] = kind;
+        m_batch.table[i] = table;
+        m_batch.col[i] = col;
+        m_batch.row[i] = row;
+        m_batch.count[i] = count;
+        m_batch.other[i] = other;
+    }
+
+    void add_table_entry(Kind kind, size_t table_ndx, size_t other = npos) noexcept
+    {
+        add(kind, table_ndx, npos, npos, npos, other);
+    }
+
+    void add_row_entry(Kind kind, size_t row_ndx, size_t count, size_t other) noexcept
+    {
+        if (in_subtable()) {
+            add_subtable_entry(m_cursor.m_subtable_col, m_cursor.m_subtable_row);
+            return;
+        }
+        add(kind, m_cursor.m_table, npos, row_ndx, count, other);
+    }
+
+    void add_column_entry(Kind kind, size_t col_ndx, size_t other) noexcept
+    {
+        if (m_cursor.m_descriptor_col != npos) {
+            add_subtable_entry(m_cursor.m_descriptor_col, npos);
+            return;
+        }
+        add(kind, m_cursor.m_table, col_ndx, npos, npos, other);
+    }
+
+    void add_subtable_entry(size_t col_ndx, size_t row_ndx) noexcept
+    {
+        size_t i = last_of_kind(Kind::subtable);
+        if (i != npos && m_batch.col[i] == col_ndx && m_batch.row[i] == row_ndx)
+            return;
+        add(Kind::subtable, m_cursor.m_table, col_ndx, row_ndx, npos, npos);
+    }
+
+    bool set(size_t col_ndx, size_t row_ndx) noexcept
+    {
+        if (in_subtable()) {
+            add_subtable_entry(m_cursor.m_subtable_col, m_cursor.m_subtable_row);
+            return true;
+        }
+        // Extend the previous entry if this cell is inside it or immediately
+        // follows it.
+        size_t i = last_of_kind(Kind::set);
+        if (i != npos && m_batch.col[i] == col_ndx && row_ndx >= m_batch.row[i] &&
+            row_ndx <= m_batch.row[i] + m_batch.count[i]) {
+            if (row_ndx == m_batch.row[i] + m_batch.count[i])
+                ++m_batch.count[i];
+            return true;
+        }
+        add(Kind::set, m_cursor.m_table, col_ndx, row_ndx, 1, npos);
+        return true;
+    }
+
+    bool link_list() noexcept
+    {
+        if (in_subtable()) {
+            add_subtable_entry(m_cursor.m_subtable_col, m_cursor.m_subtable_row);
+            return true;
+        }
+        size_t col_ndx = m_cursor.m_link_list_col, row_ndx = m_cursor.m_link_list_row;
+        size_t i = last_of_kind(Kind::link_list);
+        if (i != npos && m_batch.col[i] == col_ndx && m_batch.row[i] == row_ndx)
+            return true;
+        add(Kind::link_list, m_cursor.m_table, col_ndx, row_ndx, npos, npos);
+        return true;
+    }
+};
+
+
+ChangesetCursor::ChangesetCursor(_impl::History& hist, version_type begin_version, version_type end_version)
+    : m_input(hist, begin_version, end_version)
+{
+    m_parser.begin_parse(m_input);
+}
+
+ChangesetCursor::~ChangesetCursor() noexcept
+{
+}
+
+bool ChangesetCursor::next(ChangesetBatch& batch)
+{
+    batch.size = 0;
+    Decoder decoder(*this, batch);
+    while (batch.size < ChangesetBatch::capacity) {
+        if (!m_parser.parse_next(decoder)) // Throws
+            break;
+    }
+    return batch.size > 0;
+}
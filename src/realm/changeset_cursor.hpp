@@ -0,0 +1,148 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_CHANGESET_CURSOR_HPP
+#define REALM_CHANGESET_CURSOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <realm/impl/input_stream.hpp>
+#include <realm/impl/transact_log.hpp>
+
+
+namespace realm {
+
+/// A batch of changes decoded from the transaction logs by a
+/// ChangesetCursor. The changes are stored in struct-of-arrays form, that is,
+/// the N'th change is described by `kind[N]`, `table[N]`, `col[N]`, `row[N]`,
+/// `count[N]`, and `other[N]`, for N in [0, size). Fields that are not
+/// relevant for a particular kind of change are set to `npos`.
+///
+/// All indexes refer to the state of the database at the point where the
+/// change was applied, so a change may shift the indexes used by subsequent
+/// changes in the same way as the corresponding operation on the Table and
+/// Group API.
+///
+/// A batch has a fixed capacity and never allocates memory, so a single
+/// instance can be reused for the entire lifetime of a cursor.
+struct ChangesetBatch {
+    enum class Kind : uint8_t {
+        /// Cells [`row`, `row` + `count`) of column `col` were modified.
+        set,
+        /// `count` empty rows were inserted at `row`.
+        insert_rows,
+        /// `count` rows were erased starting at `row`.
+        erase_rows,
+        /// Row `row` was erased, and row `other` was moved into its place.
+        move_last_over,
+        /// Rows `row` and `other` were swapped.
+        swap_rows,
+        /// Row `row` was merged into row `other`.
+        merge_rows,
+        /// All rows were removed.
+        clear_table,
+        /// The link list at `row` in column `col` was modified.
+        link_list,
+        /// The subtable at `row` in column `col` was modified. If `row` is
+        /// `npos`, the subtable schema of column `col` was modified.
+        subtable,
+        /// A column was inserted at `col`.
+        insert_column,
+        /// Column `col` was erased.
+        erase_column,
+        /// Column `col` was moved to `other`.
+        move_column,
+        /// Column `col` was renamed, or its search index or link type was
+        /// changed.
+        modify_column,
+        /// A group-level table was inserted at `table`.
+        insert_table,
+        /// Group-level table `table` was erased.
+        erase_table,
+        /// Group-level table `table` was moved to `other`.
+        move_table,
+        /// Group-level table `table` was renamed.
+        rename_table
+    };
+
+    static const size_t capacity = 256;
+
+    size_t size = 0;
+    Kind kind[capacity];
+    size_t table[capacity]; ///< Group-level table index
+    size_t col[capacity];
+    size_t row[capacity];
+    size_t count[capacity];
+    size_t other[capacity];
+};
+
+
+/// Decodes the changesets between two versions of the database directly out
+/// of the history, i.e., without copying the changesets, and without
+/// allocating memory per instruction.
+///
+/// This is intended for language bindings and other observers that need to
+/// know which tables, columns, and rows were touched by a range of
+/// transactions, but not the new values, and which would otherwise need to
+/// implement a full instruction handler for TransactLogParser.
+///
+/// The cursor retrieves changesets using History::get_changesets(), so the
+/// restrictions documented for that function apply to the lifetime of the
+/// cursor. In particular, the cursor must be used from within a transaction
+/// in which the changesets in the specified range are available, and it must
+/// not be used after that transaction has ended or advanced.
+class ChangesetCursor {
+public:
+    using version_type = _impl::History::version_type;
+
+    ChangesetCursor(_impl::History&, version_type begin_version, version_type end_version);
+    ~ChangesetCursor() noexcept;
+
+    /// Replace the contents of the specified batch with the next changes. Runs
+    /// of changes to consecutive cells of a column are coalesced into a
+    /// single `set` entry, and repeated changes to the same link list or
+    /// subtable are reported once.
+    ///
+    /// \return False if there were no more changes, in which case the batch
+    /// will be empty.
+    bool next(ChangesetBatch&);
+
+private:
+    class Decoder;
+
+    _impl::ChangesetInputStream m_input;
+    _impl::TransactLogParser m_parser;
+
+    size_t m_table = npos;
+    // The column and row of the root-level cell containing the currently
+    // selected subtable. `npos` if a group-level table is selected.
+    size_t m_subtable_col = npos;
+    size_t m_subtable_row = npos;
+    // The root-level column of the currently selected subtable descriptor.
+    // `npos` if the descriptor of the selected table itself is selected.
+    size_t m_descriptor_col = npos;
+    // The column and row of the currently selected link list
+    size_t m_link_list_col = npos;
+    size_t m_link_list_row = npos;
+};
+
+
+} // namespace realm
+
+#endif // REALM_CHANGESET_CURSOR_HPP
@@ -68,6 +68,7 @@ void ColumnBaseWithIndex::move_assign(ColumnBaseWithIndex& col) noexcept
 {
     ColumnBase::move_assign(col);
     m_search_index = std::move(col.m_search_index);
+    m_ordered_index = std::move(col.m_ordered_index);
 }
 
 void ColumnBase::set_string(size_t, StringData)
@@ -80,6 +81,9 @@ void ColumnBaseWithIndex::set_ndx_in_parent(size_t ndx) noexcept
     if (m_search_index) {
         m_search_index->set_ndx_in_parent(ndx + 1);
     }
+    if (m_ordered_index) {
+        m_ordered_index->set_ndx_in_parent(ndx + 1);
+    }
 }
 
 void ColumnBaseWithIndex::update_from_parent(size_t old_baseline) noexcept
@@ -87,6 +91,9 @@ void ColumnBaseWithIndex::update_from_parent(size_t old_baseline) noexcept
     if (m_search_index) {
         m_search_index->update_from_parent(old_baseline);
     }
+    if (m_ordered_index) {
+        m_ordered_index->update_from_parent(old_baseline);
+    }
 }
 
 void ColumnBaseWithIndex::refresh_accessor_tree(size_t new_col_ndx, const realm::Spec& spec)
@@ -95,6 +102,9 @@ void ColumnBaseWithIndex::refresh_accessor_tree(size_t new_col_ndx, const realm:
     if (m_search_index) {
         m_search_index->refresh_accessor_tree(new_col_ndx, spec);
     }
+    if (m_ordered_index) {
+        m_ordered_index->refresh_accessor_tree(new_col_ndx, spec); // Throws
+    }
 }
 
 
@@ -114,6 +124,9 @@ void ColumnBaseWithIndex::destroy() noexcept
     if (m_search_index) {
         m_search_index->destroy();
     }
+    if (m_ordered_index) {
+        m_ordered_index->destroy();
+    }
 }
 
 void ColumnBase::verify(const Table&, size_t column_ndx) const
@@ -369,6 +382,17 @@ void ColumnBaseWithIndex::set_search_index_ref(ref_type ref, ArrayParent* parent
         new StringIndex(ref, parent, ndx_in_parent, this, !allow_duplicate_valaues, get_alloc())); // Throws
 }
 
+void ColumnBaseWithIndex::destroy_ordered_index() noexcept
+{
+    m_ordered_index.reset();
+}
+
+void ColumnBaseWithIndex::set_ordered_index_ref(ref_type ref, ArrayParent* parent, size_t ndx_in_parent)
+{
+    REALM_ASSERT(!m_ordered_index);
+    m_ordered_index.reset(new OrderedIndex(ref, parent, ndx_in_parent, get_alloc())); // Throws
+}
+
 
 #ifdef REALM_DEBUG // LCOV_EXCL_START ignore debug functions
 
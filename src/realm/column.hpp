@@ -31,6 +31,7 @@
 #include <realm/impl/output_stream.hpp>
 #include <realm/query_conditions.hpp>
 #include <realm/bptree.hpp>
+#include <realm/index_ordered.hpp>
 #include <realm/index_string.hpp>
 #include <realm/impl/destroy_guard.hpp>
 #include <realm/exceptions.hpp>
@@ -211,6 +212,14 @@ public:
     virtual void set_search_index_ref(ref_type, ArrayParent*, size_t ndx_in_parent, bool allow_duplicate_values);
     virtual void set_search_index_allow_duplicate_values(bool) noexcept;
 
+    // Ordered index
+    virtual bool has_ordered_index() const noexcept;
+    virtual OrderedIndex* create_ordered_index();
+    virtual void destroy_ordered_index() noexcept;
+    virtual const OrderedIndex* get_ordered_index() const noexcept;
+    virtual OrderedIndex* get_ordered_index() noexcept;
+    virtual void set_ordered_index_ref(ref_type, ArrayParent*, size_t ndx_in_parent);
+
     virtual Allocator& get_alloc() const noexcept = 0;
 
     /// Returns the 'ref' of the root array.
@@ -507,10 +516,26 @@ public:
                               bool allow_duplicate_valaues) final;
     StringIndex* create_search_index() override = 0;
 
+    bool has_ordered_index() const noexcept final
+    {
+        return bool(m_ordered_index);
+    }
+    OrderedIndex* get_ordered_index() noexcept final
+    {
+        return m_ordered_index.get();
+    }
+    const OrderedIndex* get_ordered_index() const noexcept final
+    {
+        return m_ordered_index.get();
+    }
+    void destroy_ordered_index() noexcept override;
+    void set_ordered_index_ref(ref_type ref, ArrayParent* parent, size_t ndx_in_parent) final;
+
 protected:
     using ColumnBase::ColumnBase;
     ColumnBaseWithIndex(ColumnBaseWithIndex&&) = default;
     std::unique_ptr<StringIndex> m_search_index;
+    std::unique_ptr<OrderedIndex> m_ordered_index;
 };
 
 
@@ -593,6 +618,7 @@ public:
     void set(size_t, T value);
     void set_null(size_t) override;
     void add(T value = T{});
+    void add(const T* values, size_t num_values);
     void insert(size_t ndx, T value = T{}, size_t num_rows = 1);
     void erase(size_t row_ndx);
     void erase(size_t row_ndx, bool is_last);
@@ -617,6 +643,11 @@ public:
     template <class U>
     void adjust_ge(T limit, U diff);
 
+    /// Store leaves more compactly where possible (see
+    /// Array::try_encode()). Only supported for non-nullable integer
+    /// columns. Returns true if any leaf was encoded.
+    bool encode_leaves();
+
     size_t count(T target) const;
 
     typename ColumnTypeTraits<T>::sum_type sum(size_t start = 0, size_t end = npos, size_t limit = npos,
@@ -643,6 +674,9 @@ public:
             return true;
     }
 
+    void populate_ordered_index();
+    OrderedIndex* create_ordered_index() override;
+
 
     //@{
     /// Find the lower/upper bound for the specified value assuming
@@ -813,6 +847,34 @@ inline void ColumnBase::set_search_index_allow_duplicate_values(bool) noexcept
 {
 }
 
+inline bool ColumnBase::has_ordered_index() const noexcept
+{
+    return get_ordered_index() != nullptr;
+}
+
+inline OrderedIndex* ColumnBase::create_ordered_index()
+{
+    return nullptr;
+}
+
+inline void ColumnBase::destroy_ordered_index() noexcept
+{
+}
+
+inline const OrderedIndex* ColumnBase::get_ordered_index() const noexcept
+{
+    return nullptr;
+}
+
+inline OrderedIndex* ColumnBase::get_ordered_index() noexcept
+{
+    return nullptr;
+}
+
+inline void ColumnBase::set_ordered_index_ref(ref_type, ArrayParent*, size_t)
+{
+}
+
 inline void ColumnBase::discard_child_accessors() noexcept
 {
     do_discard_child_accessors();
@@ -897,6 +959,9 @@ void Column<T>::set(size_t ndx, T value)
     if (has_search_index()) {
         m_search_index->set(ndx, value);
     }
+    if (has_ordered_index()) {
+        m_ordered_index->set(ndx, get(ndx), value); // Throws
+    }
     set_without_updating_index(ndx, std::move(value));
 }
 
@@ -910,6 +975,11 @@ void Column<T>::set_null(size_t ndx)
     if (has_search_index()) {
         m_search_index->set(ndx, null{});
     }
+    if (has_ordered_index()) {
+        // Null values are not indexed
+        bool is_last = true; // This tells OrderedIndex::erase() to not adjust subsequent indexes
+        m_ordered_index->erase(ndx, get(ndx), is_last); // Throws
+    }
     m_tree.set_null(ndx);
 }
 
@@ -934,6 +1004,12 @@ template <class U>
 void Column<T>::adjust(size_t ndx, U diff)
 {
     REALM_ASSERT_3(ndx, <, size());
+    if (has_ordered_index()) {
+        T old_value = get(ndx);
+        m_tree.adjust(ndx, diff);                       // Throws
+        m_ordered_index->set(ndx, old_value, get(ndx)); // Throws
+        return;
+    }
     m_tree.adjust(ndx, diff);
 }
 
@@ -942,6 +1018,10 @@ template <class U>
 void Column<T>::adjust(U diff)
 {
     m_tree.adjust(diff);
+    if (has_ordered_index()) {
+        m_ordered_index->clear(); // Throws
+        populate_ordered_index(); // Throws
+    }
 }
 
 template <class T>
@@ -949,6 +1029,17 @@ template <class U>
 void Column<T>::adjust_ge(T limit, U diff)
 {
     m_tree.adjust_ge(limit, diff);
+    if (has_ordered_index()) {
+        m_ordered_index->clear(); // Throws
+        populate_ordered_index(); // Throws
+    }
+}
+
+template <class T>
+bool Column<T>::encode_leaves()
+{
+    // The values do not change, so the search index remains valid
+    return m_tree.encode_leaves(); // Throws
 }
 
 template <class T>
@@ -1045,6 +1136,22 @@ StringIndex* Column<T>::create_search_index()
     return m_search_index.get();
 }
 
+template <class T>
+void Column<T>::populate_ordered_index()
+{
+    REALM_ASSERT(has_ordered_index());
+    m_ordered_index->populate(size(), [this](size_t row_ndx) { return get(row_ndx); }); // Throws
+}
+
+template <class T>
+OrderedIndex* Column<T>::create_ordered_index()
+{
+    REALM_ASSERT(!has_ordered_index());
+    m_ordered_index.reset(new OrderedIndex(nullptr, 0, get_alloc())); // Throws
+    populate_ordered_index();                                         // Throws
+    return m_ordered_index.get();
+}
+
 template <class T>
 size_t Column<T>::find_first(T value, size_t begin, size_t end) const
 {
@@ -1294,6 +1401,21 @@ void Column<T>::add(T value)
     insert(npos, std::move(value));
 }
 
+template <class T>
+void Column<T>::add(const T* values, size_t num_values)
+{
+    size_t column_size = this->size(); // Slow
+    m_tree.append(values, num_values); // Throws
+
+    if (has_search_index())
+        m_search_index->insert_bulk(column_size, values, num_values); // Throws
+    if (has_ordered_index()) {
+        bool is_append = true;
+        for (size_t i = 0; i < num_values; ++i)
+            m_ordered_index->insert(column_size + i, values[i], 1, is_append); // Throws
+    }
+}
+
 template <class T>
 void Column<T>::insert_without_updating_index(size_t row_ndx, T value, size_t num_rows)
 {
@@ -1313,9 +1435,12 @@ void Column<T>::insert(size_t row_ndx, T value, size_t num_rows)
 
     m_tree.insert(ndx_or_npos_if_append, value, num_rows); // Throws
 
-    if (has_search_index()) {
+    if (has_search_index() || has_ordered_index()) {
         row_ndx = is_append ? column_size : row_ndx;
-        m_search_index->insert(row_ndx, value, num_rows, is_append); // Throws
+        if (has_search_index())
+            m_search_index->insert(row_ndx, value, num_rows, is_append); // Throws
+        if (has_ordered_index())
+            m_ordered_index->insert(row_ndx, value, num_rows, is_append); // Throws
     }
 }
 
@@ -1364,6 +1489,9 @@ void Column<T>::move_last_over(size_t row_ndx, size_t last_row_ndx)
             m_search_index->update_ref(moved_value, last_row_ndx, row_ndx); // Throws
         }
     }
+    if (has_ordered_index()) {
+        m_ordered_index->move_last_over(row_ndx, get(row_ndx), last_row_ndx, get(last_row_ndx)); // Throws
+    }
 
     move_last_over_without_updating_index(row_ndx, last_row_ndx);
 }
@@ -1387,6 +1515,9 @@ void Column<T>::swap_rows(size_t row_ndx_1, size_t row_ndx_2)
         m_search_index->erase<StringData>(row_ndx_2, row_ndx_2_is_last);
         m_search_index->insert(row_ndx_2, value_1, 1, row_ndx_2_is_last);
     }
+    if (has_ordered_index()) {
+        m_ordered_index->swap(row_ndx_1, get(row_ndx_1), row_ndx_2, get(row_ndx_2)); // Throws
+    }
 
     swap_rows_without_updating_index(row_ndx_1, row_ndx_2);
 }
@@ -1413,6 +1544,9 @@ void Column<T>::clear()
     if (has_search_index()) {
         m_search_index->clear();
     }
+    if (has_ordered_index()) {
+        m_ordered_index->clear(); // Throws
+    }
     clear_without_updating_index();
 }
 
@@ -1610,6 +1744,12 @@ void Column<T>::do_erase(size_t row_ndx, size_t num_rows_to_erase, bool is_last)
             m_search_index->erase<T>(row_ndx_2, is_last); // Throws
         }
     }
+    if (has_ordered_index()) {
+        for (size_t i = num_rows_to_erase; i > 0; --i) {
+            size_t row_ndx_2 = row_ndx + i - 1;
+            m_ordered_index->erase(row_ndx_2, get(row_ndx_2), is_last); // Throws
+        }
+    }
     for (size_t i = num_rows_to_erase; i > 0; --i) {
         size_t row_ndx_2 = row_ndx + i - 1;
         erase_without_updating_index(row_ndx_2, is_last); // Throws
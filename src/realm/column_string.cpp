@@ -244,6 +244,15 @@ std::unique_ptr<StringIndex> StringColumn::release_search_index() noexcept
 }
 
 
+void StringColumn::install_search_index(std::unique_ptr<StringIndex> index) noexcept
+{
+    REALM_ASSERT(!m_search_index);
+
+    index->set_target(this);
+    m_search_index = std::move(index); // we now own this index
+}
+
+
 void StringColumn::set_search_index_ref(ref_type ref, ArrayParent* parent, size_t ndx_in_parent,
                                         bool allow_duplicate_valaues)
 {
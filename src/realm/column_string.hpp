@@ -97,6 +97,7 @@ public:
     StringIndex* get_search_index() noexcept override;
     const StringIndex* get_search_index() const noexcept override;
     std::unique_ptr<StringIndex> release_search_index() noexcept;
+    void install_search_index(std::unique_ptr<StringIndex>) noexcept;
     bool supports_search_index() const noexcept final
     {
         return true;
@@ -328,6 +328,12 @@ void StringEnumColumn::install_search_index(std::unique_ptr<StringIndex> index)
 }
 
 
+std::unique_ptr<StringIndex> StringEnumColumn::release_search_index() noexcept
+{
+    return std::move(m_search_index);
+}
+
+
 void StringEnumColumn::refresh_accessor_tree(size_t col_ndx, const Spec& spec)
 {
     IntegerColumn::refresh_accessor_tree(col_ndx, spec);
@@ -118,6 +118,7 @@ public:
     }
     StringIndex* create_search_index() override;
     void install_search_index(std::unique_ptr<StringIndex>) noexcept;
+    std::unique_ptr<StringIndex> release_search_index() noexcept;
     void destroy_search_index() noexcept override;
 
     // Compare two string columns for equality
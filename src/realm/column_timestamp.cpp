@@ -130,6 +130,11 @@ void TimestampColumn::set_null(size_t row_ndx)
     if (has_search_index()) {
         m_search_index->set(row_ndx, null{}); // Throws
     }
+    if (has_ordered_index()) {
+        // Null values are not indexed
+        bool is_last = true; // This tells OrderedIndex::erase() to not adjust subsequent indexes
+        m_ordered_index->erase(row_ndx, get(row_ndx), is_last); // Throws
+    }
 
     // FIXME: Consider not setting 0 on m_nanoseconds
     // The current setting of 0 forces an arguably unnecessary copy-on-write etc of that leaf node
@@ -154,6 +159,10 @@ void TimestampColumn::insert_rows(size_t row_ndx, size_t num_rows_to_insert, siz
             m_search_index->insert(row_ndx, Timestamp{0, 0}, num_rows_to_insert, is_append); // Throws
         }
     }
+    if (has_ordered_index()) {
+        Timestamp value = nullable ? Timestamp{} : Timestamp{0, 0};
+        m_ordered_index->insert(row_ndx, value, num_rows_to_insert, is_append); // Throws
+    }
 }
 
 void TimestampColumn::erase(size_t row_ndx, bool is_last)
@@ -161,10 +170,19 @@ void TimestampColumn::erase(size_t row_ndx, bool is_last)
     if (has_search_index()) {
         m_search_index->erase<StringData>(row_ndx, is_last); // Throws
     }
+    if (has_ordered_index()) {
+        m_ordered_index->erase(row_ndx, get(row_ndx), is_last); // Throws
+    }
     m_seconds->erase(row_ndx, is_last);     // Throws
     m_nanoseconds->erase(row_ndx, is_last); // Throws
 }
 
+void TimestampColumn::get_seconds_leaf(size_t ndx, size_t& ndx_in_leaf,
+                                       BpTree<util::Optional<int64_t>>::LeafInfo& inout_leaf) const noexcept
+{
+    m_seconds->get_leaf(ndx, ndx_in_leaf, inout_leaf);
+}
+
 void TimestampColumn::erase_rows(size_t row_ndx, size_t num_rows_to_erase, size_t /*prior_num_rows*/,
                                  bool /*broken_reciprocal_backlinks*/)
 {
@@ -177,6 +195,10 @@ void TimestampColumn::erase_rows(size_t row_ndx, size_t num_rows_to_erase, size_
         if (has_search_index()) {
             m_search_index->erase<StringData>(row_ndx + num_rows_to_erase - i - 1, is_last); // Throws
         }
+        if (has_ordered_index()) {
+            size_t row_ndx_2 = row_ndx + num_rows_to_erase - i - 1;
+            m_ordered_index->erase(row_ndx_2, get(row_ndx_2), is_last); // Throws
+        }
         m_seconds->erase(row_ndx + num_rows_to_erase - i - 1, is_last);     // Throws
         m_nanoseconds->erase(row_ndx + num_rows_to_erase - i - 1, is_last); // Throws
     }
@@ -197,6 +219,9 @@ void TimestampColumn::move_last_row_over(size_t row_ndx, size_t prior_num_rows,
             m_search_index->update_ref(moved_value, last_row_ndx, row_ndx); // Throws
         }
     }
+    if (has_ordered_index()) {
+        m_ordered_index->move_last_over(row_ndx, get(row_ndx), last_row_ndx, get(last_row_ndx)); // Throws
+    }
 
     m_seconds->move_last_over(row_ndx, last_row_ndx);     // Throws
     m_nanoseconds->move_last_over(row_ndx, last_row_ndx); // Throws
@@ -211,6 +236,9 @@ void TimestampColumn::clear(size_t num_rows, bool /*broken_reciprocal_backlinks*
     if (has_search_index()) {
         m_search_index->clear(); // Throws
     }
+    if (has_ordered_index()) {
+        m_ordered_index->clear(); // Throws
+    }
 }
 
 void TimestampColumn::swap_rows(size_t row_ndx_1, size_t row_ndx_2)
@@ -226,6 +254,9 @@ void TimestampColumn::swap_rows(size_t row_ndx_1, size_t row_ndx_2)
         m_search_index->erase<StringData>(row_ndx_2, row_ndx_2_is_last);  // Throws
         m_search_index->insert(row_ndx_2, value_1, 1, row_ndx_2_is_last); // Throws
     }
+    if (has_ordered_index()) {
+        m_ordered_index->swap(row_ndx_1, get(row_ndx_1), row_ndx_2, get(row_ndx_2)); // Throws
+    }
 
     auto tmp1 = m_seconds->get(row_ndx_1);
     m_seconds->set(row_ndx_1, m_seconds->get(row_ndx_2)); // Throws
@@ -244,6 +275,8 @@ void TimestampColumn::destroy() noexcept
 
     if (m_search_index)
         m_search_index->destroy();
+    if (m_ordered_index)
+        m_ordered_index->destroy();
 }
 
 StringData TimestampColumn::get_index_data(size_t ndx, StringIndex::StringConversionBuffer& buffer) const noexcept
@@ -284,6 +317,31 @@ void TimestampColumn::set_search_index_ref(ref_type ref, ArrayParent* parent, si
         new StringIndex(ref, parent, ndx_in_parent, this, !allow_duplicate_values, get_alloc())); // Throws
 }
 
+void TimestampColumn::populate_ordered_index()
+{
+    REALM_ASSERT(has_ordered_index());
+    m_ordered_index->populate(size(), [this](size_t row_ndx) { return get(row_ndx); }); // Throws
+}
+
+OrderedIndex* TimestampColumn::create_ordered_index()
+{
+    REALM_ASSERT(!has_ordered_index());
+    m_ordered_index.reset(new OrderedIndex(nullptr, 0, get_alloc())); // Throws
+    populate_ordered_index();                                         // Throws
+    return m_ordered_index.get();
+}
+
+void TimestampColumn::destroy_ordered_index() noexcept
+{
+    m_ordered_index.reset();
+}
+
+void TimestampColumn::set_ordered_index_ref(ref_type ref, ArrayParent* parent, size_t ndx_in_parent)
+{
+    REALM_ASSERT(!m_ordered_index);
+    m_ordered_index.reset(new OrderedIndex(ref, parent, ndx_in_parent, get_alloc())); // Throws
+}
+
 
 ref_type TimestampColumn::write(size_t /*slice_offset*/, size_t /*slice_size*/, size_t /*table_size*/,
                                 _impl::OutputStream&) const
@@ -298,6 +356,9 @@ void TimestampColumn::set_ndx_in_parent(size_t ndx) noexcept
     if (has_search_index()) {
         m_search_index->set_ndx_in_parent(ndx + 1);
     }
+    if (has_ordered_index()) {
+        m_ordered_index->set_ndx_in_parent(ndx + 1);
+    }
 }
 
 void TimestampColumn::update_from_parent(size_t old_baseline) noexcept
@@ -309,6 +370,9 @@ void TimestampColumn::update_from_parent(size_t old_baseline) noexcept
     if (has_search_index()) {
         m_search_index->update_from_parent(old_baseline);
     }
+    if (has_ordered_index()) {
+        m_ordered_index->update_from_parent(old_baseline);
+    }
 }
 
 void TimestampColumn::refresh_accessor_tree(size_t new_col_ndx, const Spec& spec)
@@ -323,6 +387,9 @@ void TimestampColumn::refresh_accessor_tree(size_t new_col_ndx, const Spec& spec
     if (has_search_index()) {
         m_search_index->refresh_accessor_tree(new_col_ndx, spec); // Throws
     }
+    if (has_ordered_index()) {
+        m_ordered_index->refresh_accessor_tree(new_col_ndx, spec); // Throws
+    }
 }
 
 // LCOV_EXCL_START ignore debug functions
@@ -370,6 +437,10 @@ void TimestampColumn::add(const Timestamp& ts)
         size_t ndx = size() - 1;                  // Slow
         m_search_index->insert(ndx, ts, 1, true); // Throws
     }
+    if (has_ordered_index()) {
+        size_t ndx = size() - 1;                   // Slow
+        m_ordered_index->insert(ndx, ts, 1, true); // Throws
+    }
 }
 
 Timestamp TimestampColumn::get(size_t row_ndx) const noexcept
@@ -390,6 +461,9 @@ void TimestampColumn::set(size_t row_ndx, const Timestamp& ts)
     if (has_search_index()) {
         m_search_index->set(row_ndx, ts); // Throws
     }
+    if (has_ordered_index()) {
+        m_ordered_index->set(row_ndx, get(row_ndx), ts); // Throws
+    }
 
     m_seconds->set(row_ndx, seconds);         // Throws
     m_nanoseconds->set(row_ndx, nanoseconds); // Throws
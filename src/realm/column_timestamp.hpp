@@ -74,6 +74,23 @@ public:
         return true;
     }
 
+    bool has_ordered_index() const noexcept final
+    {
+        return bool(m_ordered_index);
+    }
+    OrderedIndex* get_ordered_index() noexcept final
+    {
+        return m_ordered_index.get();
+    }
+    const OrderedIndex* get_ordered_index() const noexcept final
+    {
+        return m_ordered_index.get();
+    }
+    void destroy_ordered_index() noexcept override;
+    void set_ordered_index_ref(ref_type ref, ArrayParent* parent, size_t ndx_in_parent) final;
+    void populate_ordered_index();
+    OrderedIndex* create_ordered_index() override;
+
     StringData get_index_data(size_t, StringIndex::StringConversionBuffer& buffer) const noexcept override;
     ref_type write(size_t slice_offset, size_t slice_size, size_t table_size, _impl::OutputStream&) const override;
     void update_from_parent(size_t old_baseline) noexcept override;
@@ -96,6 +113,11 @@ public:
     size_t count(Timestamp) const;
     void erase(size_t row_ndx, bool is_last);
 
+    /// Get the leaf of the seconds component that contains the specified row.
+    /// See BpTree::get_leaf().
+    void get_seconds_leaf(size_t ndx, size_t& ndx_in_leaf,
+                          BpTree<util::Optional<int64_t>>::LeafInfo& inout_leaf) const noexcept;
+
     template <class Condition>
     size_t find(Timestamp value, size_t begin, size_t end) const noexcept
     {
@@ -118,6 +140,7 @@ private:
     std::unique_ptr<BpTree<int64_t>> m_nanoseconds;
 
     std::unique_ptr<StringIndex> m_search_index;
+    std::unique_ptr<OrderedIndex> m_ordered_index;
     bool m_nullable;
 
     template <class BT>
@@ -61,7 +61,12 @@ enum ColumnAttr {
     col_attr_StrongLinks = 8,
 
     /// Specifies that elements in the column can be null.
-    col_attr_Nullable = 16
+    col_attr_Nullable = 16,
+
+    /// Specifies that the column has an ordered index (see
+    /// `Table::add_ordered_index()`). It cannot be combined with
+    /// `col_attr_Indexed`.
+    col_attr_OrderedIndex = 32
 };
 
 
@@ -195,8 +195,10 @@ void Group::open(const std::string& file_path, const char* encryption_key, OpenM
     else {
         // From a technical point of view, we could upgrade the Realm file
         // format in memory here, but since upgrading can be expensive, it is
-        // currently disallowed by the SlabAlloc::validate_buffer().
-        REALM_ASSERT(target_file_format_version == current_file_format_version);
+        // currently disallowed by the SlabAlloc::validate_buffer(). Version 7
+        // files are never downgraded (see Table::encode_integer_columns()).
+        REALM_ASSERT(target_file_format_version == current_file_format_version ||
+                     current_file_format_version == 7);
     }
 
     // Make all dynamically allocated memory (space beyond the attached file) as
@@ -230,8 +232,10 @@ void Group::open(BinaryData buffer, bool take_ownership)
     else {
         // From a technical point of view, we could upgrade the Realm file
         // format in memory here, but since upgrading can be expensive, it is
-        // currently disallowed by the SlabAlloc::validate_buffer().
-        REALM_ASSERT(target_file_format_version == current_file_format_version);
+        // currently disallowed by the SlabAlloc::validate_buffer(). Version 7
+        // files are never downgraded (see Table::encode_integer_columns()).
+        REALM_ASSERT(target_file_format_version == current_file_format_version ||
+                     current_file_format_version == 7);
     }
 
     // Make all dynamically allocated memory (space beyond the attached file) as
@@ -280,6 +284,19 @@ void Group::remap_and_update_refs(ref_type new_top_ref, size_t new_file_size)
 }
 
 
+void Group::auto_optimize_tables()
+{
+    size_t num_tables = m_table_accessors.size();
+    for (size_t i = 0; i < num_tables; ++i) {
+        typedef _impl::TableFriend tf;
+        if (Table* table = m_table_accessors[i]) {
+            size_t& num_writes = m_auto_optimize_writes[std::string(get_table_name(i))]; // Throws
+            tf::auto_optimize(*table, num_writes); // Throws
+        }
+    }
+}
+
+
 void Group::attach(ref_type top_ref, bool create_group_when_missing)
 {
     REALM_ASSERT(!m_top.is_attached());
@@ -357,9 +374,12 @@ void Group::attach_shared(ref_type new_top_ref, size_t new_file_size, bool writa
 
 void Group::detach_table_accessors() noexcept
 {
-    for (const auto& table_accessor : m_table_accessors) {
-        if (Table* t = table_accessor) {
+    size_t num_tables = m_table_accessors.size();
+    for (size_t table_ndx = 0; table_ndx < num_tables; ++table_ndx) {
+        if (Table* t = m_table_accessors[table_ndx]) {
             typedef _impl::TableFriend tf;
+            if (m_snapshot_version != 0)
+                save_summaries(table_ndx, *t);
             tf::detach(*t);
             tf::unbind_ptr(*t);
         }
@@ -367,6 +387,23 @@ void Group::detach_table_accessors() noexcept
 }
 
 
+void Group::save_summaries(size_t table_ndx, Table& table) noexcept
+{
+    typedef _impl::TableFriend tf;
+    std::vector<Table::ColumnSummaries> columns = tf::take_column_summaries(table);
+    if (columns.empty())
+        return;
+    try {
+        SavedSummaries& saved = m_saved_summaries[std::string(get_table_name(table_ndx))]; // Throws
+        saved.snapshot_version = m_snapshot_version;
+        saved.columns = std::move(columns);
+    }
+    catch (...) {
+        // The summaries can always be computed again
+    }
+}
+
+
 void Group::create_empty_group()
 {
     m_top.create(Array::type_HasRefs); // Throws
@@ -543,6 +580,18 @@ Table* Group::create_table_accessor(size_t table_ndx)
     // are created. Infinite recursion due to cycles is prevented by the early
     // registration in the group accessor of inclomplete table accessors.
 
+    // Summaries that were saved when the accessors were last detached are
+    // looked up first, as this may throw.
+    std::vector<Table::ColumnSummaries> summaries;
+    if (m_snapshot_version != 0 && !m_saved_summaries.empty()) {
+        auto i = m_saved_summaries.find(std::string(get_table_name(table_ndx))); // Throws
+        if (i != m_saved_summaries.end()) {
+            if (i->second.snapshot_version == m_snapshot_version)
+                summaries = std::move(i->second.columns);
+            m_saved_summaries.erase(i);
+        }
+    }
+
     typedef _impl::TableFriend tf;
     ref_type ref = m_tables.get_as_ref(table_ndx);
     Table* table = tf::create_incomplete_accessor(m_alloc, ref, this, table_ndx); // Throws
@@ -559,6 +608,8 @@ Table* Group::create_table_accessor(size_t table_ndx)
     m_table_accessors[table_ndx] = table;
     tf::complete_accessor(*table); // Throws
     tf::unmark(*table);
+    if (!summaries.empty())
+        tf::restore_column_summaries(*table, std::move(summaries));
     return table;
 }
 
@@ -607,6 +658,8 @@ void Group::remove_table(size_t table_ndx)
     REALM_ASSERT(!int_cast_has_overflow<ref_type>(ref_64));
     ref_type ref = ref_type(ref_64);
 
+    m_auto_optimize_writes.erase(std::string(get_table_name(table_ndx))); // Throws
+
     // Remove table and move all successive tables
     m_tables.erase(table_ndx);      // Throws
     m_table_names.erase(table_ndx); // Throws
@@ -657,6 +710,12 @@ void Group::rename_table(size_t table_ndx, StringData new_name, bool require_uni
         throw LogicError(LogicError::table_index_out_of_range);
     if (require_unique_name && has_table(new_name))
         throw TableNameInUse();
+    auto i = m_auto_optimize_writes.find(std::string(get_table_name(table_ndx))); // Throws
+    if (i != m_auto_optimize_writes.end()) {
+        size_t num_writes = i->second;
+        m_auto_optimize_writes.erase(i);
+        m_auto_optimize_writes[std::string(new_name)] = num_writes; // Throws
+    }
     m_table_names.set(table_ndx, new_name);
     if (Replication* repl = m_alloc.get_replication())
         repl->rename_group_level_table(table_ndx, new_name); // Throws
@@ -1490,6 +1549,11 @@ public:
         return true; // No-op
     }
 
+    bool unenumerate_string_columns() noexcept
+    {
+        return true; // No-op
+    }
+
     bool select_descriptor(int levels, const size_t* path)
     {
         m_desc.reset();
@@ -1645,6 +1709,16 @@ public:
         return true; // No-op
     }
 
+    bool add_ordered_index(size_t) noexcept
+    {
+        return true; // No-op
+    }
+
+    bool remove_ordered_index(size_t) noexcept
+    {
+        return true; // No-op
+    }
+
     bool add_primary_key(size_t) noexcept
     {
         return true; // No-op
@@ -2067,7 +2141,7 @@ void Group::verify() const
     // Check the concistency of the allocation of the mutable memory that has
     // been marked as free
     for (const auto& free_block : m_alloc.m_free_space) {
-        mem_usage_2.add_mutable(free_block.ref, free_block.size);
+        mem_usage_2.add_mutable(free_block.first, free_block.second);
     }
     mem_usage_2.canonicalize();
     mem_usage_1.add(mem_usage_2);
@@ -598,6 +598,28 @@ private:
     typedef std::vector<Table*> table_accessors;
     mutable table_accessors m_table_accessors;
 
+    // The number of string values written to each table since it was last
+    // considered by auto_optimize_tables(), by table name. Unlike the table
+    // accessors, this survives detach(). The tables are identified by name
+    // rather than by index, as other sessions may remove or move tables
+    // between the transactions of this one.
+    std::map<std::string, size_t> m_auto_optimize_writes;
+
+    // The version of the snapshot that this group accessor is attached to, or
+    // zero if it is unknown, or if the group is being modified. It is set by
+    // SharedGroup.
+    uint_fast64_t m_snapshot_version = 0;
+
+    // The column summaries (see Table::get_column_statistics()) of the tables
+    // whose accessors were detached, by table name, along with the version of
+    // the snapshot that they describe. They are handed to the next table
+    // accessor that is created for the same table in the same snapshot.
+    struct SavedSummaries {
+        uint_fast64_t snapshot_version;
+        std::vector<Table::ColumnSummaries> columns;
+    };
+    std::map<std::string, SavedSummaries> m_saved_summaries;
+
     bool m_attached = false;
     const bool m_is_shared;
 
@@ -633,6 +655,11 @@ private:
     void remap(size_t new_file_size);
     void remap_and_update_refs(ref_type new_top_ref, size_t new_file_size);
 
+    /// Give every table that has an accessor the chance to enumerate its
+    /// string columns, or stop doing so (see Table::optimize()). Only tables
+    /// with accessors can have been modified in the current transaction.
+    void auto_optimize_tables();
+
     /// Recursively update refs stored in all cached array
     /// accessors. This includes cached array accessors in any
     /// currently attached table accessors. This ensures that the
@@ -680,6 +707,7 @@ private:
     Table* create_table_accessor(size_t table_ndx);
 
     void detach_table_accessors() noexcept; // Idempotent
+    void save_summaries(size_t table_ndx, Table&) noexcept;
 
     void mark_all_table_accessors() noexcept;
 
@@ -1253,6 +1281,16 @@ public:
         group.remap_and_update_refs(new_top_ref, new_file_size); // Throws
     }
 
+    static void set_snapshot_version(Group& group, uint_fast64_t version) noexcept
+    {
+        group.m_snapshot_version = version;
+    }
+
+    static void auto_optimize_tables(Group& group)
+    {
+        group.auto_optimize_tables(); // Throws
+    }
+
     static void advance_transact(Group& group, ref_type new_top_ref, size_t new_file_size,
                                  _impl::NoCopyInputStream& in)
     {
@@ -19,8 +19,11 @@
 #include <algorithm>
 #include <atomic>
 #include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <fcntl.h>
 #include <iostream>
+#include <map>
 #include <mutex>
 #include <sstream>
 #include <type_traits>
@@ -38,8 +41,6 @@
 #include <realm/disable_sync_to_disk.hpp>
 
 #ifndef _WIN32
-#include <sys/wait.h>
-#include <sys/time.h>
 #include <unistd.h>
 #else
 #include <windows.h>
@@ -54,12 +55,6 @@ using Durability = SharedGroupOptions::Durability;
 
 namespace {
 
-// Constants controlling the amount of uncommited writes in flight:
-#ifdef REALM_ASYNC_DAEMON
-const uint16_t max_write_slots = 100;
-const uint16_t relaxed_sync_threshold = 50;
-#endif
-
 // value   change
 // --------------------
 // 4       Unknown
@@ -70,7 +65,12 @@ const uint16_t relaxed_sync_threshold = 50;
 //         changing `daemon_started` and `daemon_ready` from 1-bit to 8-bit
 //         fields.
 // 8       Placing the commitlog history inside the Realm file.
-const uint_fast16_t g_shared_info_version = 8;
+// 9       Introducing `group_commit`, `durable_version`, `durable_reader_idx`
+//         and the sync mutex.
+// 10      Replacing the async commit daemon by an in-process flusher, which
+//         removes `free_write_slots`, `daemon_started`, `daemon_ready`, the
+//         balance mutex, and the condition variables of the daemon.
+const uint_fast16_t g_shared_info_version = 10;
 
 // The following functions are carefully designed for minimal overhead
 // in case of contention among read transactions. In case of contention,
@@ -445,8 +445,8 @@ struct alignas(8) SharedGroup::SharedInfo {
     /// SharedInfoUnchangingLayout can have its layout changed.
     uint16_t shared_info_version = g_shared_info_version; // Offset 6
 
-    uint16_t durability;           // Offset 8
-    uint16_t free_write_slots = 0; // Offset 10
+    uint16_t durability; // Offset 8
+    uint16_t filler_0;   // Offset 10
 
     /// Number of participating shared groups
     uint32_t num_participants = 0; // Offset 12
@@ -471,36 +471,35 @@ struct alignas(8) SharedGroup::SharedInfo {
     /// sync agent can be started.
     uint8_t sync_agent_present = 0; // Offset 40
 
-    /// Set when a participant decides to start the daemon, cleared by the
-    /// daemon when it decides to exit. Participants check during open() and
-    /// start the daemon if running in async mode.
-    uint8_t daemon_started = 0; // Offset 41
-
-    /// Set by the daemon when it is ready to handle commits. Participants must
-    /// wait during open() on 'daemon_becomes_ready' for this to become true.
-    /// Cleared by the daemon when it decides to exit.
-    uint8_t daemon_ready = 0; // Offset 42
+    uint8_t filler_1; // Offset 41
+    uint8_t filler_2; // Offset 42
 
-    uint8_t filler_1;  // Offset 43
-    uint32_t filler_2; // Offset 44
+    /// Set when the session uses group commit (see
+    /// SharedGroupOptions::group_commit). Like `durability`, it is fixed from
+    /// creation.
+    uint8_t group_commit = 0; // Offset 43
+    uint32_t filler_3;        // Offset 44
 
     InterprocessMutex::SharedPart shared_writemutex; // Offset 48
-#ifdef REALM_ASYNC_DAEMON
-    InterprocessMutex::SharedPart shared_balancemutex;
-#endif
     InterprocessMutex::SharedPart shared_controlmutex;
+    InterprocessMutex::SharedPart shared_syncmutex;
 #ifndef _WIN32
     // FIXME: windows pthread support for condvar not ready
-    InterprocessCondVar::SharedPart room_to_write;
-    InterprocessCondVar::SharedPart work_to_do;
-    InterprocessCondVar::SharedPart daemon_becomes_ready;
     InterprocessCondVar::SharedPart new_commit_available;
 #endif
 
+    /// In group commit and async mode, the latest version that has been made
+    /// durable, and the index of its entry in the ringbuffer. The durable
+    /// version is kept bound (its read count is incremented) until a later
+    /// version has been made durable, so that its space is not reused by
+    /// commits that are not yet durable. Guarded by the syncmutex.
+    uint64_t durable_version = 0;
+    uint32_t durable_reader_idx = 0;
+
     // IMPORTANT: The ringbuffer MUST be the last field in SharedInfo - see above.
     Ringbuffer readers;
 
-    SharedInfo(Durability, Replication::HistoryType);
+    SharedInfo(Durability, bool group_commit, Replication::HistoryType);
     ~SharedInfo() noexcept
     {
     }
@@ -521,27 +520,21 @@ struct alignas(8) SharedGroup::SharedInfo {
 };
 
 
-SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht)
+SharedGroup::SharedInfo::SharedInfo(Durability dura, bool group_commit_enabled, Replication::HistoryType ht)
     : size_of_mutex(sizeof(shared_writemutex))
 #ifndef _WIN32
-    , size_of_condvar(sizeof(room_to_write))
+    , size_of_condvar(sizeof(new_commit_available))
 #endif
     , shared_writemutex() // Throws
-#ifdef REALM_ASYNC_DAEMON
-    , shared_balancemutex() // Throws
-#endif
     , shared_controlmutex() // Throws
+    , shared_syncmutex()    // Throws
 {
     durability = static_cast<uint16_t>(dura); // durability level is fixed from creation
+    group_commit = (group_commit_enabled && dura == Durability::Full ? 1 : 0);
     REALM_ASSERT(!util::int_cast_has_overflow<decltype(history_type)>(ht + 0));
     history_type = ht;
 #ifndef _WIN32
     InterprocessCondVar::init_shared_part(new_commit_available); // Throws
-#ifdef REALM_ASYNC_DAEMON
-    InterprocessCondVar::init_shared_part(room_to_write);        // Throws
-    InterprocessCondVar::init_shared_part(work_to_do);           // Throws
-    InterprocessCondVar::init_shared_part(daemon_becomes_ready); // Throws
-#endif
 #endif
 
     // IMPORTANT: The offsets, types (, and meanings) of these members must
@@ -565,8 +558,8 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
             offsetof(SharedInfo, file_format_version) == 4 &&
             std::is_same<decltype(file_format_version), uint8_t>::value && offsetof(SharedInfo, history_type) == 5 &&
             std::is_same<decltype(history_type), int8_t>::value && offsetof(SharedInfo, durability) == 8 &&
-            std::is_same<decltype(durability), uint16_t>::value && offsetof(SharedInfo, free_write_slots) == 10 &&
-            std::is_same<decltype(free_write_slots), uint16_t>::value &&
+            std::is_same<decltype(durability), uint16_t>::value && offsetof(SharedInfo, filler_0) == 10 &&
+            std::is_same<decltype(filler_0), uint16_t>::value &&
             offsetof(SharedInfo, num_participants) == 12 &&
             std::is_same<decltype(num_participants), uint32_t>::value &&
             offsetof(SharedInfo, latest_version_number) == 16 &&
@@ -577,111 +570,183 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
             std::is_same<decltype(number_of_versions), uint64_t>::value &&
             offsetof(SharedInfo, sync_agent_present) == 40 &&
             std::is_same<decltype(sync_agent_present), uint8_t>::value &&
-            offsetof(SharedInfo, daemon_started) == 41 && std::is_same<decltype(daemon_started), uint8_t>::value &&
-            offsetof(SharedInfo, daemon_ready) == 42 && std::is_same<decltype(daemon_ready), uint8_t>::value &&
-            offsetof(SharedInfo, filler_1) == 43 && std::is_same<decltype(filler_1), uint8_t>::value &&
-            offsetof(SharedInfo, filler_2) == 44 && std::is_same<decltype(filler_2), uint32_t>::value &&
+            offsetof(SharedInfo, filler_1) == 41 && std::is_same<decltype(filler_1), uint8_t>::value &&
+            offsetof(SharedInfo, filler_2) == 42 && std::is_same<decltype(filler_2), uint8_t>::value &&
+            offsetof(SharedInfo, group_commit) == 43 && std::is_same<decltype(group_commit), uint8_t>::value &&
+            offsetof(SharedInfo, filler_3) == 44 && std::is_same<decltype(filler_3), uint32_t>::value &&
             offsetof(SharedInfo, shared_writemutex) == 48 &&
             std::is_same<decltype(shared_writemutex), InterprocessMutex::SharedPart>::value,
         "Caught layout change requiring SharedInfo file format bumping");
 }
 
 
-namespace {
+/// Makes the commits of SharedGroup objects that use Durability::Async durable
+/// in the background. There is one instance per Realm file per process, shared
+/// by all the SharedGroup objects in the process that have the file open. As a
+/// SharedGroup object must not be used by more than one thread at a time, the
+/// flusher thread uses a SharedGroup object of its own.
+///
+/// The flusher makes all versions committed so far durable whenever the flush
+/// interval has passed, or when the commits of the process have written more
+/// than the flush threshold since the last flush. It also does so when it is
+/// destroyed, that is, when the last SharedGroup object of the file in the
+/// process is closed.
+class SharedGroup::AsyncFlusher {
+public:
+    AsyncFlusher(const std::string& path, const SharedGroupOptions&);
+    ~AsyncFlusher() noexcept;
+
+    /// Get the flusher for the specified file, creating it if it does not
+    /// exist already. The options of the SharedGroup object that creates the
+    /// flusher determine the flush interval and threshold.
+    static std::shared_ptr<AsyncFlusher> get(const std::string& path, const SharedGroupOptions&);
 
+    /// Called after each commit with the number of bytes that it wrote.
+    void add_written_size(size_t) noexcept;
 
-#ifdef REALM_ASYNC_DAEMON
+    const SharedGroupOptions& get_options() const noexcept;
 
-void spawn_daemon(const std::string& file)
+private:
+    std::unique_ptr<char[]> m_encryption_key;
+    SharedGroupOptions m_options;
+    SharedGroup m_shared_group;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    size_t m_unflushed_size = 0; // Protected by m_mutex
+    bool m_stop = false;         // Protected by m_mutex
+
+    util::Thread m_thread;
+
+    void run() noexcept;
+    void flush() noexcept;
+};
+
+
+SharedGroup::AsyncFlusher::AsyncFlusher(const std::string& path, const SharedGroupOptions& options)
+    : m_options(options)
+    , m_shared_group(SharedGroup::unattached_tag())
 {
-    // determine maximum number of open descriptors
-    errno = 0;
-    int m = int(sysconf(_SC_OPEN_MAX));
-    if (m < 0) {
-        if (errno) {
-            int err = errno; // Eliminate any risk of clobbering
-            throw std::runtime_error(get_errno_msg("'sysconf(_SC_OPEN_MAX)' failed: ", err));
-        }
-        throw std::runtime_error("'sysconf(_SC_OPEN_MAX)' failed with no reason");
+    // The options may refer to a key that does not outlive the SharedGroup
+    // object that created the flusher
+    if (options.encryption_key) {
+        const size_t key_size = 64;
+        m_encryption_key.reset(new char[key_size]); // Throws
+        std::copy_n(options.encryption_key, key_size, m_encryption_key.get());
     }
+    m_options.encryption_key = m_encryption_key.get();
+    m_options.allow_file_format_upgrade = false;
+    m_options.upgrade_callback = nullptr;
+
+    bool no_create = true;
+    bool is_backend = true;
+    m_shared_group.do_open(path, no_create, is_backend, m_options); // Throws
+    m_thread.start([this] { run(); });                             // Throws
+}
 
-    int pid = fork();
-    if (0 == pid) { // child process:
-
-        // close all descriptors:
-        int i;
-        for (i = m - 1; i >= 0; --i)
-            close(i);
-        i = ::open("/dev/null", O_RDWR);
-#ifdef REALM_ENABLE_LOGFILE
-        // FIXME: Do we want to always open the log file? Should it be configurable?
-        i = ::open((file + ".log").c_str(), O_RDWR | O_CREAT | O_APPEND | O_SYNC, S_IRWXU);
-#else
-        i = dup(i);
-#endif
-        i = dup(i);
-        static_cast<void>(i);
-#ifdef REALM_ENABLE_LOGFILE
-        std::cerr << "Detaching" << std::endl;
-#endif
-        // detach from current session:
-        setsid();
-
-        // start commit daemon executable
-        // Note that getenv (which is not thread safe) is called in a
-        // single threaded context. This is ensured by the fork above.
-        const char* async_daemon = getenv("REALM_ASYNC_DAEMON");
-        if (!async_daemon) {
-#ifndef REALM_DEBUG
-            async_daemon = REALM_INSTALL_LIBEXECDIR "/realmd";
-#else
-            async_daemon = REALM_INSTALL_LIBEXECDIR "/realmd-dbg";
-#endif
-        }
-        execl(async_daemon, async_daemon, file.c_str(), static_cast<char*>(0));
 
-// if we continue here, exec has failed so return error
-// if exec succeeds, we don't come back here.
-#if REALM_ANDROID
-        _exit(1);
+SharedGroup::AsyncFlusher::~AsyncFlusher() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+
+std::shared_ptr<SharedGroup::AsyncFlusher> SharedGroup::AsyncFlusher::get(const std::string& path,
+                                                                          const SharedGroupOptions& options)
+{
+    // Flushers are keyed by the identity of the file rather than by its path,
+    // so that a file opened through different paths (relative, or via
+    // symbolic links) still gets a single flusher.
+#ifndef _WIN32
+    using FileKey = util::File::UniqueID;
+    FileKey key;
+    if (!util::File::get_unique_id(path, key)) // Throws
+        throw util::File::NotFound("Realm file not found", path);
 #else
-        _Exit(1);
+    // File::get_unique_id() is not yet supported on Windows
+    using FileKey = std::string;
+    FileKey key = path;
 #endif
-        // child process ends here
-    }
-    else if (pid > 0) { // parent process, fork succeeded:
 
-        // use childs exit code to catch and report any errors:
-        int status;
-        int pid_changed;
-        do {
-            pid_changed = waitpid(pid, &status, 0);
-        } while (pid_changed == -1 && errno == EINTR);
-        if (pid_changed != pid) {
-            std::cerr << "Waitpid returned pid = " << pid_changed << " and status = " << std::hex << status
-                      << std::endl;
-            throw std::runtime_error("call to waitpid failed");
-        }
-        if (!WIFEXITED(status))
-            throw std::runtime_error("failed starting async commit (exit)");
-        if (WEXITSTATUS(status) == 1) {
-            // FIXME: Or `ld` could not find a required shared library
-            throw std::runtime_error("async commit daemon not found");
+    // Never destroyed, as flushers may be released during static destruction
+    static util::Mutex& mutex = *new util::Mutex;
+    static auto& flushers = *new std::map<FileKey, std::weak_ptr<AsyncFlusher>>;
+
+    LockGuard lock(mutex);
+    std::shared_ptr<AsyncFlusher> flusher = flushers[key].lock();
+    if (!flusher) {
+        for (auto i = flushers.begin(); i != flushers.end();) {
+            if (i->second.expired()) {
+                i = flushers.erase(i);
+            }
+            else {
+                ++i;
+            }
         }
-        if (WEXITSTATUS(status) == 2)
-            throw std::runtime_error("async commit daemon failed");
-        if (WEXITSTATUS(status) == 3)
-            throw std::runtime_error("wrong db given to async daemon");
+        flusher = std::make_shared<AsyncFlusher>(path, options); // Throws
+        flushers[key] = flusher;
     }
-    else { // Parent process, fork failed!
+    return flusher;
+}
 
-        throw std::runtime_error("Failed to spawn async commit");
+
+void SharedGroup::AsyncFlusher::add_written_size(size_t size) noexcept
+{
+    bool notify;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_unflushed_size += size;
+        notify = (m_options.async_flush_threshold != 0 && m_unflushed_size >= m_options.async_flush_threshold);
     }
+    if (notify)
+        m_cond.notify_all();
 }
-#endif
 
 
-} // anonymous namespace
+inline const SharedGroupOptions& SharedGroup::AsyncFlusher::get_options() const noexcept
+{
+    return m_options;
+}
+
+
+void SharedGroup::AsyncFlusher::run() noexcept
+{
+    util::Thread::set_name("realm-flusher");
+
+    size_t threshold = m_options.async_flush_threshold;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        auto deadline = std::chrono::steady_clock::now() + m_options.async_flush_interval;
+        m_cond.wait_until(lock, deadline,
+                          [&] { return m_stop || (threshold != 0 && m_unflushed_size >= threshold); });
+        bool stop = m_stop;
+        m_unflushed_size = 0;
+        lock.unlock();
+        flush();
+        if (stop)
+            return;
+        lock.lock();
+    }
+}
+
+
+void SharedGroup::AsyncFlusher::flush() noexcept
+{
+    try {
+        m_shared_group.make_durable(m_shared_group.get_version_of_latest_snapshot()); // Throws
+    }
+    catch (...) {
+        // Nothing can be reported from here. The flush is retried after the
+        // next interval, and SharedGroup::wait_until_durable() reports the
+        // error if it persists.
+    }
+}
+
 
 #if !REALM_UWP
 const std::string SharedGroupOptions::sys_tmp_dir = getenv("TMPDIR") ? getenv("TMPDIR") : "";
@@ -719,16 +784,12 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
 
     REALM_ASSERT(!is_attached());
 
-#ifndef REALM_ASYNC_DAEMON
-    if (options.durability == Durability::Async)
-        throw std::runtime_error("Async mode not yet supported on Windows, iOS and watchOS");
-#endif
-
     m_db_path = path;
     m_coordination_dir = path + ".management";
     m_lockfile_path = path + ".lock";
     try_make_dir(m_coordination_dir);
     m_key = options.encryption_key;
+    m_auto_optimize = options.auto_optimize;
     m_lockfile_prefix = m_coordination_dir + "/access_control";
     SlabAlloc& alloc = m_group.m_alloc;
 
@@ -762,8 +823,8 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             // due to the bit field members. Otherwise we would write
             // uninitialized bits to the file.
             alignas(SharedInfo) char buffer[sizeof(SharedInfo)] = {0};
-            new (buffer) SharedInfo{options.durability, history_type}; // Throws
-            m_file.write(buffer, sizeof buffer);                       // Throws
+            new (buffer) SharedInfo{options.durability, options.group_commit, history_type}; // Throws
+            m_file.write(buffer, sizeof buffer);                                             // Throws
 
             // Mark the file as completely initialized via a memory
             // mapping. Since this is done as a separate final step (involving
@@ -851,9 +912,10 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             throw IncompatibleLockFile(ss.str());
         }
 #ifndef _WIN32
-        if (info->size_of_condvar != sizeof info->room_to_write) {
+        if (info->size_of_condvar != sizeof info->new_commit_available) {
             std::stringstream ss;
-            ss << "Condtion var size doesn't match: " << info->size_of_condvar << " " << sizeof(info->room_to_write)
+            ss << "Condtion var size doesn't match: " << info->size_of_condvar << " "
+               << sizeof(info->new_commit_available)
                << ".";
             throw IncompatibleLockFile(ss.str());
         }
@@ -874,10 +936,8 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
         // again and prevent us from being notified below.
 
         m_writemutex.set_shared_part(info->shared_writemutex, m_lockfile_prefix, "write");
-#ifdef REALM_ASYNC_DAEMON
-        m_balancemutex.set_shared_part(info->shared_balancemutex, m_lockfile_prefix, "balance");
-#endif
         m_controlmutex.set_shared_part(info->shared_controlmutex, m_lockfile_prefix, "control");
+        m_syncmutex.set_shared_part(info->shared_syncmutex, m_lockfile_prefix, "sync");
 
         // even though fields match wrt alignment and size, there may still be incompatibilities
         // between implementations, so lets ask one of the mutexes if it thinks it'll work.
@@ -888,8 +948,6 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
         // OK! lock file appears valid. We can now continue operations under the protection
         // of the controlmutex. The controlmutex protects the following activities:
         // - attachment of the database file
-        // - start of the async daemon
-        // - stop of the async daemon
         // - SharedGroup beginning/ending a session
         // - Waiting for and signalling database changes
         {
@@ -909,6 +967,14 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             // proceed to initialize versioning and other metadata information related to
             // the database. Also create the database if we're beginning a new session
             bool begin_new_session = (info->num_participants == 0);
+
+            // The SharedGroup of the async flusher (see AsyncFlusher) joins a
+            // session that was begun by another participant, and adopts its
+            // history type, since it never writes.
+            REALM_ASSERT(!is_backend || !begin_new_session);
+            if (is_backend)
+                history_type = Replication::HistoryType(info->history_type);
+
             SlabAlloc::Config cfg;
             cfg.session_initiator = begin_new_session;
             cfg.is_shared = true;
@@ -993,13 +1059,24 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                 SharedInfo* r_info = m_reader_map.get_addr();
                 size_t file_size = alloc.get_baseline();
                 r_info->init_versioning(top_ref, file_size, version);
+
+                // In group commit and async mode, the initial version is the
+                // durable one, and must be kept bound until a later version
+                // becomes durable.
+                if (info->group_commit || Durability(info->durability) == Durability::Async) {
+                    ReadLockInfo durable_lock;
+                    grab_read_lock(durable_lock, VersionID()); // Throws
+                    info->durable_version = durable_lock.m_version;
+                    info->durable_reader_idx = durable_lock.m_reader_idx;
+                }
             }
             else { // Not the session initiator
                 // Durability setting must be consistent across a session. An
                 // inconsistency is a logic error, as the user is required to
                 // make sure that all possible concurrent session participants
                 // use the same durability setting for the same Realm file.
-                if (Durability(info->durability) != options.durability)
+                bool group_commit = (options.group_commit && options.durability == Durability::Full);
+                if (Durability(info->durability) != options.durability || (info->group_commit != 0) != group_commit)
                     throw LogicError(LogicError::mixed_durability);
 
                 // History type must be consistent across a session. An
@@ -1047,30 +1124,6 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
 #ifndef _WIN32
             m_new_commit_available.set_shared_part(info->new_commit_available, m_lockfile_prefix, "new_commit",
                                                    options.temp_dir);
-#ifdef REALM_ASYNC_DAEMON
-            if (options.durability == Durability::Async) {
-                m_daemon_becomes_ready.set_shared_part(info->daemon_becomes_ready, m_lockfile_prefix,
-                                                       "daemon_ready", options.temp_dir);
-                m_work_to_do.set_shared_part(info->work_to_do, m_lockfile_prefix,
-                                             "work_ready", options.temp_dir);
-                m_room_to_write.set_shared_part(info->room_to_write, m_lockfile_prefix,
-                                                "allow_write", options.temp_dir);
-                // In async mode, we need to make sure the daemon is running and ready:
-                if (!is_backend) {
-                    while (info->daemon_ready == 0) {
-                        if (info->daemon_started == 0) {
-                            spawn_daemon(path);
-                            info->daemon_started = 1;
-                        }
-                        // FIXME: It might be more robust to sleep a little, then restart the loop
-                        // std::cerr << "Waiting for daemon" << std::endl;
-                        m_daemon_becomes_ready.wait(m_controlmutex, 0);
-                        // std::cerr << " - notified" << std::endl;
-                    }
-                }
-            }
-// std::cerr << "daemon should be ready" << std::endl;
-#endif // REALM_ASYNC_DAEMON
 #endif // !defined _WIN32
 
             // Set initial version so we can track if other instances
@@ -1100,15 +1153,6 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
     m_transact_stage = transact_Ready;
 // std::cerr << "open completed" << std::endl;
 
-#ifdef REALM_ASYNC_DAEMON
-    if (options.durability == Durability::Async) {
-        if (is_backend) {
-            do_async_commits();
-        }
-    }
-#else
-    static_cast<void>(is_backend);
-#endif
 
     try {
         using gf = _impl::GroupFriend;
@@ -1127,6 +1171,9 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
         else {
             upgrade_file_format(options.allow_file_format_upgrade, target_file_format_version); // Throws
         }
+
+        if (options.durability == Durability::Async && !is_backend)
+            m_async_flusher = AsyncFlusher::get(path, options); // Throws
     }
     catch (...) {
         close();
@@ -1149,13 +1196,32 @@ bool SharedGroup::compact()
     if (m_transact_stage != transact_Ready) {
         throw std::runtime_error(m_db_path + ": compact is not supported whithin a transaction");
     }
-    Durability dura;
+    SharedGroupOptions new_options;
+    new_options.encryption_key = m_key;
+    new_options.allow_file_format_upgrade = false;
+    {
+        SharedInfo* info = m_file_map.get_addr();
+        new_options.durability = Durability(info->durability);
+        new_options.group_commit = (info->group_commit != 0);
+    }
+    // The async flusher is a session participant of its own, so it must be
+    // released before checking that this is the only participant. It stays
+    // alive if other SharedGroup objects in this process use it.
+    if (m_async_flusher) {
+        new_options.async_flush_interval = m_async_flusher->get_options().async_flush_interval;
+        new_options.async_flush_threshold = m_async_flusher->get_options().async_flush_threshold;
+        m_async_flusher.reset();
+    }
     std::string tmp_path = m_db_path + ".tmp_compaction_space";
     {
         SharedInfo* info = m_file_map.get_addr();
-        std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
-        if (info->num_participants > 1)
+        std::unique_lock<InterprocessMutex> lock(m_controlmutex); // Throws
+        if (info->num_participants > 1) {
+            lock.unlock();
+            if (new_options.durability == Durability::Async)
+                m_async_flusher = AsyncFlusher::get(m_db_path, new_options); // Throws
             return false;
+        }
 
         // group::write() will throw if the file already exists.
         // To prevent this, we have to remove the file (should it exist)
@@ -1186,7 +1252,6 @@ bool SharedGroup::compact()
             static_cast<void>(rc); // rc unused if ENABLE_ASSERTION is unset
         }
         end_read();
-        dura = Durability(info->durability);
         // We need to release any shared mapping *before* releasing the control mutex.
         // When someone attaches to the new database file, they *must* *not* see and
         // reuse any existing memory mapping of the stale file.
@@ -1197,14 +1262,31 @@ bool SharedGroup::compact()
     util::File::copy(tmp_path, m_db_path);
 #endif
 
-    SharedGroupOptions new_options;
-    new_options.durability = dura;
-    new_options.encryption_key = m_key;
-    new_options.allow_file_format_upgrade = false;
     do_open(m_db_path, true, false, new_options);
     return true;
 }
 
+size_t SharedGroup::compact_step(size_t max_relocated_size)
+{
+    if (m_transact_stage != transact_Ready)
+        throw LogicError(LogicError::wrong_transact_state);
+    REALM_ASSERT(max_relocated_size > 0);
+
+    begin_write(); // Throws
+    m_max_relocated_size = max_relocated_size;
+    m_relocated_size = 0;
+    try {
+        commit(); // Throws
+    }
+    catch (...) {
+        m_max_relocated_size = 0;
+        rollback();
+        throw;
+    }
+    m_max_relocated_size = 0;
+    return m_relocated_size;
+}
+
 uint_fast64_t SharedGroup::get_number_of_versions()
 {
     SharedInfo* info = m_file_map.get_addr();
@@ -1234,6 +1316,10 @@ void SharedGroup::close() noexcept
     }
     m_group.detach();
     m_transact_stage = transact_Ready;
+
+    // If this is the last SharedGroup object of the file in this process, the
+    // async flusher makes the remaining commits durable before it closes.
+    m_async_flusher.reset();
     SharedInfo* info = m_file_map.get_addr();
     {
         bool is_sync_agent = false;
@@ -1270,11 +1356,6 @@ void SharedGroup::close() noexcept
         }
     }
 #ifndef _WIN32
-#ifdef REALM_ASYNC_DAEMON
-    m_room_to_write.close();
-    m_work_to_do.close();
-    m_daemon_becomes_ready.close();
-#endif
     m_new_commit_available.close();
 #endif
     // On Windows it is important that we unmap before unlocking, else a SetEndOfFile() call from another thread may
@@ -1318,109 +1399,6 @@ void SharedGroup::enable_wait_for_change()
     m_wait_for_change_enabled = true;
 }
 
-#ifdef REALM_ASYNC_DAEMON
-void SharedGroup::do_async_commits()
-{
-    bool shutdown = false;
-    SharedInfo* info = m_file_map.get_addr();
-
-    // We always want to keep a read lock on the last version
-    // that was commited to disk, to protect it against being
-    // overwritten by commits being made to memory by others.
-    {
-        VersionID version_id = VersionID();      // Latest available snapshot
-        grab_read_lock(m_read_lock, version_id); // Throws
-    }
-    // we must treat version and version_index the same way:
-    {
-        std::lock_guard<InterprocessMutex> lock(m_controlmutex);
-        info->free_write_slots = max_write_slots;
-        info->daemon_ready = 1;
-        m_daemon_becomes_ready.notify_all();
-    }
-    using gf = _impl::GroupFriend;
-    gf::detach(m_group);
-
-    while (true) {
-        if (m_file.is_removed()) { // operator removed the lock file. take a hint!
-
-            shutdown = true;
-#ifdef REALM_ENABLE_LOGFILE
-            std::cerr << "Lock file removed, initiating shutdown" << std::endl;
-#endif
-        }
-
-        bool is_same;
-        ReadLockInfo next_read_lock = m_read_lock;
-        {
-            // detect if we're the last "client", and if so, shutdown (must be under lock):
-            std::lock_guard<InterprocessMutex> lock2(m_writemutex);
-            std::lock_guard<InterprocessMutex> lock(m_controlmutex);
-            version_type old_version = next_read_lock.m_version;
-            VersionID version_id = VersionID(); // Latest available snapshot
-            grab_read_lock(next_read_lock, version_id);
-            is_same = (next_read_lock.m_version == old_version);
-            if (is_same && (shutdown || info->num_participants == 1)) {
-#ifdef REALM_ENABLE_LOGFILE
-                std::cerr << "Daemon exiting nicely" << std::endl << std::endl;
-#endif
-                release_read_lock(next_read_lock);
-                release_read_lock(m_read_lock);
-                info->daemon_started = 0;
-                info->daemon_ready = 0;
-                return;
-            }
-        }
-
-        if (!is_same) {
-
-#ifdef REALM_ENABLE_LOGFILE
-            std::cerr << "Syncing from version " << m_read_lock.m_version << " to " << next_read_lock.m_version
-                      << std::endl;
-#endif
-            GroupWriter writer(m_group);
-            writer.commit(next_read_lock.m_top_ref);
-#ifdef REALM_ENABLE_LOGFILE
-            std::cerr << "..and Done" << std::endl;
-#endif
-        }
-
-        // Now we can release the version that was previously commited
-        // to disk and just keep the lock on the latest version.
-        release_read_lock(m_read_lock);
-        m_read_lock = next_read_lock;
-
-        m_balancemutex.lock();
-
-        // We have caught up with the writers, let them know that there are
-        // now free write slots, wakeup any that has been suspended.
-        uint16_t free_write_slots = info->free_write_slots;
-        info->free_write_slots = max_write_slots;
-        if (free_write_slots <= 0) {
-            m_room_to_write.notify_all();
-        }
-
-        // If we have plenty of write slots available, relax and wait a bit before syncing
-        if (free_write_slots > relaxed_sync_threshold) {
-            timespec ts;
-            timeval tv;
-            // clock_gettime(CLOCK_REALTIME, &ts); <- would like to use this, but not there on mac
-            gettimeofday(&tv, nullptr);
-            ts.tv_sec = tv.tv_sec;
-            ts.tv_nsec = tv.tv_usec * 1000;
-            ts.tv_nsec += 10000000;         // 10 msec
-            if (ts.tv_nsec >= 1000000000) { // overflow
-                ts.tv_nsec -= 1000000000;
-                ts.tv_sec += 1;
-            }
-
-            // no timeout support if the condvars are only emulated, so this will assert
-            m_work_to_do.wait(m_balancemutex, &ts);
-        }
-        m_balancemutex.unlock();
-    }
-}
-#endif // REALM_ASYNC_DAEMON
 #endif // _WIN32
 
 
@@ -1433,7 +1411,8 @@ void SharedGroup::upgrade_file_format(bool allow_file_format_upgrade, int target
     // First a non-threadsafe but fast check
     using gf = _impl::GroupFriend;
     int current_file_format_version = gf::get_file_format_version(m_group);
-    REALM_ASSERT(current_file_format_version <= target_file_format_version);
+    // Version 7 files are never downgraded (see Table::encode_integer_columns())
+    REALM_ASSERT(current_file_format_version <= target_file_format_version || current_file_format_version == 7);
     bool maybe_upgrade = (current_file_format_version < target_file_format_version);
     if (maybe_upgrade) {
 #ifdef REALM_DEBUG
@@ -1450,10 +1429,10 @@ void SharedGroup::upgrade_file_format(bool allow_file_format_upgrade, int target
         WriteTransaction wt(*this);
         int current_file_format_version_2 = gf::get_committed_file_format_version(m_group);
         // The file must either still be using its initial file_format or have
-        // been upgraded already to the chosen target file format via a
-        // concurrent SharedGroup object.
+        // been upgraded already to the chosen target file format (or beyond)
+        // via a concurrent SharedGroup object.
         REALM_ASSERT(current_file_format_version_2 == current_file_format_version ||
-                     current_file_format_version_2 == target_file_format_version);
+                     current_file_format_version_2 >= target_file_format_version);
         bool need_upgrade = (current_file_format_version_2 < target_file_format_version);
         if (need_upgrade) {
             if (!allow_file_format_upgrade)
@@ -1477,7 +1456,7 @@ void SharedGroup::upgrade_file_format(bool allow_file_format_upgrade, int target
             // If somebody else has already performed the upgrade, we still need
             // to inform the rest of the core library about the new file format
             // of the attached file.
-            gf::set_file_format_version(m_group, target_file_format_version);
+            gf::set_file_format_version(m_group, current_file_format_version_2);
         }
     }
 }
@@ -1631,9 +1610,16 @@ SharedGroup::version_type SharedGroup::commit()
 
     version_type new_version = do_commit(); // Throws
     do_end_write();
+    // The accessors now describe the new snapshot
+    using gf = _impl::GroupFriend;
+    gf::set_snapshot_version(m_group, new_version);
     do_end_read();
 
     m_transact_stage = transact_Ready;
+
+    SharedInfo* info = m_file_map.get_addr();
+    if (info->group_commit)
+        make_durable(new_version); // Throws
     return new_version;
 }
 
@@ -1696,6 +1682,7 @@ void SharedGroup::do_begin_read(VersionID version_id, bool writable)
 
     using gf = _impl::GroupFriend;
     gf::attach_shared(m_group, m_read_lock.m_top_ref, m_read_lock.m_file_size, writable); // Throws
+    gf::set_snapshot_version(m_group, writable ? 0 : m_read_lock.m_version);
 
     g.release();
 }
@@ -1722,24 +1709,6 @@ void SharedGroup::do_begin_write()
         m_writemutex.unlock();
         throw std::runtime_error("Crash of other process detected, session restart required");
     }
-
-#ifdef REALM_ASYNC_DAEMON
-    if (info->durability == static_cast<uint16_t>(Durability::Async)) {
-
-        m_balancemutex.lock(); // Throws
-
-        // if we are running low on write slots, kick the sync daemon
-        if (info->free_write_slots < relaxed_sync_threshold)
-            m_work_to_do.notify();
-        // if we are out of write slots, wait for the sync daemon to catch up
-        while (info->free_write_slots <= 0) {
-            m_room_to_write.wait(m_balancemutex, 0);
-        }
-
-        info->free_write_slots--;
-        m_balancemutex.unlock();
-    }
-#endif // _WIN32
 }
 
 
@@ -1755,6 +1724,13 @@ Replication::version_type SharedGroup::do_commit()
 
     SharedInfo* r_info = m_reader_map.get_addr();
 
+    // Optimizing is part of the transaction, so it must happen before the
+    // changes are prepared for commit
+    if (m_auto_optimize) {
+        using gf = _impl::GroupFriend;
+        gf::auto_optimize_tables(m_group); // Throws
+    }
+
     version_type current_version = r_info->get_current_version_unchecked();
     version_type new_version = current_version + 1;
     if (Replication* repl = m_group.get_replication()) {
@@ -1803,13 +1779,56 @@ SharedGroup::version_type SharedGroup::commit_and_continue_as_read()
 
     // Remap file if it has grown, and update refs in underlying node structure
     gf::remap_and_update_refs(m_group, m_read_lock.m_top_ref, m_read_lock.m_file_size); // Throws
+    gf::set_snapshot_version(m_group, m_read_lock.m_version);
 
     m_transact_stage = transact_Reading;
 
+    SharedInfo* info = m_file_map.get_addr();
+    if (info->group_commit)
+        make_durable(version); // Throws
     return version;
 }
 
 
+void SharedGroup::wait_until_durable(version_type version)
+{
+    SharedInfo* info = m_file_map.get_addr();
+    if (Durability(info->durability) == Durability::Async)
+        make_durable(version); // Throws
+}
+
+
+void SharedGroup::make_durable(version_type version)
+{
+    SharedInfo* info = m_file_map.get_addr();
+
+    // The first one to get the sync mutex makes all versions committed so far
+    // durable. In group commit mode, this includes the versions of writers that
+    // are queued up behind it. When they get the mutex, they find that there is
+    // nothing left to do.
+    std::lock_guard<InterprocessMutex> lock(m_syncmutex); // Throws
+    if (info->durable_version >= version)
+        return;
+
+    ReadLockInfo new_durable_lock;
+    VersionID version_id = VersionID();           // Latest available snapshot
+    grab_read_lock(new_durable_lock, version_id); // Throws
+    ReadLockUnlockGuard rlug(*this, new_durable_lock);
+    REALM_ASSERT_3(new_durable_lock.m_version, >=, version);
+
+    GroupWriter::commit_written(m_group.m_alloc, new_durable_lock.m_top_ref); // Throws
+
+    // Keep the new durable version bound instead of the old one
+    ReadLockInfo old_durable_lock;
+    old_durable_lock.m_version = info->durable_version;
+    old_durable_lock.m_reader_idx = info->durable_reader_idx;
+    info->durable_version = new_durable_lock.m_version;
+    info->durable_reader_idx = new_durable_lock.m_reader_idx;
+    rlug.release();
+    release_read_lock(old_durable_lock);
+}
+
+
 bool SharedGroup::grow_reader_mapping(uint_fast32_t index)
 {
     using _impl::SimulatedFailure;
@@ -1894,24 +1913,34 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
     // info->readers.dump();
     GroupWriter out(m_group); // Throws
     out.set_versions(new_version, oldest_version);
+    if (m_max_relocated_size != 0)
+        out.enable_compaction(m_max_relocated_size);
     // Recursively write all changed arrays to end of file
     ref_type new_top_ref = out.write_group(); // Throws
+    m_relocated_size = out.get_relocated_size();
     m_free_space = out.get_free_space();
     m_used_space = out.get_file_size() - m_free_space;
     // std::cout << "Writing version " << new_version << ", Topptr " << new_top_ref
     //     << " Read lock at version " << oldest_version << std::endl;
     switch (Durability(info->durability)) {
         case Durability::Full:
-            out.commit(new_top_ref); // Throws
+            // In group commit mode, the new version is made durable by
+            // make_durable() after the write mutex has been released.
+            if (!info->group_commit)
+                out.commit(new_top_ref); // Throws
             break;
         case Durability::MemOnly:
-        case Durability::Async:
             // In Durability::MemOnly mode, we just use the file as backing for
             // the shared memory. So we never actually flush the data to disk
             // (the OS may do so opportinisticly, or when swapping). So in this
             // mode the file on disk may very likely be in an invalid state.
             break;
+        case Durability::Async:
+            // In Durability::Async mode, the new version is made durable
+            // later by the async flusher, or by wait_until_durable().
+            break;
     }
+    size_t written_size = out.get_written_size();
     size_t new_file_size = out.get_file_size();
     // Update reader info. If this fails in any way, the ringbuffer may be corrupted.
     // This can lead to other readers seing invalid data which is likely to cause them
@@ -1949,6 +1978,9 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
         m_new_commit_available.notify_all();
 #endif
     }
+
+    if (m_async_flusher)
+        m_async_flusher->add_written_size(written_size);
 }
 
 
@@ -25,6 +25,7 @@
 
 #include <functional>
 #include <limits>
+#include <memory>
 #include <realm/util/features.h>
 #include <realm/util/thread.hpp>
 #ifndef _WIN32
@@ -361,6 +362,16 @@ public:
     void get_stats(size_t& free_space, size_t& used_space);
     //@}
 
+    /// Wait until the specified version, and all earlier versions, are
+    /// durable, making them durable if the async flusher has not done so yet.
+    /// This is only needed in Durability::Async mode. In Durability::Full
+    /// mode, a version is durable when commit() returns, and in
+    /// Durability::MemOnly mode, nothing is ever made durable, so in both
+    /// cases this function returns immediately.
+    ///
+    /// \param version A version returned by commit().
+    void wait_until_durable(version_type version);
+
     enum TransactStage {
         transact_Ready,
         transact_Reading,
@@ -379,6 +390,11 @@ public:
     /// a read transaction will not immediately release any versions.
     uint_fast64_t get_number_of_versions();
 
+    /// Report how often the ref translations of this SharedGroup were found in
+    /// the translation cache that is shared by all SharedGroups attached to the
+    /// same file in this process. See SlabAlloc::get_translation_cache_stats().
+    SlabAlloc::TranslationCacheStats get_translation_cache_stats() const noexcept;
+
     /// Compact the database file.
     /// - The method will throw if called inside a transaction.
     /// - The method will throw if called in unattached state.
@@ -403,6 +419,34 @@ public:
     /// because it's not crash safe! It may corrupt your database if something fails
     bool compact();
 
+    /// Perform one step of online, incremental compaction of the database
+    /// file. Unlike compact(), this can be done while other SharedGroups, in
+    /// this or other processes, are accessing the database.
+    ///
+    /// The step is a write transaction of its own, which changes nothing but
+    /// the placement of data in the file: Array nodes near the end of the
+    /// file, up to approximately \a max_relocated_size bytes of them, are
+    /// moved to free space closer to the beginning of the file. The space they
+    /// occupied becomes free once no reader is bound to a snapshot that uses
+    /// it, and a later commit then removes free space at the end of the file
+    /// from the file. Call this function periodically, for example after
+    /// large deletions, until it returns zero.
+    ///
+    /// Every commit removes free space at the end of the file, that is no
+    /// longer used by any reader, if the file shrinks by at least an eighth.
+    /// A step of compaction removes it regardless of the amount. The file is
+    /// only truncated in Durability::Full mode without group commit, and not
+    /// if the file is encrypted, or on Windows. Otherwise, the removed space
+    /// is reused when the file needs to grow again.
+    ///
+    /// \return The approximate number of bytes relocated. Zero means that
+    /// no progress could be made, either because there is no live data left
+    /// near the end of the file, or because the free space that is not in use
+    /// by readers is too small or too fragmented.
+    ///
+    /// \throw LogicError If called inside a transaction.
+    size_t compact_step(size_t max_relocated_size = 1024 * 1024);
+
 #ifdef REALM_DEBUG
     void test_ringbuf();
 #endif
@@ -530,6 +574,8 @@ private:
     // Member variables
     size_t m_free_space = 0;
     size_t m_used_space = 0;
+    size_t m_max_relocated_size = 0; // Nonzero during compact_step()
+    size_t m_relocated_size = 0;
     Group m_group;
     ReadLockInfo m_read_lock;
     uint_fast32_t m_local_max_entry;
@@ -542,22 +588,20 @@ private:
     std::string m_db_path;
     std::string m_coordination_dir;
     const char* m_key;
+    bool m_auto_optimize = false;
     TransactStage m_transact_stage;
     util::InterprocessMutex m_writemutex;
-#ifdef REALM_ASYNC_DAEMON
-    util::InterprocessMutex m_balancemutex;
-#endif
     util::InterprocessMutex m_controlmutex;
+    util::InterprocessMutex m_syncmutex; // Serializes file header updates in group commit and async mode
 #ifndef _WIN32
-#ifdef REALM_ASYNC_DAEMON
-    util::InterprocessCondVar m_room_to_write;
-    util::InterprocessCondVar m_work_to_do;
-    util::InterprocessCondVar m_daemon_becomes_ready;
-#endif
     util::InterprocessCondVar m_new_commit_available;
 #endif
     std::function<void(int, int)> m_upgrade_callback;
 
+    class AsyncFlusher;
+    std::shared_ptr<AsyncFlusher> m_async_flusher; // Only in async mode
+
+    // \param is_backend True for the SharedGroup object of an AsyncFlusher.
     void do_open(const std::string& file, bool no_create, bool is_backend, const SharedGroupOptions options);
 
     // Ring buffer management
@@ -597,6 +641,11 @@ private:
     version_type do_commit();
     void do_end_write() noexcept;
 
+    // In group commit mode, wait until the specified version is durable,
+    // making it, and any other version committed so far, durable if no one
+    // else has done so.
+    void make_durable(version_type);
+
     /// Returns the version of the latest snapshot.
     version_type get_version_of_latest_snapshot();
 
@@ -613,8 +662,6 @@ private:
     // mutex.
     void low_level_commit(uint_fast64_t new_version);
 
-    void do_async_commits();
-
     void upgrade_file_format(bool allow_file_format_upgrade, int target_file_format_version);
 
     //@{
@@ -838,6 +885,11 @@ inline SharedGroup::TransactStage SharedGroup::get_transact_stage() const noexce
     return m_transact_stage;
 }
 
+inline SlabAlloc::TranslationCacheStats SharedGroup::get_translation_cache_stats() const noexcept
+{
+    return m_group.m_alloc.get_translation_cache_stats();
+}
+
 inline SharedGroup::version_type SharedGroup::get_version_of_bound_snapshot() const noexcept
 {
     return m_read_lock.m_version;
@@ -942,6 +994,8 @@ inline void SharedGroup::advance_read(O* observer, VersionID version_id)
         throw LogicError(LogicError::no_history);
 
     do_advance_read(observer, version_id, *hist); // Throws
+    using gf = _impl::GroupFriend;
+    gf::set_snapshot_version(m_group, m_read_lock.m_version);
 }
 
 template <class O>
@@ -955,6 +1009,8 @@ inline void SharedGroup::promote_to_write(O* observer)
         throw LogicError(LogicError::no_history);
 
     do_begin_write(); // Throws
+    using gf = _impl::GroupFriend;
+    gf::set_snapshot_version(m_group, 0);
     try {
         VersionID version = VersionID();                                  // Latest
         bool history_updated = do_advance_read(observer, version, *hist); // Throws
@@ -967,10 +1023,10 @@ inline void SharedGroup::promote_to_write(O* observer)
         // If the group has no top array (top_ref == 0), create a new node
         // structure for an empty group now, to be ready for modifications. See
         // also Group::attach_shared().
-        using gf = _impl::GroupFriend;
         gf::create_empty_group_when_missing(m_group); // Throws
     }
     catch (...) {
+        gf::set_snapshot_version(m_group, m_read_lock.m_version);
         do_end_write();
         throw;
     }
@@ -1012,6 +1068,7 @@ inline void SharedGroup::rollback_and_continue_as_read(O* observer)
     size_t file_size = m_read_lock.m_file_size;
     _impl::ReversedNoCopyInputStream reversed_in(reverser);
     gf::advance_transact(m_group, top_ref, file_size, reversed_in); // Throws
+    gf::set_snapshot_version(m_group, m_read_lock.m_version);
 
     do_end_write();
 
@@ -1131,17 +1188,6 @@ public:
         sg.rollback_and_continue_as_read(obs); // Throws
     }
 
-    static void async_daemon_open(SharedGroup& sg, const std::string& file)
-    {
-        bool no_create = true;
-        bool is_backend = true;
-        SharedGroupOptions options;
-        options.durability = SharedGroupOptions::Durability::Async;
-        options.encryption_key = nullptr;
-        options.allow_file_format_upgrade = false;
-        sg.do_open(file, no_create, is_backend, options); // Throws
-    }
-
     static int get_file_format_version(const SharedGroup& sg) noexcept
     {
         return sg.get_file_format_version();
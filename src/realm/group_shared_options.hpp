@@ -19,6 +19,9 @@
 #ifndef REALM_GROUP_SHARED_OPTIONS_HPP
 #define REALM_GROUP_SHARED_OPTIONS_HPP
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 
@@ -31,7 +34,7 @@ struct SharedGroupOptions {
     enum class Durability : uint16_t {
         Full,
         MemOnly,
-        Async ///< Not yet supported on windows.
+        Async ///< Commits are made durable later by a background thread
     };
 
     explicit SharedGroupOptions(Durability level = Durability::Full, const char* key = nullptr,
@@ -58,6 +61,48 @@ struct SharedGroupOptions {
     /// The persistence level of the Realm file. See Durability.
     Durability durability;
 
+    /// Enable group commit. Only has an effect when \a durability is
+    /// Durability::Full.
+    ///
+    /// With group commit, a write transaction releases the write lock as soon
+    /// as its changes have been written to the file, and then waits for them
+    /// to become durable. Writers that commit while a flush to stable storage
+    /// is in progress are made durable together by the next flush, with a
+    /// single update of the file header. This lets write throughput scale with
+    /// the number of concurrent writers, rather than being bounded by the
+    /// latency of synchronizing the file. Every commit still gets its own
+    /// version, and SharedGroup::commit() still only returns once that version
+    /// is durable. If making the changes durable fails, commit() throws, even
+    /// though the changes are already visible to other session participants.
+    ///
+    /// This setting must be the same for all session participants.
+    bool group_commit = false;
+
+    /// In Durability::Async mode, commit() returns without making the changes
+    /// durable. Instead, a background thread, which is shared by all
+    /// SharedGroup objects in the process that have the same file open, makes
+    /// all changes committed so far durable once every \a
+    /// async_flush_interval. It also does so when the commits have written more
+    /// than \a async_flush_threshold bytes since the last time, unless the
+    /// threshold is zero. SharedGroup::wait_until_durable() can be used to
+    /// wait for a specific commit. These options are taken from the SharedGroup
+    /// object that starts the background thread.
+    std::chrono::milliseconds async_flush_interval = std::chrono::milliseconds(10);
+    size_t async_flush_threshold = 16 * 1024 * 1024;
+
+    /// Enumerate string columns automatically. When a write transaction is
+    /// committed, every table that has had a quarter of its rows written since
+    /// it was last considered, and that has at least 1000 rows, is optimized
+    /// as if by Table::optimize(), if a sample of its string columns suggests
+    /// that this would enumerate one of them. Likewise, enumerated columns
+    /// whose values have become mostly distinct are turned back into plain
+    /// string columns as if by Table::unenumerate_string_columns(). Subtables
+    /// are never optimized.
+    ///
+    /// The optimization is part of the committed transaction, so this setting
+    /// only affects the SharedGroup objects that it is specified for.
+    bool auto_optimize = false;
+
     /// The key to encrypt and decrypt the Realm file with, or nullptr to
     /// indicate that encryption should not be used.
     const char* encryption_key;
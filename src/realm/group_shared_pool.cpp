@@ -0,0 +1,206 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <realm/group_shared_pool.hpp>
+
+using namespace realm;
+
+
+SharedGroupPool::SharedGroupPool(const std::string& file, size_t max_shared_groups, bool no_create,
+                                 const SharedGroupOptions& options)
+    : m_file(file)
+    , m_no_create(no_create)
+    , m_options(options)
+    , m_max_shared_groups(max_shared_groups)
+{
+    REALM_ASSERT(max_shared_groups > 0);
+    // Ensures that release() never needs to allocate
+    m_idle.reserve(max_shared_groups); // Throws
+}
+
+
+SharedGroupPool::~SharedGroupPool() noexcept
+{
+    // Every ReadSession holds a pointer to the pool
+    REALM_ASSERT(m_idle.size() == m_num_shared_groups);
+}
+
+
+SharedGroupPool::ReadSession SharedGroupPool::start_read(VersionID version)
+{
+    std::unique_ptr<SharedGroup> shared_group = acquire(version); // Throws
+    return ReadSession(*this, std::move(shared_group));
+}
+
+
+void SharedGroupPool::close_idle()
+{
+    std::vector<std::unique_ptr<SharedGroup>> idle;
+    idle.reserve(m_max_shared_groups); // Throws
+    {
+        // Leave the capacity of m_idle intact
+        util::LockGuard lock(m_mutex);
+        for (auto& shared_group : m_idle)
+            idle.push_back(std::move(shared_group));
+        m_idle.clear();
+        m_num_shared_groups -= idle.size();
+    }
+    // Closing a SharedGroup ends its read transaction. This is done without
+    // holding the lock.
+    idle.clear();
+}
+
+
+void SharedGroupPool::release_stale()
+{
+    util::LockGuard lock(m_mutex);
+    end_stale_reads();
+}
+
+
+SharedGroupPool::Stats SharedGroupPool::get_stats() const
+{
+    util::LockGuard lock(m_mutex);
+    Stats stats;
+    stats.num_shared_groups = m_num_shared_groups;
+    stats.num_idle = m_idle.size();
+    stats.num_sessions = m_num_sessions;
+    stats.num_reused_snapshots = m_num_reused_snapshots;
+    return stats;
+}
+
+
+std::unique_ptr<SharedGroup> SharedGroupPool::acquire(VersionID version)
+{
+    std::unique_ptr<SharedGroup> shared_group;
+    {
+        util::LockGuard lock(m_mutex);
+        for (;;) {
+            if (!m_idle.empty()) {
+                // Prefer the most recently used SharedGroup whose read
+                // transaction can be reused, otherwise take the most recently
+                // used one.
+                size_t ndx = m_idle.size() - 1;
+                for (size_t i = m_idle.size(); i > 0; --i) {
+                    if (is_bound_to(*m_idle[i - 1], version)) {
+                        ndx = i - 1;
+                        break;
+                    }
+                }
+                shared_group = std::move(m_idle[ndx]);
+                m_idle.erase(m_idle.begin() + ndx);
+                break;
+            }
+            if (m_num_shared_groups < m_max_shared_groups) {
+                // Reserve a place for a new SharedGroup
+                ++m_num_shared_groups;
+                break;
+            }
+            m_idle_available.wait(lock);
+        }
+        ++m_num_sessions;
+        // A commit may have landed while the remaining SharedGroups were
+        // idle, in which case their snapshots are no longer the latest.
+        end_stale_reads();
+    }
+
+    // The expensive parts (opening the SharedGroup, and starting the read
+    // transaction) are done without holding the lock.
+    if (!shared_group) {
+        try {
+            shared_group.reset(new SharedGroup(m_file, m_no_create, m_options)); // Throws
+        }
+        catch (...) {
+            util::LockGuard lock(m_mutex);
+            --m_num_shared_groups;
+            m_idle_available.notify();
+            throw;
+        }
+    }
+
+    if (shared_group->get_transact_stage() == SharedGroup::transact_Reading) {
+        if (is_bound_to(*shared_group, version)) {
+            util::LockGuard lock(m_mutex);
+            ++m_num_reused_snapshots;
+            return shared_group;
+        }
+        shared_group->end_read();
+    }
+    try {
+        shared_group->begin_read(version); // Throws
+    }
+    catch (...) {
+        release(std::move(shared_group));
+        throw;
+    }
+    return shared_group;
+}
+
+
+void SharedGroupPool::release(std::unique_ptr<SharedGroup> shared_group) noexcept
+{
+    // Do not let idle SharedGroups hold on to versions that are no longer the
+    // latest one, as that would prevent the space they occupy in the file
+    // from being reused.
+    try {
+        if (shared_group->get_transact_stage() == SharedGroup::transact_Reading && shared_group->has_changed())
+            shared_group->end_read();
+    }
+    catch (...) {
+        // The SharedGroup is closed rather than handed out again, as it is
+        // unknown whether it is still usable
+        shared_group->end_read();
+        shared_group.reset();
+        util::LockGuard lock(m_mutex);
+        --m_num_shared_groups;
+        m_idle_available.notify();
+        return;
+    }
+
+    util::LockGuard lock(m_mutex);
+    m_idle.push_back(std::move(shared_group));
+    m_idle_available.notify();
+}
+
+
+void SharedGroupPool::end_stale_reads() noexcept
+{
+    for (auto& shared_group : m_idle) {
+        if (shared_group->get_transact_stage() != SharedGroup::transact_Reading)
+            continue;
+        bool stale;
+        try {
+            stale = shared_group->has_changed();
+        }
+        catch (...) {
+            stale = true;
+        }
+        if (stale)
+            shared_group->end_read();
+    }
+}
+
+
+bool SharedGroupPool::is_bound_to(SharedGroup& shared_group, VersionID version)
+{
+    if (shared_group.get_transact_stage() != SharedGroup::transact_Reading)
+        return false;
+    if (version == VersionID())
+        return !shared_group.has_changed();
+    return shared_group.get_version_of_current_transaction() == version;
+}
@@ -0,0 +1,202 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_GROUP_SHARED_POOL_HPP
+#define REALM_GROUP_SHARED_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <realm/util/thread.hpp>
+#include <realm/group_shared.hpp>
+
+namespace realm {
+
+/// A pool of SharedGroups attached to the same database file, which serves
+/// many short read transactions (read sessions), possibly from many threads,
+/// with a bounded number of SharedGroups.
+///
+/// Each read session has exclusive use of one SharedGroup from the pool for
+/// its duration. When a session ends, its SharedGroup is returned to the pool
+/// without ending the read transaction, as long as the snapshot is still the
+/// latest one. A later session that asks for the same version (or for the
+/// latest version, when nothing has been committed in the meantime) reuses
+/// that read transaction, including its read lock and the accessors that were
+/// already created, instead of starting a new one.
+///
+/// An idle SharedGroup keeps the version of the database that it is bound to
+/// from being reclaimed. Snapshots that are no longer the latest are released
+/// when a session ends, and those of the remaining idle SharedGroups when the
+/// next session starts, or when release_stale() is called. Until then, a
+/// commit that lands while SharedGroups are idle leaves them holding on to
+/// the previous version, so an application that commits without reading
+/// afterwards should call release_stale() to let the space be reused.
+///
+/// If all SharedGroups are in use, start_read() waits until a session ends.
+///
+/// The pool is thread-safe. A ReadSession, and all accessors obtained through
+/// it, must only be used by one thread at a time, and must not be used after
+/// the session has ended.
+class SharedGroupPool {
+public:
+    class ReadSession;
+
+    /// Open the pool. No SharedGroups are opened until they are needed. The
+    /// arguments \a file, \a no_create, and \a options are passed to the
+    /// constructor of each SharedGroup. If an encryption key is specified, it
+    /// must remain valid for the lifetime of the pool.
+    SharedGroupPool(const std::string& file, size_t max_shared_groups, bool no_create = false,
+                    const SharedGroupOptions& options = SharedGroupOptions());
+
+    /// All read sessions must have ended before the pool is destroyed.
+    ~SharedGroupPool() noexcept;
+
+    /// Start a read session bound to the specified version, or to the latest
+    /// version if none is specified.
+    ///
+    /// \throw SharedGroup::BadVersion If the specified version is no longer
+    /// available.
+    ReadSession start_read(VersionID = VersionID());
+
+    /// End the read transactions of all idle SharedGroups whose snapshot is
+    /// no longer the latest one. The SharedGroups remain open.
+    void release_stale();
+
+    /// End the read transactions of, and close, all idle SharedGroups.
+    void close_idle();
+
+    struct Stats {
+        size_t num_shared_groups = 0;          ///< SharedGroups currently open
+        size_t num_idle = 0;                   ///< Of those, the ones not in use
+        uint_fast64_t num_sessions = 0;        ///< Read sessions started
+        uint_fast64_t num_reused_snapshots = 0; ///< Of those, the ones that reused a read transaction
+    };
+
+    Stats get_stats() const;
+
+private:
+    const std::string m_file;
+    const bool m_no_create;
+    const SharedGroupOptions m_options;
+    const size_t m_max_shared_groups;
+
+    mutable util::Mutex m_mutex;
+    util::CondVar m_idle_available;
+    // Most recently used last
+    std::vector<std::unique_ptr<SharedGroup>> m_idle;
+    size_t m_num_shared_groups = 0;
+    uint_fast64_t m_num_sessions = 0;
+    uint_fast64_t m_num_reused_snapshots = 0;
+
+    std::unique_ptr<SharedGroup> acquire(VersionID);
+    void release(std::unique_ptr<SharedGroup>) noexcept;
+
+    // Must be called with m_mutex locked
+    void end_stale_reads() noexcept;
+
+    static bool is_bound_to(SharedGroup&, VersionID);
+};
+
+
+/// A read transaction on a SharedGroup borrowed from a SharedGroupPool. The
+/// SharedGroup is returned to the pool when the session is destroyed.
+class SharedGroupPool::ReadSession {
+public:
+    ReadSession(ReadSession&&) noexcept;
+    ReadSession& operator=(ReadSession&&) noexcept;
+    ~ReadSession() noexcept;
+
+    bool has_table(StringData name) const noexcept
+    {
+        return get_group().has_table(name);
+    }
+
+    ConstTableRef get_table(size_t table_ndx) const
+    {
+        return get_group().get_table(table_ndx); // Throws
+    }
+
+    ConstTableRef get_table(StringData name) const
+    {
+        return get_group().get_table(name); // Throws
+    }
+
+    const Group& get_group() const noexcept;
+
+    /// Get the version of the snapshot to which this session is bound.
+    VersionID get_version() const;
+
+private:
+    SharedGroupPool* m_pool;
+    std::unique_ptr<SharedGroup> m_shared_group;
+
+    ReadSession(SharedGroupPool&, std::unique_ptr<SharedGroup>) noexcept;
+
+    friend class SharedGroupPool;
+};
+
+
+// Implementation:
+
+inline SharedGroupPool::ReadSession::ReadSession(SharedGroupPool& pool,
+                                                 std::unique_ptr<SharedGroup> shared_group) noexcept
+    : m_pool(&pool)
+    , m_shared_group(std::move(shared_group))
+{
+}
+
+inline SharedGroupPool::ReadSession::ReadSession(ReadSession&& other) noexcept
+    : m_pool(other.m_pool)
+    , m_shared_group(std::move(other.m_shared_group))
+{
+}
+
+inline SharedGroupPool::ReadSession& SharedGroupPool::ReadSession::operator=(ReadSession&& other) noexcept
+{
+    if (this != &other) {
+        if (m_shared_group)
+            m_pool->release(std::move(m_shared_group));
+        m_pool = other.m_pool;
+        m_shared_group = std::move(other.m_shared_group);
+    }
+    return *this;
+}
+
+inline SharedGroupPool::ReadSession::~ReadSession() noexcept
+{
+    if (m_shared_group)
+        m_pool->release(std::move(m_shared_group));
+}
+
+inline const Group& SharedGroupPool::ReadSession::get_group() const noexcept
+{
+    using sgf = _impl::SharedGroupFriend;
+    return sgf::get_group(*m_shared_group);
+}
+
+inline VersionID SharedGroupPool::ReadSession::get_version() const
+{
+    return m_shared_group->get_version_of_current_transaction();
+}
+
+} // namespace realm
+
+#endif // REALM_GROUP_SHARED_POOL_HPP
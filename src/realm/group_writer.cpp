@@ -269,6 +269,16 @@ GroupWriter::MapWindow* GroupWriter::get_window(ref_type start_ref, size_t size)
 ref_type GroupWriter::write_group()
 {
     merge_free_space(); // Throws
+    if (m_max_relocated_size != 0) {
+        release_free_tail(0); // Throws
+        select_relocation_threshold();
+    }
+    else {
+        // Avoid shrinking the file when it is likely to grow again right
+        // away.
+        size_t logical_file_size = to_size_t(m_group.m_top.get(2) / 2);
+        release_free_tail(logical_file_size / 8); // Throws
+    }
 
     Array& top = m_group.m_top;
     bool is_shared = m_group.m_is_shared;
@@ -392,6 +402,8 @@ ref_type GroupWriter::write_group()
     // change the byte-size of those arrays.
     size_t reserve_pos = to_size_t(m_free_positions.get(reserve_ndx));
     REALM_ASSERT_3(reserve_size, >, max_free_space_needed);
+    if (m_relocation_threshold != 0 && reserve_pos + max_free_space_needed > m_relocation_threshold)
+        m_used_space_beyond_threshold = true;
     int_fast64_t value_4 = to_int64(reserve_pos + max_free_space_needed);
 
 #if REALM_ENABLE_MEMDEBUG
@@ -528,6 +540,96 @@ void GroupWriter::merge_free_space()
 }
 
 
+void GroupWriter::release_free_tail(size_t min_size)
+{
+    bool is_shared = m_group.m_is_shared;
+
+    if (m_free_positions.is_empty())
+        return;
+
+    size_t ndx = m_free_positions.size() - 1;
+    size_t chunk_pos = to_size_t(m_free_positions.get(ndx));
+    size_t chunk_size = to_size_t(m_free_lengths.get(ndx));
+    size_t logical_file_size = to_size_t(m_group.m_top.get(2) / 2);
+    if (chunk_pos + chunk_size != logical_file_size)
+        return;
+    if (is_shared) {
+        size_t ver = to_size_t(m_free_versions.get(ndx));
+        if (ver >= m_readlock_version)
+            return;
+    }
+
+    // The file can only be mapped in whole sections, so the new size must be
+    // a section boundary.
+    size_t new_file_size = chunk_pos;
+    if (!m_alloc.matches_section_boundary(new_file_size))
+        new_file_size = m_alloc.get_upper_section_boundary(new_file_size);
+    if (new_file_size >= logical_file_size || logical_file_size - new_file_size < min_size)
+        return;
+
+    if (new_file_size > chunk_pos) {
+        m_free_lengths.set(ndx, to_int64(new_file_size - chunk_pos)); // Throws
+    }
+    else {
+        m_free_positions.erase(ndx);
+        m_free_lengths.erase(ndx);
+        if (is_shared)
+            m_free_versions.erase(ndx);
+    }
+    m_group.m_top.set(2, 1 + 2 * new_file_size); // Throws
+    m_logical_file_size_reduced = true;
+}
+
+
+void GroupWriter::select_relocation_threshold()
+{
+    bool is_shared = m_group.m_is_shared;
+
+    auto is_usable = [&](size_t ndx) {
+        return !is_shared || to_size_t(m_free_versions.get(ndx)) < m_readlock_version;
+    };
+
+    size_t n = m_free_positions.size();
+    size_t usable = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (is_usable(i))
+            usable += to_size_t(m_free_lengths.get(i));
+    }
+
+    // Move the threshold backwards from the end of the file, one chunk of free
+    // space at a time, for as long as the live data beyond it fits within the
+    // budget, and within the free space below it that can be used by this
+    // commit. Free space that is still in use by readers counts as neither.
+    size_t threshold = to_size_t(m_group.m_top.get(2) / 2);
+    size_t live = 0;
+    for (size_t i = n; i > 0; --i) {
+        size_t chunk_pos = to_size_t(m_free_positions.get(i - 1));
+        size_t chunk_end = chunk_pos + to_size_t(m_free_lengths.get(i - 1));
+        size_t usable_below = usable - (is_usable(i - 1) ? chunk_end - chunk_pos : 0);
+        size_t live_2 = live + (threshold - chunk_end);
+        if (live_2 > m_max_relocated_size || live_2 > usable_below) {
+            // Take as much of the live data just below the threshold as
+            // possible.
+            size_t limit = std::min(m_max_relocated_size, usable);
+            if (limit > live) {
+                size_t extra = (limit - live) & ~size_t(7); // 8-byte alignment
+                threshold -= extra;
+                live += extra;
+            }
+            break;
+        }
+        threshold = chunk_pos;
+        live = live_2;
+        usable = usable_below;
+    }
+
+    if (live == 0)
+        return;
+    m_relocation_threshold = threshold;
+    m_relocated_size = live;
+}
+
+
 size_t GroupWriter::get_free_space(size_t size)
 {
     REALM_ASSERT_3(size % 8, ==, 0); // 8-byte alignment
@@ -560,6 +662,8 @@ size_t GroupWriter::get_free_space(size_t size)
             m_free_versions.erase(chunk_ndx);
     }
     REALM_ASSERT((chunk_pos % 8) == 0);
+    if (m_relocation_threshold != 0 && chunk_pos + size > m_relocation_threshold)
+        m_used_space_beyond_threshold = true;
     return chunk_pos;
 }
 
@@ -632,24 +736,14 @@ std::pair<size_t, size_t> GroupWriter::reserve_free_space(size_t size)
     typedef std::pair<size_t, size_t> Chunk;
     Chunk chunk;
     bool found;
-    // Since we do a first-fit search for small chunks, the top pieces are
-    // likely to get smaller and smaller. So when we are looking for bigger
-    // chunks we are likely to find them faster by skipping the first half of
-    // the list.
+    // The free-lists are sorted by position, so a first-fit search from the
+    // beginning allocates at the lowest possible offset. This keeps the end
+    // of the file free as often as possible, such that release_free_tail()
+    // can return it to the file system.
     size_t end = m_free_lengths.size();
-    if (size < 1024) {
-        chunk = search_free_space_in_part_of_freelist(size, 0, end, found);
-        if (found)
-            return chunk;
-    }
-    else {
-        chunk = search_free_space_in_part_of_freelist(size, end / 2, end, found);
-        if (found)
-            return chunk;
-        chunk = search_free_space_in_part_of_freelist(size, 0, end / 2, found);
-        if (found)
-            return chunk;
-    }
+    chunk = search_free_space_in_part_of_freelist(size, 0, end, found);
+    if (found)
+        return chunk;
 
     // No free space, so we have to extend the file.
     do {
@@ -725,6 +819,7 @@ void GroupWriter::write(const char* data, size_t size)
     window->encryption_read_barrier(dest_addr, size);
     std::copy_n(data, size, dest_addr);
     window->encryption_write_barrier(dest_addr, size);
+    m_written_size += size;
 }
 
 
@@ -742,6 +837,7 @@ ref_type GroupWriter::write_array(const char* data, size_t size, uint32_t checks
     memcpy(dest_addr + 4, data + 4, size - 4);
 
     window->encryption_write_barrier(dest_addr, size);
+    m_written_size += size;
     // return ref of the written array
     ref_type ref = to_ref(pos);
     return ref;
@@ -759,14 +855,41 @@ void GroupWriter::write_array_at(MapWindow* window, ref_type ref, const char* da
     uint32_t dummy_checksum = 0x41414141UL; // "AAAA" in ASCII
     memcpy(dest_addr, &dummy_checksum, 4);
     memcpy(dest_addr + 4, data + 4, size - 4);
+    m_written_size += size;
 }
 
 
 void GroupWriter::commit(ref_type new_top_ref)
 {
     MapWindow* window = get_window(0, sizeof(SlabAlloc::Header));
-    SlabAlloc::Header& file_header = *reinterpret_cast<SlabAlloc::Header*>(window->translate(0));
-    window->encryption_read_barrier(&file_header, sizeof file_header);
+    write_header(*window, m_alloc.get_file_format_version(), new_top_ref, [this] { sync_all_mappings(); });
+
+    // Only now that the new snapshot is durable, is it safe to truncate the
+    // file. Had the previous snapshot been recovered after a crash, it would
+    // still have considered the removed space as free space. Note that the
+    // file may have been extended again after release_free_tail().
+    if (m_logical_file_size_reduced) {
+        size_t logical_file_size = to_size_t(m_group.m_top.get(2) / 2);
+        m_alloc.shrink_file(logical_file_size);
+    }
+}
+
+
+void GroupWriter::commit_written(SlabAlloc& alloc, ref_type new_top_ref)
+{
+    util::File& file = alloc.get_file();
+    MapWindow window(file, 0, sizeof(SlabAlloc::Header));
+    // The changes were written through memory mappings that are not known
+    // here, so the whole file needs to be flushed.
+    write_header(window, alloc.get_file_format_version(), new_top_ref, [&] { file.sync(); }); // Throws
+}
+
+
+void GroupWriter::write_header(MapWindow& window, int file_format_version, ref_type new_top_ref,
+                               const std::function<void()>& sync_data)
+{
+    SlabAlloc::Header& file_header = *reinterpret_cast<SlabAlloc::Header*>(window.translate(0));
+    window.encryption_read_barrier(&file_header, sizeof file_header);
 
     // One bit of the flags field selects which of the two top ref slots are in
     // use (same for file format version slots). The current value of the bit
@@ -776,8 +899,14 @@ void GroupWriter::commit(ref_type new_top_ref)
     unsigned new_flags = old_flags ^ SlabAlloc::flags_SelectBit;
     int slot_selector = ((new_flags & SlabAlloc::flags_SelectBit) != 0 ? 1 : 0);
 
+    // Never lower the file format version, as the file may already contain
+    // data that only a newer version allows (see
+    // Table::encode_integer_columns())
+    int old_file_format_version = int(file_header.m_file_format[1 - slot_selector]);
+    if (old_file_format_version > file_format_version)
+        file_format_version = old_file_format_version;
+
     // Update top ref and file format version
-    int file_format_version = m_alloc.get_file_format_version();
     using type_1 = std::remove_reference<decltype(file_header.m_file_format[0])>::type;
     REALM_ASSERT(!util::int_cast_has_overflow<type_1>(file_format_version));
     file_header.m_top_ref[slot_selector] = new_top_ref;
@@ -788,9 +917,9 @@ void GroupWriter::commit(ref_type new_top_ref)
 
     // Make sure that that all data relating to the new snapshot is written to
     // stable storage before flipping the slot selector
-    window->encryption_write_barrier(&file_header, sizeof file_header);
+    window.encryption_write_barrier(&file_header, sizeof file_header);
     if (!disable_sync)
-        sync_all_mappings();
+        sync_data(); // Throws
 
     // Flip the slot selector bit.
     using type_2 = std::remove_reference<decltype(file_header.m_flags)>::type;
@@ -798,9 +927,9 @@ void GroupWriter::commit(ref_type new_top_ref)
 
     // Write new selector to disk
     // FIXME: we might optimize this to write of a single page?
-    window->encryption_write_barrier(&file_header, sizeof file_header);
+    window.encryption_write_barrier(&file_header, sizeof file_header);
     if (!disable_sync)
-        window->sync();
+        window.sync();
 }
 
 
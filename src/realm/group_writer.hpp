@@ -20,6 +20,7 @@
 #define REALM_GROUP_WRITER_HPP
 
 #include <cstdint> // unint8_t etc
+#include <functional>
 #include <utility>
 
 #include <realm/util/file.hpp>
@@ -55,6 +56,24 @@ public:
 
     void set_versions(uint64_t current, uint64_t read_lock) noexcept;
 
+    /// Make write_group() perform a step of incremental compaction: Unmodified
+    /// array nodes near the end of the file, up to approximately \a
+    /// max_relocated_size bytes of them, are relocated to free space closer to
+    /// the beginning of the file. Must be called before write_group().
+    ///
+    /// Independently of this, write_group() removes free space at the end of
+    /// the file, that is no longer in use by any reader, from the file, when
+    /// that makes a worthwhile difference (during compaction, always). The
+    /// file itself is truncated by commit().
+    void enable_compaction(size_t max_relocated_size) noexcept;
+
+    /// The approximate number of bytes of live data that write_group()
+    /// relocated due to enable_compaction(). Zero if any of the space used by
+    /// write_group() had to be taken at or beyond the relocation threshold,
+    /// because the free space is too fragmented for compaction to make
+    /// progress.
+    size_t get_relocated_size() const noexcept;
+
     /// Write all changed array nodes into free space.
     ///
     /// Returns the new top ref. When in full durability mode, call
@@ -66,8 +85,21 @@ public:
     /// returned by write_group().
     void commit(ref_type new_top_ref);
 
+    /// Like commit(), but for a snapshot whose changes, and the changes of
+    /// any preceding snapshot that is not yet durable, were written by
+    /// write_group() of other GroupWriter instances, possibly in other
+    /// processes. The entire file is flushed, not just the parts written
+    /// through this process. Unlike the constructor, this function may be
+    /// called outside a write transaction, while write_group() runs
+    /// concurrently in another session. The caller must ensure that the file
+    /// header is not updated by anyone else while this function runs.
+    static void commit_written(SlabAlloc&, ref_type new_top_ref);
+
     size_t get_file_size() const noexcept;
 
+    /// The number of bytes written by write_group() and write() so far.
+    size_t get_written_size() const noexcept;
+
     /// Write the specified chunk into free space.
     void write(const char* data, size_t size);
 
@@ -87,6 +119,13 @@ private:
     ArrayInteger m_free_versions;  // 6th slot in Group::m_top
     uint64_t m_current_version;
     uint64_t m_readlock_version;
+    size_t m_written_size = 0;
+    size_t m_max_relocated_size = 0;
+    size_t m_relocated_size = 0;
+    bool m_used_space_beyond_threshold = false;
+    // True if write_group() has reduced the logical file size, in which case
+    // commit() truncates the file accordingly.
+    bool m_logical_file_size_reduced = false;
 
     // Currently cached memory mappings. We keep as many as 16 1MB windows
     // open for writing. The allocator will favor sequential allocation
@@ -108,6 +147,15 @@ private:
     // Merge adjacent chunks
     void merge_free_space();
 
+    // Remove the last chunk of free space from the free-lists if it extends to
+    // the end of the file, and no reader uses it, and reduce the logical file
+    // size accordingly. Nothing is done unless the file would shrink by at
+    // least `min_size` bytes.
+    void release_free_tail(size_t min_size);
+
+    // Choose the relocation threshold for a step of incremental compaction.
+    void select_relocation_threshold();
+
     /// Allocate a chunk of free space of the specified size. The
     /// specified size must be 8-byte aligned. Extend the file if
     /// required. The returned chunk is removed from the amount of
@@ -147,12 +195,22 @@ private:
     std::pair<size_t, size_t> extend_free_space(size_t requested_size);
 
     void write_array_at(MapWindow* window, ref_type, const char* data, size_t size);
+
+    // Flip the file header to the specified top ref. `sync_data` must flush
+    // all data of the new snapshot to stable storage.
+    static void write_header(MapWindow&, int file_format_version, ref_type new_top_ref,
+                             const std::function<void()>& sync_data);
     size_t split_freelist_chunk(size_t index, size_t start_pos, size_t alloc_pos, size_t chunk_size, bool is_shared);
 };
 
 
 // Implementation:
 
+inline size_t GroupWriter::get_written_size() const noexcept
+{
+    return m_written_size;
+}
+
 inline void GroupWriter::set_versions(uint64_t current, uint64_t read_lock) noexcept
 {
     REALM_ASSERT(read_lock <= current);
@@ -160,6 +218,16 @@ inline void GroupWriter::set_versions(uint64_t current, uint64_t read_lock) noex
     m_readlock_version = read_lock;
 }
 
+inline void GroupWriter::enable_compaction(size_t max_relocated_size) noexcept
+{
+    m_max_relocated_size = max_relocated_size;
+}
+
+inline size_t GroupWriter::get_relocated_size() const noexcept
+{
+    return m_used_space_beyond_threshold ? 0 : m_relocated_size;
+}
+
 } // namespace realm
 
 #endif // REALM_GROUP_WRITER_HPP
@@ -36,6 +36,20 @@ public:
     /// Returns the ref (position in the target stream) of the written copy of
     /// the specified array data.
     virtual ref_type write_array(const char* data, size_t size, uint32_t checksum) = 0;
+
+    /// When only modified arrays are written (see Array::write()), unmodified
+    /// arrays that already reside in the target are normally left where they
+    /// are. If the relocation threshold is nonzero, unmodified arrays at or
+    /// beyond that position are written anyway, along with all the arrays on
+    /// the path leading to them, and the space they occupied is freed. Zero,
+    /// the default, means that nothing is relocated.
+    ref_type get_relocation_threshold() const noexcept
+    {
+        return m_relocation_threshold;
+    }
+
+protected:
+    ref_type m_relocation_threshold = 0;
 };
 
 } // namespace impl_
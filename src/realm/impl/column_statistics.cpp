@@ -0,0 +1,173 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include <realm/table.hpp>
+#include <realm/impl/column_statistics.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+
+ColumnStatistics ColumnStatistics::compute(const Table& table, size_t col_ndx)
+{
+    ColumnStatistics stats;
+    stats.m_num_rows = table.size();
+
+    DataType type = table.get_column_type(col_ndx);
+    switch (type) {
+        case type_Int:
+        case type_Bool:
+        case type_OldDateTime:
+        case type_Timestamp:
+            stats.m_ordered = true;
+            break;
+        case type_String:
+            break;
+        default:
+            return stats;
+    }
+    stats.m_supported = true;
+
+    // Pick one row at a random position in each of `sample_size` equally
+    // large runs of rows. This samples every row of small columns, and avoids
+    // aliasing with periodic data in large ones. The generator has a fixed
+    // seed, so the result is deterministic.
+    size_t num_rows = stats.m_num_rows;
+    size_t sample_size = std::min(num_rows, size_t(max_sample_size));
+    bool nullable = table.is_nullable(col_ndx);
+    uint_fast64_t random = 0;
+    stats.m_keys.reserve(sample_size); // Throws
+    for (size_t i = 0; i < sample_size; ++i) {
+        size_t begin = size_t((uint_fast64_t(i) * num_rows) / sample_size);
+        size_t end = size_t((uint_fast64_t(i + 1) * num_rows) / sample_size);
+        random = (random * 6364136223846793005ULL + 1442695040888963407ULL) & 0xFFFFFFFFFFFFFFFFULL;
+        size_t row_ndx = begin + size_t((random >> 33) % (end - begin));
+        if (nullable && table.is_null(col_ndx, row_ndx)) {
+            ++stats.m_num_nulls;
+            continue;
+        }
+        int64_t key;
+        switch (type) {
+            case type_Int:
+                key = table.get_int(col_ndx, row_ndx);
+                break;
+            case type_Bool:
+                key = table.get_bool(col_ndx, row_ndx);
+                break;
+            case type_OldDateTime:
+                key = table.get_olddatetime(col_ndx, row_ndx).get_olddatetime();
+                break;
+            case type_Timestamp:
+                key = table.get_timestamp(col_ndx, row_ndx).get_seconds();
+                break;
+            default:
+                key = string_key(table.get_string(col_ndx, row_ndx));
+                break;
+        }
+        stats.m_keys.push_back(key);
+    }
+    stats.m_num_sampled = sample_size;
+    stats.finalize();
+    return stats;
+}
+
+
+void ColumnStatistics::finalize()
+{
+    std::sort(m_keys.begin(), m_keys.end());
+
+    // Count the number of distinct keys, and the number of keys that were
+    // seen exactly once
+    size_t num_distinct = 0;
+    size_t num_singletons = 0;
+    for (size_t i = 0; i < m_keys.size();) {
+        size_t j = i + 1;
+        while (j < m_keys.size() && m_keys[j] == m_keys[i])
+            ++j;
+        ++num_distinct;
+        if (j - i == 1)
+            ++num_singletons;
+        i = j;
+    }
+
+    if (m_num_sampled == m_num_rows || m_keys.empty()) {
+        m_distinct = double(num_distinct);
+        return;
+    }
+
+    // The Guaranteed-Error Estimator of Charikar et al.: values that were
+    // seen more than once are likely to be frequent, so they are counted
+    // once. Each value that was seen only once stands for a number of unseen
+    // values that grows with the square root of the sampling ratio.
+    double num_non_null = double(m_num_rows) * m_keys.size() / m_num_sampled;
+    double estimate = std::sqrt(num_non_null / m_keys.size()) * num_singletons + (num_distinct - num_singletons);
+    m_distinct = std::max(double(num_distinct), std::min(estimate, num_non_null));
+}
+
+
+double ColumnStatistics::unseen_fraction() const noexcept
+{
+    // A value that was not sampled is known to be absent if all rows were
+    // sampled. Otherwise, it is assumed to be a typical unseen value, but at
+    // most half as frequent as a value that was sampled once.
+    if (m_num_sampled == m_num_rows)
+        return 0;
+    double typical = (1 - null_fraction()) / std::max(m_distinct, 1.0);
+    return std::min(typical, 0.5 / m_num_sampled);
+}
+
+
+double ColumnStatistics::estimate_equal(int64_t key) const noexcept
+{
+    if (m_num_sampled == 0)
+        return 0;
+    auto range = std::equal_range(m_keys.begin(), m_keys.end(), key);
+    size_t count = size_t(range.second - range.first);
+    if (count == 0)
+        return unseen_fraction();
+    return double(count) / m_num_sampled;
+}
+
+
+double ColumnStatistics::estimate_range(int64_t first, int64_t last) const noexcept
+{
+    REALM_ASSERT_DEBUG(m_ordered);
+    if (m_num_sampled == 0 || first > last)
+        return 0;
+    auto begin = std::lower_bound(m_keys.begin(), m_keys.end(), first);
+    auto end = std::upper_bound(begin, m_keys.end(), last);
+    size_t count = size_t(end - begin);
+    if (count == 0)
+        return unseen_fraction();
+    return double(count) / m_num_sampled;
+}
+
+
+int64_t ColumnStatistics::string_key(StringData str) noexcept
+{
+    // 64-bit FNV-1a
+    uint_fast64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < str.size(); ++i) {
+        hash ^= static_cast<unsigned char>(str.data()[i]);
+        hash = (hash * 1099511628211ULL) & 0xFFFFFFFFFFFFFFFFULL;
+    }
+    return int64_t(uint64_t(hash));
+}
@@ -0,0 +1,140 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_COLUMN_STATISTICS_HPP
+#define REALM_IMPL_COLUMN_STATISTICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <realm/string_data.hpp>
+
+namespace realm {
+
+class Table;
+
+namespace _impl {
+
+
+/// Statistics about the values in a column, estimated from a sample of its
+/// rows. The query engine uses them to estimate how many rows a condition
+/// matches before it has had the chance to measure it.
+///
+/// Every sampled value is reduced to a 64-bit key. For integer, boolean and
+/// date columns, the key is the value itself (whole seconds for timestamps),
+/// so the order of keys is the order of values, and range estimates are
+/// possible. For string columns, the key is a hash of the string, which only
+/// allows equality estimates. Columns of other types produce statistics with
+/// no sampled values, for which every estimate is unknown.
+class ColumnStatistics {
+public:
+    /// Number of rows that are sampled from larger columns.
+    static const size_t max_sample_size = 1000;
+
+    /// Sample the specified column. The column is divided into equally large
+    /// runs of rows, and one row is picked at a pseudo-random position in each
+    /// run. The generator has a fixed seed, so the result is deterministic.
+    static ColumnStatistics compute(const Table&, size_t col_ndx);
+
+    /// The number of rows in the column when it was sampled.
+    size_t num_rows() const noexcept;
+
+    /// False if the type of the column does not support estimates.
+    bool is_supported() const noexcept;
+
+    /// Whether the order of keys reflects the order of the values, which is
+    /// required by estimate_range().
+    bool is_ordered() const noexcept;
+
+    /// The fraction of rows that are null.
+    double null_fraction() const noexcept;
+
+    /// The estimated number of distinct non-null values in the column.
+    double distinct_estimate() const noexcept;
+
+    /// The smallest and the largest sampled key. Only meaningful when some
+    /// non-null value was sampled.
+    int64_t min() const noexcept;
+    int64_t max() const noexcept;
+
+    /// The estimated fraction of rows whose value has the specified key.
+    double estimate_equal(int64_t key) const noexcept;
+
+    /// The estimated fraction of rows with a key in the range `[first,
+    /// last]`. Requires is_ordered().
+    double estimate_range(int64_t first, int64_t last) const noexcept;
+
+    static int64_t string_key(StringData) noexcept;
+
+private:
+    std::vector<int64_t> m_keys; // Sampled non-null keys, sorted
+    size_t m_num_rows = 0;
+    size_t m_num_sampled = 0;
+    size_t m_num_nulls = 0;
+    double m_distinct = 0;
+    bool m_supported = false;
+    bool m_ordered = false;
+
+    double unseen_fraction() const noexcept;
+    void finalize();
+};
+
+
+// Implementation:
+
+inline size_t ColumnStatistics::num_rows() const noexcept
+{
+    return m_num_rows;
+}
+
+inline bool ColumnStatistics::is_supported() const noexcept
+{
+    return m_supported;
+}
+
+inline bool ColumnStatistics::is_ordered() const noexcept
+{
+    return m_ordered;
+}
+
+inline double ColumnStatistics::null_fraction() const noexcept
+{
+    return m_num_sampled == 0 ? 0 : double(m_num_nulls) / m_num_sampled;
+}
+
+inline double ColumnStatistics::distinct_estimate() const noexcept
+{
+    return m_distinct;
+}
+
+inline int64_t ColumnStatistics::min() const noexcept
+{
+    return m_keys.empty() ? 0 : m_keys.front();
+}
+
+inline int64_t ColumnStatistics::max() const noexcept
+{
+    return m_keys.empty() ? 0 : m_keys.back();
+}
+
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_COLUMN_STATISTICS_HPP
@@ -0,0 +1,518 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+#include <string>
+
+#include <realm/column.hpp>
+#include <realm/column_string.hpp>
+#include <realm/column_string_enum.hpp>
+#include <realm/column_timestamp.hpp>
+#include <realm/descriptor.hpp>
+#include <realm/exceptions.hpp>
+#include <realm/impl/column_statistics.hpp>
+#include <realm/impl/hash_aggregator.hpp>
+#include <realm/impl/sequential_getter.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+
+const size_t initial_num_slots = 16;
+
+// The rows are only read during aggregation, so the leaf accessors of the
+// getters remain valid
+template <class ColType>
+REALM_FORCEINLINE typename ColType::value_type get_value(SequentialGetterBase& getter, size_t row_ndx) noexcept
+{
+    auto& leaf_getter = static_cast<SequentialGetter<ColType>&>(getter);
+    if (row_ndx >= leaf_getter.m_leaf_end || row_ndx < leaf_getter.m_leaf_start)
+        leaf_getter.cache_next(row_ndx);
+    return leaf_getter.m_leaf_ptr->get(row_ndx - leaf_getter.m_leaf_start);
+}
+
+template <class T>
+void accumulate(Table::AggrType op, bool first, T value, T& current) noexcept
+{
+    switch (op) {
+        case Table::aggr_count:
+            break;
+        case Table::aggr_sum:
+        case Table::aggr_avg:
+            current += value;
+            break;
+        case Table::aggr_min:
+            if (first || value < current)
+                current = value;
+            break;
+        case Table::aggr_max:
+            if (first || value > current)
+                current = value;
+            break;
+    }
+}
+
+// A degenerate subtable has no column accessors, and no rows to read
+template <class ColType>
+SequentialGetterBase* make_getter(const ColumnBase* column)
+{
+    if (!column)
+        return nullptr;
+    return new SequentialGetter<ColType>(static_cast<const ColType*>(column)); // Throws
+}
+
+std::string get_result_column_name(const char* op, StringData column_name)
+{
+    std::string name = op;
+    name += "(";
+    name.append(column_name.data(), column_name.size());
+    name += ")";
+    if (name.size() > Descriptor::max_column_name_length)
+        name.resize(Descriptor::max_column_name_length);
+    return name;
+}
+
+} // anonymous namespace
+
+
+HashAggregator::HashAggregator(const Table& table, const std::vector<size_t>& group_by_columns,
+                               const std::vector<GroupAggregate>& aggregates)
+    : m_table(table)
+{
+    // The null flags of all key columns must fit in one word
+    if (group_by_columns.size() > 64)
+        throw LogicError(LogicError::illegal_combination);
+
+    const Spec& spec = TableFriend::get_spec(table);
+    size_t num_columns = table.get_column_count();
+    bool degenerate = table.is_degenerate();
+    for (size_t col_ndx : group_by_columns) {
+        if (col_ndx >= num_columns)
+            throw LogicError(LogicError::column_index_out_of_range);
+        const ColumnBase* column = degenerate ? nullptr : &TableFriend::get_column(table, col_ndx);
+        KeyColumn key_column{col_ndx, KeyKind::integer, column, m_num_words, nullptr};
+        bool nullable = table.is_nullable(col_ndx);
+        switch (spec.get_column_type(col_ndx)) {
+            case col_type_Int:
+            case col_type_Bool:
+            case col_type_OldDateTime:
+                if (nullable) {
+                    key_column.kind = KeyKind::nullable_integer;
+                    key_column.getter.reset(make_getter<IntNullColumn>(column)); // Throws
+                }
+                else {
+                    key_column.getter.reset(make_getter<IntegerColumn>(column)); // Throws
+                }
+                break;
+            case col_type_Timestamp:
+                key_column.kind = KeyKind::timestamp;
+                ++m_num_words; // Seconds and nanoseconds
+                break;
+            case col_type_String:
+                key_column.kind = KeyKind::string;
+                m_has_strings = true;
+                break;
+            case col_type_StringEnum:
+                // Null has a key of its own
+                key_column.kind = KeyKind::string_enum;
+                key_column.getter.reset(make_getter<IntegerColumn>(column)); // Throws
+                nullable = false;
+                break;
+            default:
+                throw LogicError(LogicError::type_mismatch);
+        }
+        ++m_num_words;
+        m_has_null_mask = m_has_null_mask || nullable;
+        m_key_columns.push_back(std::move(key_column)); // Throws
+    }
+    if (m_has_null_mask)
+        ++m_num_words;
+
+    for (const GroupAggregate& aggregate : aggregates) {
+        Aggregate aggr{aggregate.op, aggregate.column_ndx, ValueKind::none, nullptr, false, nullptr};
+        if (aggr.op != Table::aggr_count) {
+            if (aggr.column_ndx >= num_columns)
+                throw LogicError(LogicError::column_index_out_of_range);
+            if (!degenerate)
+                aggr.column = &TableFriend::get_column(table, aggr.column_ndx);
+            aggr.nullable = table.is_nullable(aggr.column_ndx);
+            switch (spec.get_column_type(aggr.column_ndx)) {
+                case col_type_Int:
+                    if (aggr.nullable) {
+                        aggr.kind = ValueKind::nullable_integer;
+                        aggr.getter.reset(make_getter<IntNullColumn>(aggr.column)); // Throws
+                    }
+                    else {
+                        aggr.kind = ValueKind::integer;
+                        aggr.getter.reset(make_getter<IntegerColumn>(aggr.column)); // Throws
+                    }
+                    break;
+                case col_type_Float:
+                    aggr.kind = ValueKind::float_value;
+                    aggr.getter.reset(make_getter<FloatColumn>(aggr.column)); // Throws
+                    break;
+                case col_type_Double:
+                    aggr.kind = ValueKind::double_value;
+                    aggr.getter.reset(make_getter<DoubleColumn>(aggr.column)); // Throws
+                    break;
+                default:
+                    throw LogicError(LogicError::type_mismatch);
+            }
+        }
+        m_aggregates.push_back(std::move(aggr)); // Throws
+    }
+
+    m_row_key.resize(m_num_words); // Throws
+    if (m_key_columns.size() == 1 && m_key_columns[0].kind == KeyKind::string_enum && !degenerate) {
+        m_enum_column = static_cast<const StringEnumColumn*>(m_key_columns[0].column);
+        m_slots.resize(m_enum_column->get_keys().size()); // Throws
+    }
+    else {
+        m_slots.resize(initial_num_slots); // Throws
+    }
+}
+
+
+HashAggregator::~HashAggregator() noexcept
+{
+}
+
+
+void HashAggregator::add_row(size_t row_ndx)
+{
+    get_key(row_ndx, m_row_key.data());
+    size_t group_ndx = find_or_add_group(m_row_key.data(), row_ndx); // Throws
+    ++m_row_counts[group_ndx];
+    State* states = m_states.data() + group_ndx * m_aggregates.size();
+    for (size_t i = 0; i < m_aggregates.size(); ++i)
+        add_value(m_aggregates[i], row_ndx, states[i]);
+}
+
+
+void HashAggregator::merge(const HashAggregator& other)
+{
+    REALM_ASSERT(&other.m_table == &m_table);
+    REALM_ASSERT(other.m_num_words == m_num_words && other.m_aggregates.size() == m_aggregates.size());
+
+    size_t num_aggregates = m_aggregates.size();
+    for (size_t i = 0; i < other.size(); ++i) {
+        const uint64_t* words = other.m_keys.data() + i * m_num_words;
+        size_t group_ndx = find_or_add_group(words, other.m_first_rows[i]); // Throws
+        m_row_counts[group_ndx] += other.m_row_counts[i];
+        State* states = m_states.data() + group_ndx * num_aggregates;
+        const State* other_states = other.m_states.data() + i * num_aggregates;
+        for (size_t j = 0; j < num_aggregates; ++j)
+            merge_state(m_aggregates[j], states[j], other_states[j]);
+    }
+}
+
+
+void HashAggregator::get_result(Table& result) const
+{
+    REALM_ASSERT(result.is_empty() && result.get_column_count() == 0);
+
+    for (const KeyColumn& key_column : m_key_columns) {
+        size_t col_ndx = key_column.column_ndx;
+        result.add_column(m_table.get_column_type(col_ndx), m_table.get_column_name(col_ndx),
+                          m_table.is_nullable(col_ndx)); // Throws
+    }
+    for (const Aggregate& aggr : m_aggregates) {
+        bool is_integer = aggr.kind == ValueKind::integer || aggr.kind == ValueKind::nullable_integer;
+        switch (aggr.op) {
+            case Table::aggr_count:
+                result.add_column(type_Int, "COUNT()"); // Throws
+                break;
+            case Table::aggr_sum: {
+                std::string name = get_result_column_name("SUM", m_table.get_column_name(aggr.column_ndx));
+                result.add_column(is_integer ? type_Int : type_Double, name); // Throws
+                break;
+            }
+            case Table::aggr_avg: {
+                std::string name = get_result_column_name("AVG", m_table.get_column_name(aggr.column_ndx));
+                result.add_column(type_Double, name, aggr.nullable); // Throws
+                break;
+            }
+            case Table::aggr_min:
+            case Table::aggr_max: {
+                const char* op = aggr.op == Table::aggr_min ? "MIN" : "MAX";
+                std::string name = get_result_column_name(op, m_table.get_column_name(aggr.column_ndx));
+                result.add_column(m_table.get_column_type(aggr.column_ndx), name, aggr.nullable); // Throws
+                break;
+            }
+        }
+    }
+
+    size_t num_groups = size();
+    size_t num_key_columns = m_key_columns.size();
+    result.add_empty_row(num_groups); // Throws
+    for (size_t group_ndx = 0; group_ndx < num_groups; ++group_ndx) {
+        const uint64_t* words = m_keys.data() + group_ndx * m_num_words;
+        uint64_t null_mask = m_has_null_mask ? words[m_num_words - 1] : 0;
+        for (size_t i = 0; i < num_key_columns; ++i) {
+            const KeyColumn& key_column = m_key_columns[i];
+            const uint64_t* word = words + key_column.word_ndx;
+            if ((null_mask >> i) & 1) {
+                result.set_null(i, group_ndx); // Throws
+                continue;
+            }
+            switch (key_column.kind) {
+                case KeyKind::integer:
+                case KeyKind::nullable_integer:
+                    switch (result.get_column_type(i)) {
+                        case type_Bool:
+                            result.set_bool(i, group_ndx, *word != 0); // Throws
+                            break;
+                        case type_OldDateTime:
+                            result.set_olddatetime(i, group_ndx, OldDateTime(int64_t(*word))); // Throws
+                            break;
+                        default:
+                            result.set_int(i, group_ndx, int64_t(*word)); // Throws
+                            break;
+                    }
+                    break;
+                case KeyKind::timestamp:
+                    result.set_timestamp(i, group_ndx, Timestamp(int64_t(word[0]), int32_t(word[1]))); // Throws
+                    break;
+                case KeyKind::string:
+                case KeyKind::string_enum: {
+                    StringData value = m_table.get_string(key_column.column_ndx, m_first_rows[group_ndx]);
+                    result.set_string(i, group_ndx, value); // Throws
+                    break;
+                }
+            }
+        }
+
+        const State* states = m_states.data() + group_ndx * m_aggregates.size();
+        for (size_t i = 0; i < m_aggregates.size(); ++i) {
+            const Aggregate& aggr = m_aggregates[i];
+            const State& state = states[i];
+            size_t col_ndx = num_key_columns + i;
+            bool is_integer = aggr.kind == ValueKind::integer || aggr.kind == ValueKind::nullable_integer;
+            if (aggr.op == Table::aggr_count) {
+                result.set_int(col_ndx, group_ndx, m_row_counts[group_ndx]); // Throws
+            }
+            else if (aggr.op == Table::aggr_sum) {
+                if (is_integer) {
+                    result.set_int(col_ndx, group_ndx, state.int_value); // Throws
+                }
+                else {
+                    result.set_double(col_ndx, group_ndx, state.double_value); // Throws
+                }
+            }
+            else if (state.count == 0) {
+                // All values of the group are null
+                result.set_null(col_ndx, group_ndx); // Throws
+            }
+            else if (aggr.op == Table::aggr_avg) {
+                double sum = is_integer ? double(state.int_value) : state.double_value;
+                result.set_double(col_ndx, group_ndx, sum / state.count); // Throws
+            }
+            else if (is_integer) {
+                result.set_int(col_ndx, group_ndx, state.int_value); // Throws
+            }
+            else if (aggr.kind == ValueKind::float_value) {
+                result.set_float(col_ndx, group_ndx, float(state.double_value)); // Throws
+            }
+            else {
+                result.set_double(col_ndx, group_ndx, state.double_value); // Throws
+            }
+        }
+    }
+}
+
+
+void HashAggregator::get_key(size_t row_ndx, uint64_t* words) const noexcept
+{
+    uint64_t null_mask = 0;
+    for (size_t i = 0; i < m_key_columns.size(); ++i) {
+        const KeyColumn& key_column = m_key_columns[i];
+        uint64_t* word = words + key_column.word_ndx;
+        switch (key_column.kind) {
+            case KeyKind::integer:
+                *word = uint64_t(get_value<IntegerColumn>(*key_column.getter, row_ndx));
+                break;
+            case KeyKind::nullable_integer: {
+                util::Optional<int64_t> value = get_value<IntNullColumn>(*key_column.getter, row_ndx);
+                *word = value ? uint64_t(*value) : 0;
+                if (!value)
+                    null_mask |= uint64_t(1) << i;
+                break;
+            }
+            case KeyKind::timestamp: {
+                Timestamp value = static_cast<const TimestampColumn*>(key_column.column)->get(row_ndx);
+                if (value.is_null()) {
+                    word[0] = 0;
+                    word[1] = 0;
+                    null_mask |= uint64_t(1) << i;
+                }
+                else {
+                    word[0] = uint64_t(value.get_seconds());
+                    word[1] = uint64_t(value.get_nanoseconds());
+                }
+                break;
+            }
+            case KeyKind::string: {
+                StringData value = static_cast<const StringColumn*>(key_column.column)->get(row_ndx);
+                *word = uint64_t(ColumnStatistics::string_key(value));
+                if (value.is_null())
+                    null_mask |= uint64_t(1) << i;
+                break;
+            }
+            case KeyKind::string_enum:
+                *word = uint64_t(get_value<IntegerColumn>(*key_column.getter, row_ndx));
+                break;
+        }
+    }
+    if (m_has_null_mask)
+        words[m_num_words - 1] = null_mask;
+}
+
+
+uint64_t HashAggregator::hash_key(const uint64_t* words) const noexcept
+{
+    uint64_t hash = 0;
+    for (size_t i = 0; i < m_num_words; ++i) {
+        hash = (hash ^ words[i]) * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+
+bool HashAggregator::strings_equal(size_t row_ndx_1, size_t row_ndx_2) const noexcept
+{
+    for (const KeyColumn& key_column : m_key_columns) {
+        if (key_column.kind == KeyKind::string) {
+            auto column = static_cast<const StringColumn*>(key_column.column);
+            if (column->get(row_ndx_1) != column->get(row_ndx_2))
+                return false;
+        }
+    }
+    return true;
+}
+
+
+// Find the group with the specified key words. `row_ndx` is a row with the
+// same grouping values, which is used to compare strings, and becomes the
+// first row of the group if it is added.
+size_t HashAggregator::find_or_add_group(const uint64_t* words, size_t row_ndx)
+{
+    if (m_enum_column) {
+        size_t key = size_t(words[0]);
+        REALM_ASSERT_DEBUG(key < m_slots.size());
+        size_t& slot = m_slots[key];
+        if (slot == 0)
+            slot = add_group(words, 0, row_ndx) + 1; // Throws
+        return slot - 1;
+    }
+
+    uint64_t hash = hash_key(words);
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = size_t(hash) & mask; m_slots[i] != 0; i = (i + 1) & mask) {
+        size_t group_ndx = m_slots[i] - 1;
+        const uint64_t* group_words = m_keys.data() + group_ndx * m_num_words;
+        if (m_hashes[group_ndx] == hash && std::equal(words, words + m_num_words, group_words) &&
+            (!m_has_strings || strings_equal(m_first_rows[group_ndx], row_ndx)))
+            return group_ndx;
+    }
+
+    // Keep the load factor at most one half
+    if (2 * (size() + 1) > m_slots.size())
+        grow(); // Throws
+    size_t group_ndx = add_group(words, hash, row_ndx); // Throws
+    mask = m_slots.size() - 1;
+    size_t i = size_t(hash) & mask;
+    while (m_slots[i] != 0)
+        i = (i + 1) & mask;
+    m_slots[i] = group_ndx + 1;
+    return group_ndx;
+}
+
+
+size_t HashAggregator::add_group(const uint64_t* words, uint64_t hash, size_t row_ndx)
+{
+    size_t group_ndx = size();
+    m_keys.insert(m_keys.end(), words, words + m_num_words);                // Throws
+    m_hashes.push_back(hash);                                               // Throws
+    m_row_counts.push_back(0);                                              // Throws
+    m_states.resize(m_states.size() + m_aggregates.size(), State{0, 0, 0}); // Throws
+    m_first_rows.push_back(row_ndx);                                        // Throws
+    return group_ndx;
+}
+
+
+void HashAggregator::grow()
+{
+    std::vector<size_t> slots(2 * m_slots.size()); // Throws
+    size_t mask = slots.size() - 1;
+    for (size_t group_ndx = 0; group_ndx < size(); ++group_ndx) {
+        size_t i = size_t(m_hashes[group_ndx]) & mask;
+        while (slots[i] != 0)
+            i = (i + 1) & mask;
+        slots[i] = group_ndx + 1;
+    }
+    m_slots.swap(slots);
+}
+
+
+void HashAggregator::add_value(const Aggregate& aggr, size_t row_ndx, State& state) const noexcept
+{
+    switch (aggr.kind) {
+        case ValueKind::none:
+            return;
+        case ValueKind::integer: {
+            int64_t value = get_value<IntegerColumn>(*aggr.getter, row_ndx);
+            accumulate(aggr.op, state.count++ == 0, value, state.int_value);
+            return;
+        }
+        case ValueKind::nullable_integer: {
+            util::Optional<int64_t> value = get_value<IntNullColumn>(*aggr.getter, row_ndx);
+            if (value)
+                accumulate(aggr.op, state.count++ == 0, *value, state.int_value);
+            return;
+        }
+        case ValueKind::float_value: {
+            float value = get_value<FloatColumn>(*aggr.getter, row_ndx);
+            if (!aggr.nullable || !null::is_null_float(value))
+                accumulate(aggr.op, state.count++ == 0, double(value), state.double_value);
+            return;
+        }
+        case ValueKind::double_value: {
+            double value = get_value<DoubleColumn>(*aggr.getter, row_ndx);
+            if (!aggr.nullable || !null::is_null_float(value))
+                accumulate(aggr.op, state.count++ == 0, value, state.double_value);
+            return;
+        }
+    }
+}
+
+
+void HashAggregator::merge_state(const Aggregate& aggr, State& state, const State& other) noexcept
+{
+    if (other.count == 0)
+        return;
+    bool first = state.count == 0;
+    state.count += other.count;
+    if (aggr.kind == ValueKind::integer || aggr.kind == ValueKind::nullable_integer) {
+        accumulate(aggr.op, first, other.int_value, state.int_value);
+    }
+    else {
+        accumulate(aggr.op, first, other.double_value, state.double_value);
+    }
+}
@@ -0,0 +1,150 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_HASH_AGGREGATOR_HPP
+#define REALM_IMPL_HASH_AGGREGATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <realm/table.hpp>
+
+namespace realm {
+
+class SequentialGetterBase;
+
+namespace _impl {
+
+
+/// Computes aggregates over groups of rows, where the rows of a group have
+/// the same values in a number of columns. This is the engine behind
+/// Table::group_by(), TableViewBase::group_by() and Query::group_by().
+///
+/// The grouping values of a row are reduced to a fixed number of 64-bit
+/// words, and the groups are kept in an open-addressing hash table keyed by
+/// those words. Integers, booleans and timestamps are stored as they are. A
+/// string of an auto-enumerated column is represented by its key, and when
+/// such a column is the only grouping column, groups are looked up by that
+/// key directly, without hashing. Other strings are represented by a hash,
+/// and are compared in full when the hashes match.
+///
+/// Every group holds the running state of all the aggregates, so they are
+/// all computed in a single pass over the rows. Integer and floating point
+/// values are read through the leaf that was last accessed, which is cheap
+/// when the rows are visited in order. Groups are numbered in the
+/// order in which they are first seen. Rows can be split between several
+/// aggregators, for example one per thread, whose partial results are then
+/// combined with merge().
+class HashAggregator {
+public:
+    /// Throws LogicError if a column index is out of range, or if the type
+    /// of a column is not supported in its role.
+    HashAggregator(const Table&, const std::vector<size_t>& group_by_columns,
+                   const std::vector<GroupAggregate>& aggregates);
+    ~HashAggregator() noexcept;
+
+    void add_row(size_t row_ndx);
+
+    /// Fold the groups of the specified aggregator into this one. The other
+    /// aggregator must have been created with the same arguments, and its
+    /// rows are assumed to come after those already added to this one.
+    void merge(const HashAggregator&);
+
+    /// The number of groups seen so far.
+    size_t size() const noexcept;
+
+    /// Add the columns and rows of the result, as described for
+    /// Table::group_by(), to the specified table, which must be empty and
+    /// have no columns.
+    void get_result(Table&) const;
+
+private:
+    enum class KeyKind { integer, nullable_integer, timestamp, string, string_enum };
+    enum class ValueKind { none, integer, nullable_integer, float_value, double_value };
+
+    struct KeyColumn {
+        size_t column_ndx;
+        KeyKind kind;
+        const ColumnBase* column;
+        size_t word_ndx;
+        std::unique_ptr<SequentialGetterBase> getter; // Null for strings and timestamps
+    };
+
+    struct Aggregate {
+        Table::AggrType op;
+        size_t column_ndx;
+        ValueKind kind;
+        const ColumnBase* column;
+        bool nullable;
+        std::unique_ptr<SequentialGetterBase> getter; // Null for `aggr_count`
+    };
+
+    // The running state of one aggregate of one group. `count` is the number
+    // of non-null values seen.
+    struct State {
+        int64_t count;
+        int64_t int_value;
+        double double_value;
+    };
+
+    const Table& m_table;
+    std::vector<KeyColumn> m_key_columns;
+    std::vector<Aggregate> m_aggregates;
+    size_t m_num_words = 0;
+    bool m_has_null_mask = false; // The last word of a key flags null values
+    bool m_has_strings = false;   // Some key column needs full string comparison
+    const StringEnumColumn* m_enum_column = nullptr; // Set if groups are looked up by enum key
+
+    // Per group
+    std::vector<uint64_t> m_keys; // `m_num_words` per group
+    std::vector<uint64_t> m_hashes;
+    std::vector<size_t> m_first_rows;
+    std::vector<int64_t> m_row_counts;
+    std::vector<State> m_states; // One per aggregate per group
+
+    // Group index plus one, or zero for an empty slot. The size is a power of
+    // two. When looking up by enum key, this is indexed by key instead.
+    std::vector<size_t> m_slots;
+
+    std::vector<uint64_t> m_row_key;
+
+    void get_key(size_t row_ndx, uint64_t* words) const noexcept;
+    uint64_t hash_key(const uint64_t* words) const noexcept;
+    bool strings_equal(size_t row_ndx_1, size_t row_ndx_2) const noexcept;
+    size_t find_or_add_group(const uint64_t* words, size_t row_ndx);
+    size_t add_group(const uint64_t* words, uint64_t hash, size_t row_ndx);
+    void grow();
+    void add_value(const Aggregate&, size_t row_ndx, State&) const noexcept;
+    static void merge_state(const Aggregate&, State&, const State&) noexcept;
+};
+
+
+// Implementation:
+
+inline size_t HashAggregator::size() const noexcept
+{
+    return m_first_rows.size();
+}
+
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_HASH_AGGREGATOR_HPP
@@ -0,0 +1,235 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+#include <thread>
+
+#include <realm/util/assert.hpp>
+#include <realm/impl/parallel_executor.hpp>
+
+using namespace realm;
+using namespace realm::util;
+using namespace realm::_impl;
+
+
+namespace {
+
+inline uint_fast64_t make_range(size_t begin, size_t end) noexcept
+{
+    return (uint_fast64_t(begin) << 32) | uint_fast64_t(end);
+}
+
+inline size_t range_begin(uint_fast64_t range) noexcept
+{
+    return size_t(range >> 32);
+}
+
+inline size_t range_end(uint_fast64_t range) noexcept
+{
+    return size_t(range & 0xFFFFFFFFULL);
+}
+
+} // anonymous namespace
+
+
+ParallelExecutor::ParallelExecutor(size_t num_threads)
+    : m_num_threads(std::max(num_threads, size_t(1)))
+    , m_slots(new Slot[m_num_threads]) // Throws
+    , m_failed(false)
+{
+    for (size_t i = 0; i < m_num_threads; ++i)
+        m_slots[i].range = make_range(0, 0);
+
+    size_t num_workers = m_num_threads - 1;
+    if (num_workers == 0)
+        return;
+
+    m_threads.reset(new Thread[num_workers]); // Throws
+    try {
+        for (size_t i = 0; i < num_workers; ++i) {
+            size_t thread_ndx = i + 1;
+            m_threads[i].start([this, thread_ndx] { worker_thread(thread_ndx); }); // Throws
+            ++m_num_started_threads;
+        }
+    }
+    catch (...) {
+        stop_threads();
+        throw;
+    }
+}
+
+
+ParallelExecutor::~ParallelExecutor() noexcept
+{
+    stop_threads();
+}
+
+
+void ParallelExecutor::stop_threads() noexcept
+{
+    {
+        LockGuard lock(m_mutex);
+        m_stop = true;
+    }
+    m_work_cond.notify_all();
+    for (size_t i = 0; i < m_num_started_threads; ++i)
+        m_threads[i].join();
+    m_num_started_threads = 0;
+}
+
+
+void ParallelExecutor::run(size_t num_tasks, const Task& task, size_t max_threads)
+{
+    if (num_tasks == 0)
+        return;
+    REALM_ASSERT_RELEASE(num_tasks <= 0xFFFFFFFFULL);
+
+    LockGuard run_lock(m_run_mutex);
+
+    size_t num_participants = std::min(std::min(m_num_threads, num_tasks), std::max(max_threads, size_t(1)));
+    for (size_t i = 0; i < num_participants; ++i) {
+        size_t begin = num_tasks * i / num_participants;
+        size_t end = num_tasks * (i + 1) / num_participants;
+        m_slots[i].range = make_range(begin, end);
+    }
+    m_task = &task;
+    m_failed = false;
+
+    {
+        LockGuard lock(m_mutex);
+        m_num_participants = num_participants;
+        m_num_busy_workers = num_participants - 1;
+        if (num_participants > 1)
+            ++m_batch;
+    }
+    if (num_participants > 1)
+        m_work_cond.notify_all();
+
+    execute(0);
+
+    std::exception_ptr exception;
+    {
+        LockGuard lock(m_mutex);
+        while (m_num_busy_workers > 0)
+            m_done_cond.wait(lock);
+        exception = m_exception;
+        m_exception = nullptr;
+    }
+    m_task = nullptr;
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+
+void ParallelExecutor::worker_thread(size_t thread_ndx) noexcept
+{
+    Thread::set_name("realm-executor");
+
+    uint_fast64_t batch = 0;
+    for (;;) {
+        {
+            LockGuard lock(m_mutex);
+            while (m_batch == batch && !m_stop)
+                m_work_cond.wait(lock);
+            if (m_stop)
+                return;
+            batch = m_batch;
+            // A worker may sleep through an entire batch that it took no part
+            // in, so it must check against the batch that is current now.
+            if (thread_ndx >= m_num_participants)
+                continue;
+        }
+
+        execute(thread_ndx);
+
+        LockGuard lock(m_mutex);
+        if (--m_num_busy_workers == 0)
+            m_done_cond.notify_all();
+    }
+}
+
+
+void ParallelExecutor::execute(size_t thread_ndx) noexcept
+{
+    size_t task_ndx;
+    while (!m_failed && (pop_task(thread_ndx, task_ndx) || steal_task(thread_ndx, task_ndx))) {
+        try {
+            (*m_task)(task_ndx, thread_ndx); // Throws
+        }
+        catch (...) {
+            LockGuard lock(m_mutex);
+            if (!m_exception)
+                m_exception = std::current_exception();
+            m_failed = true;
+        }
+    }
+}
+
+
+bool ParallelExecutor::pop_task(size_t thread_ndx, size_t& task_ndx) noexcept
+{
+    std::atomic<uint_fast64_t>& slot = m_slots[thread_ndx].range;
+    uint_fast64_t range = slot.load();
+    for (;;) {
+        size_t begin = range_begin(range), end = range_end(range);
+        if (begin == end)
+            return false;
+        if (slot.compare_exchange_weak(range, make_range(begin + 1, end))) {
+            task_ndx = begin;
+            return true;
+        }
+    }
+}
+
+
+bool ParallelExecutor::steal_task(size_t thread_ndx, size_t& task_ndx) noexcept
+{
+    // Only called when the range of this thread is empty. Thieves never touch
+    // an empty range, so this thread can store the stolen tasks in its own
+    // slot without contention.
+    size_t num_participants = m_num_participants;
+    for (size_t i = 1; i < num_participants; ++i) {
+        std::atomic<uint_fast64_t>& victim = m_slots[(thread_ndx + i) % num_participants].range;
+        uint_fast64_t range = victim.load();
+        for (;;) {
+            size_t begin = range_begin(range), end = range_end(range);
+            if (begin == end)
+                break;
+            size_t num_stolen = (end - begin + 1) / 2;
+            size_t first = end - num_stolen;
+            if (victim.compare_exchange_weak(range, make_range(begin, first))) {
+                m_slots[thread_ndx].range = make_range(first + 1, end);
+                task_ndx = first;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+ParallelExecutor& ParallelExecutor::get_default()
+{
+    // Never destroyed, so that the worker threads do not have to be joined
+    // during static destruction. There are at least two threads, also on
+    // single core machines (or when the number of cores cannot be
+    // determined), as parallel execution must be requested explicitly anyway.
+    static ParallelExecutor& executor =
+        *new ParallelExecutor(std::max(std::thread::hardware_concurrency(), 2u)); // Throws
+    return executor;
+}
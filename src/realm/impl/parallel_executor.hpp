@@ -0,0 +1,128 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_PARALLEL_EXECUTOR_HPP
+#define REALM_IMPL_PARALLEL_EXECUTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+
+#include <realm/util/features.h>
+#include <realm/util/thread.hpp>
+
+namespace realm {
+namespace _impl {
+
+
+/// A fixed pool of worker threads that executes batches of independent
+/// tasks.
+///
+/// Each batch is a range of task indexes. At the start of a batch, every
+/// participating thread is given a contiguous run of task indexes, which it
+/// executes from the front. A thread that runs out of work steals the back
+/// half of the remaining run of another thread. This keeps neighbouring tasks
+/// (for example, adjacent B+-tree leaves) on the same thread, while still
+/// balancing work that turns out to be unevenly distributed.
+class ParallelExecutor {
+public:
+    /// The first argument is the index of the task to execute, the second is
+    /// the index of the executing thread. The thread index is less than the
+    /// number of threads participating in the batch, and can be used to
+    /// address per-thread state prepared by the caller of run(). The calling
+    /// thread always has index zero.
+    using Task = std::function<void(size_t task_ndx, size_t thread_ndx)>;
+
+    /// Create an executor that runs tasks on up to \a num_threads threads,
+    /// one of which is the thread that calls run(). A value of zero is
+    /// treated as one, in which case no worker threads are started.
+    explicit ParallelExecutor(size_t num_threads);
+    ~ParallelExecutor() noexcept;
+
+    /// The maximum number of threads (including the calling thread) that can
+    /// participate in a batch.
+    size_t get_num_threads() const noexcept;
+
+    /// Execute \a task once for every task index in `[0, num_tasks)` and
+    /// return when all of them have completed. The calling thread takes part
+    /// in the work, and at most \a max_threads threads participate.
+    ///
+    /// If a task throws, no further tasks are started, and the first
+    /// exception is rethrown by run() once all participating threads have
+    /// stopped.
+    ///
+    /// Concurrent calls to run() are serialized. A task must not call run()
+    /// on the executor that is executing it.
+    void run(size_t num_tasks, const Task& task, size_t max_threads = size_t(-1));
+
+    /// Get the process-wide executor. It is created on first use, with one
+    /// thread per hardware thread, but no fewer than two.
+    static ParallelExecutor& get_default();
+
+private:
+    // The task range assigned to a thread. The index of the first task in the
+    // range is in the upper 32 bits, and the index one beyond the last task is
+    // in the lower 32 bits. Padded to avoid false sharing between threads.
+    struct Slot {
+        std::atomic<uint_fast64_t> range;
+        char padding[64 - sizeof(std::atomic<uint_fast64_t>)];
+    };
+
+    const size_t m_num_threads;
+    std::unique_ptr<Slot[]> m_slots;
+    std::unique_ptr<util::Thread[]> m_threads;
+    size_t m_num_started_threads = 0;
+
+    util::Mutex m_run_mutex; // Serializes calls to run()
+
+    // Protected by m_mutex
+    util::Mutex m_mutex;
+    util::CondVar m_work_cond;
+    util::CondVar m_done_cond;
+    uint_fast64_t m_batch = 0;
+    size_t m_num_participants = 0;
+    size_t m_num_busy_workers = 0;
+    bool m_stop = false;
+    std::exception_ptr m_exception;
+
+    const Task* m_task = nullptr;
+    std::atomic<bool> m_failed;
+
+    void worker_thread(size_t thread_ndx) noexcept;
+    void execute(size_t thread_ndx) noexcept;
+    bool pop_task(size_t thread_ndx, size_t& task_ndx) noexcept;
+    bool steal_task(size_t thread_ndx, size_t& task_ndx) noexcept;
+    void stop_threads() noexcept;
+};
+
+
+// Implementation:
+
+inline size_t ParallelExecutor::get_num_threads() const noexcept
+{
+    return m_num_threads;
+}
+
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_PARALLEL_EXECUTOR_HPP
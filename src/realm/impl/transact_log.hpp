@@ -81,6 +81,9 @@ enum Instruction {
     instr_LinkListNullify = 36, // Remove an entry from a link list due to linked row being erased
     instr_LinkListClear = 37,   // Ramove all entries from a link list
     instr_LinkListSetAll = 38,  // Assign to link list entry
+    instr_UnenumerateStringColumns = 39, // Turn enumerated string columns of selected table back into plain ones
+    instr_AddOrderedIndex = 40,          // Add an ordered index to a column
+    instr_RemoveOrderedIndex = 41,       // Remove an ordered index from a column
 };
 
 
@@ -243,6 +246,10 @@ public:
     {
         return true;
     }
+    bool unenumerate_string_columns()
+    {
+        return true;
+    }
 
     // Must have descriptor selected:
     bool insert_link_column(size_t, DataType, StringData, size_t, size_t)
@@ -277,6 +284,14 @@ public:
     {
         return true;
     }
+    bool add_ordered_index(size_t)
+    {
+        return true;
+    }
+    bool remove_ordered_index(size_t)
+    {
+        return true;
+    }
     bool set_link_type(size_t, LinkType)
     {
         return true;
@@ -359,6 +374,7 @@ public:
     bool insert_substring(size_t col_ndx, size_t row_ndx, size_t pos, StringData);
     bool erase_substring(size_t col_ndx, size_t row_ndx, size_t pos, size_t size);
     bool optimize_table();
+    bool unenumerate_string_columns();
 
     // Must have descriptor selected:
     bool insert_link_column(size_t col_ndx, DataType, StringData name, size_t link_target_table_ndx,
@@ -370,6 +386,8 @@ public:
     bool move_column(size_t col_ndx_1, size_t col_ndx_2);
     bool add_search_index(size_t col_ndx);
     bool remove_search_index(size_t col_ndx);
+    bool add_ordered_index(size_t col_ndx);
+    bool remove_ordered_index(size_t col_ndx);
     bool set_link_type(size_t col_ndx, LinkType);
 
     // Must have linklist selected:
@@ -485,9 +503,12 @@ public:
     void merge_rows(const Table*, size_t row_ndx, size_t new_row_ndx);
     void add_search_index(const Table*, size_t col_ndx);
     void remove_search_index(const Table*, size_t col_ndx);
+    void add_ordered_index(const Table*, size_t col_ndx);
+    void remove_ordered_index(const Table*, size_t col_ndx);
     void set_link_type(const Table*, size_t col_ndx, LinkType);
     void clear_table(const Table*);
     void optimize_table(const Table*);
+    void unenumerate_string_columns(const Table*);
 
     void link_list_set(const LinkView&, size_t link_ndx, size_t value);
     void link_list_insert(const LinkView&, size_t link_ndx, size_t value);
@@ -569,6 +590,18 @@ public:
     template <class InstructionHandler>
     void parse(NoCopyInputStream&, InstructionHandler&);
 
+    /// Incremental alternative to parse(). begin_parse() binds the parser to
+    /// the specified input stream, and each subsequent call to parse_next()
+    /// parses exactly one instruction and passes it to the specified
+    /// handler. parse_next() returns false, without calling the handler, when
+    /// the end of the input has been reached. The handler may differ between
+    /// calls, but the input stream must remain valid until parse_next() has
+    /// returned false.
+    void begin_parse(NoCopyInputStream&) noexcept;
+
+    template <class InstructionHandler>
+    bool parse_next(InstructionHandler&);
+
 private:
     util::Buffer<char> m_input_buffer;
 
@@ -1479,6 +1512,31 @@ inline void TransactLogConvenientEncoder::remove_search_index(const Table* t, si
     m_encoder.remove_search_index(col_ndx); // Throws
 }
 
+inline bool TransactLogEncoder::add_ordered_index(size_t col_ndx)
+{
+    append_simple_instr(instr_AddOrderedIndex, util::tuple(col_ndx)); // Throws
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::add_ordered_index(const Table* t, size_t col_ndx)
+{
+    select_table(t);                      // Throws
+    m_encoder.add_ordered_index(col_ndx); // Throws
+}
+
+
+inline bool TransactLogEncoder::remove_ordered_index(size_t col_ndx)
+{
+    append_simple_instr(instr_RemoveOrderedIndex, util::tuple(col_ndx)); // Throws
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::remove_ordered_index(const Table* t, size_t col_ndx)
+{
+    select_table(t);                         // Throws
+    m_encoder.remove_ordered_index(col_ndx); // Throws
+}
+
 inline bool TransactLogEncoder::set_link_type(size_t col_ndx, LinkType link_type)
 {
     append_simple_instr(instr_SetLinkType, util::tuple(col_ndx, int(link_type))); // Throws
@@ -1516,6 +1574,18 @@ inline void TransactLogConvenientEncoder::optimize_table(const Table* t)
     m_encoder.optimize_table(); // Throws
 }
 
+inline bool TransactLogEncoder::unenumerate_string_columns()
+{
+    append_simple_instr(instr_UnenumerateStringColumns, util::tuple()); // Throws
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::unenumerate_string_columns(const Table* t)
+{
+    select_table(t);                        // Throws
+    m_encoder.unenumerate_string_columns(); // Throws
+}
+
 inline bool TransactLogEncoder::link_list_set(size_t link_ndx, size_t value, size_t prior_size)
 {
     append_simple_instr(instr_LinkListSet, util::tuple(link_ndx, value, prior_size)); // Throws
@@ -1686,11 +1756,9 @@ inline TransactLogParser::~TransactLogParser() noexcept
 template <class InstructionHandler>
 void TransactLogParser::parse(NoCopyInputStream& in, InstructionHandler& handler)
 {
-    m_input = &in;
-    m_input_begin = m_input_end = nullptr;
-
-    while (has_next())
-        parse_one(handler); // Throws
+    begin_parse(in);
+    while (parse_next(handler)) {
+    } // Throws
 }
 
 template <class InstructionHandler>
@@ -1700,6 +1768,21 @@ void TransactLogParser::parse(InputStream& in, InstructionHandler& handler)
     parse(in_2, handler); // Throws
 }
 
+inline void TransactLogParser::begin_parse(NoCopyInputStream& in) noexcept
+{
+    m_input = &in;
+    m_input_begin = m_input_end = nullptr;
+}
+
+template <class InstructionHandler>
+bool TransactLogParser::parse_next(InstructionHandler& handler)
+{
+    if (!has_next())
+        return false;
+    parse_one(handler); // Throws
+    return true;
+}
+
 inline bool TransactLogParser::has_next() noexcept
 {
     return m_input_begin != m_input_end || next_input_buffer();
@@ -1981,6 +2064,18 @@ void TransactLogParser::parse_one(InstructionHandler& handler)
                 parser_error();
             return;
         }
+        case instr_AddOrderedIndex: {
+            size_t col_ndx = read_int<size_t>();     // Throws
+            if (!handler.add_ordered_index(col_ndx)) // Throws
+                parser_error();
+            return;
+        }
+        case instr_RemoveOrderedIndex: {
+            size_t col_ndx = read_int<size_t>();        // Throws
+            if (!handler.remove_ordered_index(col_ndx)) // Throws
+                parser_error();
+            return;
+        }
         case instr_SetLinkType: {
             size_t col_ndx = read_int<size_t>(); // Throws
             int link_type = read_int<int>();     // Throws
@@ -2099,6 +2194,11 @@ void TransactLogParser::parse_one(InstructionHandler& handler)
                 parser_error();
             return;
         }
+        case instr_UnenumerateStringColumns: {
+            if (!handler.unenumerate_string_columns()) // Throws
+                parser_error();
+            return;
+        }
     }
 
     throw BadTransactLog();
@@ -2396,6 +2496,11 @@ public:
         return true; // No-op
     }
 
+    bool unenumerate_string_columns()
+    {
+        return true; // No-op
+    }
+
     bool insert_empty_rows(size_t row_ndx, size_t num_rows_to_insert, size_t prior_num_rows, bool unordered)
     {
         size_t num_rows_to_erase = num_rows_to_insert;
@@ -2549,6 +2654,16 @@ public:
         return true; // No-op
     }
 
+    bool add_ordered_index(size_t)
+    {
+        return true; // No-op
+    }
+
+    bool remove_ordered_index(size_t)
+    {
+        return true; // No-op
+    }
+
     bool set_link_type(size_t, LinkType)
     {
         return true; // No-op
@@ -0,0 +1,109 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_TRANSLATION_CACHE_HPP
+#define REALM_IMPL_TRANSLATION_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <realm/alloc.hpp>
+
+namespace realm {
+namespace _impl {
+
+
+/// A fixed-size cache of ref to address translations that can be used
+/// concurrently by any number of threads without locking.
+///
+/// It is intended to be shared by all the slab allocators that are attached to
+/// the same file in a process, and only for refs that point into the file,
+/// because the address of such a ref is the same for all of them. Entries never
+/// have to be invalidated, because the cache is created only after the initial
+/// mapping of the file is established, and from then on, mappings of the file
+/// are only ever added, never replaced or removed, until the cache is destroyed
+/// along with them.
+///
+/// Each entry is protected by a sequence number (a per-entry seqlock). A reader
+/// that observes a concurrent update of an entry treats it as a miss, and a
+/// writer that finds an entry being updated by another thread gives up, so
+/// neither readers nor writers ever wait.
+class TranslationCache {
+public:
+    static const size_t num_entries = 4096;
+
+    /// Returns null if the translation of \a ref is not in the cache.
+    const char* lookup(ref_type ref) const noexcept;
+
+    /// Record the translation of \a ref.
+    void insert(ref_type ref, const char* addr) noexcept;
+
+private:
+    struct Entry {
+        std::atomic<uint_fast32_t> seq{0};
+        std::atomic<ref_type> ref{0};
+        std::atomic<const char*> addr{nullptr};
+    };
+
+    Entry m_entries[num_entries];
+
+    static size_t get_index(ref_type) noexcept;
+};
+
+
+// Implementation:
+
+inline size_t TranslationCache::get_index(ref_type ref) noexcept
+{
+    // Refs are 8-byte aligned, so the low bits carry no information
+    uint_fast64_t hash = uint_fast64_t(ref >> 3) * 0x9E3779B97F4A7C15ULL;
+    return size_t(hash >> 52) & (num_entries - 1);
+}
+
+inline const char* TranslationCache::lookup(ref_type ref) const noexcept
+{
+    const Entry& entry = m_entries[get_index(ref)];
+    uint_fast32_t seq = entry.seq.load(std::memory_order_acquire);
+    if ((seq & 1) == 0) {
+        ref_type entry_ref = entry.ref.load(std::memory_order_relaxed);
+        const char* addr = entry.addr.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool consistent = entry.seq.load(std::memory_order_relaxed) == seq;
+        if (consistent && entry_ref == ref && addr)
+            return addr;
+    }
+    return nullptr;
+}
+
+inline void TranslationCache::insert(ref_type ref, const char* addr) noexcept
+{
+    Entry& entry = m_entries[get_index(ref)];
+    uint_fast32_t seq = entry.seq.load(std::memory_order_relaxed);
+    if ((seq & 1) != 0 || !entry.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_relaxed))
+        return; // Another thread is updating this entry
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.ref.store(ref, std::memory_order_relaxed);
+    entry.addr.store(addr, std::memory_order_relaxed);
+    entry.seq.store(seq + 2, std::memory_order_release);
+}
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_TRANSLATION_CACHE_HPP
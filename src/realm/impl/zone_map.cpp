@@ -0,0 +1,136 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+#include <limits>
+
+#include <realm/column.hpp>
+#include <realm/column_timestamp.hpp>
+#include <realm/impl/zone_map.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+
+ZoneMap ZoneMap::compute(const IntegerColumn& column)
+{
+    ZoneMap zone_map;
+    ArrayInteger fallback(column.get_alloc());
+    size_t size = column.size();
+    for (size_t ndx = 0; ndx < size;) {
+        const ArrayInteger* leaf;
+        IntegerColumn::LeafInfo leaf_info{&leaf, &fallback};
+        size_t ndx_in_leaf;
+        column.get_leaf(ndx, ndx_in_leaf, leaf_info);
+
+        Zone zone;
+        zone.end = ndx - ndx_in_leaf + leaf->size();
+        leaf->minimum(zone.min);
+        leaf->maximum(zone.max);
+        zone_map.m_zones.push_back(zone); // Throws
+        ndx = zone.end;
+    }
+    return zone_map;
+}
+
+
+template <class GetLeaf>
+ZoneMap ZoneMap::compute_nullable(size_t size, Allocator& alloc, GetLeaf get_leaf)
+{
+    ZoneMap zone_map;
+    ArrayIntNull fallback(alloc);
+    for (size_t ndx = 0; ndx < size;) {
+        const ArrayIntNull* leaf;
+        BpTree<util::Optional<int64_t>>::LeafInfo leaf_info{&leaf, &fallback};
+        size_t ndx_in_leaf;
+        get_leaf(ndx, ndx_in_leaf, leaf_info);
+
+        // ArrayIntNull::minimum() and maximum() do not reliably skip nulls
+        Zone zone;
+        zone.end = ndx - ndx_in_leaf + leaf->size();
+        zone.min = std::numeric_limits<int64_t>::max();
+        zone.max = std::numeric_limits<int64_t>::min();
+        for (size_t i = 0; i < leaf->size(); ++i) {
+            util::Optional<int64_t> value = leaf->get(i);
+            if (value) {
+                zone.min = std::min(zone.min, *value);
+                zone.max = std::max(zone.max, *value);
+            }
+        }
+        zone_map.m_zones.push_back(zone); // Throws
+        ndx = zone.end;
+    }
+    return zone_map;
+}
+
+
+ZoneMap ZoneMap::compute(const IntNullColumn& column)
+{
+    auto get_leaf = [&](size_t ndx, size_t& ndx_in_leaf, IntNullColumn::LeafInfo& leaf_info) {
+        column.get_leaf(ndx, ndx_in_leaf, leaf_info);
+    };
+    return compute_nullable(column.size(), column.get_alloc(), get_leaf); // Throws
+}
+
+
+ZoneMap ZoneMap::compute(const TimestampColumn& column)
+{
+    auto get_leaf = [&](size_t ndx, size_t& ndx_in_leaf, BpTree<util::Optional<int64_t>>::LeafInfo& leaf_info) {
+        column.get_seconds_leaf(ndx, ndx_in_leaf, leaf_info);
+    };
+    return compute_nullable(column.size(), column.get_alloc(), get_leaf); // Throws
+}
+
+
+void ZoneMap::widen(size_t row_ndx, int64_t value) noexcept
+{
+    auto zone_end_less = [](size_t ndx, const Zone& zone) { return ndx < zone.end; };
+    auto i = std::upper_bound(m_zones.begin(), m_zones.end(), row_ndx, zone_end_less);
+    REALM_ASSERT(i != m_zones.end());
+    i->min = std::min(i->min, value);
+    i->max = std::max(i->max, value);
+}
+
+
+template <bool candidate>
+size_t ZoneMap::find_zone(size_t begin, size_t end, int64_t first, int64_t last) const noexcept
+{
+    auto zone_end_less = [](size_t row_ndx, const Zone& zone) { return row_ndx < zone.end; };
+    auto i = std::upper_bound(m_zones.begin(), m_zones.end(), begin, zone_end_less);
+    for (; i != m_zones.end(); ++i) {
+        size_t zone_begin = i == m_zones.begin() ? 0 : (i - 1)->end;
+        if (zone_begin >= end)
+            break;
+        bool intersects = i->min <= last && i->max >= first;
+        if (intersects == candidate)
+            return std::max(begin, zone_begin);
+    }
+    return end;
+}
+
+
+size_t ZoneMap::skip(size_t begin, size_t end, int64_t first, int64_t last) const noexcept
+{
+    return find_zone<true>(begin, end, first, last);
+}
+
+
+size_t ZoneMap::skip_candidates(size_t begin, size_t end, int64_t first, int64_t last) const noexcept
+{
+    return find_zone<false>(begin, end, first, last);
+}
@@ -0,0 +1,134 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_ZONE_MAP_HPP
+#define REALM_IMPL_ZONE_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <realm/util/features.h>
+#include <realm/util/optional.hpp>
+#include <realm/column_fwd.hpp>
+
+namespace realm {
+
+class Allocator;
+
+namespace _impl {
+
+
+/// The smallest and the largest non-null value in each leaf of an integer or
+/// timestamp column. A search for values in a range can use it to skip leaves
+/// that cannot contain a match, without accessing them.
+///
+/// For timestamp columns, only the seconds are recorded.
+///
+/// A zone map must be updated through widen() and append() when values are
+/// set or rows are appended, and discarded when the column is modified in any
+/// other way. The bounds of a zone are then no longer necessarily the tightest
+/// ones, but they still contain every value in the zone.
+class ZoneMap {
+public:
+    static ZoneMap compute(const IntegerColumn&);
+    static ZoneMap compute(const IntNullColumn&);
+    static ZoneMap compute(const TimestampColumn&);
+
+    /// Widen the bounds of the zone that contains the specified row to
+    /// include `value`, after the row has been set to it.
+    void widen(size_t row_ndx, int64_t value) noexcept;
+
+    /// Extend the zone map by `num_rows` rows that have been appended to the
+    /// column. `get_value(i)` must return the value of the i'th appended row
+    /// as a `util::Optional<int64_t>`. The last zone is filled up to
+    /// REALM_MAX_BPNODE_SIZE rows before a new one is started, as the leaves
+    /// of a column are when rows are appended.
+    template <class F>
+    void append(size_t num_rows, F get_value);
+
+    /// The number of leaves.
+    size_t size() const noexcept;
+
+    /// Returns the first row in `[begin, end)` that is part of a leaf whose
+    /// values may intersect `[first, last]`, or `end` if there is none.
+    size_t skip(size_t begin, size_t end, int64_t first, int64_t last) const noexcept;
+
+    /// Returns the first row in `[begin, end)` that is part of a leaf whose
+    /// values cannot intersect `[first, last]`, or `end` if there is none.
+    size_t skip_candidates(size_t begin, size_t end, int64_t first, int64_t last) const noexcept;
+
+private:
+    struct Zone {
+        size_t end; // Index of the row after the last row of the leaf
+        int64_t min;
+        int64_t max; // Less than `min` if all values in the leaf are null
+    };
+    std::vector<Zone> m_zones;
+
+    template <bool candidate>
+    size_t find_zone(size_t begin, size_t end, int64_t first, int64_t last) const noexcept;
+
+    template <class GetLeaf>
+    static ZoneMap compute_nullable(size_t size, Allocator&, GetLeaf);
+};
+
+
+// Implementation:
+
+inline size_t ZoneMap::size() const noexcept
+{
+    return m_zones.size();
+}
+
+template <class F>
+void ZoneMap::append(size_t num_rows, F get_value)
+{
+    size_t begin = m_zones.empty() ? 0 : m_zones.back().end;
+    size_t end = begin + num_rows;
+    size_t row_ndx = begin;
+    while (row_ndx < end) {
+        size_t zone_begin = m_zones.size() < 2 ? 0 : m_zones[m_zones.size() - 2].end;
+        if (m_zones.empty() || m_zones.back().end - zone_begin >= REALM_MAX_BPNODE_SIZE) {
+            Zone zone;
+            zone.end = row_ndx;
+            zone.min = std::numeric_limits<int64_t>::max();
+            zone.max = std::numeric_limits<int64_t>::min();
+            m_zones.push_back(zone); // Throws
+            zone_begin = row_ndx;
+        }
+        Zone& zone = m_zones.back();
+        size_t zone_end = std::min(end, zone_begin + REALM_MAX_BPNODE_SIZE);
+        for (; row_ndx < zone_end; ++row_ndx) {
+            util::Optional<int64_t> value = get_value(row_ndx - begin);
+            if (value) {
+                zone.min = std::min(zone.min, *value);
+                zone.max = std::max(zone.max, *value);
+            }
+        }
+        zone.end = zone_end;
+    }
+}
+
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_ZONE_MAP_HPP
@@ -18,6 +18,9 @@
 
 // Test tool in test/test_csv/test.pl
 
+#include <algorithm>
+#include <cstring>
+#include <exception>
 #include <iostream>
 #include <limits>
 #include <sstream>
@@ -25,6 +28,8 @@
 #include <vector>
 
 #include <realm/util/assert.hpp>
+#include <realm/util/thread.hpp>
+#include <realm/impl/parallel_executor.hpp>
 #include <realm/importer.hpp>
 
 using namespace realm;
@@ -356,25 +361,26 @@ double Importer::parse_double(const char* col, bool* success, size_t* significan
     return x;
 }
 
-// Takes a row of payload and returns a vector of Realm types that can represent them. If a value can be represented
-// by multiple Realm types, it prioritizes Bool > Int > Float > Double > String. If Empty_as_string == true, then
-// empty strings turns into String type.
-std::vector<DataType> Importer::types(std::vector<std::string> v)
+// Takes a record of a block and returns a vector of Realm types that can represent its fields. If a value can be
+// represented by multiple Realm types, it prioritizes Bool > Int > Float > Double > String. If Empty_as_string ==
+// true, then empty strings turns into String type.
+std::vector<DataType> Importer::types(const RecordBlock& block, size_t record)
 {
     std::vector<DataType> res;
 
-    for (size_t t = 0; t < v.size(); t++) {
+    for (size_t t = 0; t < block.num_fields(record); t++) {
+        const char* v = block.get(record, t);
         bool i;
         bool d;
         bool f;
         bool b;
 
-        parse_integer<true>(v[t].c_str(), &i);
-        parse_double<true>(v[t].c_str(), &d);
-        parse_float<true>(v[t].c_str(), &f);
-        parse_bool<true>(v[t].c_str(), &b);
+        parse_integer<true>(v, &i);
+        parse_double<true>(v, &d);
+        parse_float<true>(v, &f);
+        parse_bool<true>(v, &b);
 
-        if (is_null(v[t].c_str()) && !Empty_as_string) {
+        if (is_null(v) && !Empty_as_string) {
             // If Empty_as_string == false, then empty strings may be represented by any of 0/0.0/false
             i = true;
             d = true;
@@ -389,7 +395,8 @@ std::vector<DataType> Importer::types(std::vector<std::string> v)
 }
 
 // Takes two vectors of Realm types, and for each field finds best type that can represent both.
-std::vector<DataType> Importer::lowest_common(std::vector<DataType> types1, std::vector<DataType> types2)
+std::vector<DataType> Importer::lowest_common(const std::vector<DataType>& types1,
+                                              const std::vector<DataType>& types2)
 {
     std::vector<DataType> res;
 
@@ -419,26 +426,27 @@ std::vector<DataType> Importer::lowest_common(std::vector<DataType> types1, std:
     return res;
 }
 
-// Takes payload vectors, and for each field finds best type that can represent all rows.
-std::vector<DataType> Importer::detect_scheme(std::vector<std::vector<std::string>> payload, size_t begin, size_t end)
+// Takes a block of records, and for each field finds best type that can represent all records in [begin, end).
+std::vector<DataType> Importer::detect_scheme(const RecordBlock& block, size_t begin, size_t end)
 {
     std::vector<DataType> res;
-    res = types(payload[begin]);
+    res = types(block, begin);
 
-    for (size_t t = begin + 1; t < end && t < payload.size(); t++) {
-        std::vector<DataType> t2 = types(payload[t]);
+    for (size_t t = begin + 1; t < end && t < block.size(); t++) {
+        std::vector<DataType> t2 = types(block, t);
         res = lowest_common(res, t2);
     }
     return res;
 }
 
-size_t Importer::tokenize(std::vector<std::vector<std::string>>& payload, size_t records)
+size_t Importer::tokenize(RecordBlock& block, size_t records)
 {
-    size_t original_size = payload.size();
+    size_t original_size = block.size();
+    std::vector<char>& data = block.data;
 
 nextrecord:
 
-    if (payload.size() - original_size >= records)
+    if (block.size() - original_size >= records)
         goto end;
 
     if (m_top - m_curpos < chunk_size / 2) {
@@ -455,13 +463,15 @@ nextrecord:
     if (src[m_curpos] == 0)
         goto end;
 
-    payload.push_back(std::vector<std::string>());
+    block.records.push_back(block.fields.size());
 
 nextfield:
-    payload.back().push_back("");
+    block.fields.push_back(data.size());
 
-    if (src[m_curpos] == 0)
+    if (src[m_curpos] == 0) {
+        data.push_back(0);
         goto end;
+    }
 
     while (src[m_curpos] == ' ')
         m_curpos++;
@@ -469,20 +479,29 @@ nextfield:
     if (src[m_curpos] == '"') {
         m_curpos++;
     payload:
-        // Field in quotes - can only end with another quote
-        while (src[m_curpos] != '"') {
-            // m_row is only used to display file line number in an err msg. We need to include field-embedded breaks
-            if (src[m_curpos] == 0xa)
-                m_row++;
-
-            // Payload character
-            payload.back().back().push_back(src[m_curpos]);
-            m_curpos++;
+        // Field in quotes - can only end with another quote. Copy everything up to the next quote at once.
+        {
+            const char* begin = src + m_curpos;
+            const char* quote = static_cast<const char*>(memchr(begin, '"', m_top - m_curpos));
+            if (!quote) {
+                char buf[100];
+                sprintf(buf, "Unterminated double-quoted field around line %lld in csv file",
+                        static_cast<unsigned long long>(m_row));
+                throw std::runtime_error(buf);
+            }
+
+            // m_row is only used to display file line number in an err msg. We need to include field-embedded
+            // breaks
+            m_row += std::count(begin, quote, char(0xa));
+
+            // Payload characters
+            data.insert(data.end(), begin, quote);
+            m_curpos = quote - src;
         }
 
         if (src[m_curpos + 1] == '"') {
             // Double-quote
-            payload.back().back().push_back('"');
+            data.push_back('"');
             m_curpos += 2;
             goto payload;
         }
@@ -500,16 +519,24 @@ nextfield:
         // Field not in quotes - cannot contain quotes or commas. So read until quote or comma or eof. Even though
         // it's
         // non-conforming, some CSV files can contain non-quoted line breaks, so we need to test if we can't test for
-        // new record by just testing for 0a/0d.
-        size_t fields = payload.back().size();
-
-        while (src[m_curpos] != Separator && src[m_curpos] != 0 &&
-               ((src[m_curpos] != 0xd && src[m_curpos] != 0xa) || (fields < m_fields && m_fields != size_t(-1)))) {
-            m_row += src[m_curpos] == 0xa;
-            payload.back().back().push_back(src[m_curpos]);
+        // new record by just testing for 0a/0d. The characters that can end the field are looked up in m_stop, so
+        // that ordinary characters are skipped with a single test each, and then copied at once.
+        size_t fields = block.fields.size() - block.records.back();
+        bool allow_breaks = fields < m_fields && m_fields != size_t(-1);
+        size_t begin = m_curpos;
+
+        for (;;) {
+            char c = src[m_curpos];
+            if (m_stop[static_cast<unsigned char>(c)]) {
+                if (!allow_breaks || (c != 0xd && c != 0xa))
+                    break;
+                m_row += c == 0xa;
+            }
             m_curpos++;
         }
+        data.insert(data.end(), src + begin, src + m_curpos);
     }
+    data.push_back(0);
 
     if (src[m_curpos] == 0)
         goto end;
@@ -525,11 +552,12 @@ nextfield:
         if (src[m_curpos] == 0xd || src[m_curpos] == 0xa)
             m_curpos++;
 
-        if (payload.size() >= 2) {
-            if (payload[payload.size() - 2].size() != payload[payload.size() - 1].size()) {
+        size_t n = block.size();
+        if (n >= 2) {
+            if (block.num_fields(n - 2) != block.num_fields(n - 1)) {
                 // We don't use n-versions of printf because windows needs some macro tweaking for it
                 char buf[500];
-                std::string s = payload[payload.size() - 1][0];
+                std::string s = block.get(n - 1, 0);
                 if (s.length() > 100)
                     s = s.substr(0, 100);
                 sprintf(buf, "Wrong number of delimitors around line %lld (+|- 3) in csv file. First few characters "
@@ -546,24 +574,169 @@ nextfield:
 
 end:
 
-    return payload.size() - original_size;
+    return block.size() - original_size;
+}
+
+// Parses the records [begin, end) of a block into typed column buffers, and appends them to the table. The
+// columns are parsed in parallel, in runs of parse_chunk_size records.
+void Importer::import_block(const RecordBlock& block, size_t begin, size_t end, Table& table,
+                            const std::vector<DataType>& scheme, size_t imported_rows, size_t type_detection_rows)
+{
+    const size_t parse_chunk_size = 1024;
+    size_t num_rows = end - begin;
+    size_t num_cols = scheme.size();
+    size_t num_chunks = (num_rows + parse_chunk_size - 1) / parse_chunk_size;
+
+    m_columns.resize(num_cols);
+    for (size_t col = 0; col < num_cols; col++) {
+        ColumnBuffer& buffer = m_columns[col];
+        if (scheme[col] == type_String)
+            buffer.strings.resize(num_rows);
+        else if (scheme[col] == type_Int)
+            buffer.ints.resize(num_rows);
+        else if (scheme[col] == type_Double)
+            buffer.doubles.resize(num_rows);
+        else if (scheme[col] == type_Float)
+            buffer.floats.resize(num_rows);
+        else if (scheme[col] == type_Bool) {
+            if (buffer.bools_size < num_rows) {
+                buffer.bools.reset(new bool[num_rows]);
+                buffer.bools_size = num_rows;
+            }
+        }
+        else
+            REALM_ASSERT(false);
+    }
+
+    // For every task, the first row (relative to `begin`) in which a field could not be parsed, or npos
+    std::vector<size_t> failed_rows(num_chunks * num_cols, npos);
+
+    auto parse = [&](size_t task_ndx, size_t) {
+        size_t col = task_ndx % num_cols;
+        size_t first = task_ndx / num_cols * parse_chunk_size;
+        size_t last = std::min(first + parse_chunk_size, num_rows);
+        ColumnBuffer& buffer = m_columns[col];
+        for (size_t row = first; row < last; row++) {
+            const char* field = block.get(begin + row, col);
+            bool success = true;
+
+            if (scheme[col] == type_String)
+                buffer.strings[row] = StringData(field);
+            else if (scheme[col] == type_Int)
+                buffer.ints[row] = parse_integer<true>(field, &success);
+            else if (scheme[col] == type_Double)
+                buffer.doubles[row] = parse_double<true>(field, &success);
+            else if (scheme[col] == type_Float)
+                buffer.floats[row] = parse_float<true>(field, &success);
+            else if (scheme[col] == type_Bool)
+                buffer.bools[row] = parse_bool<true>(field, &success);
+
+            if (!success) {
+                failed_rows[task_ndx] = row;
+                return;
+            }
+        }
+    };
+    _impl::ParallelExecutor::get_default().run(num_chunks * num_cols, parse);
+
+    // Report the first failure in the order the fields appear in the file
+    size_t failed_row = npos;
+    size_t failed_col = npos;
+    for (size_t task_ndx = 0; task_ndx < failed_rows.size(); task_ndx++) {
+        size_t row = failed_rows[task_ndx];
+        size_t col = task_ndx % num_cols;
+        if (row < failed_row || (row == failed_row && row != npos && col < failed_col)) {
+            failed_row = row;
+            failed_col = col;
+        }
+    }
+
+    if (failed_row != npos) {
+        size_t col = failed_col;
+        const char* field = block.get(begin + failed_row, col);
+        size_t row_in_file = imported_rows + failed_row;
+
+        // Remove all columns so that user can call csv_import() on it again
+        table.clear();
+
+        for (size_t t = 0; t < table.get_column_count(); t++)
+            table.remove_column(0);
+
+        std::stringstream sstm;
+
+        if (type_detection_rows > 0) {
+            if (scheme[col] != type_String && is_null(field) && Empty_as_string)
+                sstm << "Column " << col << " was auto detected to be of type " << DataTypeToText(scheme[col])
+                     << " using the first " << type_detection_rows << " rows of CSV file, but in row " << row_in_file
+                     << " of cvs file the field contained the NULL value '" << field
+                     << "'. Please increase the 'type_detection_rows' argument or set "
+                     << "Empty_as_string = false/void the -e flag to convert such fields to 0, 0.0 or "
+                        "false";
+            else
+                sstm << "Column " << col << " was auto detected to be of type " << DataTypeToText(scheme[col])
+                     << " using the first " << type_detection_rows << " rows of CSV file, but in row " << row_in_file
+                     << " of cvs file the field contained '" << field
+                     << "' which is of another type. Please increase the 'type_detection_rows' argument";
+        }
+        else
+            sstm << "Column " << col << " was specified to be of type " << DataTypeToText(scheme[col])
+                 << ", but in row " << row_in_file << " of cvs file,"
+                 << "the field contained '" << field << "' which is of another type";
+
+        throw std::runtime_error(sstm.str());
+    }
+
+    std::vector<BulkColumn> columns;
+    columns.reserve(num_cols);
+    for (size_t col = 0; col < num_cols; col++) {
+        ColumnBuffer& buffer = m_columns[col];
+        if (scheme[col] == type_String)
+            columns.emplace_back(col, buffer.strings.data());
+        else if (scheme[col] == type_Int)
+            columns.emplace_back(col, buffer.ints.data());
+        else if (scheme[col] == type_Double)
+            columns.emplace_back(col, buffer.doubles.data());
+        else if (scheme[col] == type_Float)
+            columns.emplace_back(col, buffer.floats.data());
+        else if (scheme[col] == type_Bool)
+            columns.emplace_back(col, static_cast<const bool*>(buffer.bools.get()));
+    }
+    table.add_rows(num_rows, columns);
+
+    if (!Quiet) {
+        for (size_t row = imported_rows; row < imported_rows + num_rows; row++) {
+            if (row < 10)
+                print_row(table, row);
+            else if (row == 11)
+                std::cout << "\nOnly showing first few rows...\n";
+        }
+    }
 }
 
 size_t Importer::import_csv(FILE* file, Table& table, std::vector<DataType>* import_scheme,
                             std::vector<std::string>* column_names, size_t type_detection_rows,
                             size_t skip_first_rows, size_t import_rows)
 {
-    std::vector<std::vector<std::string>>
-        payload;                     // Used to build a 2D string vector with rows and columns of .csv content.
-    std::vector<std::string> header; // Column names (will be either auto-detected or read from cmd line args)
-    std::vector<DataType> scheme;    // Scheme (will be either auto-detected or read from cmd line args)
-    bool header_present = false;     // Used only in auto-detection mode.
+    RecordBlock* payload = &m_blocks[0]; // Records of .csv content
+    RecordBlock* next_payload = &m_blocks[1];
+    size_t payload_begin = 0;         // First record of `payload` that is not a header
+    std::vector<std::string> header;  // Column names (will be either auto-detected or read from cmd line args)
+    std::vector<DataType> scheme;     // Scheme (will be either auto-detected or read from cmd line args)
+    bool header_present = false;      // Used only in auto-detection mode.
 
     m_top = 0;
     m_curpos = 0;
     m_fields = static_cast<size_t>(-1);
     m_file = file;
     m_row = 1;
+    payload->clear();
+    next_payload->clear();
+
+    std::fill(m_stop, m_stop + 256, false);
+    m_stop[static_cast<unsigned char>(Separator)] = true;
+    m_stop[0] = true;
+    m_stop[0xd] = true;
+    m_stop[0xa] = true;
 
     if (import_scheme == nullptr) {
         // Header detection: 1) If first line is strings-only and next line has at least 1 occurence of non-string,
@@ -572,19 +745,21 @@ size_t Importer::import_csv(FILE* file, Table& table, std::vector<DataType>* imp
         // not present. 3) If first two lines are strings-only, we can't tell, and treat both as payload
 
         // So, first read two lines
-        tokenize(payload, 2);
+        tokenize(*payload, 2);
+        if (payload->size() == 0)
+            throw std::runtime_error("The csv file is empty");
 
         // To detect empty strings for case 2 above, we need to temporarely disable Empty_as_string
         bool original_empty_as_string_flag = Empty_as_string;
         Empty_as_string = false;
-        std::vector<DataType> scheme1 = detect_scheme(payload, 0, 1);
+        std::vector<DataType> scheme1 = detect_scheme(*payload, 0, 1);
 
         // First row is best one to detect number of fields since it's less likely to contain embedded line breaks
         // (field payload that contains a line break) because it some times is a header.
         m_fields = scheme1.size();
 
 
-        std::vector<DataType> scheme2 = detect_scheme(payload, 1, 2);
+        std::vector<DataType> scheme2 = detect_scheme(*payload, 1, 2);
         bool only_strings1 = true;
         bool only_strings2 = true;
         for (size_t t = 0; t < scheme1.size() - 1; t++) {
@@ -597,7 +772,7 @@ size_t Importer::import_csv(FILE* file, Table& table, std::vector<DataType>* imp
         // For the first row, the last column is allowed to be "" and still be header. The only reason we allow this
         // is
         // because the "flight-database" we use internally and for demonstration purpose is "malformed" that way.
-        if (scheme1[scheme1.size() - 1] != type_String && payload[0][payload[0].size() - 1] != "")
+        if (scheme1[scheme1.size() - 1] != type_String && *payload->get(0, scheme1.size() - 1) != 0)
             only_strings1 = false;
         if (scheme2[scheme2.size() - 1] != type_String)
             only_strings2 = false;
@@ -610,8 +785,9 @@ size_t Importer::import_csv(FILE* file, Table& table, std::vector<DataType>* imp
 
         if (header_present) {
             // Use first row of csv for column names
-            header = payload[0];
-            payload.erase(payload.begin());
+            for (size_t t = 0; t < payload->num_fields(0); t++)
+                header.push_back(payload->get(0, t));
+            payload_begin = 1;
 
             for (size_t t = 0; t < header.size(); t++) {
                 // In flight database, header is present but contains null ("") as last field. We replace such
@@ -633,8 +809,8 @@ size_t Importer::import_csv(FILE* file, Table& table, std::vector<DataType>* imp
         }
 
         // Detect scheme using next N rows.
-        tokenize(payload, type_detection_rows);
-        scheme = detect_scheme(payload, 0, type_detection_rows);
+        tokenize(*payload, type_detection_rows);
+        scheme = detect_scheme(*payload, payload_begin, payload_begin + type_detection_rows);
     }
     else {
         // Use user provided column names and types
@@ -653,86 +829,55 @@ size_t Importer::import_csv(FILE* file, Table& table, std::vector<DataType>* imp
 
     // Skip first rows if user specified -s flag
     if (skip_first_rows > 0) {
-        tokenize(payload, skip_first_rows);
-        payload.clear();
+        tokenize(*payload, skip_first_rows);
+        payload->clear();
     }
 
-    do {
-        for (size_t row = 0; row < payload.size(); row++) {
-
-            if (imported_rows == import_rows)
-                return imported_rows;
-
-            if (!Quiet && imported_rows % 123 == 0)
-                std::cout << imported_rows << " rows\r";
-
-            // Add empty row to Realm
-            table.add_empty_row();
-
-            // Add all fields to new row
-            for (size_t col = 0; col < scheme.size(); col++) {
-                bool success = true;
-
-                if (scheme[col] == type_String)
-                    table.set_string(col, imported_rows, StringData(payload[row][col]));
-                else if (scheme[col] == type_Int)
-                    table.set_int(col, imported_rows, parse_integer<true>(payload[row][col].c_str(), &success));
-                else if (scheme[col] == type_Double)
-                    table.set_double(col, imported_rows, parse_double<true>(payload[row][col].c_str(), &success));
-                else if (scheme[col] == type_Float)
-                    table.set_float(col, imported_rows, parse_float<true>(payload[row][col].c_str(), &success));
-                else if (scheme[col] == type_Bool)
-                    table.set_bool(col, imported_rows, parse_bool<true>(payload[row][col].c_str(), &success));
-                else
-                    REALM_ASSERT(false);
-
-                if (!success) {
-                    // Remove all columns so that user can call csv_import() on it again
-                    table.clear();
-
-                    for (size_t t = 0; t < table.get_column_count(); t++)
-                        table.remove_column(0);
-
-                    std::stringstream sstm;
-
-                    if (type_detection_rows > 0) {
-                        if (scheme[col] != type_String && is_null(payload[row][col].c_str()) && Empty_as_string)
-                            sstm << "Column " << col << " was auto detected to be of type "
-                                 << DataTypeToText(scheme[col]) << " using the first " << type_detection_rows
-                                 << " rows of CSV file, but in row " << imported_rows
-                                 << " of cvs file the field contained the NULL value '" << payload[row][col].c_str()
-                                 << "'. Please increase the 'type_detection_rows' argument or set "
-                                 << "Empty_as_string = false/void the -e flag to convert such fields to 0, 0.0 or "
-                                    "false";
-                        else
-                            sstm << "Column " << col << " was auto detected to be of type "
-                                 << DataTypeToText(scheme[col]) << " using the first " << type_detection_rows
-                                 << " rows of CSV file, but in row " << imported_rows
-                                 << " of cvs file the field contained '" << payload[row][col].c_str()
-                                 << "' which is of another type. Please increase the 'type_detection_rows' argument";
-                    }
-                    else
-                        sstm << "Column " << col << " was specified to be of type " << DataTypeToText(scheme[col])
-                             << ", but in row " << imported_rows << " of cvs file,"
-                             << "the field contained '" << payload[row][col].c_str() << "' which is of another type";
-
-                    throw std::runtime_error(sstm.str());
+    if (payload->size() == payload_begin)
+        tokenize(*payload, record_chunks);
+
+    while (payload->size() > payload_begin) {
+        size_t end = payload->size();
+        if (end - payload_begin > import_rows - imported_rows)
+            end = payload_begin + (import_rows - imported_rows);
+        bool last = imported_rows + (end - payload_begin) == import_rows;
+
+        // Tokenize the next block while this one is being imported
+        std::exception_ptr tokenize_error;
+        util::Thread tokenizer;
+        if (!last) {
+            tokenizer.start([&] {
+                try {
+                    tokenize(*next_payload, record_chunks);
                 }
-            }
+                catch (...) {
+                    tokenize_error = std::current_exception();
+                }
+            });
+        }
 
+        try {
+            if (!Quiet)
+                std::cout << imported_rows << " rows\r";
+            import_block(*payload, payload_begin, end, table, scheme, imported_rows, type_detection_rows);
+        }
+        catch (...) {
+            if (tokenizer.joinable())
+                tokenizer.join();
+            throw;
+        }
+        imported_rows += end - payload_begin;
 
-            if (!Quiet) {
-                if (imported_rows < 10)
-                    print_row(table, imported_rows);
-                else if (imported_rows == 11)
-                    std::cout << "\nOnly showing first few rows...\n";
-            }
+        if (last)
+            break;
+        tokenizer.join();
+        if (tokenize_error)
+            std::rethrow_exception(tokenize_error);
 
-            imported_rows++;
-        }
-        payload.clear();
-        tokenize(payload, record_chunks);
-    } while (payload.size() > 0);
+        payload->clear();
+        std::swap(payload, next_payload);
+        payload_begin = 0;
+    }
 
     return imported_rows;
 }
@@ -61,10 +61,13 @@ Design:
 
 import_csv(csv file handle, realm table)
     Calls tokenize(csv file handle):
-        reads payload chunk and returns std::vector<std::vector<std::string>> with the right dimensions filled with
-        rows and columns of the chunk payload
-    Calls parse_float(), parse_bool(), etc, which tests for type and returns converted values
-    Calls table.add_empty_row(), table.set_float(), table.set_bool()
+        reads payload chunk and appends the records of the chunk to a RecordBlock, which stores all field values
+        back to back in a single buffer
+    Reads blocks of record_chunks records in a pipeline: while one block is converted and inserted into the table,
+    the next block is tokenized on a separate thread. Only two blocks are held in memory at any time
+    Calls parse_float(), parse_bool(), etc, which tests for type and returns converted values. The fields of a
+    block are parsed into typed, column-major buffers in parallel
+    Calls table.add_rows() once per block with the typed buffers
 */
 
 #include <cstddef>
@@ -77,11 +80,12 @@ import_csv(csv file handle, realm table)
 static const size_t chunk_size = 32 * 1024;
 
 // Number of rows to csv-parse + insert into realm in each iteration.
-static const size_t record_chunks = 100;
+static const size_t record_chunks = 10000;
 
 // Width of each column when printing them on screen (non-Quiet mode)
 const size_t print_width = 25;
 
+#include <memory>
 #include <vector>
 #include <realm.hpp>
 
@@ -102,9 +106,51 @@ public:
     bool Empty_as_string; // Import columns that have occurences of empty strings as String type column
 
 private:
+    // A block of tokenized records. The values of all fields are stored back to back in `data`, each one terminated
+    // by a zero byte. `fields` holds the offset in `data` of every field, and `records` holds the index in `fields`
+    // of the first field of every record. The buffers are reused from block to block, so tokenizing does not
+    // allocate memory per field.
+    struct RecordBlock {
+        std::vector<char> data;
+        std::vector<size_t> fields;
+        std::vector<size_t> records;
+
+        size_t size() const noexcept
+        {
+            return records.size();
+        }
+        size_t num_fields(size_t record) const noexcept
+        {
+            size_t end = record + 1 < records.size() ? records[record + 1] : fields.size();
+            return end - records[record];
+        }
+        const char* get(size_t record, size_t field) const noexcept
+        {
+            return data.data() + fields[records[record] + field];
+        }
+        void clear() noexcept
+        {
+            data.clear();
+            fields.clear();
+            records.clear();
+        }
+    };
+
+    // Parsed values of one column of a block
+    struct ColumnBuffer {
+        std::vector<int64_t> ints;
+        std::vector<float> floats;
+        std::vector<double> doubles;
+        std::vector<StringData> strings;
+        std::unique_ptr<bool[]> bools;
+        size_t bools_size = 0;
+    };
+
     size_t import_csv(FILE* file, Table& table, std::vector<DataType>* import_scheme,
                       std::vector<std::string>* column_names, size_t type_detection_rows, size_t skip_first_rows,
                       size_t import_rows);
+    void import_block(const RecordBlock& block, size_t begin, size_t end, Table& table,
+                      const std::vector<DataType>& scheme, size_t imported_rows, size_t type_detection_rows);
     template <bool can_fail>
     float parse_float(const char* col, bool* success = nullptr);
     template <bool can_fail>
@@ -113,10 +159,10 @@ private:
     int64_t parse_integer(const char* col, bool* success = nullptr);
     template <bool can_fail>
     bool parse_bool(const char* col, bool* success = nullptr);
-    std::vector<DataType> types(std::vector<std::string> v);
-    size_t tokenize(std::vector<std::vector<std::string>>& payload, size_t records);
-    std::vector<DataType> detect_scheme(std::vector<std::vector<std::string>> payload, size_t begin, size_t end);
-    std::vector<DataType> lowest_common(std::vector<DataType> types1, std::vector<DataType> types2);
+    std::vector<DataType> types(const RecordBlock& block, size_t record);
+    size_t tokenize(RecordBlock& block, size_t records);
+    std::vector<DataType> detect_scheme(const RecordBlock& block, size_t begin, size_t end);
+    std::vector<DataType> lowest_common(const std::vector<DataType>& types1, const std::vector<DataType>& types2);
 
     char src[2 * chunk_size]; // .csv input buffer
     size_t m_top;             // points at top of buffer
@@ -124,6 +170,10 @@ private:
     FILE* m_file;             // handle to .csv file
     size_t m_fields;          // number of fields in each row
     size_t m_row;             // current row in .csv file, including field-embedded line breaks. Used for err msg only
+    bool m_stop[256];         // characters that end a non-quoted field: separator, line breaks, and end of input
+
+    RecordBlock m_blocks[2];             // block being imported, and block being tokenized
+    std::vector<ColumnBuffer> m_columns; // parsed values of the block being imported
 };
 
 } // namespace realm
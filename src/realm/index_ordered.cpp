@@ -0,0 +1,277 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <realm/index_ordered.hpp>
+#include <realm/impl/destroy_guard.hpp>
+#include <realm/util/assert.hpp>
+
+using namespace realm;
+
+
+OrderedIndex::OrderedIndex(ArrayParent* parent, size_t ndx_in_parent, Allocator& alloc)
+    : OrderedIndex(create_empty(alloc), parent, ndx_in_parent, alloc) // Throws
+{
+}
+
+
+OrderedIndex::OrderedIndex(ref_type ref, ArrayParent* parent, size_t ndx_in_parent, Allocator& alloc)
+    : m_top(alloc)
+    , m_high(alloc)
+    , m_low(alloc)
+    , m_rows(alloc)
+{
+    m_top.init_from_ref(ref);
+    m_top.set_parent(parent, ndx_in_parent);
+    init_trees(); // Throws
+}
+
+
+ref_type OrderedIndex::create_empty(Allocator& alloc)
+{
+    Array top(alloc);
+    _impl::DeepArrayDestroyGuard dg(&top);
+    top.create(Array::type_HasRefs); // Throws
+    for (int i = 0; i < 3; ++i) {
+        MemRef mem = BpTree<int64_t>::create_leaf(Array::type_Normal, 0, 0, alloc); // Throws
+        _impl::DeepArrayRefDestroyGuard dg_2(mem.get_ref(), alloc);
+        int_fast64_t v(from_ref(mem.get_ref()));
+        top.add(v); // Throws
+        dg_2.release();
+    }
+    dg.release();
+    return top.get_ref();
+}
+
+
+void OrderedIndex::init_trees()
+{
+    m_high.init_from_ref(get_alloc(), m_top.get_as_ref(0)); // Throws
+    m_high.set_parent(&m_top, 0);
+    m_low.init_from_ref(get_alloc(), m_top.get_as_ref(1)); // Throws
+    m_low.set_parent(&m_top, 1);
+    m_rows.init_from_ref(get_alloc(), m_top.get_as_ref(2)); // Throws
+    m_rows.set_parent(&m_top, 2);
+}
+
+
+OrderedIndex::Key OrderedIndex::min_key() noexcept
+{
+    return Key{std::numeric_limits<int64_t>::min(), std::numeric_limits<int32_t>::min()};
+}
+
+
+OrderedIndex::Key OrderedIndex::max_key() noexcept
+{
+    return Key{std::numeric_limits<int64_t>::max(), std::numeric_limits<int32_t>::max()};
+}
+
+
+OrderedIndex::Key OrderedIndex::next(Key key) noexcept
+{
+    REALM_ASSERT_DEBUG(key != max_key());
+    if (key.low != std::numeric_limits<int32_t>::max())
+        return Key{key.high, key.low + 1};
+    return Key{key.high + 1, std::numeric_limits<int32_t>::min()};
+}
+
+
+OrderedIndex::Key OrderedIndex::prev(Key key) noexcept
+{
+    REALM_ASSERT_DEBUG(key != min_key());
+    if (key.low != std::numeric_limits<int32_t>::min())
+        return Key{key.high, key.low - 1};
+    return Key{key.high - 1, std::numeric_limits<int32_t>::max()};
+}
+
+
+bool OrderedIndex::get_key(double value, Key& key) noexcept
+{
+    // Null is a NaN
+    if (std::isnan(value))
+        return false;
+    if (value == 0)
+        value = 0; // Same key for -0 and +0
+    int64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    // Positive doubles order like their bit patterns. Flipping all bits but
+    // the sign bit of negative doubles makes them order like their values too.
+    key.high = bits < 0 ? bits ^ std::numeric_limits<int64_t>::max() : bits;
+    key.low = 0;
+    return true;
+}
+
+
+void OrderedIndex::destroy() noexcept
+{
+    if (m_top.is_attached())
+        m_top.destroy_deep();
+}
+
+
+void OrderedIndex::update_from_parent(size_t old_baseline) noexcept
+{
+    if (!m_top.update_from_parent(old_baseline))
+        return;
+    m_high.update_from_parent(old_baseline);
+    m_low.update_from_parent(old_baseline);
+    m_rows.update_from_parent(old_baseline);
+}
+
+
+void OrderedIndex::refresh_accessor_tree(size_t, const Spec&)
+{
+    m_top.init_from_parent();
+    m_high.init_from_parent(); // Throws
+    m_low.init_from_parent();  // Throws
+    m_rows.init_from_parent(); // Throws
+}
+
+
+void OrderedIndex::clear()
+{
+    m_high.clear(); // Throws
+    m_low.clear();  // Throws
+    m_rows.clear(); // Throws
+}
+
+
+size_t OrderedIndex::find_position(Key key, size_t row_ndx) const noexcept
+{
+    // Binary search over the positions of the entries, comparing the high
+    // part of the key first, and only reading the rest when it is equal
+    size_t begin = 0;
+    size_t end = size();
+    while (begin < end) {
+        size_t mid = begin + (end - begin) / 2;
+        int64_t high = m_high.get(mid);
+        bool less = high < key.high;
+        if (high == key.high) {
+            int32_t low = int32_t(m_low.get(mid));
+            less = low < key.low || (low == key.low && size_t(m_rows.get(mid)) < row_ndx);
+        }
+        if (less) {
+            begin = mid + 1;
+        }
+        else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+
+size_t OrderedIndex::lower_bound(Key key) const noexcept
+{
+    return find_position(key, 0);
+}
+
+
+size_t OrderedIndex::upper_bound(Key key) const noexcept
+{
+    if (key == max_key())
+        return size();
+    return find_position(next(key), 0);
+}
+
+
+size_t OrderedIndex::count(Key first, Key last) const noexcept
+{
+    if (last < first)
+        return 0;
+    return upper_bound(last) - lower_bound(first);
+}
+
+
+void OrderedIndex::find_all(Key first, Key last, std::vector<size_t>& rows) const
+{
+    if (last < first)
+        return;
+    size_t begin = lower_bound(first);
+    size_t end = upper_bound(last);
+    size_t offset = rows.size();
+    rows.reserve(offset + (end - begin)); // Throws
+    Reader reader(m_rows);
+    for (size_t pos = begin; pos < end; ++pos)
+        rows.push_back(size_t(reader.get(pos)));
+    std::sort(rows.begin() + offset, rows.end());
+}
+
+
+void OrderedIndex::do_insert(size_t row_ndx, const Key* key, size_t num_rows, bool is_append)
+{
+    // Adding the same amount to all row indexes from a certain row index and
+    // up keeps the entries in order
+    if (!is_append)
+        m_rows.adjust_ge(int64_t(row_ndx), int64_t(num_rows)); // Throws
+    if (!key)
+        return;
+
+    // The new rows go before the entries with the same key and greater row
+    // indexes
+    size_t pos = find_position(*key, row_ndx);
+    size_t pos_or_npos_if_append = (pos == size() ? npos : pos);
+    m_high.insert(pos_or_npos_if_append, key->high, num_rows); // Throws
+    m_low.insert(pos_or_npos_if_append, key->low, num_rows);   // Throws
+    for (size_t i = 0; i < num_rows; ++i) {
+        size_t pos_2 = (pos_or_npos_if_append == npos ? npos : pos + i);
+        m_rows.insert(pos_2, int64_t(row_ndx + i)); // Throws
+    }
+}
+
+
+void OrderedIndex::do_erase(size_t row_ndx, const Key* key, bool is_last)
+{
+    if (key) {
+        size_t pos = find_position(*key, row_ndx);
+        REALM_ASSERT_3(pos, <, size());
+        REALM_ASSERT_3(size_t(m_rows.get(pos)), ==, row_ndx);
+        bool is_last_entry = pos == size() - 1;
+        m_high.erase(pos, is_last_entry); // Throws
+        m_low.erase(pos, is_last_entry);  // Throws
+        m_rows.erase(pos, is_last_entry); // Throws
+    }
+    if (!is_last)
+        m_rows.adjust_ge(int64_t(row_ndx + 1), -1); // Throws
+}
+
+
+void OrderedIndex::verify(size_t num_rows) const
+{
+    size_t n = size();
+    REALM_ASSERT_3(m_high.size(), ==, n);
+    REALM_ASSERT_3(m_low.size(), ==, n);
+    std::vector<bool> seen(num_rows);
+    bool first = true;
+    Entry prev_entry{};
+    for_each(0, n, [&](const Entry& entry) {
+        REALM_ASSERT_3(entry.row_ndx, <, num_rows);
+        REALM_ASSERT(!seen[entry.row_ndx]);
+        seen[entry.row_ndx] = true;
+        if (!first) {
+            REALM_ASSERT(prev_entry.key <= entry.key);
+            REALM_ASSERT(prev_entry.key != entry.key || prev_entry.row_ndx < entry.row_ndx);
+        }
+        first = false;
+        prev_entry = entry;
+    });
+}
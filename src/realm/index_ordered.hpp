@@ -0,0 +1,368 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_INDEX_ORDERED_HPP
+#define REALM_INDEX_ORDERED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <realm/array.hpp>
+#include <realm/array_integer.hpp>
+#include <realm/bptree.hpp>
+#include <realm/null.hpp>
+#include <realm/timestamp.hpp>
+#include <realm/util/optional.hpp>
+
+/*
+The OrderedIndex class is a secondary index over an integer, float, double or timestamp column, which keeps the rows
+in the order of their values. Unlike StringIndex, which converts integral values to strings and therefore only
+supports lookups by equality, it answers range lookups (`<`, `<=`, `>`, `>=` and between), and allows the rows of
+the column to be visited in sorted order.
+
+Every non-null value is reduced to a key made of a 64-bit and a 32-bit part, such that the lexicographic order of
+the keys is the order of the values. Integers are stored in the first part. Floats and doubles are stored as their
+bit patterns, transformed so that they order like the values. Timestamps are stored as seconds and nanoseconds.
+Nulls and NaNs are not indexed, since they match no range.
+
+The index is stored in the Realm file, in the slot that follows its column in the list of column refs of the table,
+like a search index. Its top array holds the refs of three integer B+-trees of equal size, which hold the two parts
+of the key and the row index of every entry. The entries are ordered by key, and then by row index, so an entry is
+found by a binary search over its position. When rows are inserted or erased in the middle of the column, the row
+indexes of the subsequent entries are adjusted in place, which does not change their order.
+
+Slot | Value
+------------------------
+0    | Ref of the high parts of the keys
+1    | Ref of the low parts of the keys
+2    | Ref of the row indexes
+*/
+
+namespace realm {
+
+class Spec;
+
+class OrderedIndex {
+public:
+    struct Key {
+        int64_t high;
+        int32_t low;
+    };
+
+    struct Entry {
+        Key key;
+        size_t row_ndx;
+    };
+
+    /// Create a new, empty index, and attach this accessor to it.
+    OrderedIndex(ArrayParent*, size_t ndx_in_parent, Allocator&);
+
+    /// Attach to an existing index.
+    OrderedIndex(ref_type, ArrayParent*, size_t ndx_in_parent, Allocator&);
+
+    static ref_type create_empty(Allocator&);
+
+    static Key min_key() noexcept;
+    static Key max_key() noexcept;
+
+    /// The smallest key that is greater than the specified one. The key must
+    /// not be max_key().
+    static Key next(Key) noexcept;
+
+    /// The largest key that is less than the specified one. The key must not
+    /// be min_key().
+    static Key prev(Key) noexcept;
+
+    /// Get the key of the specified value. Returns false for values that are
+    /// not indexed (null and NaN).
+    static bool get_key(int64_t, Key&) noexcept;
+    static bool get_key(util::Optional<int64_t>, Key&) noexcept;
+    static bool get_key(float, Key&) noexcept;
+    static bool get_key(double, Key&) noexcept;
+    static bool get_key(Timestamp, Key&) noexcept;
+
+    // Accessor concept:
+    Allocator& get_alloc() const noexcept;
+    void destroy() noexcept;
+    bool is_attached() const noexcept;
+    void set_parent(ArrayParent* parent, size_t ndx_in_parent) noexcept;
+    size_t get_ndx_in_parent() const noexcept;
+    void set_ndx_in_parent(size_t ndx_in_parent) noexcept;
+    void update_from_parent(size_t old_baseline) noexcept;
+    void refresh_accessor_tree(size_t, const Spec&);
+    ref_type get_ref() const noexcept;
+
+    /// Add an entry for every indexed row among the first `num_rows` rows,
+    /// where `get(row_ndx)` returns the value of a row. The index must be
+    /// empty.
+    template <class Get>
+    void populate(size_t num_rows, Get get);
+
+    template <class T>
+    void insert(size_t row_ndx, T value, size_t num_rows, bool is_append);
+    template <class T>
+    void set(size_t row_ndx, T old_value, T new_value);
+    template <class T>
+    void erase(size_t row_ndx, T value, bool is_last);
+    template <class T>
+    void move_last_over(size_t row_ndx, T value, size_t last_row_ndx, T last_value);
+    template <class T>
+    void swap(size_t row_ndx_1, T value_1, size_t row_ndx_2, T value_2);
+    void clear();
+
+    /// The number of indexed (non-null) rows.
+    size_t size() const noexcept;
+
+    /// The entry at the specified position in the order of the keys, and then
+    /// of the row indexes.
+    Entry get(size_t pos) const noexcept;
+
+    /// The position of the first entry with a key that is not less than,
+    /// respectively greater than, the specified key.
+    size_t lower_bound(Key) const noexcept;
+    size_t upper_bound(Key) const noexcept;
+
+    /// The number of rows with a key in `[first, last]`.
+    size_t count(Key first, Key last) const noexcept;
+
+    /// Append the indexes of the rows with a key in `[first, last]` to
+    /// `rows`, in increasing order of row index.
+    void find_all(Key first, Key last, std::vector<size_t>& rows) const;
+
+    /// Call `handler(entry)` for the entries at the positions in
+    /// `[begin, end)`, in order.
+    template <class Handler>
+    void for_each(size_t begin, size_t end, Handler handler) const;
+
+    void verify(size_t num_rows) const;
+
+private:
+    Array m_top;
+    BpTree<int64_t> m_high;
+    BpTree<int64_t> m_low;
+    BpTree<int64_t> m_rows;
+
+    // Reads the values of one of the B+-trees in the order of their
+    // positions, one leaf at a time.
+    class Reader {
+    public:
+        Reader(const BpTree<int64_t>&) noexcept;
+        int64_t get(size_t pos) noexcept;
+
+    private:
+        const BpTree<int64_t>& m_tree;
+        ArrayInteger m_fallback;
+        const ArrayInteger* m_leaf = nullptr;
+        size_t m_leaf_begin = 0;
+        size_t m_leaf_end = 0;
+    };
+
+    void init_trees();
+
+    /// The position of the first entry that is not less than an entry with
+    /// the specified key and row index.
+    size_t find_position(Key, size_t row_ndx) const noexcept;
+
+    void do_insert(size_t row_ndx, const Key*, size_t num_rows, bool is_append);
+    void do_erase(size_t row_ndx, const Key*, bool is_last);
+};
+
+bool operator==(OrderedIndex::Key, OrderedIndex::Key) noexcept;
+bool operator!=(OrderedIndex::Key, OrderedIndex::Key) noexcept;
+bool operator<(OrderedIndex::Key, OrderedIndex::Key) noexcept;
+bool operator<=(OrderedIndex::Key, OrderedIndex::Key) noexcept;
+
+
+// Implementation:
+
+inline bool operator==(OrderedIndex::Key a, OrderedIndex::Key b) noexcept
+{
+    return a.high == b.high && a.low == b.low;
+}
+
+inline bool operator!=(OrderedIndex::Key a, OrderedIndex::Key b) noexcept
+{
+    return !(a == b);
+}
+
+inline bool operator<(OrderedIndex::Key a, OrderedIndex::Key b) noexcept
+{
+    return a.high < b.high || (a.high == b.high && a.low < b.low);
+}
+
+inline bool operator<=(OrderedIndex::Key a, OrderedIndex::Key b) noexcept
+{
+    return !(b < a);
+}
+
+inline bool OrderedIndex::get_key(int64_t value, Key& key) noexcept
+{
+    key.high = value;
+    key.low = 0;
+    return true;
+}
+
+inline bool OrderedIndex::get_key(util::Optional<int64_t> value, Key& key) noexcept
+{
+    return value && get_key(*value, key);
+}
+
+inline bool OrderedIndex::get_key(float value, Key& key) noexcept
+{
+    return get_key(double(value), key);
+}
+
+inline bool OrderedIndex::get_key(Timestamp value, Key& key) noexcept
+{
+    if (value.is_null())
+        return false;
+    key.high = value.get_seconds();
+    key.low = value.get_nanoseconds();
+    return true;
+}
+
+inline Allocator& OrderedIndex::get_alloc() const noexcept
+{
+    return m_top.get_alloc();
+}
+
+inline bool OrderedIndex::is_attached() const noexcept
+{
+    return m_top.is_attached();
+}
+
+inline void OrderedIndex::set_parent(ArrayParent* parent, size_t ndx_in_parent) noexcept
+{
+    m_top.set_parent(parent, ndx_in_parent);
+}
+
+inline size_t OrderedIndex::get_ndx_in_parent() const noexcept
+{
+    return m_top.get_ndx_in_parent();
+}
+
+inline void OrderedIndex::set_ndx_in_parent(size_t ndx_in_parent) noexcept
+{
+    m_top.set_ndx_in_parent(ndx_in_parent);
+}
+
+inline ref_type OrderedIndex::get_ref() const noexcept
+{
+    return m_top.get_ref();
+}
+
+inline size_t OrderedIndex::size() const noexcept
+{
+    return m_rows.size();
+}
+
+inline OrderedIndex::Entry OrderedIndex::get(size_t pos) const noexcept
+{
+    Key key{m_high.get(pos), int32_t(m_low.get(pos))};
+    return Entry{key, size_t(m_rows.get(pos))};
+}
+
+inline OrderedIndex::Reader::Reader(const BpTree<int64_t>& tree) noexcept
+    : m_tree(tree)
+    , m_fallback(tree.get_alloc())
+{
+}
+
+inline int64_t OrderedIndex::Reader::get(size_t pos) noexcept
+{
+    if (pos < m_leaf_begin || pos >= m_leaf_end) {
+        size_t ndx_in_leaf;
+        BpTree<int64_t>::LeafInfo leaf_info{&m_leaf, &m_fallback};
+        m_tree.get_leaf(pos, ndx_in_leaf, leaf_info);
+        m_leaf_begin = pos - ndx_in_leaf;
+        m_leaf_end = m_leaf_begin + m_leaf->size();
+    }
+    return m_leaf->get(pos - m_leaf_begin);
+}
+
+template <class Get>
+void OrderedIndex::populate(size_t num_rows, Get get)
+{
+    REALM_ASSERT(size() == 0);
+    for (size_t row_ndx = 0; row_ndx < num_rows; ++row_ndx) {
+        bool is_append = true;
+        insert(row_ndx, get(row_ndx), 1, is_append); // Throws
+    }
+}
+
+template <class T>
+void OrderedIndex::insert(size_t row_ndx, T value, size_t num_rows, bool is_append)
+{
+    Key key;
+    bool indexed = get_key(value, key);
+    do_insert(row_ndx, indexed ? &key : nullptr, num_rows, is_append); // Throws
+}
+
+template <class T>
+void OrderedIndex::set(size_t row_ndx, T old_value, T new_value)
+{
+    Key old_key, new_key;
+    bool old_indexed = get_key(old_value, old_key);
+    bool new_indexed = get_key(new_value, new_key);
+    if (old_indexed == new_indexed && (!old_indexed || old_key == new_key))
+        return;
+    bool is_last = true; // Do not adjust the other rows
+    do_erase(row_ndx, old_indexed ? &old_key : nullptr, is_last);     // Throws
+    do_insert(row_ndx, new_indexed ? &new_key : nullptr, 1, is_last); // Throws
+}
+
+template <class T>
+void OrderedIndex::erase(size_t row_ndx, T value, bool is_last)
+{
+    Key key;
+    bool indexed = get_key(value, key);
+    do_erase(row_ndx, indexed ? &key : nullptr, is_last); // Throws
+}
+
+template <class T>
+void OrderedIndex::move_last_over(size_t row_ndx, T value, size_t last_row_ndx, T last_value)
+{
+    bool is_last = true; // Do not adjust the other rows
+    erase(row_ndx, value, is_last); // Throws
+    if (row_ndx != last_row_ndx) {
+        erase(last_row_ndx, last_value, is_last); // Throws
+        insert(row_ndx, last_value, 1, is_last);  // Throws
+    }
+}
+
+template <class T>
+void OrderedIndex::swap(size_t row_ndx_1, T value_1, size_t row_ndx_2, T value_2)
+{
+    set(row_ndx_1, value_1, value_2); // Throws
+    set(row_ndx_2, value_2, value_1); // Throws
+}
+
+template <class Handler>
+void OrderedIndex::for_each(size_t begin, size_t end, Handler handler) const
+{
+    Reader high(m_high), low(m_low), rows(m_rows);
+    for (size_t pos = begin; pos < end; ++pos) {
+        Key key{high.get(pos), int32_t(low.get(pos))};
+        handler(Entry{key, size_t(rows.get(pos))}); // Throws
+    }
+}
+
+} // namespace realm
+
+#endif // REALM_INDEX_ORDERED_HPP
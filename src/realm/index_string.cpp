@@ -888,6 +888,60 @@ void StringIndex::distinct(IntegerColumn& result) const
     }
 }
 
+void StringIndex::group_rows(std::vector<size_t>& groups, std::vector<size_t>& first_rows) const
+{
+    Allocator& alloc = m_array->get_alloc();
+    const size_t array_size = m_array->size();
+
+    // Same traversal as distinct(), but every row is visited
+    if (m_array->is_inner_bptree_node()) {
+        for (size_t i = 1; i < array_size; ++i) {
+            size_t ref = m_array->get_as_ref(i);
+            StringIndex ndx(ref, nullptr, 0, m_target_column, m_deny_duplicate_values, alloc);
+            ndx.group_rows(groups, first_rows); // Throws
+        }
+        return;
+    }
+
+    for (size_t i = 1; i < array_size; ++i) {
+        int64_t ref = m_array->get(i);
+
+        // low bit set indicate literal ref (shifted)
+        if (ref & 1) {
+            size_t r = to_size_t((uint64_t(ref) >> 1));
+            groups[r] = first_rows.size();
+            first_rows.push_back(r); // Throws
+            continue;
+        }
+
+        // A real ref either points to a list or a subindex
+        char* header = alloc.translate(to_ref(ref));
+        if (Array::get_context_flag_from_header(header)) {
+            StringIndex ndx(to_ref(ref), m_array.get(), i, m_target_column, m_deny_duplicate_values, alloc);
+            ndx.group_rows(groups, first_rows); // Throws
+            continue;
+        }
+
+        // The rows of a list are sorted by value, so equal values are adjacent
+        IntegerColumn sub(alloc, to_ref(ref)); // Throws
+        IntegerColumn::const_iterator it = sub.cbegin();
+        IntegerColumn::const_iterator it_end = sub.cend();
+        SortedListComparator slc(*m_target_column);
+        StringConversionBuffer buffer;
+        while (it != it_end) {
+            size_t group = first_rows.size();
+            first_rows.push_back(to_size_t(*it)); // Throws
+            IntegerColumn::const_iterator next = it_end;
+            if (sub.size() > 1) {
+                StringData it_data = get(to_size_t(*it), buffer);
+                next = std::upper_bound(it, it_end, it_data, slc);
+            }
+            for (; it != next; ++it)
+                groups[to_size_t(*it)] = group;
+        }
+    }
+}
+
 StringData StringIndex::get(size_t ndx, StringConversionBuffer& buffer) const
 {
     return m_target_column->get_index_data(ndx, buffer);
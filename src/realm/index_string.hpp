@@ -20,8 +20,10 @@
 #define REALM_INDEX_STRING_HPP
 
 #include <cstring>
+#include <algorithm>
 #include <memory>
 #include <array>
+#include <vector>
 
 #include <realm/array.hpp>
 #include <realm/column_fwd.hpp>
@@ -125,6 +127,13 @@ public:
     template <class T>
     void insert(size_t row_ndx, util::Optional<T> value, size_t num_rows, bool is_append);
 
+    /// Add the specified values of rows that were appended to the column,
+    /// starting at \a row_ndx. The values are added in sorted order, so that
+    /// equal values, and values that share a key prefix, are added to the
+    /// same part of the index one after the other.
+    template <class T>
+    void insert_bulk(size_t row_ndx, const T* values, size_t num_values);
+
     template <class T>
     void set(size_t row_ndx, T new_value);
     template <class T>
@@ -147,6 +156,14 @@ public:
     void clear();
 
     void distinct(IntegerColumn& result) const;
+
+    /// Number the distinct values of the indexed rows. For every row,
+    /// `groups[row_ndx]` is set to the number of its value, and for every
+    /// value, the index of its first row is appended to `first_rows`. The
+    /// values are numbered in the order of the index, which is not the order
+    /// in which they are sorted. `groups` must have one element per row.
+    void group_rows(std::vector<size_t>& groups, std::vector<size_t>& first_rows) const;
+
     bool has_duplicate_values() const noexcept;
 
     /// By default, duplicate values are allowed.
@@ -454,6 +471,21 @@ void StringIndex::insert(size_t row_ndx, T value, size_t num_rows, bool is_appen
     }
 }
 
+template <class T>
+void StringIndex::insert_bulk(size_t row_ndx, const T* values, size_t num_values)
+{
+    // A stable sort keeps the rows of equal values in ascending order, which
+    // is the order that the row lists of the index must have
+    std::vector<size_t> order(num_values); // Throws
+    for (size_t i = 0; i < num_values; ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [values](size_t a, size_t b) { return values[a] < values[b]; });
+
+    bool is_append = true;
+    for (size_t i : order)
+        insert(row_ndx + i, values[i], 1, is_append); // Throws
+}
+
 template <class T>
 void StringIndex::insert(size_t row_ndx, util::Optional<T> value, size_t num_rows, bool is_append)
 {
@@ -18,7 +18,9 @@
 
 #include <cstdio>
 #include <algorithm>
+#include <numeric>
 
+#include <realm/alloc_slab.hpp>
 #include <realm/array.hpp>
 #include <realm/column_fwd.hpp>
 #include <realm/query.hpp>
@@ -26,6 +28,8 @@
 #include <realm/descriptor.hpp>
 #include <realm/table_view.hpp>
 #include <realm/link_view.hpp>
+#include <realm/impl/hash_aggregator.hpp>
+#include <realm/impl/parallel_executor.hpp>
 
 using namespace realm;
 
@@ -96,6 +100,10 @@ Query::Query(const Query& source)
     , m_groups(source.m_groups)
     , m_current_descriptor(source.m_current_descriptor)
     , m_table(source.m_table)
+    , m_max_threads(source.m_max_threads)
+    , m_plan(source.m_plan)
+    , m_has_plan(source.m_has_plan)
+    , m_plan_version(source.m_plan_version)
 {
     if (source.m_owned_source_table_view) {
         m_owned_source_table_view = source.m_owned_source_table_view->clone();
@@ -117,6 +125,11 @@ Query& Query::operator=(const Query& source)
     if (this != &source) {
         m_groups = source.m_groups;
         m_table = source.m_table;
+        m_max_threads = source.m_max_threads;
+        m_last_condition = nullptr;
+        m_plan = source.m_plan;
+        m_has_plan = source.m_has_plan;
+        m_plan_version = source.m_plan_version;
 
         if (source.m_owned_source_table_view) {
             m_owned_source_table_view = source.m_owned_source_table_view->clone();
@@ -149,6 +162,7 @@ Query::~Query() noexcept = default;
 Query::Query(Query& source, HandoverPatch& patch, MutableSourcePayload mode)
     : m_table(TableRef())
     , m_source_link_view(LinkViewRef())
+    , m_max_threads(source.m_max_threads)
 {
     Table::generate_patch(source.m_table.get(), patch.m_table);
     if (source.m_source_table_view) {
@@ -169,6 +183,7 @@ Query::Query(Query& source, HandoverPatch& patch, MutableSourcePayload mode)
 Query::Query(const Query& source, HandoverPatch& patch, ConstSourcePayload mode)
     : m_table(TableRef())
     , m_source_link_view(LinkViewRef())
+    , m_max_threads(source.m_max_threads)
 {
     Table::generate_patch(source.m_table.get(), patch.m_table);
     if (source.m_source_table_view) {
@@ -199,6 +214,7 @@ void Query::set_table(TableRef tr)
 {
     REALM_ASSERT(!m_table);
     m_table = tr;
+    m_has_plan = false;
     if (m_table) {
         fetch_descriptor();
         if (ParentNode* root = root_node())
@@ -384,7 +400,9 @@ Query& Query::add_condition(size_t column_ndx, T value)
 {
     REALM_ASSERT_DEBUG(m_current_descriptor);
     auto node = make_condition_node<TConditionFunction>(*m_current_descriptor, column_ndx, value);
+    ParentNode* condition = node.get();
     add_node(std::move(node));
+    m_last_condition = condition;
     return *this;
 }
 
@@ -595,16 +613,24 @@ Query& Query::greater_equal(size_t column_ndx, int64_t value)
 {
     if (value > LLONG_MIN) {
         add_condition<Greater>(column_ndx, value - 1);
+        m_last_condition->m_param_adjustment = -1;
+    }
+    else {
+        // field >= LLONG_MIN has no effect
+        m_last_condition = nullptr;
     }
-    // field >= LLONG_MIN has no effect
     return *this;
 }
 Query& Query::less_equal(size_t column_ndx, int64_t value)
 {
     if (value < LLONG_MAX) {
         add_condition<Less>(column_ndx, value + 1);
+        m_last_condition->m_param_adjustment = 1;
+    }
+    else {
+        // field <= LLONG_MAX has no effect
+        m_last_condition = nullptr;
     }
-    // field <= LLONG_MAX has no effect
     return *this;
 }
 Query& Query::less(size_t column_ndx, int64_t value)
@@ -775,6 +801,66 @@ Query& Query::like(size_t column_ndx, StringData value, bool case_sensitive)
 }
 
 
+// Parameters
+
+Query& Query::parameter(size_t param_ndx)
+{
+    if (!m_last_condition) {
+        error_code = "Parameter without condition";
+        return *this;
+    }
+    m_last_condition->m_param_ndx = param_ndx;
+    return *this;
+}
+
+template <class F>
+Query& Query::bind_parameter(size_t param_ndx, F set_value)
+{
+    std::vector<ParentNode*> nodes;
+    for (auto& group : m_groups) {
+        if (group.m_root_node)
+            group.m_root_node->gather_parameter_nodes(param_ndx, nodes); // Throws
+    }
+    if (nodes.empty())
+        throw LogicError(LogicError::illegal_combination);
+
+    m_has_plan = false;
+    for (ParentNode* node : nodes)
+        set_value(*node); // Throws
+    return *this;
+}
+
+Query& Query::bind(size_t param_ndx, int64_t value)
+{
+    return bind_parameter(param_ndx, [=](ParentNode& node) { node.set_int_value(value); });
+}
+
+Query& Query::bind(size_t param_ndx, float value)
+{
+    return bind_parameter(param_ndx, [=](ParentNode& node) { node.set_float_value(value); });
+}
+
+Query& Query::bind(size_t param_ndx, double value)
+{
+    return bind_parameter(param_ndx, [=](ParentNode& node) { node.set_double_value(value); });
+}
+
+Query& Query::bind(size_t param_ndx, Timestamp value)
+{
+    return bind_parameter(param_ndx, [=](ParentNode& node) { node.set_timestamp_value(value); });
+}
+
+Query& Query::bind(size_t param_ndx, StringData value)
+{
+    return bind_parameter(param_ndx, [=](ParentNode& node) { node.set_string_value(value); });
+}
+
+Query& Query::bind(size_t param_ndx, null)
+{
+    return bind_parameter(param_ndx, [](ParentNode& node) { node.set_null_value(); });
+}
+
+
 // Aggregates =================================================================================
 
 size_t Query::peek_tablerow(size_t tablerow) const
@@ -790,6 +876,138 @@ size_t Query::peek_tablerow(size_t tablerow) const
     return tablerow;
 }
 
+namespace {
+
+// Smallest number of rows that a thread scans as one unit of work during
+// parallel execution. Partition boundaries are multiples of
+// REALM_MAX_BPNODE_SIZE, which are leaf boundaries when every leaf but the
+// last one is full, as after a series of appends. Otherwise, a leaf may
+// straddle two partitions, and be scanned partly by each of two threads,
+// which is correct, but less efficient.
+const size_t min_rows_per_partition = 4 * REALM_MAX_BPNODE_SIZE;
+
+// Number of partitions to aim for per participating thread. More partitions
+// balance the load better when matches are unevenly distributed, fewer
+// partitions reduce the per-partition overhead.
+const size_t partitions_per_thread = 4;
+
+// Row indexes found in one partition by a parallel find_all()
+struct PartitionMatches {
+    PartitionMatches() = default;
+    PartitionMatches(PartitionMatches&&) = default;
+    ~PartitionMatches() noexcept
+    {
+        if (rows)
+            rows->destroy();
+    }
+
+    std::unique_ptr<IntegerColumn> rows;
+};
+
+// Groups found in one partition by a parallel group_by()
+struct PartitionGroups {
+    std::unique_ptr<_impl::HashAggregator> aggregator;
+};
+
+// Fold the result of a partition into the result of the partitions preceding
+// it. Partitions must be merged in row order, so that min/max report the
+// first occurrence of the extreme value, just like serial execution.
+template <Action action, class R>
+void merge_partition_state(QueryState<R>& st, const QueryState<R>& partition)
+{
+    st.m_match_count += partition.m_match_count;
+    if (action == act_Sum) {
+        st.m_state += partition.m_state;
+    }
+    else if (action == act_Max) {
+        if (partition.m_state > st.m_state) {
+            st.m_state = partition.m_state;
+            st.m_minmax_index = partition.m_minmax_index;
+        }
+    }
+    else if (action == act_Min) {
+        if (partition.m_state < st.m_state) {
+            st.m_state = partition.m_state;
+            st.m_minmax_index = partition.m_minmax_index;
+        }
+    }
+    else {
+        REALM_ASSERT_DEBUG(false);
+    }
+}
+
+} // anonymous namespace
+
+
+Query& Query::set_threads(unsigned int threadcount)
+{
+    m_max_threads = threadcount;
+    return *this;
+}
+
+
+// Returns the number of threads to scan the specified range of the table
+// with. A return value of 1 means that the query must be executed serially.
+size_t Query::get_parallel_thread_count(size_t start, size_t end, size_t limit) const
+{
+    if (m_max_threads == 1 || m_view || limit != size_t(-1) || !has_conditions())
+        return 1;
+    if (end <= start || end - start < 2 * min_rows_per_partition)
+        return 1;
+    if (!root_node()->is_parallelizable())
+        return 1;
+
+    size_t num_threads = _impl::ParallelExecutor::get_default().get_num_threads(); // Throws
+    if (m_max_threads != 0)
+        num_threads = std::min(num_threads, m_max_threads);
+    return num_threads;
+}
+
+
+// Divides the specified range of the table into partitions, and calls
+// `func(query, state, begin, end)` for each of them using up to `num_threads`
+// threads. `states` is resized to hold one element per partition, and
+// `state` refers to the element of the partition being scanned. The query
+// must already be initialized.
+template <class State, class F>
+void Query::for_each_partition(size_t start, size_t end, size_t num_threads, std::vector<State>& states,
+                               F func) const
+{
+    REALM_ASSERT_3(start, <, end);
+    size_t rows_per_partition = (end - start) / (num_threads * partitions_per_thread);
+    rows_per_partition = std::max(rows_per_partition, min_rows_per_partition);
+    rows_per_partition = (rows_per_partition + REALM_MAX_BPNODE_SIZE - 1) / REALM_MAX_BPNODE_SIZE;
+    rows_per_partition *= REALM_MAX_BPNODE_SIZE;
+
+    // Partition boundaries are multiples of `rows_per_partition`, and the
+    // first and last partitions are clipped to the range.
+    size_t first = start / rows_per_partition;
+    size_t num_partitions = (end - 1) / rows_per_partition - first + 1;
+    states.resize(num_partitions); // Throws
+
+    // The condition nodes cache leaf accessors and search statistics, so each
+    // thread must evaluate its own copy of the query. The copies are made and
+    // initialized here, because neither is safe to do concurrently. The
+    // calling thread uses this query.
+    num_threads = std::min(num_threads, num_partitions);
+    std::vector<std::unique_ptr<Query>> queries;
+    queries.reserve(num_threads - 1); // Throws
+    for (size_t i = 1; i < num_threads; ++i) {
+        queries.emplace_back(new Query(*this)); // Throws
+        queries.back()->init();                 // Throws
+    }
+
+    auto task = [&](size_t partition_ndx, size_t thread_ndx) {
+        const Query& query = thread_ndx == 0 ? *this : *queries[thread_ndx - 1];
+        size_t begin = std::max(start, (first + partition_ndx) * rows_per_partition);
+        size_t partition_end = std::min(end, (first + partition_ndx + 1) * rows_per_partition);
+        SlabAlloc::UncachedTranslationGuard guard;
+        func(query, states[partition_ndx], begin, partition_end); // Throws
+    };
+    _impl::ParallelExecutor::get_default().run(num_partitions, task, num_threads); // Throws
+}
+
+
 template <Action action, typename T, typename R, class ColType>
 R Query::aggregate(R (ColType::*aggregateMethod)(size_t start, size_t end, size_t limit, size_t* return_ndx) const,
                    size_t column_ndx, size_t* resultcount, size_t start, size_t end, size_t limit,
@@ -825,7 +1043,21 @@ R Query::aggregate(R (ColType::*aggregateMethod)(size_t start, size_t end, size_
 
         SequentialGetter<ColType> source_column(*m_table, column_ndx);
 
-        if (!m_view) {
+        size_t num_threads = get_parallel_thread_count(start, end, limit);
+        if (num_threads > 1) {
+            std::vector<QueryState<R>> states;
+            auto func = [column_ndx](const Query& query, QueryState<R>& partition_st, size_t part_begin,
+                                     size_t part_end) {
+                partition_st.init(action, nullptr, size_t(-1));
+                SequentialGetter<ColType> partition_column(*query.m_table, column_ndx);
+                query.aggregate_internal(action, ColumnTypeTraits<T>::id, ColType::nullable, query.root_node(),
+                                         &partition_st, part_begin, part_end, &partition_column);
+            };
+            for_each_partition(start, end, num_threads, states, func);
+            for (const auto& partition_st : states)
+                merge_partition_state<action>(st, partition_st);
+        }
+        else if (!m_view) {
             aggregate_internal(action, ColumnTypeTraits<T>::id, ColType::nullable, root_node(), &st, start, end,
                                &source_column);
         }
@@ -1059,6 +1291,7 @@ double Query::average_double(size_t column_ndx, size_t* resultcount, size_t star
 Query& Query::group()
 {
     m_groups.emplace_back();
+    m_last_condition = nullptr;
     return *this;
 }
 Query& Query::end_group()
@@ -1108,6 +1341,7 @@ void Query::handle_pending_not()
 
 Query& Query::Or()
 {
+    m_last_condition = nullptr;
     auto& current_group = m_groups.back();
     OrNode* or_node = dynamic_cast<OrNode*>(current_group.m_root_node.get());
     if (!or_node) {
@@ -1197,6 +1431,8 @@ void Query::find_all(TableViewBase& ret, size_t begin, size_t end, size_t limit)
     if (end == size_t(-1))
         end = m_table->size();
 
+    size_t num_threads = get_parallel_thread_count(begin, end, limit);
+
     if (m_view) {
         for (size_t t = 0; t < m_view->size() && ret.size() < limit; t++) {
             size_t tablerow = static_cast<size_t>(m_view->m_row_indexes.get(t));
@@ -1212,6 +1448,27 @@ void Query::find_all(TableViewBase& ret, size_t begin, size_t end, size_t limit)
                 refs.add(i);
             }
         }
+        else if (num_threads > 1) {
+            std::vector<PartitionMatches> matches;
+            auto func = [](const Query& query, PartitionMatches& partition, size_t part_begin, size_t part_end) {
+                partition.rows.reset(
+                    new IntegerColumn(IntegerColumn::unattached_root_tag(), Allocator::get_default())); // Throws
+                partition.rows->get_root_array()->create(Array::type_Normal);                           // Throws
+                QueryState<int64_t> st;
+                st.init(act_FindAll, partition.rows.get(), size_t(-1));
+                query.aggregate_internal(act_FindAll, ColumnTypeTraits<int64_t>::id, false, query.root_node(), &st,
+                                         part_begin, part_end, nullptr);
+            };
+            for_each_partition(begin, end, num_threads, matches, func);
+
+            // Concatenating in partition order preserves table order
+            IntegerColumn& refs = ret.m_row_indexes;
+            for (const auto& partition : matches) {
+                size_t n = partition.rows->size();
+                for (size_t i = 0; i < n; ++i)
+                    refs.add(partition.rows->get(i)); // Throws
+            }
+        }
         else {
             QueryState<int64_t> st;
             st.init(act_FindAll, &ret.m_row_indexes, limit);
@@ -1249,6 +1506,7 @@ size_t Query::count(size_t start, size_t end, size_t limit) const
 
     init();
     size_t cnt = 0;
+    size_t num_threads = get_parallel_thread_count(start, end, limit);
 
     if (m_view) {
         for (size_t t = 0; t < m_view->size() && cnt < limit; t++) {
@@ -1258,6 +1516,18 @@ size_t Query::count(size_t start, size_t end, size_t limit) const
             }
         }
     }
+    else if (num_threads > 1) {
+        std::vector<size_t> counts;
+        auto func = [](const Query& query, size_t& partition_cnt, size_t part_begin, size_t part_end) {
+            QueryState<int64_t> st;
+            st.init(act_Count, nullptr, size_t(-1));
+            query.aggregate_internal(act_Count, ColumnTypeTraits<int64_t>::id, false, query.root_node(), &st,
+                                     part_begin, part_end, nullptr);
+            partition_cnt = size_t(st.m_state);
+        };
+        for_each_partition(start, end, num_threads, counts, func);
+        cnt = std::accumulate(counts.begin(), counts.end(), size_t(0));
+    }
     else {
         QueryState<int64_t> st;
         st.init(act_Count, nullptr, limit);
@@ -1269,147 +1539,88 @@ size_t Query::count(size_t start, size_t end, size_t limit) const
 }
 
 
-// todo, not sure if start, end and limit could be useful for delete.
-size_t Query::remove()
-{
-    if (m_table->is_degenerate())
-        return 0;
-
-    TableView tv = find_all();
-    size_t rows = tv.size();
-    tv.clear();
-    return rows;
-}
-
-#if REALM_MULTITHREAD_QUERY
-TableView Query::find_all_multi(size_t start, size_t end)
+void Query::group_by(const std::vector<size_t>& group_by_columns, const std::vector<GroupAggregate>& aggregates,
+                     Table& result, size_t start, size_t end) const
 {
-    static_cast<void>(start);
-    static_cast<void>(end);
-
-    // Initialization
-    init();
-    ts.next_job = start;
-    ts.end_job = end;
-    ts.done_job = 0;
-    ts.count = 0;
-    ts.table = &table;
-    ts.node = first[0];
-
-    // Signal all threads to start
-    pthread_mutex_unlock(&ts.jobs_mutex);
-    pthread_cond_broadcast(&ts.jobs_cond);
-
-    // Wait until all threads have completed
-    pthread_mutex_lock(&ts.completed_mutex);
-    while (ts.done_job < ts.end_job)
-        pthread_cond_wait(&ts.completed_cond, &ts.completed_mutex);
-    pthread_mutex_lock(&ts.jobs_mutex);
-    pthread_mutex_unlock(&ts.completed_mutex);
-
-    TableView tv(*m_table);
-
-    // Sort search results because user expects ascending order
-    sort(ts.chunks.begin(), ts.chunks.end(), &Query::comp);
-    for (size_t i = 0; i < ts.chunks.size(); ++i) {
-        const size_t from = ts.chunks[i].m_root_node;
-        const size_t upto = (i == ts.chunks.size() - 1) ? size_t(-1) : ts.chunks[i + 1].m_root_node;
-        size_t first = ts.chunks[i].second;
-
-        while (first < ts.results.size() && ts.results[first] < upto && ts.results[first] >= from) {
-            tv.get_ref_column().add(ts.results[first]);
-            ++first;
-        }
+    _impl::HashAggregator aggregator(*m_table, group_by_columns, aggregates); // Throws
+    if (m_table->is_degenerate()) {
+        aggregator.get_result(result); // Throws
+        return;
     }
 
-    return move(tv);
-}
-
-int Query::set_threads(unsigned int threadcount)
-{
-#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64)
-    pthread_win32_process_attach_np();
-#endif
-    pthread_mutex_init(&ts.result_mutex, nullptr);
-    pthread_cond_init(&ts.completed_cond, nullptr);
-    pthread_mutex_init(&ts.jobs_mutex, nullptr);
-    pthread_mutex_init(&ts.completed_mutex, nullptr);
-    pthread_cond_init(&ts.jobs_cond, nullptr);
+    if (end == size_t(-1))
+        end = m_table->size();
 
-    pthread_mutex_lock(&ts.jobs_mutex);
+    init();
 
-    for (size_t i = 0; i < m_threadcount; ++i)
-        pthread_detach(threads[i]);
+    // Matching rows are found a few leaves at a time, and grouped before the
+    // next ones are found, so that their indexes need not all be stored.
+    auto add_matches = [](const Query& query, _impl::HashAggregator& partition_aggregator, size_t begin,
+                          size_t part_end) {
+        PartitionMatches matches;
+        matches.rows.reset(
+            new IntegerColumn(IntegerColumn::unattached_root_tag(), Allocator::get_default())); // Throws
+        matches.rows->get_root_array()->create(Array::type_Normal);                         // Throws
+        while (begin < part_end) {
+            size_t chunk_end = std::min(part_end, begin + min_rows_per_partition);
+            QueryState<int64_t> st;
+            st.init(act_FindAll, matches.rows.get(), size_t(-1));
+            query.aggregate_internal(act_FindAll, ColumnTypeTraits<int64_t>::id, false, query.root_node(), &st,
+                                     begin, chunk_end, nullptr);
+            size_t n = matches.rows->size();
+            for (size_t i = 0; i < n; ++i)
+                partition_aggregator.add_row(size_t(matches.rows->get(i))); // Throws
+            matches.rows->clear();
+            begin = chunk_end;
+        }
+    };
 
-    for (size_t i = 0; i < threadcount; ++i) {
-        int r = pthread_create(&threads[i], nullptr, query_thread, (void*)&ts);
-        if (r != 0)
-            REALM_ASSERT(false); // todo
+    size_t num_threads = get_parallel_thread_count(start, end, size_t(-1));
+    if (m_view) {
+        for (size_t t = 0; t < m_view->size(); t++) {
+            size_t tablerow = static_cast<size_t>(m_view->m_row_indexes.get(t));
+            if (tablerow >= start && tablerow < end && peek_tablerow(tablerow) != not_found)
+                aggregator.add_row(tablerow); // Throws
+        }
+    }
+    else if (!has_conditions()) {
+        for (size_t i = start; i < end; ++i)
+            aggregator.add_row(i); // Throws
     }
-    m_threadcount = threadcount;
-    return 0;
+    else if (num_threads > 1) {
+        std::vector<PartitionGroups> partitions;
+        auto func = [&](const Query& query, PartitionGroups& partition, size_t part_begin, size_t part_end) {
+            partition.aggregator.reset(
+                new _impl::HashAggregator(*query.m_table, group_by_columns, aggregates)); // Throws
+            add_matches(query, *partition.aggregator, part_begin, part_end);              // Throws
+        };
+        for_each_partition(start, end, num_threads, partitions, func);
+
+        // Merging in partition order keeps the groups in the order in which
+        // they are first seen
+        for (const auto& partition : partitions)
+            aggregator.merge(*partition.aggregator); // Throws
+    }
+    else {
+        add_matches(*this, aggregator, start, end); // Throws
+    }
+
+    aggregator.get_result(result); // Throws
 }
 
 
-void* Query::query_thread(void* arg)
+// todo, not sure if start, end and limit could be useful for delete.
+size_t Query::remove()
 {
-    static_cast<void>(arg);
-    thread_state* ts = static_cast<thread_state*>(arg);
-
-    std::vector<size_t> res;
-    std::vector<pair<size_t, size_t>> chunks;
-
-    for (;;) {
-        // Main waiting loop that waits for a query to start
-        pthread_mutex_lock(&ts->jobs_mutex);
-        while (ts->next_job == ts->end_job)
-            pthread_cond_wait(&ts->jobs_cond, &ts->jobs_mutex);
-        pthread_mutex_unlock(&ts->jobs_mutex);
-
-        for (;;) {
-            // Pick a job
-            pthread_mutex_lock(&ts->jobs_mutex);
-            if (ts->next_job == ts->end_job)
-                break;
-            const size_t chunk = min(ts->end_job - ts->next_job, thread_chunk_size);
-            const size_t mine = ts->next_job;
-            ts->next_job += chunk;
-            size_t r = mine - 1;
-            const size_t end = mine + chunk;
-
-            pthread_mutex_unlock(&ts->jobs_mutex);
-
-            // Execute job
-            for (;;) {
-                r = ts->node->find_first(r + 1, end);
-                if (r == end)
-                    break;
-                res.push_back(r);
-            }
-
-            // Append result in common queue shared by all threads.
-            pthread_mutex_lock(&ts->result_mutex);
-            ts->done_job += chunk;
-            if (res.size() > 0) {
-                ts->chunks.push_back(std::pair<size_t, size_t>(mine, ts->results.size()));
-                ts->count += res.size();
-                for (size_t i = 0; i < res.size(); i++) {
-                    ts->results.push_back(res[i]);
-                }
-                res.clear();
-            }
-            pthread_mutex_unlock(&ts->result_mutex);
+    if (m_table->is_degenerate())
+        return 0;
 
-            // Signal main thread that we might have compleeted
-            pthread_mutex_lock(&ts->completed_mutex);
-            pthread_cond_signal(&ts->completed_cond);
-            pthread_mutex_unlock(&ts->completed_mutex);
-        }
-    }
-    return 0;
+    TableView tv = find_all();
+    size_t rows = tv.size();
+    tv.clear();
+    return rows;
 }
 
-#endif // REALM_MULTITHREADQUERY
 
 std::string Query::validate()
 {
@@ -1425,6 +1636,45 @@ std::string Query::validate()
     return root_node()->validate(); // errors detected by QueryEngine
 }
 
+namespace {
+
+// For each column with an ordered index, let the first range condition on it
+// match only the rows that the index finds in the intersection of the ranges
+// of all the range conditions on it, if there are few enough of them.
+void use_ordered_indexes(const Table& table, const std::vector<ParentNode*>& nodes)
+{
+    size_t limit = table.size() / ordered_index_max_match_divisor;
+    std::vector<size_t> done_columns;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        size_t col_ndx;
+        OrderedIndex::Key first, last;
+        if (!nodes[i]->get_index_range(col_ndx, first, last))
+            continue;
+        if (std::find(done_columns.begin(), done_columns.end(), col_ndx) != done_columns.end())
+            continue;
+        done_columns.push_back(col_ndx); // Throws
+        const OrderedIndex* index = table.get_ordered_index(col_ndx);
+        if (!index)
+            continue;
+
+        for (size_t j = i + 1; j < nodes.size(); ++j) {
+            size_t col_ndx_2;
+            OrderedIndex::Key first_2, last_2;
+            if (nodes[j]->get_index_range(col_ndx_2, first_2, last_2) && col_ndx_2 == col_ndx) {
+                first = std::max(first, first_2);
+                last = std::min(last, last_2);
+            }
+        }
+        if (index->count(first, last) > limit)
+            continue;
+        std::vector<size_t> rows;
+        index->find_all(first, last, rows); // Throws
+        nodes[i]->set_ordered_matches(std::move(rows));
+    }
+}
+
+} // anonymous namespace
+
 void Query::init() const
 {
     REALM_ASSERT(m_table);
@@ -1432,6 +1682,43 @@ void Query::init() const
         root->init();
         std::vector<ParentNode*> v;
         root->gather_children(v);
+
+        uint_fast64_t version = m_table->get_version_counter();
+        if (m_has_plan && m_plan_version == version && m_plan.size() == v.size()) {
+            for (size_t i = 0; i < v.size(); ++i) {
+                const NodePlan& plan = m_plan[i];
+                if (plan.m_has_ordered_matches)
+                    v[i]->set_ordered_matches(plan.m_ordered_matches); // Throws
+                v[i]->m_dD = plan.m_dD;
+                v[i]->m_dT = plan.m_dT;
+            }
+            return;
+        }
+
+        // The order in which conditions are evaluated only matters when
+        // there are several of them
+        if (v.size() > 1 && m_table->size() >= statistics_min_rows) {
+            for (ParentNode* node : v)
+                node->init_cost_from_statistics(); // Throws
+        }
+
+        use_ordered_indexes(*m_table, v); // Throws
+
+        m_has_plan = false;
+        m_plan.resize(v.size()); // Throws
+        for (size_t i = 0; i < v.size(); ++i) {
+            NodePlan& plan = m_plan[i];
+            const std::vector<size_t>* ordered_matches = v[i]->get_ordered_matches();
+            plan.m_dD = v[i]->m_dD;
+            plan.m_dT = v[i]->m_dT;
+            plan.m_has_ordered_matches = bool(ordered_matches);
+            if (ordered_matches)
+                plan.m_ordered_matches = *ordered_matches; // Throws
+            else
+                plan.m_ordered_matches.clear();
+        }
+        m_has_plan = true;
+        m_plan_version = version;
     }
 }
 
@@ -1464,6 +1751,9 @@ void Query::add_node(std::unique_ptr<ParentNode> node)
     REALM_ASSERT(node);
     using State = QueryGroup::State;
 
+    m_last_condition = nullptr;
+    m_has_plan = false;
+
     if (m_table && m_subtable_path.empty() && !m_table->is_degenerate())
         node->set_table(*m_table);
 
@@ -26,14 +26,6 @@
 #include <string>
 #include <vector>
 
-#define REALM_MULTITHREAD_QUERY 0
-
-#if REALM_MULTITHREAD_QUERY
-// FIXME: Use our C++ thread abstraction API since it provides a much
-// higher level of encapsulation and safety.
-#include <pthread.h>
-#endif
-
 #include <realm/views.hpp>
 #include <realm/table_ref.hpp>
 #include <realm/binary_data.hpp>
@@ -56,6 +48,7 @@ class Array;
 class Expression;
 class SequentialGetterBase;
 class Group;
+struct GroupAggregate;
 
 struct QueryGroup {
     enum class State {
@@ -225,6 +218,42 @@ public:
     Query& ends_with(size_t column_ndx, BinaryData value);
     Query& contains(size_t column_ndx, BinaryData value);
 
+    // Parameters
+
+    /// Mark the condition that was added last as query parameter \a
+    /// param_ndx, so that the value it compares against can be replaced by
+    /// bind() without building the query again. Must be called directly after
+    /// a condition that compares a column against a single integer, boolean,
+    /// float, double, timestamp, string, or null value, as in
+    /// `query.greater(0, int64_t(0)).parameter(0)`. Several conditions may be
+    /// marked as the same parameter.
+    Query& parameter(size_t param_ndx);
+
+    /// Replace the value of query parameter \a param_ndx in all conditions
+    /// marked as that parameter. The value must be of a type that the
+    /// condition could have been created with.
+    ///
+    /// Parameters are preserved when the query is copied or handed over to
+    /// another thread, so a query can be built once, and then bound and
+    /// executed any number of times. While neither the parameter values nor
+    /// the table change, repeated executions reuse the evaluation order and
+    /// ordered index matches that the first execution derived from the
+    /// column statistics.
+    ///
+    /// Throws LogicError::illegal_combination if no condition is marked as
+    /// the parameter, or if the value is the smallest (largest) integer and
+    /// the parameter was created by greater_equal() (less_equal()). Throws
+    /// LogicError::type_mismatch if the value is of the wrong type.
+    Query& bind(size_t param_ndx, int64_t value);
+    Query& bind(size_t param_ndx, int value);
+    Query& bind(size_t param_ndx, bool value);
+    Query& bind(size_t param_ndx, float value);
+    Query& bind(size_t param_ndx, double value);
+    Query& bind(size_t param_ndx, Timestamp value);
+    Query& bind(size_t param_ndx, StringData value);
+    Query& bind(size_t param_ndx, const char* c_str);
+    Query& bind(size_t param_ndx, null);
+
     // Negation
     Query& Not();
 
@@ -300,15 +329,34 @@ public:
     Timestamp minimum_timestamp(size_t column_ndx, size_t* return_ndx, size_t start = 0, size_t end = size_t(-1),
                                 size_t limit = size_t(-1));
 
+    // Grouped aggregates
+
+    /// Group the matching rows, as described for Table::group_by(). When the
+    /// scan is spread over several threads (see set_threads()), each thread
+    /// groups the rows of its own partitions, and the partial results are
+    /// combined in row order.
+    void group_by(const std::vector<size_t>& group_by_columns, const std::vector<GroupAggregate>& aggregates,
+                  Table& result, size_t start = 0, size_t end = size_t(-1)) const;
+
     // Deletion
     size_t remove();
 
-#if REALM_MULTITHREAD_QUERY
     // Multi-threading
-    TableView find_all_multi(size_t start = 0, size_t end = size_t(-1));
-    ConstTableView find_all_multi(size_t start = 0, size_t end = size_t(-1)) const;
-    int set_threads(unsigned int threadcount);
-#endif
+
+    /// Allow find_all(), count() and the aggregate functions to spread the
+    /// scan over up to \a threadcount threads, including the calling thread.
+    /// Zero means one thread per hardware thread. The default is one, which
+    /// disables parallel execution.
+    ///
+    /// The rows are divided into partitions aligned to B+-tree leaves, and
+    /// each participating thread evaluates its own copy of the conditions.
+    /// Parallel execution is only used when the query is not restricted by a
+    /// view, no limit is specified, the range is large enough to benefit, and
+    /// all conditions support it (conditions on subtables and links, and
+    /// query expressions, currently do not). Results are identical to those of
+    /// serial execution, except that sums of floating point values may differ
+    /// in rounding.
+    Query& set_threads(unsigned int threadcount);
 
     const TableRef& get_table()
     {
@@ -335,6 +383,9 @@ private:
     void init() const;
     size_t find_internal(size_t start = 0, size_t end = size_t(-1)) const;
     size_t peek_tablerow(size_t row) const;
+    size_t get_parallel_thread_count(size_t start, size_t end, size_t limit) const;
+    template <class State, class F>
+    void for_each_partition(size_t start, size_t end, size_t num_threads, std::vector<State>&, F) const;
     void handle_pending_not();
     void set_table(TableRef tr);
 
@@ -417,6 +468,9 @@ private:
 
     void add_node(std::unique_ptr<ParentNode>);
 
+    template <class F>
+    Query& bind_parameter(size_t param_ndx, F set_value);
+
     friend class Table;
     friend class TableViewBase;
 
@@ -439,6 +493,27 @@ private:
     LinkViewRef m_source_link_view;               // link views are refcounted and shared.
     TableViewBase* m_source_table_view = nullptr; // table views are not refcounted, and not owned by the query.
     std::unique_ptr<TableViewBase> m_owned_source_table_view; // <--- except when indicated here
+
+    size_t m_max_threads = 1; // See set_threads()
+
+    // The condition added by the last call to add_condition(), if nothing
+    // else was added since. See parameter().
+    ParentNode* m_last_condition = nullptr;
+
+    // The evaluation costs and ordered index matches that init() derived from
+    // the column statistics for the conditions that are evaluated first, in
+    // the order of ParentNode::gather_children(). They are reused by
+    // subsequent calls to init() until the conditions, the parameter values,
+    // or the table version changes.
+    struct NodePlan {
+        double m_dD;
+        double m_dT;
+        bool m_has_ordered_matches;
+        std::vector<size_t> m_ordered_matches;
+    };
+    mutable std::vector<NodePlan> m_plan;
+    mutable bool m_has_plan = false;
+    mutable uint_fast64_t m_plan_version = 0;
 };
 
 // Implementation:
@@ -453,6 +528,21 @@ inline Query& Query::not_equal(size_t column_ndx, const char* c_str, bool case_s
     return not_equal(column_ndx, StringData(c_str), case_sensitive);
 }
 
+inline Query& Query::bind(size_t param_ndx, int value)
+{
+    return bind(param_ndx, int64_t(value));
+}
+
+inline Query& Query::bind(size_t param_ndx, bool value)
+{
+    return bind(param_ndx, int64_t(value));
+}
+
+inline Query& Query::bind(size_t param_ndx, const char* c_str)
+{
+    return bind(param_ndx, StringData(c_str));
+}
+
 } // namespace realm
 
 #endif // REALM_QUERY_HPP
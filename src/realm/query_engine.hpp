@@ -86,6 +86,7 @@ AggregateState      State of the aggregate - contains a state variable that stor
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 #include <string>
 #include <array>
 
@@ -106,6 +107,7 @@ AggregateState      State of the aggregate - contains a state variable that stor
 #include <realm/column_timestamp.hpp>
 #include <realm/column_type_traits.hpp>
 #include <realm/column_type_traits.hpp>
+#include <realm/index_ordered.hpp>
 #include <realm/link_view.hpp>
 #include <realm/query_conditions.hpp>
 #include <realm/query_expression.hpp>
@@ -136,6 +138,18 @@ const size_t probe_matches = 4;
 
 const size_t bitwidth_time_unit = 64;
 
+// Minimum number of rows in a table before sampled column statistics are used to pick the first condition to
+// evaluate. Sampling costs a fixed number of random accesses per column, which only pays off against long scans.
+const size_t statistics_min_rows = 10000;
+
+// Minimum number of rows in a table before a zone map is used to skip leaves in searches for ranges of values.
+const size_t zone_map_min_rows = 4 * REALM_MAX_BPNODE_SIZE;
+
+// An ordered index is used to find the rows that match the range conditions on a column only if it finds at most
+// this fraction of the rows of the table. The rows are visited in the order of their values, and must be sorted
+// again by row index, which only beats a sequential scan when there are few of them.
+const size_t ordered_index_max_match_divisor = 16;
+
 typedef bool (*CallbackDummy)(int64_t);
 
 
@@ -166,6 +180,93 @@ public:
                m_dT; // dt = 1/64 to 1. Match dist is 8 times more important than bitwidth
     }
 
+    // Replace the guess of m_dD made by init() by one based on sampled column
+    // statistics, if this condition can estimate the fraction of rows that it
+    // matches. Must be called after init().
+    void init_cost_from_statistics()
+    {
+        util::Optional<double> selectivity = estimate_selectivity();
+        if (!selectivity)
+            return;
+        // A condition that is estimated to match no rows is treated as
+        // matching one row beyond the end of the table.
+        double min_selectivity = 1.0 / (m_table->size() + 1.0);
+        m_dD = 1.0 / std::max(*selectivity, min_selectivity);
+    }
+
+    // Returns the estimated fraction of rows that match this condition alone,
+    // or none if no estimate can be made.
+    virtual util::Optional<double> estimate_selectivity() const
+    {
+        return util::none;
+    }
+
+    // If this condition restricts the values of a column to a range, gets the
+    // column and the range of OrderedIndex keys that it matches, so that an
+    // ordered index on the column can find the matching rows.
+    virtual bool get_index_range(size_t&, OrderedIndex::Key&, OrderedIndex::Key&) const
+    {
+        return false;
+    }
+
+    // Make this condition match only the specified rows, which must be in
+    // increasing order, and be a subset of the rows that it matches. Used when
+    // an ordered index has found the rows. Must be called after init().
+    void set_ordered_matches(std::vector<size_t> rows)
+    {
+        m_dD = m_table->size() / (rows.size() + 1.0);
+        m_dT = 0.0;
+        m_ordered_matches = std::move(rows);
+        m_has_ordered_matches = true;
+    }
+
+    // Rows passed to set_ordered_matches() since the last call to init(), or
+    // null if there were none.
+    const std::vector<size_t>* get_ordered_matches() const noexcept
+    {
+        return m_has_ordered_matches ? &m_ordered_matches : nullptr;
+    }
+
+    // Replace the value that this condition compares the column against. Used
+    // by Query::bind() for conditions marked as a query parameter, and must be
+    // followed by init() before the condition is evaluated. Throws
+    // LogicError::type_mismatch unless the condition could have been created
+    // with a value of the specified type.
+    virtual void set_int_value(int64_t)
+    {
+        throw LogicError(LogicError::type_mismatch);
+    }
+    virtual void set_float_value(float)
+    {
+        throw LogicError(LogicError::type_mismatch);
+    }
+    virtual void set_double_value(double)
+    {
+        throw LogicError(LogicError::type_mismatch);
+    }
+    virtual void set_timestamp_value(Timestamp)
+    {
+        throw LogicError(LogicError::type_mismatch);
+    }
+    virtual void set_string_value(StringData)
+    {
+        throw LogicError(LogicError::type_mismatch);
+    }
+    virtual void set_null_value()
+    {
+        throw LogicError(LogicError::type_mismatch);
+    }
+
+    // Add this condition, and the conditions nested within and following it,
+    // to `nodes` if they are marked as query parameter `param_ndx`.
+    virtual void gather_parameter_nodes(size_t param_ndx, std::vector<ParentNode*>& nodes)
+    {
+        if (m_param_ndx == param_ndx)
+            nodes.push_back(this);
+        if (m_child)
+            m_child->gather_parameter_nodes(param_ndx, nodes);
+    }
+
     size_t find_first(size_t start, size_t end);
 
     virtual void init()
@@ -173,6 +274,7 @@ public:
         if (m_child)
             m_child->init();
         m_column_action_specializer = nullptr;
+        clear_ordered_matches();
     }
 
     void set_table(const Table& table)
@@ -229,6 +331,15 @@ public:
             return m_child->validate();
     }
 
+    // Returns true if separate clones of this condition and all conditions
+    // that follow it may be evaluated concurrently by different threads. This
+    // requires that evaluation only reads column data through accessors owned
+    // by the node, and never creates or modifies accessors owned by the table.
+    virtual bool is_parallelizable() const
+    {
+        return !m_child || m_child->is_parallelizable();
+    }
+
     ParentNode(const ParentNode& from)
         : ParentNode(from, nullptr)
     {
@@ -241,6 +352,8 @@ public:
         , m_dT(from.m_dT)
         , m_probes(from.m_probes)
         , m_matches(from.m_matches)
+        , m_param_ndx(from.m_param_ndx)
+        , m_param_adjustment(from.m_param_adjustment)
         , m_table(patches ? ConstTableRef{} : from.m_table)
     {
     }
@@ -272,6 +385,14 @@ public:
     size_t m_probes = 0;
     size_t m_matches = 0;
 
+    // The query parameter that this condition was marked as by
+    // Query::parameter(), or npos.
+    size_t m_param_ndx = npos;
+    // Added to integer values bound to the parameter, because
+    // Query::greater_equal() and less_equal() create integer conditions on
+    // the adjacent value.
+    int m_param_adjustment = 0;
+
 protected:
     typedef bool (ParentNode::*Column_action_specialized)(QueryStateBase*, SequentialGetterBase*, size_t);
     Column_action_specialized m_column_action_specializer;
@@ -296,6 +417,24 @@ protected:
         return m_table->get_real_column_type(ndx);
     }
 
+    // Rows passed to set_ordered_matches()
+    std::vector<size_t> m_ordered_matches;
+    bool m_has_ordered_matches = false;
+
+    void clear_ordered_matches() noexcept
+    {
+        m_ordered_matches.clear();
+        m_has_ordered_matches = false;
+    }
+
+    // Returns the first row passed to set_ordered_matches() that is in
+    // `[start, end)`, or not_found.
+    size_t find_first_ordered_match(size_t start, size_t end) const noexcept
+    {
+        auto i = std::lower_bound(m_ordered_matches.begin(), m_ordered_matches.end(), start);
+        return (i != m_ordered_matches.end() && *i < end) ? *i : not_found;
+    }
+
     template <class ColType>
     void copy_getter(SequentialGetter<ColType>& dst, size_t& dst_idx, const SequentialGetter<ColType>& src,
                      const QueryNodeHandoverPatches* patches)
@@ -351,6 +490,13 @@ public:
             m_column = &m_table->get_column_mixed(m_condition_column_idx);
     }
 
+    void gather_parameter_nodes(size_t param_ndx, std::vector<ParentNode*>& nodes) override
+    {
+        if (m_condition)
+            m_condition->gather_parameter_nodes(param_ndx, nodes);
+        ParentNode::gather_parameter_nodes(param_ndx, nodes);
+    }
+
     std::string validate() override
     {
         if (error_code != "")
@@ -390,6 +536,12 @@ public:
         return not_found;
     }
 
+    bool is_parallelizable() const override
+    {
+        // Evaluation instantiates subtable accessors
+        return false;
+    }
+
     std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override
     {
         return std::unique_ptr<ParentNode>(new SubtableNode(*this, patches));
@@ -446,6 +598,239 @@ struct CostHeuristic<IntNullColumn> {
 };
 
 // FIXME: Add AdaptiveStringColumn, BasicColumn, etc.
+
+// Estimates the fraction of rows that match `value TConditionFunction key`
+// from the statistics of a column. Keys are values mapped to integers as
+// described for ColumnStatistics. If a key is rounded down from a more precise
+// value (`coarse`), strict range conditions include it.
+template <class TConditionFunction>
+struct SelectivityEstimate {
+    static util::Optional<double> estimate(const ColumnStatistics&, int64_t, bool)
+    {
+        return util::none;
+    }
+    static util::Optional<double> estimate_null(const ColumnStatistics&)
+    {
+        return util::none;
+    }
+};
+
+template <>
+struct SelectivityEstimate<Equal> {
+    static util::Optional<double> estimate(const ColumnStatistics& stats, int64_t key, bool)
+    {
+        return stats.estimate_equal(key);
+    }
+    static util::Optional<double> estimate_null(const ColumnStatistics& stats)
+    {
+        return stats.null_fraction();
+    }
+};
+
+template <>
+struct SelectivityEstimate<NotEqual> {
+    static util::Optional<double> estimate(const ColumnStatistics& stats, int64_t key, bool)
+    {
+        return std::max(1 - stats.null_fraction() - stats.estimate_equal(key), 0.0);
+    }
+    static util::Optional<double> estimate_null(const ColumnStatistics& stats)
+    {
+        return 1 - stats.null_fraction();
+    }
+};
+
+template <class TConditionFunction, bool less, bool inclusive>
+struct RangeSelectivityEstimate {
+    static util::Optional<double> estimate(const ColumnStatistics& stats, int64_t key, bool coarse)
+    {
+        if (!stats.is_ordered())
+            return util::none;
+        const int64_t min = std::numeric_limits<int64_t>::min();
+        const int64_t max = std::numeric_limits<int64_t>::max();
+        if (!inclusive && !coarse) {
+            if (key == (less ? min : max))
+                return 0.0;
+            key += less ? -1 : 1;
+        }
+        return less ? stats.estimate_range(min, key) : stats.estimate_range(key, max);
+    }
+    static util::Optional<double> estimate_null(const ColumnStatistics&)
+    {
+        return util::none;
+    }
+};
+
+template <>
+struct SelectivityEstimate<Less> : RangeSelectivityEstimate<Less, true, false> {
+};
+
+template <>
+struct SelectivityEstimate<LessEqual> : RangeSelectivityEstimate<LessEqual, true, true> {
+};
+
+template <>
+struct SelectivityEstimate<Greater> : RangeSelectivityEstimate<Greater, false, false> {
+};
+
+template <>
+struct SelectivityEstimate<GreaterEqual> : RangeSelectivityEstimate<GreaterEqual, false, true> {
+};
+
+template <class TConditionFunction>
+util::Optional<double> estimate_selectivity(const ColumnStatistics& stats, util::Optional<int64_t> key,
+                                            bool coarse = false)
+{
+    if (!stats.is_supported())
+        return util::none;
+    if (!key)
+        return SelectivityEstimate<TConditionFunction>::estimate_null(stats);
+    return SelectivityEstimate<TConditionFunction>::estimate(stats, *key, coarse);
+}
+
+// Gets the range `[first, last]` of non-null keys that can match
+// `value TConditionFunction key`, for skipping leaves with a zone map. Returns
+// false if the condition does not restrict the keys to a range. An empty
+// range has `first > last`. Keys are rounded down like for
+// SelectivityEstimate.
+template <class TConditionFunction>
+struct ZoneRange {
+    static bool get(int64_t, bool, int64_t&, int64_t&)
+    {
+        return false;
+    }
+};
+
+template <>
+struct ZoneRange<Equal> {
+    static bool get(int64_t key, bool, int64_t& first, int64_t& last)
+    {
+        first = last = key;
+        return true;
+    }
+};
+
+template <bool less, bool inclusive>
+struct OpenZoneRange {
+    static bool get(int64_t key, bool coarse, int64_t& first, int64_t& last)
+    {
+        const int64_t min = std::numeric_limits<int64_t>::min();
+        const int64_t max = std::numeric_limits<int64_t>::max();
+        first = less ? min : key;
+        last = less ? key : max;
+        if (!inclusive && !coarse) {
+            if (key == (less ? min : max)) {
+                first = max;
+                last = min;
+            }
+            else if (less) {
+                last = key - 1;
+            }
+            else {
+                first = key + 1;
+            }
+        }
+        return true;
+    }
+};
+
+template <>
+struct ZoneRange<Less> : OpenZoneRange<true, false> {
+};
+
+template <>
+struct ZoneRange<LessEqual> : OpenZoneRange<true, true> {
+};
+
+template <>
+struct ZoneRange<Greater> : OpenZoneRange<false, false> {
+};
+
+template <>
+struct ZoneRange<GreaterEqual> : OpenZoneRange<false, true> {
+};
+
+// Gets the zone map of a column if `key TConditionFunction value` restricts
+// the values to a range in a table that is large enough for it to pay off.
+template <class TConditionFunction>
+std::shared_ptr<const ZoneMap> get_zone_map(const Table& table, size_t col_ndx, util::Optional<int64_t> key,
+                                            bool coarse, int64_t& first, int64_t& last)
+{
+    if (!key || table.size() < zone_map_min_rows)
+        return nullptr;
+    if (!ZoneRange<TConditionFunction>::get(*key, coarse, first, last))
+        return nullptr;
+    return table.get_zone_map(col_ndx); // Throws
+}
+
+// Gets the range `[first, last]` of OrderedIndex keys that can match
+// `value TConditionFunction key`. Returns false if the condition does not
+// restrict the values to a range. An empty range has `last < first`.
+template <class TConditionFunction>
+struct IndexRange {
+    static bool get(OrderedIndex::Key, OrderedIndex::Key&, OrderedIndex::Key&)
+    {
+        return false;
+    }
+};
+
+template <>
+struct IndexRange<Equal> {
+    static bool get(OrderedIndex::Key key, OrderedIndex::Key& first, OrderedIndex::Key& last)
+    {
+        first = last = key;
+        return true;
+    }
+};
+
+template <bool less, bool inclusive>
+struct OpenIndexRange {
+    static bool get(OrderedIndex::Key key, OrderedIndex::Key& first, OrderedIndex::Key& last)
+    {
+        const OrderedIndex::Key min = OrderedIndex::min_key();
+        const OrderedIndex::Key max = OrderedIndex::max_key();
+        first = less ? min : key;
+        last = less ? key : max;
+        if (!inclusive) {
+            if (key == (less ? min : max)) {
+                first = max;
+                last = min;
+            }
+            else if (less) {
+                last = OrderedIndex::prev(key);
+            }
+            else {
+                first = OrderedIndex::next(key);
+            }
+        }
+        return true;
+    }
+};
+
+template <>
+struct IndexRange<Less> : OpenIndexRange<true, false> {
+};
+
+template <>
+struct IndexRange<LessEqual> : OpenIndexRange<true, true> {
+};
+
+template <>
+struct IndexRange<Greater> : OpenIndexRange<false, false> {
+};
+
+template <>
+struct IndexRange<GreaterEqual> : OpenIndexRange<false, true> {
+};
+
+// Null and NaN keys match no range.
+template <class TConditionFunction, class T>
+bool get_index_range(T value, OrderedIndex::Key& first, OrderedIndex::Key& last)
+{
+    OrderedIndex::Key key;
+    if (!OrderedIndex::get_key(value, key))
+        return false;
+    return IndexRange<TConditionFunction>::get(key, first, last);
+}
 }
 
 class ColumnNodeBase : public ParentNode {
@@ -552,6 +937,11 @@ protected:
         // column only, with no references to other columns:
         bool fastmode = should_run_in_fastmode(source_column);
         for (size_t s = start; s < end;) {
+            if (s >= m_leaf_end || s < m_leaf_start) {
+                s = skip_zones(s, end);
+                if (s == end)
+                    break;
+            }
             cache_leaf(s);
 
             size_t end_in_leaf;
@@ -649,6 +1039,13 @@ protected:
         }
     }
 
+    // Returns the first row in `[start, end)` that is not in a leaf which the
+    // zone map rules out, or `end`.
+    size_t skip_zones(size_t start, size_t end) const noexcept
+    {
+        return m_zone_map ? m_zone_map->skip(start, end, m_zone_first, m_zone_last) : start;
+    }
+
     bool should_run_in_fastmode(SequentialGetterBase* source_column) const
     {
         return (m_children.size() == 1 &&
@@ -672,6 +1069,12 @@ protected:
     size_t m_leaf_end = 0;
     size_t m_local_end;
 
+    // Zone map of the condition column, and the range of values that can
+    // match. Set by init() of the derived class.
+    std::shared_ptr<const _impl::ZoneMap> m_zone_map;
+    int64_t m_zone_first = 0;
+    int64_t m_zone_last = 0;
+
     // Aggregate optimization
     using TFind_callback_specialized = bool (ThisType::*)(size_t, size_t);
     TFind_callback_specialized m_find_callback_specialized = nullptr;
@@ -696,8 +1099,35 @@ public:
     {
     }
 
+    void init() override
+    {
+        BaseType::init();
+        this->m_zone_map = _impl::get_zone_map<TConditionFunction>(
+            *this->m_table, this->m_condition_column_idx, util::Optional<int64_t>(this->m_value), false,
+            this->m_zone_first, this->m_zone_last); // Throws
+    }
+
+    void set_int_value(int64_t value) override
+    {
+        int64_t adjustment = this->m_param_adjustment;
+        if ((adjustment < 0 && value < std::numeric_limits<int64_t>::min() - adjustment) ||
+            (adjustment > 0 && value > std::numeric_limits<int64_t>::max() - adjustment))
+            throw LogicError(LogicError::illegal_combination);
+        this->m_value = value + adjustment;
+    }
+
+    void set_null_value() override
+    {
+        if (!BaseType::nullable)
+            throw LogicError(LogicError::type_mismatch);
+        this->m_value = TConditionValue{};
+    }
+
     void aggregate_local_prepare(Action action, DataType col_id, bool nullable) override
     {
+        // For the generic aggregate_local() used with ordered index matches
+        ParentNode::aggregate_local_prepare(action, col_id, nullable);
+
         this->m_fastmode_disabled = (col_id == type_Float || col_id == type_Double);
         this->m_action = action;
         this->m_find_callback_specialized = get_specialized_callback(action, col_id, nullable);
@@ -706,18 +1136,38 @@ public:
     size_t aggregate_local(QueryStateBase* st, size_t start, size_t end, size_t local_limit,
                            SequentialGetterBase* source_column) override
     {
+        if (this->m_has_ordered_matches)
+            return ParentNode::aggregate_local(st, start, end, local_limit, source_column);
         constexpr int cond = TConditionFunction::condition;
         return this->aggregate_local_impl(st, start, end, local_limit, source_column, cond);
     }
 
+    bool get_index_range(size_t& col_ndx, OrderedIndex::Key& first, OrderedIndex::Key& last) const override
+    {
+        col_ndx = this->m_condition_column_idx;
+        return _impl::get_index_range<TConditionFunction>(this->m_value, first, last);
+    }
+
+    util::Optional<double> estimate_selectivity() const override
+    {
+        const auto& stats = this->m_table->get_column_statistics(this->m_condition_column_idx);
+        return _impl::estimate_selectivity<TConditionFunction>(stats, util::Optional<int64_t>(this->m_value));
+    }
+
     size_t find_first_local(size_t start, size_t end) override
     {
         REALM_ASSERT(this->m_table);
 
+        if (this->m_has_ordered_matches)
+            return this->find_first_ordered_match(start, end);
+
         while (start < end) {
 
             // Cache internal leaves
             if (start >= this->m_leaf_end || start < this->m_leaf_start) {
+                start = this->skip_zones(start, end);
+                if (start == end)
+                    break;
                 this->get_leaf(*this->m_condition_column, start);
             }
 
@@ -846,8 +1296,32 @@ public:
         m_dD = 100.0;
     }
 
+    void set_float_value(float value) override
+    {
+        set_value(value);
+    }
+
+    void set_double_value(double value) override
+    {
+        set_value(value);
+    }
+
+    void set_null_value() override
+    {
+        m_value = null::get_null_float<TConditionValue>();
+    }
+
+    bool get_index_range(size_t& col_ndx, OrderedIndex::Key& first, OrderedIndex::Key& last) const override
+    {
+        col_ndx = m_condition_column_idx;
+        return _impl::get_index_range<TConditionFunction>(m_value, first, last);
+    }
+
     size_t find_first_local(size_t start, size_t end) override
     {
+        if (m_has_ordered_matches)
+            return find_first_ordered_match(start, end);
+
         TConditionFunction cond;
 
         auto find = [&](bool nullability) {
@@ -873,6 +1347,14 @@ public:
         return std::unique_ptr<ParentNode>(new FloatDoubleNode(*this, patches));
     }
 
+    template <class T>
+    void set_value(T value)
+    {
+        if (!std::is_same<T, TConditionValue>::value)
+            throw LogicError(LogicError::type_mismatch);
+        m_value = TConditionValue(value);
+    }
+
     FloatDoubleNode(const FloatDoubleNode& from, QueryNodeHandoverPatches* patches)
         : ParentNode(from, patches)
         , m_value(from.m_value)
@@ -973,15 +1455,62 @@ public:
     void init() override
     {
         m_dD = 100.0;
+        clear_ordered_matches();
+
+        util::Optional<int64_t> key;
+        if (!m_value.is_null())
+            key = m_value.get_seconds();
+        m_zone_map = _impl::get_zone_map<TConditionFunction>(*m_table, m_condition_column_idx, key, true,
+                                                             m_zone_first, m_zone_last); // Throws
 
         if (m_child)
             m_child->init();
     }
 
+    void set_timestamp_value(Timestamp value) override
+    {
+        m_value = value;
+    }
+
+    void set_null_value() override
+    {
+        m_value = Timestamp{};
+    }
+
+    bool get_index_range(size_t& col_ndx, OrderedIndex::Key& first, OrderedIndex::Key& last) const override
+    {
+        col_ndx = m_condition_column_idx;
+        return _impl::get_index_range<TConditionFunction>(m_value, first, last);
+    }
+
     size_t find_first_local(size_t start, size_t end) override
     {
-        size_t ret = m_condition_column->find<TConditionFunction>(m_value, start, end);
-        return ret;
+        if (m_has_ordered_matches)
+            return find_first_ordered_match(start, end);
+
+        if (!m_zone_map)
+            return m_condition_column->find<TConditionFunction>(m_value, start, end);
+
+        // Search the runs of leaves that the zone map does not rule out
+        while (start < end) {
+            start = m_zone_map->skip(start, end, m_zone_first, m_zone_last);
+            size_t run_end = m_zone_map->skip_candidates(start, end, m_zone_first, m_zone_last);
+            size_t ret = m_condition_column->find<TConditionFunction>(m_value, start, run_end);
+            if (ret != npos)
+                return ret;
+            start = run_end;
+        }
+        return not_found;
+    }
+
+    util::Optional<double> estimate_selectivity() const override
+    {
+        // Timestamps are sampled with a precision of whole seconds
+        const auto& stats = m_table->get_column_statistics(m_condition_column_idx);
+        util::Optional<int64_t> key;
+        if (!m_value.is_null())
+            key = m_value.get_seconds();
+        return _impl::estimate_selectivity<TConditionFunction>(stats, key, true);
     }
 
     std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override
@@ -1001,6 +1530,9 @@ public:
 private:
     Timestamp m_value;
     const TimestampColumn* m_condition_column;
+    std::shared_ptr<const _impl::ZoneMap> m_zone_map;
+    int64_t m_zone_first = 0;
+    int64_t m_zone_last = 0;
 };
 
 class StringNodeBase : public ParentNode {
@@ -1035,6 +1567,16 @@ public:
         m_leaf.reset(nullptr);
     }
 
+    void set_string_value(StringData v) override
+    {
+        m_value = v.is_null() ? util::none : util::make_optional(std::string(v));
+    }
+
+    void set_null_value() override
+    {
+        set_string_value(StringData()); // Throws
+    }
+
     StringNodeBase(const StringNodeBase& from, QueryNodeHandoverPatches* patches)
         : ParentNode(from, patches)
         , m_value(from.m_value)
@@ -1058,7 +1600,69 @@ protected:
     size_t m_end_s = 0;
     size_t m_leaf_start = 0;
     size_t m_leaf_end = 0;
-    
+
+    // Used for linear scan through enum-string. The condition is evaluated
+    // once per key, and the rows are then matched by their key indexes.
+    SequentialGetter<StringEnumColumn> m_cse;
+    std::vector<uint8_t> m_key_matches; // One per key, non-zero if the key matches
+    size_t m_num_key_matches = 0;
+    size_t m_first_key_match = 0;
+
+    template <class Cond>
+    void init_key_matches(Cond cond)
+    {
+        auto column = static_cast<const StringEnumColumn*>(m_condition_column);
+        const StringColumn& keys = column->get_keys();
+        size_t num_keys = keys.size();
+        m_key_matches.assign(num_keys, 0); // Throws
+        m_num_key_matches = 0;
+        for (size_t i = 0; i < num_keys; ++i) {
+            if (cond(keys.get(i))) {
+                m_key_matches[i] = 1;
+                if (m_num_key_matches++ == 0)
+                    m_first_key_match = i;
+            }
+        }
+        m_cse.init(column);
+    }
+
+    size_t find_first_key_match(size_t start, size_t end)
+    {
+        if (m_num_key_matches == 0)
+            return not_found;
+        if (m_num_key_matches == m_key_matches.size())
+            return start < end ? start : not_found;
+
+        for (size_t s = start; s < end; s = m_cse.m_leaf_end) {
+            m_cse.cache_next(s);
+            const ArrayInteger& leaf = *m_cse.m_leaf_ptr;
+            size_t begin = s - m_cse.m_leaf_start;
+            size_t local_end = m_cse.local_end(end);
+
+            // A single matching key can use the regular integer search
+            if (m_num_key_matches == 1) {
+                size_t f = leaf.find_first(int64_t(m_first_key_match), begin, local_end);
+                if (f != not_found)
+                    return f + m_cse.m_leaf_start;
+                continue;
+            }
+
+            // Otherwise decode the keys eight at a time and look them up in
+            // the set of matching keys
+            for (size_t i = begin; i < local_end; i += 8) {
+                int64_t chunk[8];
+                leaf.get_chunk(i, chunk);
+                size_t n = std::min(local_end - i, size_t(8));
+                for (size_t j = 0; j < n; ++j) {
+                    REALM_ASSERT_DEBUG(size_t(chunk[j]) < m_key_matches.size());
+                    if (m_key_matches[size_t(chunk[j])])
+                        return i + j + m_cse.m_leaf_start;
+                }
+            }
+        }
+        return not_found;
+    }
+
     inline StringData get_string(size_t s)
     {
         StringData t;
@@ -1104,15 +1708,13 @@ public:
     StringNode(StringData v, size_t column)
         : StringNodeBase(v, column)
     {
-        auto upper = case_map(v, true);
-        auto lower = case_map(v, false);
-        if (!upper || !lower) {
-            error_code = "Malformed UTF-8: " + std::string(v);
-        }
-        else {
-            m_ucase = std::move(*upper);
-            m_lcase = std::move(*lower);
-        }
+        init_case_maps(v);
+    }
+
+    void set_string_value(StringData v) override
+    {
+        StringNodeBase::set_string_value(v);
+        init_case_maps(v);
     }
 
     void init() override
@@ -1123,6 +1725,14 @@ public:
 
         StringNodeBase::init();
 
+        if (m_column_type == col_type_StringEnum) {
+            m_dT = 1.0;
+            TConditionFunction cond;
+            init_key_matches([&](StringData t) {
+                return cond(StringData(m_value), m_ucase.data(), m_lcase.data(), t);
+            }); // Throws
+        }
+
         if (m_child)
             m_child->init();
     }
@@ -1130,6 +1740,9 @@ public:
 
     size_t find_first_local(size_t start, size_t end) override
     {
+        if (m_column_type == col_type_StringEnum)
+            return find_first_key_match(start, end);
+
         TConditionFunction cond;
 
         for (size_t s = start; s < end; ++s) {
@@ -1156,6 +1769,23 @@ public:
 protected:
     std::string m_ucase;
     std::string m_lcase;
+
+private:
+    void init_case_maps(StringData v)
+    {
+        auto upper = case_map(v, true);
+        auto lower = case_map(v, false);
+        if (!upper || !lower) {
+            error_code = "Malformed UTF-8: " + std::string(v);
+            m_ucase.clear();
+            m_lcase.clear();
+        }
+        else {
+            error_code.clear();
+            m_ucase = std::move(*upper);
+            m_lcase = std::move(*lower);
+        }
+    }
 };
 
 // Specialization for Contains condition on Strings - we specialize because we can utilize Boyer-Moore
@@ -1165,19 +1795,13 @@ public:
     StringNode(StringData v, size_t column)
     : StringNodeBase(v, column), m_charmap()
     {
-        if (v.size() == 0)
-            return;
-        
-        // Build a dictionary of char-to-last distances in the search string
-        // (zero indicates that the char is not in needle)
-        size_t last_char_pos = v.size()-1;
-        for (size_t i = 0; i < last_char_pos; ++i) {
-            // we never jump longer increments than 255 chars, even if needle is longer (to fit in one byte)
-            uint8_t jump = last_char_pos-i < 255 ? static_cast<uint8_t>(last_char_pos-i) : 255;
-            
-            unsigned char c = v[i];
-            m_charmap[c] = jump;
-        }
+        init_charmap(v);
+    }
+
+    void set_string_value(StringData v) override
+    {
+        StringNodeBase::set_string_value(v);
+        init_charmap(v);
     }
     
     void init() override
@@ -1187,7 +1811,15 @@ public:
         m_dD = 100.0;
         
         StringNodeBase::init();
-        
+
+        if (m_column_type == col_type_StringEnum) {
+            m_dT = 1.0;
+            Contains cond;
+            init_key_matches([&](StringData t) {
+                return cond(StringData(m_value), m_charmap, t);
+            }); // Throws
+        }
+
         if (m_child)
             m_child->init();
     }
@@ -1195,6 +1827,9 @@ public:
     
     size_t find_first_local(size_t start, size_t end) override
     {
+        if (m_column_type == col_type_StringEnum)
+            return find_first_key_match(start, end);
+
         Contains cond;
         
         for (size_t s = start; s < end; ++s) {
@@ -1219,41 +1854,41 @@ public:
     
 protected:
     std::array<uint8_t, 256> m_charmap;
-};
 
-// Specialization for ContainsIns condition on Strings - we specialize because we can utilize Boyer-Moore
-template <>
-class StringNode<ContainsIns> : public StringNodeBase {
-public:
-    StringNode(StringData v, size_t column)
-    : StringNodeBase(v, column), m_charmap()
+private:
+    void init_charmap(StringData v)
     {
-        auto upper = case_map(v, true);
-        auto lower = case_map(v, false);
-        if (!upper || !lower) {
-            error_code = "Malformed UTF-8: " + std::string(v);
-        }
-        else {
-            m_ucase = std::move(*upper);
-            m_lcase = std::move(*lower);
-        }
-        
+        m_charmap.fill(0);
         if (v.size() == 0)
             return;
         
         // Build a dictionary of char-to-last distances in the search string
         // (zero indicates that the char is not in needle)
-        size_t last_char_pos = m_ucase.size()-1;
+        size_t last_char_pos = v.size()-1;
         for (size_t i = 0; i < last_char_pos; ++i) {
             // we never jump longer increments than 255 chars, even if needle is longer (to fit in one byte)
             uint8_t jump = last_char_pos-i < 255 ? static_cast<uint8_t>(last_char_pos-i) : 255;
             
-            unsigned char uc = m_ucase[i];
-            unsigned char lc = m_lcase[i];
-            m_charmap[uc] = jump;
-            m_charmap[lc] = jump;
+            unsigned char c = v[i];
+            m_charmap[c] = jump;
         }
+    }
+};
 
+// Specialization for ContainsIns condition on Strings - we specialize because we can utilize Boyer-Moore
+template <>
+class StringNode<ContainsIns> : public StringNodeBase {
+public:
+    StringNode(StringData v, size_t column)
+    : StringNodeBase(v, column), m_charmap()
+    {
+        init_needle(v);
+    }
+
+    void set_string_value(StringData v) override
+    {
+        StringNodeBase::set_string_value(v);
+        init_needle(v);
     }
     
     void init() override
@@ -1263,7 +1898,15 @@ public:
         m_dD = 100.0;
         
         StringNodeBase::init();
-        
+
+        if (m_column_type == col_type_StringEnum) {
+            m_dT = 1.0;
+            ContainsIns cond;
+            init_key_matches([&](StringData t) {
+                return cond(StringData(m_value), m_ucase.data(), m_lcase.data(), m_charmap, t);
+            }); // Throws
+        }
+
         if (m_child)
             m_child->init();
     }
@@ -1271,6 +1914,9 @@ public:
     
     size_t find_first_local(size_t start, size_t end) override
     {
+        if (m_column_type == col_type_StringEnum)
+            return find_first_key_match(start, end);
+
         ContainsIns cond;
         
         for (size_t s = start; s < end; ++s) {
@@ -1299,6 +1945,40 @@ protected:
     std::array<uint8_t, 256> m_charmap;
     std::string m_ucase;
     std::string m_lcase;
+
+private:
+    void init_needle(StringData v)
+    {
+        m_charmap.fill(0);
+        auto upper = case_map(v, true);
+        auto lower = case_map(v, false);
+        if (!upper || !lower) {
+            error_code = "Malformed UTF-8: " + std::string(v);
+            m_ucase.clear();
+            m_lcase.clear();
+        }
+        else {
+            error_code.clear();
+            m_ucase = std::move(*upper);
+            m_lcase = std::move(*lower);
+        }
+        
+        if (m_ucase.size() == 0)
+            return;
+        
+        // Build a dictionary of char-to-last distances in the search string
+        // (zero indicates that the char is not in needle)
+        size_t last_char_pos = m_ucase.size()-1;
+        for (size_t i = 0; i < last_char_pos; ++i) {
+            // we never jump longer increments than 255 chars, even if needle is longer (to fit in one byte)
+            uint8_t jump = last_char_pos-i < 255 ? static_cast<uint8_t>(last_char_pos-i) : 255;
+            
+            unsigned char uc = m_ucase[i];
+            unsigned char lc = m_lcase[i];
+            m_charmap[uc] = jump;
+            m_charmap[lc] = jump;
+        }
+    }
 };
 
 // Specialization for Equal condition on Strings - we specialize because we can utilize indexes (if they exist) for
@@ -1330,6 +2010,15 @@ public:
         m_index_getter.reset();
     }
 
+    util::Optional<double> estimate_selectivity() const override
+    {
+        const auto& stats = m_table->get_column_statistics(m_condition_column_idx);
+        util::Optional<int64_t> key;
+        if (m_value)
+            key = _impl::ColumnStatistics::string_key(*m_value);
+        return _impl::estimate_selectivity<Equal>(stats, key);
+    }
+
     void init() override
     {
         deallocate();
@@ -1510,9 +2199,6 @@ private:
     size_t m_key_ndx = not_found;
     size_t m_last_indexed;
 
-    // Used for linear scan through enum-string
-    SequentialGetter<StringEnumColumn> m_cse;
-
     // Used for index lookup
     std::unique_ptr<IntegerColumn> m_index_matches;
     bool m_index_matches_destroy = false;
@@ -1614,6 +2300,13 @@ public:
         return index;
     }
 
+    void gather_parameter_nodes(size_t param_ndx, std::vector<ParentNode*>& nodes) override
+    {
+        for (auto& condition : m_conditions)
+            condition->gather_parameter_nodes(param_ndx, nodes);
+        ParentNode::gather_parameter_nodes(param_ndx, nodes);
+    }
+
     std::string validate() override
     {
         if (error_code != "")
@@ -1635,6 +2328,15 @@ public:
         return "";
     }
 
+    bool is_parallelizable() const override
+    {
+        for (auto& condition : m_conditions) {
+            if (!condition->is_parallelizable())
+                return false;
+        }
+        return ParentNode::is_parallelizable();
+    }
+
     std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override
     {
         return std::unique_ptr<ParentNode>(new OrNode(*this, patches));
@@ -1694,6 +2396,13 @@ public:
 
     size_t find_first_local(size_t start, size_t end) override;
 
+    void gather_parameter_nodes(size_t param_ndx, std::vector<ParentNode*>& nodes) override
+    {
+        if (m_condition)
+            m_condition->gather_parameter_nodes(param_ndx, nodes);
+        ParentNode::gather_parameter_nodes(param_ndx, nodes);
+    }
+
     std::string validate() override
     {
         if (error_code != "")
@@ -1711,6 +2420,11 @@ public:
         return "";
     }
 
+    bool is_parallelizable() const override
+    {
+        return m_condition->is_parallelizable() && ParentNode::is_parallelizable();
+    }
+
     std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override
     {
         return std::unique_ptr<ParentNode>(new NotNode(*this, patches));
@@ -1881,6 +2595,13 @@ public:
         return m_expression->find_first(start, end);
     }
 
+    bool is_parallelizable() const override
+    {
+        // Expressions may follow links, which instantiates accessors for the
+        // target tables and link lists
+        return false;
+    }
+
     std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override
     {
         return std::unique_ptr<ParentNode>(new ExpressionNode(*this, patches));
@@ -1949,6 +2670,13 @@ public:
         return not_found;
     }
 
+    bool is_parallelizable() const override
+    {
+        // Evaluation instantiates link list accessors, and copying the node
+        // registers a row accessor with the target table
+        return false;
+    }
+
     std::unique_ptr<ParentNode> clone(QueryNodeHandoverPatches* patches) const override
     {
         return std::unique_ptr<ParentNode>(patches ? new LinksToNode(*this, patches) : new LinksToNode(*this));
@@ -131,6 +131,7 @@ The Columns class encapsulates all this into a simple class that, for any type T
 #include <realm/util/optional.hpp>
 #include <realm/impl/sequential_getter.hpp>
 
+#include <algorithm>
 #include <numeric>
 
 // Normally, if a next-generation-syntax condition is supported by the old query_engine.hpp, a query_engine node is
@@ -346,6 +347,46 @@ struct ValueBase {
     size_t m_values;
 };
 
+// Maximum number of rows evaluated at a time by Subexpr::evaluate_batch(). A batch of a column spans at most two
+// B+-tree leaves.
+static const size_t expression_batch_size = REALM_MAX_BPNODE_SIZE;
+
+// Values of a subexpression for a range of consecutive rows, as produced by Subexpr::evaluate_batch(). Values and
+// null flags are kept in separate contiguous arrays, so that the loops operating on them can be vectorized by the
+// compiler. The null flags are only meaningful if `m_has_nulls` is true. Memory is allocated by reserve(), and is
+// reused for every batch.
+template <class T>
+struct ValueBatch {
+    std::unique_ptr<T[]> m_values;
+    std::unique_ptr<bool[]> m_nulls;
+    bool m_has_nulls = false;
+
+    void reserve()
+    {
+        if (!m_values) {
+            m_values.reset(new T[expression_batch_size]);   // Throws
+            m_nulls.reset(new bool[expression_batch_size]); // Throws
+        }
+    }
+};
+
+namespace _impl {
+
+template <class D, class T>
+typename std::enable_if<std::is_arithmetic<T>::value, D>::type batch_cast(T value)
+{
+    return static_cast<D>(value);
+}
+
+template <class D, class T>
+typename std::enable_if<!std::is_arithmetic<T>::value, D>::type batch_cast(const T&)
+{
+    REALM_ASSERT(false);
+    return D();
+}
+
+} // namespace _impl
+
 class Expression {
 public:
     Expression()
@@ -402,6 +443,30 @@ public:
     }
 
     virtual void evaluate(size_t index, ValueBase& destination) = 0;
+
+    // Subexpressions that produce exactly one numeric value per row (columns without links, constants, and
+    // arithmetic on those) can also be evaluated for a whole range of rows at a time. If supports_batches()
+    // returns true, evaluate_batch() stores the values of the rows [index, index + size) in `destination`, which
+    // must have been reserved. `size` must not exceed `expression_batch_size`.
+    virtual bool supports_batches() const
+    {
+        return false;
+    }
+
+    virtual void evaluate_batch(size_t, size_t, ValueBatch<int64_t>&)
+    {
+        REALM_ASSERT(false);
+    }
+
+    virtual void evaluate_batch(size_t, size_t, ValueBatch<float>&)
+    {
+        REALM_ASSERT(false);
+    }
+
+    virtual void evaluate_batch(size_t, size_t, ValueBatch<double>&)
+    {
+        REALM_ASSERT(false);
+    }
 };
 
 template <typename T, typename... Args>
@@ -1078,6 +1143,39 @@ public:
         destination.import(*this);
     }
 
+    bool supports_batches() const override
+    {
+        return realm::is_any<T, int, int64_t, float, double>::value && !ValueBase::m_from_link_list &&
+               ValueBase::m_values > 0;
+    }
+
+    // A constant has the same value for every row, so it is broadcast to the entire batch
+    void evaluate_batch(size_t, size_t size, ValueBatch<int64_t>& destination) override
+    {
+        broadcast(size, destination);
+    }
+
+    void evaluate_batch(size_t, size_t size, ValueBatch<float>& destination) override
+    {
+        broadcast(size, destination);
+    }
+
+    void evaluate_batch(size_t, size_t size, ValueBatch<double>& destination) override
+    {
+        broadcast(size, destination);
+    }
+
+    template <class D>
+    void broadcast(size_t size, ValueBatch<D>& destination) const
+    {
+        bool is_null = m_storage.is_null(0);
+        D value = is_null ? D() : _impl::batch_cast<D>(m_storage[0]);
+        std::fill_n(destination.m_values.get(), size, value);
+        if (is_null)
+            std::fill_n(destination.m_nulls.get(), size, true);
+        destination.m_has_nulls = is_null;
+    }
+
 
     template <class TOperator>
     REALM_FORCEINLINE void fun(const Value* left, const Value* right)
@@ -2533,6 +2631,63 @@ public:
         }
     }
 
+    bool supports_batches() const override
+    {
+        return realm::is_any<T, int64_t, float, double>::value && m_sg && !links_exist();
+    }
+
+    void evaluate_batch(size_t index, size_t size, ValueBatch<int64_t>& destination) override
+    {
+        evaluate_batch_dispatch(index, size, destination);
+    }
+
+    void evaluate_batch(size_t index, size_t size, ValueBatch<float>& destination) override
+    {
+        evaluate_batch_dispatch(index, size, destination);
+    }
+
+    void evaluate_batch(size_t index, size_t size, ValueBatch<double>& destination) override
+    {
+        evaluate_batch_dispatch(index, size, destination);
+    }
+
+    template <class D>
+    void evaluate_batch_dispatch(size_t index, size_t size, ValueBatch<D>& destination)
+    {
+        if (m_nullable && std::is_same<typename ColType::value_type, int64_t>::value) {
+            evaluate_batch_internal<IntNullColumn>(index, size, destination);
+        }
+        else {
+            evaluate_batch_internal<ColType>(index, size, destination);
+        }
+    }
+
+    // Copy the values directly out of the leaves, one leaf at a time
+    template <class ColType2, class D>
+    void evaluate_batch_internal(size_t index, size_t size, ValueBatch<D>& destination)
+    {
+        REALM_ASSERT_DEBUG(m_sg.get());
+        REALM_ASSERT_DEBUG(dynamic_cast<SequentialGetter<ColType2>*>(m_sg.get()));
+        REALM_ASSERT_3(size, <=, expression_batch_size);
+
+        auto sgc = static_cast<SequentialGetter<ColType2>*>(m_sg.get());
+        D* values = destination.m_values.get();
+        bool* nulls = destination.m_nulls.get();
+        bool has_nulls = false;
+        size_t end = index + size;
+        while (index < end) {
+            sgc->cache_next(index);
+            size_t begin_in_leaf = index - sgc->m_leaf_start;
+            size_t end_in_leaf = std::min(sgc->m_leaf_end, end) - sgc->m_leaf_start;
+            has_nulls |= load_leaf(*sgc->m_leaf_ptr, begin_in_leaf, end_in_leaf, values, nulls);
+            size_t n = end_in_leaf - begin_in_leaf;
+            values += n;
+            nulls += n;
+            index += n;
+        }
+        destination.m_has_nulls = has_nulls;
+    }
+
     bool links_exist() const
     {
         return m_link_map.m_link_columns.size() > 0;
@@ -2568,6 +2723,65 @@ private:
         else
             return *static_cast<SequentialGetter<ColType>&>(*m_sg).m_column;
     }
+
+    // Copy the elements [begin, end) of a leaf into `values`, and return whether any of them were null, in which
+    // case `nulls` has been updated too. Leaves that cannot contain nulls leave `nulls` untouched.
+    template <class D>
+    static bool load_leaf(const ArrayInteger& leaf, size_t begin, size_t end, D* values, bool*)
+    {
+        int64_t chunk[8];
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            leaf.get_chunk(i, chunk);
+            for (size_t j = 0; j < 8; ++j)
+                values[j] = static_cast<D>(chunk[j]);
+            values += 8;
+        }
+        for (; i < end; ++i)
+            *values++ = static_cast<D>(leaf.get(i));
+        return false;
+    }
+
+    template <class D>
+    static bool load_leaf(const ArrayIntNull& leaf, size_t begin, size_t end, D* values, bool* nulls)
+    {
+        // Element 0 of the underlying array is the value that represents null
+        const Array& array = leaf;
+        int64_t null_value = leaf.null_value();
+        int64_t chunk[8];
+        bool has_nulls = false;
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            array.get_chunk(i + 1, chunk);
+            for (size_t j = 0; j < 8; ++j) {
+                values[j] = static_cast<D>(chunk[j]);
+                nulls[j] = chunk[j] == null_value;
+                has_nulls |= nulls[j];
+            }
+            values += 8;
+            nulls += 8;
+        }
+        for (; i < end; ++i) {
+            int64_t value = array.get(i + 1);
+            *values++ = static_cast<D>(value);
+            *nulls = value == null_value;
+            has_nulls |= *nulls++;
+        }
+        return has_nulls;
+    }
+
+    template <class F, class D>
+    static bool load_leaf(const BasicArray<F>& leaf, size_t begin, size_t end, D* values, bool* nulls)
+    {
+        bool has_nulls = false;
+        for (size_t i = begin; i < end; ++i) {
+            F value = leaf.get(i);
+            *values++ = static_cast<D>(value);
+            *nulls = null::is_null_float(value);
+            has_nulls |= *nulls++;
+        }
+        return has_nulls;
+    }
 };
 
 template <typename T, typename Operation>
@@ -2937,6 +3151,26 @@ public:
         destination.import(result);
     }
 
+    bool supports_batches() const override
+    {
+        return realm::is_any<T, int64_t, float, double>::value && m_left->supports_batches();
+    }
+
+    void evaluate_batch(size_t index, size_t size, ValueBatch<int64_t>& destination) override
+    {
+        evaluate_batch_internal(index, size, destination, BatchSupport());
+    }
+
+    void evaluate_batch(size_t index, size_t size, ValueBatch<float>& destination) override
+    {
+        evaluate_batch_internal(index, size, destination, BatchSupport());
+    }
+
+    void evaluate_batch(size_t index, size_t size, ValueBatch<double>& destination) override
+    {
+        evaluate_batch_internal(index, size, destination, BatchSupport());
+    }
+
     std::unique_ptr<Subexpr> clone(QueryNodeHandoverPatches* patches) const override
     {
         return make_subexpr<UnaryOperator>(*this, patches);
@@ -2949,7 +3183,40 @@ public:
 
 private:
     typedef typename oper::type T;
+    using BatchSupport = std::integral_constant<bool, realm::is_any<T, int64_t, float, double>::value>;
+
+    template <class D>
+    void evaluate_batch_internal(size_t, size_t, ValueBatch<D>&, std::false_type)
+    {
+        REALM_ASSERT(false);
+    }
+
+    template <class D>
+    void evaluate_batch_internal(size_t index, size_t size, ValueBatch<D>& destination, std::true_type)
+    {
+        m_left_batch.reserve(); // Throws
+        m_left->evaluate_batch(index, size, m_left_batch);
+
+        T* left = m_left_batch.m_values.get();
+        if (std::is_integral<T>::value && m_left_batch.m_has_nulls) {
+            // The values of null rows are unspecified, so replace them by a value that cannot overflow
+            const bool* nulls = m_left_batch.m_nulls.get();
+            for (size_t i = 0; i < size; ++i)
+                left[i] = nulls[i] ? T(1) : left[i];
+        }
+
+        oper o;
+        D* values = destination.m_values.get();
+        for (size_t i = 0; i < size; ++i)
+            values[i] = static_cast<D>(o(left[i]));
+
+        destination.m_has_nulls = m_left_batch.m_has_nulls;
+        if (m_left_batch.m_has_nulls)
+            std::copy_n(m_left_batch.m_nulls.get(), size, destination.m_nulls.get());
+    }
+
     std::unique_ptr<TLeft> m_left;
+    ValueBatch<T> m_left_batch;
 };
 
 
@@ -3014,6 +3281,27 @@ public:
         destination.import(result);
     }
 
+    bool supports_batches() const override
+    {
+        return realm::is_any<T, int64_t, float, double>::value && m_left->supports_batches() &&
+               m_right->supports_batches();
+    }
+
+    void evaluate_batch(size_t index, size_t size, ValueBatch<int64_t>& destination) override
+    {
+        evaluate_batch_internal(index, size, destination, BatchSupport());
+    }
+
+    void evaluate_batch(size_t index, size_t size, ValueBatch<float>& destination) override
+    {
+        evaluate_batch_internal(index, size, destination, BatchSupport());
+    }
+
+    void evaluate_batch(size_t index, size_t size, ValueBatch<double>& destination) override
+    {
+        evaluate_batch_internal(index, size, destination, BatchSupport());
+    }
+
     std::unique_ptr<Subexpr> clone(QueryNodeHandoverPatches* patches) const override
     {
         return make_subexpr<Operator>(*this, patches);
@@ -3027,8 +3315,56 @@ public:
 
 private:
     typedef typename oper::type T;
+    using BatchSupport = std::integral_constant<bool, realm::is_any<T, int64_t, float, double>::value>;
+
+    template <class D>
+    void evaluate_batch_internal(size_t, size_t, ValueBatch<D>&, std::false_type)
+    {
+        REALM_ASSERT(false);
+    }
+
+    template <class D>
+    void evaluate_batch_internal(size_t index, size_t size, ValueBatch<D>& destination, std::true_type)
+    {
+        m_left_batch.reserve();  // Throws
+        m_right_batch.reserve(); // Throws
+        m_left->evaluate_batch(index, size, m_left_batch);
+        m_right->evaluate_batch(index, size, m_right_batch);
+
+        T* left = m_left_batch.m_values.get();
+        T* right = m_right_batch.m_values.get();
+        bool has_nulls = m_left_batch.m_has_nulls || m_right_batch.m_has_nulls;
+        if (has_nulls) {
+            // The result is null if either operand is null
+            const bool* left_nulls = m_left_batch.m_nulls.get();
+            const bool* right_nulls = m_right_batch.m_nulls.get();
+            bool* nulls = destination.m_nulls.get();
+            bool left_has_nulls = m_left_batch.m_has_nulls;
+            bool right_has_nulls = m_right_batch.m_has_nulls;
+            for (size_t i = 0; i < size; ++i)
+                nulls[i] = (left_has_nulls && left_nulls[i]) || (right_has_nulls && right_nulls[i]);
+
+            // The values of null rows are unspecified, so replace the operands by a value that cannot cause
+            // integer division by zero or overflow
+            if (std::is_integral<T>::value) {
+                for (size_t i = 0; i < size; ++i) {
+                    left[i] = nulls[i] ? T(1) : left[i];
+                    right[i] = nulls[i] ? T(1) : right[i];
+                }
+            }
+        }
+
+        oper o;
+        D* values = destination.m_values.get();
+        for (size_t i = 0; i < size; ++i)
+            values[i] = static_cast<D>(o(left[i], right[i]));
+        destination.m_has_nulls = has_nulls;
+    }
+
     std::unique_ptr<TLeft> m_left;
     std::unique_ptr<TRight> m_right;
+    ValueBatch<T> m_left_batch;
+    ValueBatch<T> m_right_batch;
 };
 
 
@@ -3046,6 +3382,9 @@ public:
     {
         m_left->set_base_table(table);
         m_right->set_base_table(table);
+        m_table = table;
+        m_batch_mode = BatchMode::unknown;
+        m_matches_begin = m_matches_end = 0;
     }
 
     // Recursively fetch tables of columns in expression tree. Used when user first builds a stand-alone expression
@@ -3065,6 +3404,14 @@ public:
 
     size_t find_first(size_t start, size_t end) const override
     {
+        if (m_batch_mode == BatchMode::unknown) {
+            bool supported = BatchSupport::value && m_table && m_left->supports_batches() &&
+                             m_right->supports_batches();
+            m_batch_mode = supported ? BatchMode::enabled : BatchMode::disabled;
+        }
+        if (m_batch_mode == BatchMode::enabled)
+            return find_first_batched(start, end, BatchSupport());
+
         size_t match;
         Value<T> right;
         Value<T> left;
@@ -3097,14 +3444,103 @@ public:
     }
 
 private:
+    using BatchSupport = std::integral_constant<bool, realm::is_any<T, int64_t, float, double>::value>;
+    enum class BatchMode { unknown, enabled, disabled };
+
     Compare(const Compare& other, QueryNodeHandoverPatches* patches)
         : m_left(other.m_left->clone(patches))
         , m_right(other.m_right->clone(patches))
+        , m_table(patches ? nullptr : other.m_table)
     {
     }
 
+    size_t find_first_batched(size_t, size_t, std::false_type) const
+    {
+        REALM_ASSERT(false);
+        return not_found;
+    }
+
+    // Evaluate both sides a batch of rows at a time, and collect the indexes of the matching rows of the most
+    // recent batch. When the condition matches many rows, the ParentNode calls find_first() once per match, and
+    // most of these calls are then answered from the matches that were already found.
+    size_t find_first_batched(size_t start, size_t end, std::true_type) const
+    {
+        uint_fast64_t version = m_table->get_version_counter();
+        if (version != m_matches_version) {
+            m_matches_begin = m_matches_end = 0;
+            m_matches_version = version;
+        }
+
+        while (start < end) {
+            if (start < m_matches_begin || start >= m_matches_end)
+                compute_matches(start, std::min(end - start, expression_batch_size));
+
+            const size_t* matches_begin = m_matches.get();
+            const size_t* matches_end = matches_begin + m_num_matches;
+            const size_t* match = std::lower_bound(matches_begin, matches_end, start);
+            if (match != matches_end)
+                return *match < end ? *match : not_found;
+            start = m_matches_end;
+        }
+        return not_found;
+    }
+
+    void compute_matches(size_t start, size_t size) const
+    {
+        m_left_batch.reserve();  // Throws
+        m_right_batch.reserve(); // Throws
+        if (!m_matches) {
+            m_match_mask.reset(new bool[expression_batch_size]); // Throws
+            m_matches.reset(new size_t[expression_batch_size]);  // Throws
+        }
+        m_left->evaluate_batch(start, size, m_left_batch);
+        m_right->evaluate_batch(start, size, m_right_batch);
+
+        TCond c;
+        const T* left = m_left_batch.m_values.get();
+        const T* right = m_right_batch.m_values.get();
+        bool* mask = m_match_mask.get();
+        if (!m_left_batch.m_has_nulls && !m_right_batch.m_has_nulls) {
+            for (size_t i = 0; i < size; ++i)
+                mask[i] = c(left[i], right[i], false, false);
+        }
+        else {
+            const bool* left_nulls = m_left_batch.m_nulls.get();
+            const bool* right_nulls = m_right_batch.m_nulls.get();
+            bool left_has_nulls = m_left_batch.m_has_nulls;
+            bool right_has_nulls = m_right_batch.m_has_nulls;
+            for (size_t i = 0; i < size; ++i)
+                mask[i] = c(left[i], right[i], left_has_nulls && left_nulls[i], right_has_nulls && right_nulls[i]);
+        }
+
+        // Convert the mask into a selection vector without branching on the outcome of each comparison
+        size_t* matches = m_matches.get();
+        size_t n = 0;
+        for (size_t i = 0; i < size; ++i) {
+            matches[n] = start + i;
+            n += mask[i];
+        }
+        m_num_matches = n;
+        m_matches_begin = start;
+        m_matches_end = start + size;
+    }
+
     std::unique_ptr<TLeft> m_left;
     std::unique_ptr<TRight> m_right;
+
+    const Table* m_table = nullptr;
+    mutable BatchMode m_batch_mode = BatchMode::unknown;
+    mutable ValueBatch<T> m_left_batch;
+    mutable ValueBatch<T> m_right_batch;
+    mutable std::unique_ptr<bool[]> m_match_mask;
+
+    // Indexes of the rows in [m_matches_begin, m_matches_end) that match the condition, in ascending order. Only
+    // valid as long as the version of the table is `m_matches_version`.
+    mutable std::unique_ptr<size_t[]> m_matches;
+    mutable size_t m_num_matches = 0;
+    mutable size_t m_matches_begin = 0;
+    mutable size_t m_matches_end = 0;
+    mutable uint_fast64_t m_matches_version = 0;
 };
 }
 #endif // REALM_QUERY_EXPRESSION_HPP
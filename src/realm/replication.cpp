@@ -393,6 +393,34 @@ public:
         return false;
     }
 
+    bool add_ordered_index(size_t col_ndx)
+    {
+        if (REALM_LIKELY(REALM_COVER_ALWAYS(m_table && m_table->is_attached()))) {
+            if (REALM_LIKELY(REALM_COVER_ALWAYS(!m_table->has_shared_type()))) {
+                if (REALM_LIKELY(REALM_COVER_ALWAYS(col_ndx < m_table->get_column_count()))) {
+                    log("table->add_ordered_index(%1);", col_ndx); // Throws
+                    m_table->add_ordered_index(col_ndx);           // Throws
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool remove_ordered_index(size_t col_ndx)
+    {
+        if (REALM_LIKELY(REALM_COVER_ALWAYS(m_table && m_table->is_attached()))) {
+            if (REALM_LIKELY(REALM_COVER_ALWAYS(!m_table->has_shared_type()))) {
+                if (REALM_LIKELY(REALM_COVER_ALWAYS(col_ndx < m_table->get_column_count()))) {
+                    log("table->remove_ordered_index(%1);", col_ndx); // Throws
+                    m_table->remove_ordered_index(col_ndx);           // Throws
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
     bool set_link_type(size_t col_ndx, LinkType link_type)
     {
         if (REALM_LIKELY(REALM_COVER_ALWAYS(m_table && m_desc))) {
@@ -586,6 +614,18 @@ public:
         return false;
     }
 
+    bool unenumerate_string_columns()
+    {
+        if (REALM_LIKELY(REALM_COVER_ALWAYS(m_table && m_table->is_attached()))) {
+            if (REALM_LIKELY(REALM_COVER_ALWAYS(!m_table->has_shared_type()))) {
+                log("table->unenumerate_string_columns();"); // Throws
+                m_table->unenumerate_string_columns();       // Throws
+                return true;
+            }
+        }
+        return false;
+    }
+
     bool select_link_list(size_t col_ndx, size_t row_ndx, size_t)
     {
         if (REALM_UNLIKELY(REALM_COVER_NEVER(!m_table)))
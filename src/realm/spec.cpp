@@ -366,6 +366,19 @@ void Spec::upgrade_string_to_enum(size_t column_ndx, ref_type keys_ref, ArrayPar
 }
 
 
+void Spec::downgrade_enum_to_string(size_t column_ndx)
+{
+    REALM_ASSERT(get_column_type(column_ndx) == col_type_StringEnum);
+    REALM_ASSERT(m_enumkeys.is_attached());
+
+    // The enumkeys list is kept even when it becomes empty
+    size_t ndx = get_enumkeys_ndx(column_ndx);
+    m_enumkeys.erase(ndx);
+
+    set_column_type(column_ndx, col_type_String);
+}
+
+
 size_t Spec::get_enumkeys_ndx(size_t column_ndx) const noexcept
 {
     // The enumkeys array only keep info for stringEnum columns
@@ -497,7 +510,7 @@ size_t Spec::get_column_ndx_in_parent(size_t column_ndx) const
 
     size_t offset = 0;
     for (size_t i = 0; i < column_ndx; ++i) {
-        if ((m_attr.get(i) & col_attr_Indexed) != 0)
+        if ((m_attr.get(i) & (col_attr_Indexed | col_attr_OrderedIndex)) != 0)
             ++offset;
     }
     return column_ndx + offset;
@@ -509,6 +522,7 @@ Spec::ColumnInfo Spec::get_column_info(size_t column_ndx) const noexcept
     ColumnInfo info;
     info.m_column_ref_ndx = get_column_ndx_in_parent(column_ndx);
     info.m_has_search_index = (get_column_attr(column_ndx) & col_attr_Indexed) != 0;
+    info.m_has_ordered_index = (get_column_attr(column_ndx) & col_attr_OrderedIndex) != 0;
     return info;
 }
 
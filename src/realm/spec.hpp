@@ -83,6 +83,9 @@ public:
 
     // Auto Enumerated string columns
     void upgrade_string_to_enum(size_t column_ndx, ref_type keys_ref, ArrayParent*& keys_parent, size_t& keys_ndx);
+    /// Turn an enumerated strings column back into a plain string column. The
+    /// key list is removed from the spec, but not destroyed.
+    void downgrade_enum_to_string(size_t column_ndx);
     size_t get_enumkeys_ndx(size_t column_ndx) const noexcept;
     ref_type get_enumkeys_ref(size_t column_ndx, ArrayParent** keys_parent = nullptr,
                               size_t* keys_ndx = nullptr) noexcept;
@@ -167,6 +170,14 @@ private:
     struct ColumnInfo {
         size_t m_column_ref_ndx = 0; ///< Index within Table::m_columns
         bool m_has_search_index = false;
+        bool m_has_ordered_index = false;
+
+        /// Whether the column is followed by the ref of its index in
+        /// Table::m_columns.
+        bool has_index() const noexcept
+        {
+            return m_has_search_index || m_has_ordered_index;
+        }
     };
 
     ColumnInfo get_column_info(size_t column_ndx) const noexcept;
@@ -372,9 +383,11 @@ inline void Spec::set_column_type(size_t column_ndx, ColumnType type)
 {
     REALM_ASSERT(column_ndx < get_column_count());
 
-    // At this point we only support upgrading to string enum
-    REALM_ASSERT(ColumnType(m_types.get(column_ndx)) == col_type_String);
-    REALM_ASSERT(type == col_type_StringEnum);
+    // At this point we only support upgrading to string enum, and
+    // downgrading back to string
+    ColumnType old_type = ColumnType(m_types.get(column_ndx));
+    REALM_ASSERT((old_type == col_type_String && type == col_type_StringEnum) ||
+                 (old_type == col_type_StringEnum && type == col_type_String));
 
     m_types.set(column_ndx, type); // Throws
 
@@ -27,7 +27,9 @@
 
 #include <realm/util/features.h>
 #include <realm/util/miscellaneous.hpp>
+#include <realm/util/scope_exit.hpp>
 #include <realm/impl/destroy_guard.hpp>
+#include <realm/impl/hash_aggregator.hpp>
 #include <realm/exceptions.hpp>
 #include <realm/table.hpp>
 #include <realm/descriptor.hpp>
@@ -932,9 +934,9 @@ void Table::do_erase_root_column(size_t ndx)
     Array::destroy_deep(col_ref, m_columns.get_alloc());
     m_columns.erase(ndx_in_parent);
 
-    // If the column had a source index we have to remove and destroy that as
-    // well
-    if (info.m_has_search_index) {
+    // If the column had a search index or an ordered index we have to remove
+    // and destroy that as well
+    if (info.has_index()) {
         ref_type index_ref = m_columns.get_as_ref(ndx_in_parent);
         Array::destroy_deep(index_ref, m_columns.get_alloc());
         m_columns.erase(ndx_in_parent);
@@ -951,15 +953,15 @@ void Table::do_move_root_column(size_t from_ndx, size_t to_ndx)
     size_t from = from_info.m_column_ref_ndx;
     size_t to = to_info.m_column_ref_ndx;
 
-    size_t from_width = from_info.m_has_search_index ? 2 : 1;
+    size_t from_width = from_info.has_index() ? 2 : 1;
     if (to_ndx > from_ndx) {
         to = to - from_width + 1;
     }
     m_columns.move_rotate(from, to, from_width);
 
     // When moving upwards, we need to check if the displaced column
-    // has a search index, and if it does, move it down where it belongs.
-    if (to_ndx > from_ndx && to_info.m_has_search_index) {
+    // has an index, and if it does, move it down where it belongs.
+    if (to_ndx > from_ndx && to_info.has_index()) {
         // Move the search index down where it belongs (next to its owner).
         m_columns.move_rotate(to + from_width, to);
     }
@@ -1706,6 +1708,10 @@ void Table::add_search_index(size_t col_ndx)
     if (has_search_index(col_ndx))
         return;
 
+    // The slot after the column in m_columns can only hold one index
+    if (has_ordered_index(col_ndx))
+        throw LogicError(LogicError::illegal_combination);
+
     ColumnBase& col = get_column_base(col_ndx);
 
     if (!col.supports_search_index())
@@ -1773,6 +1779,122 @@ void Table::remove_search_index(size_t col_ndx)
 }
 
 
+bool Table::has_ordered_index(size_t col_ndx) const noexcept
+{
+    // Utilize the guarantee that m_cols.size() == 0 for a detached table accessor.
+    if (REALM_UNLIKELY(col_ndx >= m_cols.size()))
+        return false;
+    const ColumnBase& col = get_column_base(col_ndx);
+    return col.has_ordered_index();
+}
+
+
+void Table::add_ordered_index(size_t col_ndx)
+{
+    if (REALM_UNLIKELY(!is_attached()))
+        throw LogicError(LogicError::detached_accessor);
+
+    if (REALM_UNLIKELY(has_shared_type()))
+        throw LogicError(LogicError::wrong_kind_of_table);
+
+    if (REALM_UNLIKELY(col_ndx >= m_cols.size()))
+        throw LogicError(LogicError::column_index_out_of_range);
+
+    if (has_ordered_index(col_ndx))
+        return;
+
+    switch (get_real_column_type(col_ndx)) {
+        case col_type_Int:
+        case col_type_Bool:
+        case col_type_OldDateTime:
+        case col_type_Float:
+        case col_type_Double:
+        case col_type_Timestamp:
+            break;
+        default:
+            throw LogicError(LogicError::illegal_combination);
+    }
+
+    // The slot after the column in m_columns can only hold one index
+    if (has_search_index(col_ndx))
+        throw LogicError(LogicError::illegal_combination);
+
+    // Create the index
+    ColumnBase& col = get_column_base(col_ndx);
+    OrderedIndex* index = col.create_ordered_index(); // Throws
+    REALM_ASSERT(index);
+
+    // The index goes in the list of column refs immediate after the owning column
+    size_t index_pos = m_spec.get_column_info(col_ndx).m_column_ref_ndx + 1;
+    index->set_parent(&m_columns, index_pos);
+    m_columns.insert(index_pos, index->get_ref()); // Throws
+
+    // Mark the column as having an index
+    int attr = m_spec.get_column_attr(col_ndx);
+    attr |= col_attr_OrderedIndex;
+    m_spec.set_column_attr(col_ndx, ColumnAttr(attr)); // Throws
+
+    // Update column accessors for all columns after the one we just added an
+    // index for, as their position in `m_columns` has changed
+    refresh_column_accessors(col_ndx + 1); // Throws
+
+    // Older versions of the library would take the index for the next column,
+    // so the file must be switched to the version that introduced it
+    if (Group* group = get_parent_group()) {
+        if (group->get_file_format_version() < 7)
+            group->set_file_format_version(7);
+    }
+
+    if (Replication* repl = get_repl())
+        repl->add_ordered_index(this, col_ndx); // Throws
+}
+
+
+void Table::remove_ordered_index(size_t col_ndx)
+{
+    if (REALM_UNLIKELY(!is_attached()))
+        throw LogicError(LogicError::detached_accessor);
+
+    if (REALM_UNLIKELY(has_shared_type()))
+        throw LogicError(LogicError::wrong_kind_of_table);
+
+    if (REALM_UNLIKELY(col_ndx >= m_cols.size()))
+        throw LogicError(LogicError::column_index_out_of_range);
+
+    if (!has_ordered_index(col_ndx))
+        return;
+
+    // Destroy and remove the index column
+    ColumnBase& col = get_column_base(col_ndx);
+    col.get_ordered_index()->destroy();
+    col.destroy_ordered_index();
+
+    // The index is always immediately after the column in m_columns
+    size_t index_pos = m_spec.get_column_info(col_ndx).m_column_ref_ndx + 1;
+    m_columns.erase(index_pos);
+
+    // Mark the column as no longer having an index
+    int attr = m_spec.get_column_attr(col_ndx);
+    attr &= ~col_attr_OrderedIndex;
+    m_spec.set_column_attr(col_ndx, ColumnAttr(attr)); // Throws
+
+    // Update column accessors for all columns after the one we just removed the
+    // index for, as their position in `m_columns` has changed
+    refresh_column_accessors(col_ndx + 1); // Throws
+
+    if (Replication* repl = get_repl())
+        repl->remove_ordered_index(this, col_ndx); // Throws
+}
+
+
+const OrderedIndex* Table::get_ordered_index(size_t col_ndx) const noexcept
+{
+    if (REALM_UNLIKELY(col_ndx >= m_cols.size()))
+        return nullptr;
+    return get_column_base(col_ndx).get_ordered_index();
+}
+
+
 // FIXME:
 //
 // Note the two versions of get_column_base(). The difference between
@@ -2145,15 +2267,21 @@ void Table::insert_empty_row(size_t row_ndx, size_t num_rows)
         throw LogicError(LogicError::table_has_no_columns);
     }
 
+    uint_fast64_t prior_version = m_version;
     bump_version();
+    m_auto_optimize_writes += num_rows;
 
     for (size_t col_ndx = 0; col_ndx != num_cols; ++col_ndx) {
         ColumnBase& col = get_column_base(col_ndx);
         bool insert_nulls = is_nullable(col_ndx);
         col.insert_rows(row_ndx, num_rows, m_size, insert_nulls); // Throws
     }
-    if (row_ndx < m_size)
+    if (row_ndx < m_size) {
         adj_row_acc_insert_rows(row_ndx, num_rows);
+    }
+    else {
+        update_summaries_on_append(num_rows, {}, prior_version);
+    }
     m_size += num_rows;
 
     if (Replication* repl = get_repl()) {
@@ -2164,6 +2292,203 @@ void Table::insert_empty_row(size_t row_ndx, size_t num_rows)
 }
 
 
+namespace {
+
+// Appends the values returned by `get_value` for [0, num_rows) to the
+// specified column, substituting null where flagged in `nulls`. Values are
+// converted in chunks, so the column is always given an array of its own
+// value type.
+template <class T, class F>
+void add_bulk_values(Column<T>& col, size_t num_rows, const bool* nulls, F get_value)
+{
+    const size_t chunk_size = 256;
+    T buffer[chunk_size];
+    for (size_t i = 0; i < num_rows; i += chunk_size) {
+        size_t n = std::min(chunk_size, num_rows - i);
+        for (size_t j = 0; j != n; ++j) {
+            bool is_null = nulls && nulls[i + j];
+            buffer[j] = is_null ? NullOrDefaultValue<T>::null_or_default_value(true) : T(get_value(i + j));
+        }
+        col.add(buffer, n); // Throws
+    }
+}
+
+template <class T>
+void add_bulk_ints(Column<T>& col, size_t num_rows, const bool* nulls, const void* values)
+{
+    const int64_t* ints = static_cast<const int64_t*>(values);
+    add_bulk_values(col, num_rows, nulls, [=](size_t i) { return ints[i]; }); // Throws
+}
+
+} // anonymous namespace
+
+
+size_t Table::add_rows(size_t num_rows, const std::vector<BulkColumn>& columns)
+{
+    if (REALM_UNLIKELY(!is_attached()))
+        throw LogicError(LogicError::detached_accessor);
+    size_t num_cols = m_spec.get_column_count();
+    if (REALM_UNLIKELY(num_cols == 0))
+        throw LogicError(LogicError::table_has_no_columns);
+
+    // For each column, the index of its entry in `columns`, or npos
+    std::vector<size_t> sources(num_cols, npos); // Throws
+    size_t num_string_values = 0;
+    for (size_t i = 0; i != columns.size(); ++i) {
+        const BulkColumn& column = columns[i];
+        size_t col_ndx = column.column_ndx;
+        if (REALM_UNLIKELY(col_ndx >= num_cols))
+            throw LogicError(LogicError::column_index_out_of_range);
+        if (REALM_UNLIKELY(sources[col_ndx] != npos))
+            throw LogicError(LogicError::illegal_combination);
+        if (REALM_UNLIKELY(get_column_type(col_ndx) != column.type))
+            throw LogicError(LogicError::type_mismatch);
+        bool nullable = is_nullable(col_ndx);
+        if (column.type == type_String) {
+            const StringData* values = static_cast<const StringData*>(column.values);
+            for (size_t j = 0; j != num_rows; ++j) {
+                if (REALM_UNLIKELY(!nullable && values[j].is_null()))
+                    throw LogicError(LogicError::column_not_nullable);
+                if (REALM_UNLIKELY(values[j].size() > max_string_size))
+                    throw LogicError(LogicError::string_too_big);
+            }
+            num_string_values += num_rows;
+        }
+        else if (column.nulls && !nullable) {
+            if (REALM_UNLIKELY(std::find(column.nulls, column.nulls + num_rows, true) != column.nulls + num_rows))
+                throw LogicError(LogicError::column_not_nullable);
+        }
+        sources[col_ndx] = i;
+    }
+
+    uint_fast64_t prior_version = m_version;
+    bump_version();
+    m_auto_optimize_writes += num_string_values;
+
+    size_t row_ndx = m_size;
+    for (size_t col_ndx = 0; col_ndx != num_cols; ++col_ndx) {
+        if (sources[col_ndx] == npos) {
+            ColumnBase& col = get_column_base(col_ndx);
+            col.insert_rows(row_ndx, num_rows, m_size, is_nullable(col_ndx)); // Throws
+        }
+        else {
+            add_bulk_column(columns[sources[col_ndx]], num_rows); // Throws
+        }
+    }
+    m_size += num_rows;
+    update_summaries_on_append(num_rows, columns, prior_version);
+
+    if (Replication* repl = get_repl()) {
+        repl->insert_empty_rows(this, row_ndx, num_rows, row_ndx); // Throws
+        for (const BulkColumn& column : columns)
+            replicate_bulk_column(*repl, column, row_ndx, num_rows); // Throws
+    }
+
+    return row_ndx;
+}
+
+
+void Table::add_bulk_column(const BulkColumn& column, size_t num_rows)
+{
+    size_t col_ndx = column.column_ndx;
+    bool nullable = is_nullable(col_ndx);
+    switch (column.type) {
+        case type_Int:
+            if (nullable) {
+                add_bulk_ints(get_column_int_null(col_ndx), num_rows, column.nulls, column.values); // Throws
+            }
+            else {
+                add_bulk_ints(get_column(col_ndx), num_rows, column.nulls, column.values); // Throws
+            }
+            return;
+        case type_Bool: {
+            const bool* values = static_cast<const bool*>(column.values);
+            auto get_value = [=](size_t i) { return int64_t(values[i]); };
+            if (nullable) {
+                add_bulk_values(get_column_int_null(col_ndx), num_rows, column.nulls, get_value); // Throws
+            }
+            else {
+                add_bulk_values(get_column(col_ndx), num_rows, column.nulls, get_value); // Throws
+            }
+            return;
+        }
+        case type_Float: {
+            const float* values = static_cast<const float*>(column.values);
+            add_bulk_values(get_column_float(col_ndx), num_rows, column.nulls,
+                            [=](size_t i) { return values[i]; }); // Throws
+            return;
+        }
+        case type_Double: {
+            const double* values = static_cast<const double*>(column.values);
+            add_bulk_values(get_column_double(col_ndx), num_rows, column.nulls,
+                            [=](size_t i) { return values[i]; }); // Throws
+            return;
+        }
+        case type_String: {
+            const StringData* values = static_cast<const StringData*>(column.values);
+            if (get_real_column_type(col_ndx) == col_type_StringEnum) {
+                StringEnumColumn& col = get_column_string_enum(col_ndx);
+                for (size_t i = 0; i != num_rows; ++i)
+                    col.add(values[i]); // Throws
+            }
+            else {
+                StringColumn& col = get_column_string(col_ndx);
+                for (size_t i = 0; i != num_rows; ++i)
+                    col.add(values[i]); // Throws
+            }
+            return;
+        }
+        default:
+            break;
+    }
+    REALM_ASSERT(false);
+}
+
+
+void Table::replicate_bulk_column(Replication& repl, const BulkColumn& column, size_t row_ndx,
+                                  size_t num_rows) const
+{
+    // The rows were replicated as empty rows, so only cells whose value
+    // differs from what insert_empty_rows() produces need to be replicated.
+    size_t col_ndx = column.column_ndx;
+    bool nullable = is_nullable(col_ndx);
+    for (size_t i = 0; i != num_rows; ++i) {
+        if (column.nulls && column.nulls[i])
+            continue; // Rows were inserted as null
+        switch (column.type) {
+            case type_Int: {
+                int64_t value = static_cast<const int64_t*>(column.values)[i];
+                if (value != 0 || nullable)
+                    repl.set_int(this, col_ndx, row_ndx + i, value); // Throws
+                break;
+            }
+            case type_Bool: {
+                bool value = static_cast<const bool*>(column.values)[i];
+                if (value || nullable)
+                    repl.set_bool(this, col_ndx, row_ndx + i, value); // Throws
+                break;
+            }
+            case type_Float:
+                repl.set_float(this, col_ndx, row_ndx + i, static_cast<const float*>(column.values)[i]); // Throws
+                break;
+            case type_Double:
+                repl.set_double(this, col_ndx, row_ndx + i,
+                                static_cast<const double*>(column.values)[i]); // Throws
+                break;
+            case type_String: {
+                StringData value = static_cast<const StringData*>(column.values)[i];
+                bool is_default = (nullable ? value.is_null() : value.size() == 0);
+                if (!is_default)
+                    repl.set_string(this, col_ndx, row_ndx + i, value); // Throws
+                break;
+            }
+            default:
+                REALM_ASSERT(false);
+        }
+    }
+}
+
+
 void Table::erase_row(size_t row_ndx, bool is_move_last_over)
 {
     REALM_ASSERT(is_attached());
@@ -2921,6 +3246,7 @@ void Table::set_int(size_t col_ndx, size_t ndx, int_fast64_t value, bool is_defa
 {
     REALM_ASSERT_3(col_ndx, <, get_column_count());
     REALM_ASSERT_3(ndx, <, m_size);
+    uint_fast64_t prior_version = m_version;
     bump_version();
 
     if (is_nullable(col_ndx)) {
@@ -2931,6 +3257,7 @@ void Table::set_int(size_t col_ndx, size_t ndx, int_fast64_t value, bool is_defa
         auto& col = get_column(col_ndx);
         col.set(ndx, value);
     }
+    update_summaries_on_set(col_ndx, ndx, int64_t(value), prior_version);
 
     if (Replication* repl = get_repl())
         repl->set_int(this, col_ndx, ndx, value, is_default ? _impl::instr_SetDefault : _impl::instr_Set); // Throws
@@ -2940,6 +3267,7 @@ void Table::add_int(size_t col_ndx, size_t ndx, int_fast64_t value)
 {
     REALM_ASSERT_3(col_ndx, <, get_column_count());
     REALM_ASSERT_3(ndx, <, m_size);
+    uint_fast64_t prior_version = m_version;
     bump_version();
 
     auto add_wrap = [](int64_t a, int64_t b) -> int64_t {
@@ -2948,11 +3276,13 @@ void Table::add_int(size_t col_ndx, size_t ndx, int_fast64_t value)
         return int64_t(ua + ub);
     };
 
+    int64_t new_value;
     if (is_nullable(col_ndx)) {
         auto& col = get_column_int_null(col_ndx);
         Optional<int64_t> old = col.get(ndx);
         if (old) {
-            col.set(ndx, add_wrap(*old, value));
+            new_value = add_wrap(*old, value);
+            col.set(ndx, new_value);
         }
         else {
             throw LogicError{LogicError::illegal_combination};
@@ -2961,8 +3291,10 @@ void Table::add_int(size_t col_ndx, size_t ndx, int_fast64_t value)
     else {
         auto& col = get_column(col_ndx);
         int64_t old = col.get(ndx);
-        col.set(ndx, add_wrap(old, value));
+        new_value = add_wrap(old, value);
+        col.set(ndx, new_value);
     }
+    update_summaries_on_set(col_ndx, ndx, new_value, prior_version);
 
     if (Replication* repl = get_repl())
         repl->add_int(this, col_ndx, ndx, value); // Throws
@@ -2979,6 +3311,7 @@ void Table::set_timestamp(size_t col_ndx, size_t ndx, Timestamp value, bool is_d
     REALM_ASSERT_3(col_ndx, <, get_column_count());
     REALM_ASSERT_3(get_real_column_type(col_ndx), ==, col_type_Timestamp);
     REALM_ASSERT_3(ndx, <, m_size);
+    uint_fast64_t prior_version = m_version;
     bump_version();
 
     if (!is_nullable(col_ndx) && value.is_null())
@@ -2986,6 +3319,10 @@ void Table::set_timestamp(size_t col_ndx, size_t ndx, Timestamp value, bool is_d
 
     TimestampColumn& col = get_column<TimestampColumn, col_type_Timestamp>(col_ndx);
     col.set(ndx, value);
+    util::Optional<int64_t> seconds;
+    if (!value.is_null())
+        seconds = value.get_seconds();
+    update_summaries_on_set(col_ndx, ndx, seconds, prior_version);
 
     if (Replication* repl = get_repl()) {
         if (value.is_null())
@@ -3008,6 +3345,7 @@ void Table::set_bool(size_t col_ndx, size_t ndx, bool value, bool is_default)
     REALM_ASSERT_3(col_ndx, <, get_column_count());
     REALM_ASSERT_3(get_real_column_type(col_ndx), ==, col_type_Bool);
     REALM_ASSERT_3(ndx, <, m_size);
+    uint_fast64_t prior_version = m_version;
     bump_version();
 
     if (is_nullable(col_ndx)) {
@@ -3018,6 +3356,7 @@ void Table::set_bool(size_t col_ndx, size_t ndx, bool value, bool is_default)
         IntegerColumn& col = get_column(col_ndx);
         col.set(ndx, value ? 1 : 0);
     }
+    update_summaries_on_set(col_ndx, ndx, int64_t(value ? 1 : 0), prior_version);
 
     if (Replication* repl = get_repl())
         repl->set_bool(this, col_ndx, ndx, value, is_default ? _impl::instr_SetDefault : _impl::instr_Set); // Throws
@@ -3035,6 +3374,7 @@ void Table::set_olddatetime(size_t col_ndx, size_t ndx, OldDateTime value, bool
     REALM_ASSERT_3(col_ndx, <, get_column_count());
     REALM_ASSERT_3(get_real_column_type(col_ndx), ==, col_type_OldDateTime);
     REALM_ASSERT_3(ndx, <, m_size);
+    uint_fast64_t prior_version = m_version;
     bump_version();
 
     if (is_nullable(col_ndx)) {
@@ -3045,6 +3385,7 @@ void Table::set_olddatetime(size_t col_ndx, size_t ndx, OldDateTime value, bool
         IntegerColumn& col = get_column(col_ndx);
         col.set(ndx, value.get_olddatetime());
     }
+    update_summaries_on_set(col_ndx, ndx, value.get_olddatetime(), prior_version);
 
     if (Replication* repl = get_repl())
         repl->set_olddatetime(this, col_ndx, ndx, value,
@@ -3117,6 +3458,7 @@ void Table::set_string(size_t col_ndx, size_t ndx, StringData value, bool is_def
         throw LogicError(LogicError::string_too_big);
 
     bump_version();
+    ++m_auto_optimize_writes;
     ColumnBase& col = get_column_base(col_ndx);
     col.set_string(ndx, value); // Throws
 
@@ -3150,6 +3492,7 @@ size_t Table::set_string_unique(size_t col_ndx, size_t ndx, StringData value)
     check_lists_are_empty(ndx); // Throws
 
     bump_version();
+    ++m_auto_optimize_writes;
 
     ColumnType actual_type = get_real_column_type(col_ndx);
     REALM_ASSERT(actual_type == ColumnType::col_type_String || actual_type == ColumnType::col_type_StringEnum);
@@ -3197,6 +3540,7 @@ void Table::insert_substring(size_t col_ndx, size_t row_ndx, size_t pos, StringD
     copy_of_value.insert(pos, value.data(), value.size()); // Throws
 
     bump_version();
+    ++m_auto_optimize_writes;
     ColumnBase& col = get_column_base(col_ndx);
     col.set_string(row_ndx, copy_of_value); // Throws
 
@@ -3227,6 +3571,7 @@ void Table::remove_substring(size_t col_ndx, size_t row_ndx, size_t pos, size_t
     copy_of_value.erase(pos, substring_size); // Throws
 
     bump_version();
+    ++m_auto_optimize_writes;
     ColumnBase& col = get_column_base(col_ndx);
     col.set_string(row_ndx, copy_of_value); // Throws
 
@@ -3534,9 +3879,11 @@ void Table::set_null(size_t col_ndx, size_t row_ndx, bool is_default)
     REALM_ASSERT_3(col_ndx, <, get_column_count());
     REALM_ASSERT_3(row_ndx, <, m_size);
 
+    uint_fast64_t prior_version = m_version;
     bump_version();
     ColumnBase& col = get_column_base(col_ndx);
     col.set_null(row_ndx);
+    update_summaries_on_set(col_ndx, row_ndx, util::none, prior_version);
 
     if (Replication* repl = get_repl())
         repl->set_null(this, col_ndx, row_ndx, is_default ? _impl::instr_SetDefault : _impl::instr_Set); // Throws
@@ -4399,6 +4746,184 @@ void Table::aggregate(size_t group_by_column, size_t aggr_column, AggrType op, T
 }
 
 
+void Table::group_by(const std::vector<size_t>& group_by_columns, const std::vector<GroupAggregate>& aggregates,
+                     Table& result, const IntegerColumn* viewrefs) const
+{
+    if (REALM_UNLIKELY(!is_attached()))
+        throw LogicError(LogicError::detached_accessor);
+    REALM_ASSERT(result.is_empty() && result.get_column_count() == 0);
+
+    // A degenerate subtable has no rows, so the result only gets its columns
+    _impl::HashAggregator aggregator(*this, group_by_columns, aggregates); // Throws
+    if (viewrefs) {
+        size_t count = viewrefs->size();
+        for (size_t i = 0; i < count; ++i) {
+            int64_t row_ndx = viewrefs->get(i);
+            if (row_ndx != detached_ref)
+                aggregator.add_row(size_t(row_ndx)); // Throws
+        }
+    }
+    else {
+        size_t count = size();
+        for (size_t i = 0; i < count; ++i)
+            aggregator.add_row(i); // Throws
+    }
+    aggregator.get_result(result); // Throws
+}
+
+
+Table::ColumnSummaries& Table::get_column_summaries(size_t col_ndx) const
+{
+    REALM_ASSERT_3(col_ndx, <, get_column_count());
+
+    if (m_column_summaries_version != m_version || m_column_summaries.size() != get_column_count()) {
+        m_column_summaries.clear();
+        m_column_summaries.resize(get_column_count()); // Throws
+        m_column_summaries_version = m_version;
+    }
+    return m_column_summaries[col_ndx];
+}
+
+
+_impl::ZoneMap& Table::ColumnSummaries::get_writable_zone_map()
+{
+    if (zone_map.use_count() > 1)
+        zone_map = std::make_shared<_impl::ZoneMap>(*zone_map); // Throws
+    return *zone_map;
+}
+
+
+void Table::update_summaries_on_set(size_t col_ndx, size_t row_ndx, util::Optional<int64_t> value,
+                                    uint_fast64_t prior_version) noexcept
+{
+    if (m_column_summaries_version != prior_version || m_column_summaries.size() != get_column_count())
+        return;
+
+    // The statistics are estimated from a sample, and cannot be updated
+    ColumnSummaries& summaries = m_column_summaries[col_ndx];
+    summaries.statistics.reset();
+    if (summaries.zone_map && value) {
+        try {
+            summaries.get_writable_zone_map().widen(row_ndx, *value); // Throws
+        }
+        catch (...) {
+            return; // Computed again on demand
+        }
+    }
+    m_column_summaries_version = m_version;
+}
+
+
+void Table::update_summaries_on_append(size_t num_rows, const std::vector<BulkColumn>& columns,
+                                       uint_fast64_t prior_version) noexcept
+{
+    if (m_column_summaries_version != prior_version || m_column_summaries.size() != get_column_count())
+        return;
+
+    try {
+        size_t num_cols = m_column_summaries.size();
+        for (size_t col_ndx = 0; col_ndx != num_cols; ++col_ndx) {
+            ColumnSummaries& summaries = m_column_summaries[col_ndx];
+            summaries.statistics.reset();
+            if (!summaries.zone_map)
+                continue;
+
+            const BulkColumn* column = nullptr;
+            for (const BulkColumn& c : columns) {
+                if (c.column_ndx == col_ndx)
+                    column = &c;
+            }
+            using Value = util::Optional<int64_t>;
+            _impl::ZoneMap& zone_map = summaries.get_writable_zone_map(); // Throws
+            if (!column) {
+                // See ColumnBase::insert_rows()
+                Value default_value = is_nullable(col_ndx) ? Value() : Value(int64_t(0));
+                zone_map.append(num_rows, [&](size_t) { return default_value; }); // Throws
+            }
+            else if (column->type == type_Int) {
+                const int64_t* values = static_cast<const int64_t*>(column->values);
+                zone_map.append(num_rows, [&](size_t i) {
+                    return column->nulls && column->nulls[i] ? Value() : Value(values[i]);
+                }); // Throws
+            }
+            else {
+                REALM_ASSERT_3(column->type, ==, type_Bool);
+                const bool* values = static_cast<const bool*>(column->values);
+                zone_map.append(num_rows, [&](size_t i) {
+                    return column->nulls && column->nulls[i] ? Value() : Value(int64_t(values[i]));
+                }); // Throws
+            }
+        }
+    }
+    catch (...) {
+        return; // Computed again on demand
+    }
+    m_column_summaries_version = m_version;
+}
+
+
+std::vector<Table::ColumnSummaries> Table::take_column_summaries() noexcept
+{
+    if (m_column_summaries_version != m_version || m_column_summaries.size() != get_column_count())
+        return {};
+    return std::move(m_column_summaries);
+}
+
+
+void Table::restore_column_summaries(std::vector<ColumnSummaries> summaries) noexcept
+{
+    if (summaries.size() != get_column_count())
+        return;
+    m_column_summaries = std::move(summaries);
+    m_column_summaries_version = m_version;
+}
+
+
+const _impl::ColumnStatistics& Table::get_column_statistics(size_t col_ndx) const
+{
+    std::unique_ptr<_impl::ColumnStatistics>& stats = get_column_summaries(col_ndx).statistics; // Throws
+    if (!stats)
+        stats.reset(new _impl::ColumnStatistics(_impl::ColumnStatistics::compute(*this, col_ndx))); // Throws
+    return *stats;
+}
+
+
+std::shared_ptr<const _impl::ZoneMap> Table::get_zone_map(size_t col_ndx) const
+{
+    ColumnSummaries& summaries = get_column_summaries(col_ndx); // Throws
+    if (summaries.zone_map || !summaries.zone_map_requested) {
+        summaries.zone_map_requested = true;
+        return summaries.zone_map;
+    }
+
+    std::shared_ptr<_impl::ZoneMap> zone_map;
+    switch (get_real_column_type(col_ndx)) {
+        case col_type_Int:
+        case col_type_Bool:
+        case col_type_OldDateTime: {
+            // Booleans and dates are stored in integer columns
+            const ColumnBase& column = get_column_base(col_ndx);
+            if (is_nullable(col_ndx)) {
+                const IntNullColumn& int_column = static_cast<const IntNullColumn&>(column);
+                zone_map = std::make_shared<_impl::ZoneMap>(_impl::ZoneMap::compute(int_column)); // Throws
+            }
+            else {
+                const IntegerColumn& int_column = static_cast<const IntegerColumn&>(column);
+                zone_map = std::make_shared<_impl::ZoneMap>(_impl::ZoneMap::compute(int_column)); // Throws
+            }
+            break;
+        }
+        case col_type_Timestamp:
+            zone_map = std::make_shared<_impl::ZoneMap>(_impl::ZoneMap::compute(get_column_timestamp(col_ndx))); // Throws
+            break;
+        default:
+            REALM_ASSERT(false);
+    }
+    summaries.zone_map = std::move(zone_map);
+    return summaries.zone_map;
+}
+
+
 TableView Table::get_range_view(size_t begin, size_t end)
 {
     REALM_ASSERT(!m_columns.is_attached() || end <= size());
@@ -4517,58 +5042,212 @@ void Table::optimize(bool enforce)
     if (has_shared_type())
         return;
 
-    Allocator& alloc = m_columns.get_alloc();
+    size_t column_count = get_column_count();
+    for (size_t i = 0; i < column_count; ++i) {
+        if (get_real_column_type(i) == col_type_String)
+            enumerate_string_column(i, enforce); // Throws
+    }
 
+    if (Replication* repl = get_repl())
+        repl->optimize_table(this); // Throws
+}
+
+
+void Table::unenumerate_string_columns()
+{
+    if (has_shared_type())
+        return;
+
+    bool changed = false;
     size_t column_count = get_column_count();
     for (size_t i = 0; i < column_count; ++i) {
-        ColumnType type_i = get_real_column_type(i);
-        if (type_i == col_type_String) {
-            StringColumn* column_i = &get_column_string(i);
+        if (get_real_column_type(i) == col_type_StringEnum) {
+            if (unenumerate_string_column(i)) // Throws
+                changed = true;
+        }
+    }
 
-            ref_type ref, keys_ref;
-            bool res = column_i->auto_enumerate(keys_ref, ref, enforce);
-            if (!res)
-                continue;
+    // Which columns are turned back depends only on their values, so a replay
+    // of the instruction changes the same columns.
+    if (changed) {
+        if (Replication* repl = get_repl())
+            repl->unenumerate_string_columns(this); // Throws
+    }
+}
 
-            Spec::ColumnInfo info = m_spec.get_column_info(i);
-            ArrayParent* keys_parent;
-            size_t keys_ndx_in_parent;
-            m_spec.upgrade_string_to_enum(i, keys_ref, keys_parent, keys_ndx_in_parent);
-
-            // Upgrading the column may have moved the
-            // refs to keylists in other columns so we
-            // have to update their parent info
-            for (size_t c = i + 1; c < m_cols.size(); ++c) {
-                ColumnType type_c = get_real_column_type(c);
-                if (type_c == col_type_StringEnum) {
-                    StringEnumColumn& column_c = get_column_string_enum(c);
-                    column_c.adjust_keys_ndx_in_parent(1);
-                }
-            }
 
-            // Indexes are also in m_columns, so we need adjusted pos
-            size_t ndx_in_parent = m_spec.get_column_ndx_in_parent(i);
+bool Table::encode_integer_columns()
+{
+    if (REALM_UNLIKELY(!is_attached()))
+        throw LogicError(LogicError::detached_accessor);
 
-            // Replace column
-            StringEnumColumn* e = new StringEnumColumn(alloc, ref, keys_ref, is_nullable(i), i); // Throws
-            e->set_parent(&m_columns, ndx_in_parent);
-            e->get_keys().set_parent(keys_parent, keys_ndx_in_parent);
-            m_cols[i] = e;
-            m_columns.set(ndx_in_parent, ref); // Throws
+    // Encoded leaves can only be stored in a file of file format version 7
+    // (see Array::try_encode()), which is switched to here, and is kept only
+    // if a leaf is actually encoded. If nothing is encoded, or if an exception
+    // is thrown, the old version is restored.
+    Group* group = get_parent_group();
+    if (!group)
+        return false;
+    int file_format_version = group->get_file_format_version();
+    if (file_format_version < 7)
+        group->set_file_format_version(7);
+
+    bool encoded = false;
+    auto restore_version = util::make_scope_exit([&]() noexcept {
+        if (!encoded)
+            group->set_file_format_version(file_format_version);
+    });
+    size_t column_count = get_column_count();
+    for (size_t i = 0; i < column_count; ++i) {
+        if (get_real_column_type(i) == col_type_Int && !is_nullable(i)) {
+            if (get_column(i).encode_leaves()) // Throws
+                encoded = true;
+        }
+    }
+
+    return encoded;
+}
 
-            // Inherit any existing index
-            if (info.m_has_search_index) {
-                e->install_search_index(column_i->release_search_index());
-            }
 
-            // Clean up the old column
-            column_i->destroy();
-            delete column_i;
+bool Table::enumerate_string_column(size_t col_ndx, bool enforce)
+{
+    Allocator& alloc = m_columns.get_alloc();
+    StringColumn* column = &get_column_string(col_ndx);
+
+    ref_type ref, keys_ref;
+    bool res = column->auto_enumerate(keys_ref, ref, enforce);
+    if (!res)
+        return false;
+
+    Spec::ColumnInfo info = m_spec.get_column_info(col_ndx);
+    ArrayParent* keys_parent;
+    size_t keys_ndx_in_parent;
+    m_spec.upgrade_string_to_enum(col_ndx, keys_ref, keys_parent, keys_ndx_in_parent);
+
+    // Upgrading the column may have moved the
+    // refs to keylists in other columns so we
+    // have to update their parent info
+    for (size_t c = col_ndx + 1; c < m_cols.size(); ++c) {
+        ColumnType type_c = get_real_column_type(c);
+        if (type_c == col_type_StringEnum) {
+            StringEnumColumn& column_c = get_column_string_enum(c);
+            column_c.adjust_keys_ndx_in_parent(1);
         }
     }
 
-    if (Replication* repl = get_repl())
-        repl->optimize_table(this); // Throws
+    // Indexes are also in m_columns, so we need adjusted pos
+    size_t ndx_in_parent = m_spec.get_column_ndx_in_parent(col_ndx);
+
+    // Replace column
+    StringEnumColumn* e = new StringEnumColumn(alloc, ref, keys_ref, is_nullable(col_ndx), col_ndx); // Throws
+    e->set_parent(&m_columns, ndx_in_parent);
+    e->get_keys().set_parent(keys_parent, keys_ndx_in_parent);
+    m_cols[col_ndx] = e;
+    m_columns.set(ndx_in_parent, ref); // Throws
+
+    // Inherit any existing index
+    if (info.m_has_search_index) {
+        e->install_search_index(column->release_search_index());
+    }
+
+    // Clean up the old column
+    column->destroy();
+    delete column;
+    return true;
+}
+
+
+bool Table::unenumerate_string_column(size_t col_ndx)
+{
+    StringEnumColumn* column = &get_column_string_enum(col_ndx);
+
+    // The number of keys is an upper bound on the number of distinct values,
+    // since keys are never removed
+    size_t num_rows = size();
+    size_t num_keys = column->get_keys().size();
+    if (num_keys <= num_rows / 2)
+        return false;
+
+    // Count the keys that are still in use
+    std::vector<bool> used(num_keys); // Throws
+    size_t num_used = 0;
+    const IntegerColumn& key_ndxs = *column;
+    for (size_t i = 0; i < num_rows && num_used <= num_rows / 2; ++i) {
+        size_t key_ndx = to_size_t(key_ndxs.get(i));
+        if (!used[key_ndx]) {
+            used[key_ndx] = true;
+            ++num_used;
+        }
+    }
+    if (num_used <= num_rows / 2)
+        return false;
+
+    Allocator& alloc = m_columns.get_alloc();
+    ref_type ref = column->clone_deep(alloc).get_ref(); // Throws
+    bool has_search_index = m_spec.get_column_info(col_ndx).m_has_search_index;
+
+    m_spec.downgrade_enum_to_string(col_ndx);
+
+    // The key lists of the following enumerated columns move one
+    // position back
+    for (size_t c = col_ndx + 1; c < m_cols.size(); ++c) {
+        ColumnType type_c = get_real_column_type(c);
+        if (type_c == col_type_StringEnum) {
+            StringEnumColumn& column_c = get_column_string_enum(c);
+            column_c.adjust_keys_ndx_in_parent(-1);
+        }
+    }
+
+    // Replace column
+    size_t ndx_in_parent = m_spec.get_column_ndx_in_parent(col_ndx);
+    StringColumn* s = new StringColumn(alloc, ref, is_nullable(col_ndx), col_ndx); // Throws
+    s->set_parent(&m_columns, ndx_in_parent);
+    m_cols[col_ndx] = s;
+    m_columns.set(ndx_in_parent, ref); // Throws
+
+    // Inherit any existing index
+    if (has_search_index)
+        s->install_search_index(column->release_search_index());
+
+    // Clean up the old column, including its key list
+    column->destroy();
+    delete column;
+    return true;
+}
+
+
+void Table::auto_optimize(size_t& num_writes)
+{
+    num_writes += m_auto_optimize_writes;
+    m_auto_optimize_writes = 0;
+    size_t num_rows = size();
+    if (num_rows < auto_optimize_min_rows || num_writes < num_rows / 4)
+        return;
+    num_writes = 0;
+    if (has_shared_type())
+        return;
+
+    // Use sampled statistics to avoid enumerating every string column just
+    // to find out that it should not be enumerated
+    bool enumerate = false;
+    bool unenumerate = false;
+    size_t column_count = get_column_count();
+    for (size_t i = 0; i < column_count && !(enumerate && unenumerate); ++i) {
+        ColumnType type_i = get_real_column_type(i);
+        if (type_i == col_type_String && !enumerate) {
+            auto stats = _impl::ColumnStatistics::compute(*this, i); // Throws
+            double num_distinct = stats.distinct_estimate() + (stats.null_fraction() > 0 ? 1 : 0);
+            enumerate = num_distinct <= num_rows / 2;
+        }
+        else if (type_i == col_type_StringEnum && !unenumerate) {
+            unenumerate = get_column_string_enum(i).get_keys().size() > num_rows / 2;
+        }
+    }
+
+    if (enumerate)
+        optimize(); // Throws
+    if (unenumerate)
+        unenumerate_string_columns(); // Throws
 }
 
 
@@ -4611,7 +5290,7 @@ public:
             for (size_t i = 0; i != n; ++i) {
                 int attr = spec.get_column_attr(i);
                 // Remove any index specifying attributes
-                attr &= ~(col_attr_Indexed | col_attr_Unique);
+                attr &= ~(col_attr_Indexed | col_attr_Unique | col_attr_OrderedIndex);
                 spec.set_column_attr(i, ColumnAttr(attr)); // Throws
             }
             bool deep = true;                                         // Deep
@@ -5826,9 +6505,12 @@ void Table::refresh_column_accessors(size_t col_ndx_begin)
         // equipped with a search index, create the accessor now.
         ColumnAttr attr = m_spec.get_column_attr(col_ndx);
         bool column_has_search_index = (attr & col_attr_Indexed) != 0;
+        bool column_has_ordered_index = (attr & col_attr_OrderedIndex) != 0;
 
         if (!column_has_search_index && col)
             col->destroy_search_index();
+        if (!column_has_ordered_index && col)
+            col->destroy_ordered_index();
 
         // If the current column accessor is StringColumn, but the underlying
         // column has been upgraded to an enumerated strings column, then we
@@ -5845,6 +6527,17 @@ void Table::refresh_column_accessors(size_t col_ndx_begin)
             }
         }
 
+        // Likewise if an enumerated strings column has been turned back into
+        // a plain string column.
+        if (dynamic_cast<StringEnumColumn*>(col) != nullptr) {
+            ColumnType col_type = m_spec.get_column_type(col_ndx);
+            if (col_type == col_type_String) {
+                delete col;
+                col = 0;
+                m_cols[col_ndx] = nullptr;
+            }
+        }
+
         if (col) {
             // Refresh the column accessor
             col->set_ndx_in_parent(ndx_in_parent);
@@ -5897,8 +6590,12 @@ void Table::refresh_column_accessors(size_t col_ndx_begin)
                 col->set_search_index_ref(ref, &m_columns, ndx_in_parent + 1, allow_duplicate_values); // Throws
             }
         }
+        else if (column_has_ordered_index && !col->has_ordered_index()) {
+            ref_type ref = m_columns.get_as_ref(ndx_in_parent + 1);
+            col->set_ordered_index_ref(ref, &m_columns, ndx_in_parent + 1); // Throws
+        }
 
-        ndx_in_parent += (column_has_search_index ? 2 : 1);
+        ndx_in_parent += (column_has_search_index || column_has_ordered_index ? 2 : 1);
     }
 
     // Set table size
@@ -6020,6 +6717,8 @@ void Table::verify() const
             REALM_ASSERT_3(ndx_in_parent, ==, col.get_ndx_in_parent());
             col.verify(*this, i);
             REALM_ASSERT_3(col.size(), ==, m_size);
+            if (const OrderedIndex* index = col.get_ordered_index())
+                index->verify(m_size);
         }
     }
 #endif
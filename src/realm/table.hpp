@@ -35,17 +35,22 @@
 #include <realm/mixed.hpp>
 #include <realm/query.hpp>
 #include <realm/column.hpp>
+#include <realm/impl/column_statistics.hpp>
+#include <realm/impl/zone_map.hpp>
 
 namespace realm {
 
 class BacklinkColumn;
 class BinaryColumy;
+struct BulkColumn;
 class ConstTableView;
 class Group;
 class LinkColumn;
 class LinkColumnBase;
 class LinkListColumn;
 class LinkView;
+struct GroupAggregate;
+class OrderedIndex;
 class SortDescriptor;
 class StringIndex;
 class TableView;
@@ -228,7 +233,8 @@ public:
     ///
     /// add_search_index() adds a search index to the specified column of this
     /// table. It has no effect if a search index has already been added to the
-    /// specified column (idempotency).
+    /// specified column (idempotency). A column cannot have both a search index
+    /// and an ordered index.
     ///
     /// remove_search_index() removes the search index from the specified column
     /// of this table. It has no effect if the specified column has no search
@@ -248,6 +254,36 @@ public:
 
     //@}
 
+    //@{
+
+    /// add_ordered_index() adds an ordered index to the specified column of
+    /// this table, which must be an integer, boolean, date, float, double or
+    /// timestamp column without a search index. The index keeps the rows in
+    /// the order of their values. Queries use it for `==`, `<`, `<=`, `>`,
+    /// `>=` and between conditions that match few rows, and sorting a view by
+    /// the column uses it to rank the values. It has no effect if the column
+    /// already has an ordered index.
+    ///
+    /// Like a search index, an ordered index is stored in the Realm file, and
+    /// its addition and removal are replicated. Since older versions of the
+    /// library cannot read it, adding an ordered index to a group-level table
+    /// switches the file to file format version 7.
+    ///
+    /// has_ordered_index() and get_ordered_index() return false and null
+    /// respectively if the table accessor is detached, if the specified index
+    /// is out of range, or if the column has no ordered index.
+    ///
+    /// This table must be a root table (see add_search_index()).
+    ///
+    /// \param column_ndx The index of a column of this table.
+
+    bool has_ordered_index(size_t column_ndx) const noexcept;
+    void add_ordered_index(size_t column_ndx);
+    void remove_ordered_index(size_t column_ndx);
+    const OrderedIndex* get_ordered_index(size_t column_ndx) const noexcept;
+
+    //@}
+
     //@{
     /// Get the dynamic type descriptor for this table.
     ///
@@ -388,6 +424,19 @@ public:
     void swap_rows(size_t row_ndx_1, size_t row_ndx_2);
     //@}
 
+    /// Append \a num_rows rows, taking the values of the specified columns
+    /// from column-major arrays (see BulkColumn). Columns that are not
+    /// specified get the same values as they would have gotten from
+    /// add_empty_row(). Returns the index of the first new row.
+    ///
+    /// The effect is the same as that of add_empty_row() followed by a call
+    /// to set_int(), set_string(), etc. for every specified cell, but values
+    /// are appended directly to the columns, arguments are validated once per
+    /// column, and nothing is replicated for cells that are left with their
+    /// default value. All arguments are validated before the table is
+    /// modified.
+    size_t add_rows(size_t num_rows, const std::vector<BulkColumn>& columns);
+
     /// Replaces all links to \a row_ndx with links to \a new_row_ndx.
     ///
     /// This operation is usually followed by Table::move_last_over()
@@ -661,6 +710,36 @@ public:
     void aggregate(size_t group_by_column, size_t aggr_column, AggrType op, Table& result,
                    const IntegerColumn* viewrefs = nullptr) const;
 
+    /// Divide the rows into groups of rows with equal values in the specified
+    /// columns, and compute the specified aggregates for each group. All
+    /// aggregates are computed in a single pass over the rows.
+    ///
+    /// The grouping columns must be of type int, bool, string, timestamp or
+    /// olddatetime, and the aggregated columns of type int, float or double.
+    /// Nulls form a group of their own.
+    ///
+    /// The result table must be empty and have no columns. It gets a column
+    /// for each grouping column, with the same name and type, followed by a
+    /// column for each aggregate:
+    ///
+    ///  - `COUNT()` (int), the number of rows in the group.
+    ///  - `SUM(name)` (int for int columns, else double), the sum of the
+    ///    non-null values.
+    ///  - `AVG(name)` (double), the mean of the non-null values.
+    ///  - `MIN(name)` and `MAX(name)`, of the same type as the column.
+    ///
+    /// Averages, minimums and maximums are null when all values of a group
+    /// are null. The result has one row per group, in the order in which the
+    /// groups are first seen.
+    ///
+    /// If \a viewrefs is specified, only the rows that it refers to are
+    /// grouped.
+    ///
+    /// Throws LogicError if this accessor is detached, if a column index is
+    /// out of range, or if the type of a column is not supported.
+    void group_by(const std::vector<size_t>& group_by_columns, const std::vector<GroupAggregate>& aggregates,
+                  Table& result, const IntegerColumn* viewrefs = nullptr) const;
+
     /// Report the current versioning counter for the table. The versioning counter is guaranteed to
     /// change when the contents of the table changes after advance_read() or promote_to_write(), or
     /// immediately after calls to methods which change the table. The term "change" means "change of
@@ -672,6 +751,28 @@ public:
     /// without any apparent reason.
     uint_fast64_t get_version_counter() const noexcept;
 
+    /// Get statistics about the values in the specified column, estimated
+    /// from a sample of its rows. They are computed on first use, and cached
+    /// until the version counter of the table changes. This is used by the
+    /// query engine to decide which condition to evaluate first.
+    ///
+    /// When the accessors of a SharedGroup are detached at the end of a
+    /// transaction, the cached statistics and zone maps of each table are
+    /// kept by the group accessor, and handed to the next accessor for the
+    /// same table in the same version of the database. A transaction that
+    /// reads a version that has not been read through the same SharedGroup
+    /// before computes them again for every table it searches.
+    const _impl::ColumnStatistics& get_column_statistics(size_t column_ndx) const;
+
+    /// Get the zone map of the specified integer, boolean, date or timestamp
+    /// column. It is only computed when requested for the second time for
+    /// the same version of the table, so that tables that change between
+    /// every search do not pay for it. Returns null if it has not been
+    /// computed. Setting values and appending rows updates the zone map
+    /// (widening the bounds of the affected zones); any other modification
+    /// of the table discards it.
+    std::shared_ptr<const _impl::ZoneMap> get_zone_map(size_t column_ndx) const;
+
 private:
     template <class T>
     size_t find_first(size_t column_ndx, T value) const; // called by above methods
@@ -747,6 +848,32 @@ public:
     // enforce == false will auto-evaluate if they should be enumerated or not
     void optimize(bool enforce = false);
 
+    /// Turn every enumerated string column of which more than half of the
+    /// values are distinct back into a plain string column. Any search index is
+    /// carried over. Like optimize(), this does nothing for a subtable with
+    /// shared spec.
+    void unenumerate_string_columns();
+
+    /// Encode the leaves of the non-nullable integer columns of this table
+    /// where that makes them smaller (see Array::try_encode()). Values are
+    /// stored as narrow offsets from a base value, or from a line through the
+    /// first and the last value of the leaf, and a leaf is decoded again the
+    /// first time it is modified.
+    ///
+    /// Encoded leaves require file format version 7, so the first call that
+    /// encodes a leaf switches the file to that version, and older versions
+    /// of the library can no longer open it. Nothing is encoded unless this is
+    /// a group-level table.
+    ///
+    /// Encoding is never applied implicitly: since it makes the file
+    /// unreadable to older versions of the library, the application has to
+    /// ask for it by calling this function, typically on tables that are
+    /// mostly read, after they have been populated.
+    ///
+    /// Only the way the values are stored changes, so this operation is not
+    /// replicated. Returns true if any leaf was encoded.
+    bool encode_integer_columns();
+
     /// Write this table (or a slice of this table) to the specified
     /// output stream.
     ///
@@ -947,6 +1074,62 @@ private:
 
     mutable uint_fast64_t m_version;
 
+    // Summaries of the values in a column, for the table version in
+    // m_column_summaries_version. They are computed on demand.
+    struct ColumnSummaries {
+        std::unique_ptr<_impl::ColumnStatistics> statistics;
+        std::shared_ptr<_impl::ZoneMap> zone_map;
+        bool zone_map_requested = false;
+
+        // Zone maps are shared with the query nodes that use them, so they
+        // are copied before they are modified.
+        _impl::ZoneMap& get_writable_zone_map();
+    };
+    mutable std::vector<ColumnSummaries> m_column_summaries;
+    mutable uint_fast64_t m_column_summaries_version = 0;
+
+    ColumnSummaries& get_column_summaries(size_t column_ndx) const;
+
+    // Used by Group to keep the summaries across detachment of the accessor.
+    // take_column_summaries() returns an empty vector if they are not valid
+    // for the current version of the table.
+    std::vector<ColumnSummaries> take_column_summaries() noexcept;
+    void restore_column_summaries(std::vector<ColumnSummaries>) noexcept;
+
+    // Keep the summaries valid across a modification that changed the
+    // version of the table from `prior_version`, if they were valid before
+    // it. update_summaries_on_set() is called after a value of the specified
+    // column has been set (`value` is the new value of an integer, boolean,
+    // date or timestamp column, or none), and update_summaries_on_append()
+    // after rows have been appended, with the values of `columns`.
+    void update_summaries_on_set(size_t column_ndx, size_t row_ndx, util::Optional<int64_t> value,
+                                 uint_fast64_t prior_version) noexcept;
+    void update_summaries_on_append(size_t num_rows, const std::vector<BulkColumn>& columns,
+                                    uint_fast64_t prior_version) noexcept;
+
+    // The number of string values written through this accessor since they
+    // were last passed on to auto_optimize()
+    size_t m_auto_optimize_writes = 0;
+
+    /// Tables with fewer rows are not optimized automatically.
+    static const size_t auto_optimize_min_rows = 1000;
+
+    /// Call optimize() if it is likely to enumerate a string column, and
+    /// unenumerate_string_columns() if it is likely to turn an enumerated
+    /// column back into a plain one. This is decided from a sample of each
+    /// column, and only once the number of string values written since the
+    /// table was last considered reaches a quarter of the number of rows.
+    /// \a num_writes is that number, which is kept by the caller, since it
+    /// must outlive the accessor. The writes recorded by this accessor are
+    /// added to it, and it is reset when the table is considered.
+    void auto_optimize(size_t& num_writes);
+
+    bool enumerate_string_column(size_t col_ndx, bool enforce);
+    bool unenumerate_string_column(size_t col_ndx);
+
+    void add_bulk_column(const BulkColumn&, size_t num_rows);
+    void replicate_bulk_column(Replication&, const BulkColumn&, size_t row_ndx, size_t num_rows) const;
+
     void erase_row(size_t row_ndx, bool is_move_last_over);
     void batch_erase_rows(const IntegerColumn& row_indexes, bool is_move_last_over);
     void do_remove(size_t row_ndx, bool broken_reciprocal_backlinks);
@@ -2036,6 +2219,62 @@ inline void Table::set_ndx_in_parent(size_t ndx_in_parent) noexcept
     }
 }
 
+/// An aggregate to compute for every group of rows in Table::group_by().
+/// `column_ndx` is not used for `Table::aggr_count`.
+struct GroupAggregate {
+    Table::AggrType op;
+    size_t column_ndx;
+};
+
+/// The values of one column for Table::add_rows(). `values` refers to an
+/// array with one element per row whose element type is given by `type`,
+/// which must match the type of the column (int64_t, bool, float, double, or
+/// StringData). For nullable integer, boolean, float, and double columns,
+/// `nulls` may refer to an array of flags marking the rows that are to be
+/// null. A string is null if StringData::is_null() is true.
+struct BulkColumn {
+    size_t column_ndx;
+    DataType type;
+    const void* values;
+    const bool* nulls;
+
+    BulkColumn(size_t col_ndx, const int64_t* v, const bool* n = nullptr) noexcept
+        : column_ndx(col_ndx)
+        , type(type_Int)
+        , values(v)
+        , nulls(n)
+    {
+    }
+    BulkColumn(size_t col_ndx, const bool* v, const bool* n = nullptr) noexcept
+        : column_ndx(col_ndx)
+        , type(type_Bool)
+        , values(v)
+        , nulls(n)
+    {
+    }
+    BulkColumn(size_t col_ndx, const float* v, const bool* n = nullptr) noexcept
+        : column_ndx(col_ndx)
+        , type(type_Float)
+        , values(v)
+        , nulls(n)
+    {
+    }
+    BulkColumn(size_t col_ndx, const double* v, const bool* n = nullptr) noexcept
+        : column_ndx(col_ndx)
+        , type(type_Double)
+        , values(v)
+        , nulls(n)
+    {
+    }
+    BulkColumn(size_t col_ndx, const StringData* v) noexcept
+        : column_ndx(col_ndx)
+        , type(type_String)
+        , values(v)
+        , nulls(nullptr)
+    {
+    }
+};
+
 // This class groups together information about the target of a link column
 // This is not a valid link if the target table == nullptr
 struct LinkTargetInfo {
@@ -2402,6 +2641,21 @@ public:
         return Table::is_link_type(type);
     }
 
+    static void auto_optimize(Table& table, size_t& num_writes)
+    {
+        table.auto_optimize(num_writes); // Throws
+    }
+
+    static std::vector<Table::ColumnSummaries> take_column_summaries(Table& table) noexcept
+    {
+        return table.take_column_summaries();
+    }
+
+    static void restore_column_summaries(Table& table, std::vector<Table::ColumnSummaries> summaries) noexcept
+    {
+        table.restore_column_summaries(std::move(summaries));
+    }
+
     static void bump_version(Table& table, bool bump_global = true) noexcept
     {
         table.bump_version(bump_global);
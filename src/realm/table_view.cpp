@@ -438,6 +438,13 @@ void TableViewBase::aggregate(size_t group_by_column, size_t aggr_column, Table:
     m_table->aggregate(group_by_column, aggr_column, op, result, &m_row_indexes);
 }
 
+void TableViewBase::group_by(const std::vector<size_t>& group_by_columns,
+                             const std::vector<GroupAggregate>& aggregates, Table& result) const
+{
+    check_cookie();
+    m_table->group_by(group_by_columns, aggregates, result, &m_row_indexes);
+}
+
 void TableViewBase::to_json(std::ostream& out) const
 {
     check_cookie();
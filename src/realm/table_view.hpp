@@ -249,6 +249,10 @@ public:
     // document method publicly.
     void aggregate(size_t group_by_column, size_t aggr_column, Table::AggrType op, Table& result) const;
 
+    /// Group the rows of this view, as described for Table::group_by().
+    void group_by(const std::vector<size_t>& group_by_columns,
+                  const std::vector<GroupAggregate>& aggregates, Table& result) const;
+
     // Get row index in the source table this view is "looking" at.
     size_t get_source_ndx(size_t row_ndx) const noexcept;
 
@@ -101,6 +101,15 @@ size_t sequence_length(char lead);
 // Return bool(string1 < string2)
 bool utf8_compare(StringData string1, StringData string2);
 
+// Compute a key from the first characters of a string, so that strings can be
+// sorted without decoding them at every comparison. If the keys of two strings
+// differ, the order of the keys is the order of the strings according to
+// utf8_compare(), otherwise the strings must be compared. Only the lower 60
+// bits of the key are used. Returns false if the current string compare method
+// is not STRING_COMPARE_CORE or STRING_COMPARE_CORE_SIMILAR, or if the string
+// is not valid utf-8.
+bool utf8_sort_prefix(StringData string, uint64_t& prefix);
+
 // Return unicode value of character.
 uint32_t utf8value(const char* character);
 
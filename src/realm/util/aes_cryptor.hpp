@@ -24,10 +24,15 @@
 
 #if REALM_ENABLE_ENCRYPTION
 
+#include <sys/types.h>
+
+#include <realm/impl/parallel_executor.hpp>
+
 #if REALM_PLATFORM_APPLE
 #include <CommonCrypto/CommonCrypto.h>
 #elif !defined(_WIN32)
 #include <openssl/aes.h>
+#include <openssl/evp.h>
 #include <openssl/sha.h>
 #else
 #error Encryption is not yet implemented for this platform.
@@ -44,9 +49,27 @@ public:
     AESCryptor(const uint8_t* key);
     ~AESCryptor() noexcept;
 
+    /// Prepare for reading and writing data up to \a new_size bytes into the
+    /// file. This allocates the buffers used by read() and write(), and when
+    /// the file is large enough, the per-thread contexts for batches that are
+    /// processed in parallel.
     void set_file_size(off_t new_size);
 
+    /// Read and decrypt \a size bytes starting at data position \a pos,
+    /// which must both be multiples of the block size. Blocks that share an
+    /// IV table are read from the file with a single system call, and when
+    /// many blocks are read at once, they are checked and decrypted on
+    /// several threads.
+    ///
+    /// Returns false if any of the blocks has never been written, in which
+    /// case the corresponding part of \a dst is left unchanged.
     bool read(int fd, off_t pos, char* dst, size_t size);
+
+    /// Encrypt and write \a size bytes starting at data position \a pos,
+    /// which must both be multiples of the block size. Blocks that share an
+    /// IV table are encrypted into one buffer, on several threads when there
+    /// are many of them, and then written with one system call for their IV
+    /// table entries and one for the data.
     void write(int fd, off_t pos, const char* src, size_t size) noexcept;
 
 private:
@@ -60,22 +83,38 @@ private:
 #endif
     };
 
+    // m_encr and m_decr hold one context for each thread that can take part
+    // in processing a batch of blocks. The first ones are also used when a
+    // batch is processed on the calling thread alone.
 #if REALM_PLATFORM_APPLE
-    CCCryptorRef m_encr;
-    CCCryptorRef m_decr;
+    std::vector<CCCryptorRef> m_encr;
+    std::vector<CCCryptorRef> m_decr;
 #else
-    AES_KEY m_ectx;
-    AES_KEY m_dctx;
+    // The EVP interface is used rather than AES_cbc_encrypt(), as only the
+    // former makes use of AES-NI, which decrypts several CBC blocks in
+    // parallel.
+    std::vector<EVP_CIPHER_CTX*> m_encr;
+    std::vector<EVP_CIPHER_CTX*> m_decr;
 #endif
 
+    uint8_t m_aesKey[32];
     uint8_t m_hmacKey[32];
     std::vector<iv_table> m_iv_buffer;
     std::unique_ptr<char[]> m_rw_buffer;
+    size_t m_rw_buffer_blocks;
+    _impl::ParallelExecutor* m_executor = nullptr; // Null if batches are never processed in parallel
 
     void calc_hmac(const void* src, size_t len, uint8_t* dst, const uint8_t* key) const;
     bool check_hmac(const void* data, size_t len, const uint8_t* hmac) const;
-    void crypt(EncryptionMode mode, off_t pos, char* dst, const char* src, const char* stored_iv) noexcept;
+    void crypt(EncryptionMode mode, off_t pos, char* dst, const char* src, const char* stored_iv,
+               size_t thread_ndx = 0) noexcept;
     iv_table& get_iv_table(int fd, off_t data_pos) noexcept;
+    bool decrypt_block(off_t pos, char* dst, const char* src, size_t src_size, iv_table& iv, size_t thread_ndx);
+    void encrypt_block(off_t pos, char* dst, const char* src, iv_table& iv, size_t thread_ndx) noexcept;
+    size_t get_batch_size(off_t pos, size_t size) const noexcept;
+    void for_each_block(size_t num_blocks, const _impl::ParallelExecutor::Task& func);
+    void ensure_contexts(size_t num_threads);
+    void free_contexts() noexcept;
 };
 
 struct SharedFileInfo {
@@ -23,6 +23,8 @@
 #if REALM_ENABLE_ENCRYPTION
 #include <cstdlib>
 #include <algorithm>
+#include <new>
+#include <thread>
 
 #ifdef REALM_DEBUG
 #include <cstdio>
@@ -82,6 +84,15 @@ const size_t block_size = 4096;
 const size_t metadata_size = sizeof(iv_table);
 const size_t blocks_per_metadata_block = block_size / metadata_size;
 
+// Batches of at least this many blocks are encrypted or decrypted in
+// parallel
+const size_t min_parallel_blocks = 8;
+
+// The most that EncryptedFileMapping reads ahead of a sequential scan. This
+// is the amount of data covered by a single IV table, which AESCryptor::read()
+// reads with a single system call.
+const size_t max_read_ahead_size = blocks_per_metadata_block * block_size;
+
 // map an offset in the data to the actual location in the file
 template <typename Int>
 Int real_offset(Int pos)
@@ -125,27 +136,87 @@ size_t check_read(int fd, off_t pos, void* dst, size_t len)
     return ret < 0 ? 0 : static_cast<size_t>(ret);
 }
 
+#if REALM_PLATFORM_APPLE
+CCCryptorRef new_cryptor(bool encrypt, const uint8_t* key)
+{
+    CCCryptorRef cryptor = nullptr;
+    CCCryptorCreate(encrypt ? kCCEncrypt : kCCDecrypt, kCCAlgorithmAES, 0 /* options */, key, kCCKeySizeAES256,
+                    0 /* IV */, &cryptor);
+    return cryptor;
+}
+#else
+EVP_CIPHER_CTX* new_cryptor(bool encrypt, const uint8_t* key)
+{
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!ctx)
+        throw std::bad_alloc();
+    int ret = EVP_CipherInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, nullptr, encrypt ? 1 : 0);
+    REALM_ASSERT(ret == 1);
+    // Whole blocks are always encrypted, so there is nothing to pad. This
+    // setting survives the reinitialization with a new IV in crypt().
+    EVP_CIPHER_CTX_set_padding(ctx, 0);
+    return ctx;
+}
+#endif
+
+_impl::ParallelExecutor& get_crypto_executor()
+{
+    // Not the default executor, because the tasks of that one (for example,
+    // those of a parallel query) may run into read barriers, and a task must
+    // not start a batch on the executor that is executing it. Never destroyed,
+    // like the default executor.
+    static _impl::ParallelExecutor& executor =
+        *new _impl::ParallelExecutor(std::thread::hardware_concurrency()); // Throws
+    return executor;
+}
+
 } // anonymous namespace
 
 AESCryptor::AESCryptor(const uint8_t* key)
     : m_rw_buffer(new char[block_size])
+    , m_rw_buffer_blocks(1)
 {
-#if REALM_PLATFORM_APPLE
-    CCCryptorCreate(kCCEncrypt, kCCAlgorithmAES, 0 /* options */, key, kCCKeySizeAES256, 0 /* IV */, &m_encr);
-    CCCryptorCreate(kCCDecrypt, kCCAlgorithmAES, 0 /* options */, key, kCCKeySizeAES256, 0 /* IV */, &m_decr);
-#else
-    AES_set_encrypt_key(key, 256 /* key size in bits */, &m_ectx);
-    AES_set_decrypt_key(key, 256 /* key size in bits */, &m_dctx);
-#endif
+    memcpy(m_aesKey, key, 32);
     memcpy(m_hmacKey, key + 32, 32);
+    try {
+        ensure_contexts(1); // Throws
+    }
+    catch (...) {
+        free_contexts();
+        throw;
+    }
 }
 
 AESCryptor::~AESCryptor() noexcept
+{
+    free_contexts();
+}
+
+void AESCryptor::ensure_contexts(size_t num_threads)
+{
+    m_encr.reserve(num_threads); // Throws
+    m_decr.reserve(num_threads); // Throws
+    while (m_encr.size() < num_threads)
+        m_encr.push_back(new_cryptor(true, m_aesKey)); // Throws
+    while (m_decr.size() < num_threads)
+        m_decr.push_back(new_cryptor(false, m_aesKey)); // Throws
+}
+
+void AESCryptor::free_contexts() noexcept
 {
 #if REALM_PLATFORM_APPLE
-    CCCryptorRelease(m_encr);
-    CCCryptorRelease(m_decr);
+    for (CCCryptorRef cryptor : m_encr)
+        CCCryptorRelease(cryptor);
+    for (CCCryptorRef cryptor : m_decr)
+        CCCryptorRelease(cryptor);
+#else
+    for (EVP_CIPHER_CTX* ctx : m_encr)
+        EVP_CIPHER_CTX_free(ctx);
+    for (EVP_CIPHER_CTX* ctx : m_decr)
+        EVP_CIPHER_CTX_free(ctx);
 #endif
+    m_encr.clear();
+    m_decr.clear();
 }
 
 void AESCryptor::set_file_size(off_t new_size)
@@ -154,6 +225,40 @@ void AESCryptor::set_file_size(off_t new_size)
     size_t new_size_casted = size_t(new_size);
     size_t block_count = (new_size_casted + block_size - 1) / block_size;
     m_iv_buffer.reserve((block_count + blocks_per_metadata_block - 1) & ~(blocks_per_metadata_block - 1));
+
+    // Everything that read() and write() need for batches of up to one IV
+    // table's worth of blocks is allocated here, as write() must not throw
+    size_t batch_blocks = std::min(block_count, blocks_per_metadata_block);
+    if (batch_blocks > m_rw_buffer_blocks) {
+        m_rw_buffer.reset(new char[batch_blocks * block_size]); // Throws
+        m_rw_buffer_blocks = batch_blocks;
+    }
+    if (!m_executor && batch_blocks >= min_parallel_blocks) {
+        _impl::ParallelExecutor& executor = get_crypto_executor(); // Throws
+        if (executor.get_num_threads() > 1) {
+            ensure_contexts(executor.get_num_threads()); // Throws
+            m_executor = &executor;
+        }
+    }
+}
+
+size_t AESCryptor::get_batch_size(off_t pos, size_t size) const noexcept
+{
+    // Blocks that share an IV table are stored contiguously in the file, and
+    // so are their entries in the IV table
+    size_t first_block = size_t(pos) / block_size;
+    size_t num_blocks = blocks_per_metadata_block - first_block % blocks_per_metadata_block;
+    return std::min(std::min(size / block_size, num_blocks), m_rw_buffer_blocks);
+}
+
+void AESCryptor::for_each_block(size_t num_blocks, const _impl::ParallelExecutor::Task& func)
+{
+    if (m_executor && num_blocks >= min_parallel_blocks) {
+        m_executor->run(num_blocks, func); // Throws
+        return;
+    }
+    for (size_t i = 0; i < num_blocks; ++i)
+        func(i, 0); // Throws
 }
 
 iv_table& AESCryptor::get_iv_table(int fd, off_t data_pos) noexcept
@@ -193,52 +298,73 @@ bool AESCryptor::check_hmac(const void* src, size_t len, const uint8_t* hmac) co
 bool AESCryptor::read(int fd, off_t pos, char* dst, size_t size)
 {
     REALM_ASSERT(size % block_size == 0);
+    bool success = true;
     while (size > 0) {
-        ssize_t bytes_read = check_read(fd, real_offset(pos), m_rw_buffer.get(), block_size);
+        size_t num_blocks = get_batch_size(pos, size);
+        char* buffer = m_rw_buffer.get();
+        size_t bytes_read = check_read(fd, real_offset(pos), buffer, num_blocks * block_size);
+
+        iv_table* ivs[blocks_per_metadata_block];
+        for (size_t i = 0; i < num_blocks; ++i)
+            ivs[i] = &get_iv_table(fd, pos + i * block_size);
+
+        bool written[blocks_per_metadata_block];
+        for_each_block(num_blocks, [&](size_t i, size_t thread_ndx) {
+            size_t offset = i * block_size;
+            size_t src_size = bytes_read > offset ? std::min(bytes_read - offset, block_size) : 0;
+            written[i] = decrypt_block(pos + offset, dst + offset, buffer + offset, src_size, *ivs[i],
+                                       thread_ndx); // Throws
+        }); // Throws
+        for (size_t i = 0; i < num_blocks; ++i)
+            success = success && written[i];
+
+        pos += num_blocks * block_size;
+        dst += num_blocks * block_size;
+        size -= num_blocks * block_size;
+    }
+    return success;
+}
 
-        if (bytes_read == 0)
-            return false;
+bool AESCryptor::decrypt_block(off_t pos, char* dst, const char* src, size_t src_size, iv_table& iv,
+                               size_t thread_ndx)
+{
+    if (src_size == 0)
+        return false;
 
-        iv_table& iv = get_iv_table(fd, pos);
-        if (iv.iv1 == 0) {
-            // This block has never been written to, so we've just read pre-allocated
-            // space. No memset() since the code using this doesn't rely on
-            // pre-allocated space being zeroed.
+    if (iv.iv1 == 0) {
+        // This block has never been written to, so we've just read pre-allocated
+        // space. No memset() since the code using this doesn't rely on
+        // pre-allocated space being zeroed.
+        return false;
+    }
+
+    if (!check_hmac(src, src_size, iv.hmac1)) {
+        // Either the DB is corrupted or we were interrupted between writing the
+        // new IV and writing the data
+        if (iv.iv2 == 0) {
+            // Very first write was interrupted
             return false;
         }
 
-        if (!check_hmac(m_rw_buffer.get(), bytes_read, iv.hmac1)) {
-            // Either the DB is corrupted or we were interrupted between writing the
-            // new IV and writing the data
-            if (iv.iv2 == 0) {
-                // Very first write was interrupted
-                return false;
-            }
-
-            if (check_hmac(m_rw_buffer.get(), bytes_read, iv.hmac2)) {
-                // Un-bump the IV since the write with the bumped IV never actually
-                // happened
-                memcpy(&iv.iv1, &iv.iv2, 32);
-            }
-            else {
-                // If the file has been shrunk and then re-expanded, we may have
-                // old hmacs that don't go with this data. ftruncate() is
-                // required to fill any added space with zeroes, so assume that's
-                // what happened if the buffer is all zeroes
-                for (ssize_t i = 0; i < bytes_read; ++i) {
-                    if (m_rw_buffer[i] != 0)
-                        throw DecryptionFailed();
-                }
-                return false;
+        if (check_hmac(src, src_size, iv.hmac2)) {
+            // Un-bump the IV since the write with the bumped IV never actually
+            // happened
+            memcpy(&iv.iv1, &iv.iv2, 32);
+        }
+        else {
+            // If the file has been shrunk and then re-expanded, we may have
+            // old hmacs that don't go with this data. ftruncate() is
+            // required to fill any added space with zeroes, so assume that's
+            // what happened if the buffer is all zeroes
+            for (size_t i = 0; i < src_size; ++i) {
+                if (src[i] != 0)
+                    throw DecryptionFailed();
             }
+            return false;
         }
-
-        crypt(mode_Decrypt, pos, dst, m_rw_buffer.get(), reinterpret_cast<const char*>(&iv.iv1));
-
-        pos += block_size;
-        dst += block_size;
-        size -= block_size;
     }
+
+    crypt(mode_Decrypt, pos, dst, src, reinterpret_cast<const char*>(&iv.iv1), thread_ndx);
     return true;
 }
 
@@ -246,39 +372,56 @@ void AESCryptor::write(int fd, off_t pos, const char* src, size_t size) noexcept
 {
     REALM_ASSERT(size % block_size == 0);
     while (size > 0) {
-        iv_table& iv = get_iv_table(fd, pos);
+        size_t num_blocks = get_batch_size(pos, size);
+        char* buffer = m_rw_buffer.get();
+
+        iv_table* ivs[blocks_per_metadata_block];
+        for (size_t i = 0; i < num_blocks; ++i)
+            ivs[i] = &get_iv_table(fd, pos + i * block_size);
+
+        for_each_block(num_blocks, [&](size_t i, size_t thread_ndx) {
+            size_t offset = i * block_size;
+            encrypt_block(pos + offset, buffer + offset, src + offset, *ivs[i], thread_ndx);
+        });
+
+        // The IV table entries of all the blocks are written before any of
+        // the blocks, so read() can still tell for each block whether it was
+        // written with the new or the old IV if this is interrupted
+        check_write(fd, iv_table_pos(pos), ivs[0], num_blocks * metadata_size);
+        check_write(fd, real_offset(pos), buffer, num_blocks * block_size);
+
+        pos += num_blocks * block_size;
+        src += num_blocks * block_size;
+        size -= num_blocks * block_size;
+    }
+}
 
-        memcpy(&iv.iv2, &iv.iv1, 32);
-        do {
+void AESCryptor::encrypt_block(off_t pos, char* dst, const char* src, iv_table& iv, size_t thread_ndx) noexcept
+{
+    memcpy(&iv.iv2, &iv.iv1, 32);
+    do {
+        ++iv.iv1;
+        // 0 is reserved for never-been-used, so bump if we just wrapped around
+        if (iv.iv1 == 0)
             ++iv.iv1;
-            // 0 is reserved for never-been-used, so bump if we just wrapped around
-            if (iv.iv1 == 0)
-                ++iv.iv1;
-
-            crypt(mode_Encrypt, pos, m_rw_buffer.get(), src, reinterpret_cast<const char*>(&iv.iv1));
-            calc_hmac(m_rw_buffer.get(), block_size, iv.hmac1, m_hmacKey);
-            // In the extremely unlikely case that both the old and new versions have
-            // the same hash we won't know which IV to use, so bump the IV until
-            // they're different.
-        } while (REALM_UNLIKELY(memcmp(iv.hmac1, iv.hmac2, 4) == 0));
-
-        check_write(fd, iv_table_pos(pos), &iv, sizeof(iv));
-        check_write(fd, real_offset(pos), m_rw_buffer.get(), block_size);
-
-        pos += block_size;
-        src += block_size;
-        size -= block_size;
-    }
+
+        crypt(mode_Encrypt, pos, dst, src, reinterpret_cast<const char*>(&iv.iv1), thread_ndx);
+        calc_hmac(dst, block_size, iv.hmac1, m_hmacKey);
+        // In the extremely unlikely case that both the old and new versions have
+        // the same hash we won't know which IV to use, so bump the IV until
+        // they're different.
+    } while (REALM_UNLIKELY(memcmp(iv.hmac1, iv.hmac2, 4) == 0));
 }
 
-void AESCryptor::crypt(EncryptionMode mode, off_t pos, char* dst, const char* src, const char* stored_iv) noexcept
+void AESCryptor::crypt(EncryptionMode mode, off_t pos, char* dst, const char* src, const char* stored_iv,
+                       size_t thread_ndx) noexcept
 {
     uint8_t iv[aes_block_size] = {0};
     memcpy(iv, stored_iv, 4);
     memcpy(iv + 4, &pos, sizeof(pos));
 
 #if REALM_PLATFORM_APPLE
-    CCCryptorRef cryptor = mode == mode_Encrypt ? m_encr : m_decr;
+    CCCryptorRef cryptor = (mode == mode_Encrypt ? m_encr : m_decr)[thread_ndx];
     CCCryptorReset(cryptor, iv);
 
     size_t bytesEncrypted = 0;
@@ -286,8 +429,15 @@ void AESCryptor::crypt(EncryptionMode mode, off_t pos, char* dst, const char* sr
     REALM_ASSERT(err == kCCSuccess);
     REALM_ASSERT(bytesEncrypted == block_size);
 #else
-    AES_cbc_encrypt(reinterpret_cast<const uint8_t*>(src), reinterpret_cast<uint8_t*>(dst), block_size,
-                    mode == mode_Encrypt ? &m_ectx : &m_dctx, iv, mode);
+    EVP_CIPHER_CTX* ctx = (mode == mode_Encrypt ? m_encr : m_decr)[thread_ndx];
+    int ret = EVP_CipherInit_ex(ctx, nullptr, nullptr, nullptr, iv, -1 /* keep direction */);
+    REALM_ASSERT(ret == 1);
+
+    int bytes_encrypted = 0;
+    ret = EVP_CipherUpdate(ctx, reinterpret_cast<uint8_t*>(dst), &bytes_encrypted,
+                           reinterpret_cast<const uint8_t*>(src), int(block_size));
+    REALM_ASSERT(ret == 1);
+    REALM_ASSERT(bytes_encrypted == int(block_size));
 #endif
 }
 
@@ -384,14 +534,62 @@ bool EncryptedFileMapping::copy_up_to_date_page(size_t page) noexcept
     return false;
 }
 
+bool EncryptedFileMapping::is_up_to_date_elsewhere(size_t page) const noexcept
+{
+    for (size_t i = 0; i < m_file.mappings.size(); ++i) {
+        const EncryptedFileMapping* m = m_file.mappings[i];
+        if (m != this && page < m->m_page_count && m->m_up_to_date_pages[page])
+            return true;
+    }
+    return false;
+}
+
+// The number of pages, starting with the specified one, to refresh from the
+// file. The read-ahead window opens when a page is refreshed right after the
+// pages refreshed last time, and doubles with every further sequential
+// refresh, until it covers max_read_ahead_size. Any other access closes it.
+//
+// Read-ahead stops short of pages that are up to date in this or any other
+// mapping, since the latter may have changes that are not yet in the file.
+size_t EncryptedFileMapping::get_read_ahead_count(size_t page) noexcept
+{
+    if (page == m_next_sequential_page) {
+        size_t max_pages = max_read_ahead_size >> m_page_shift;
+        m_read_ahead_pages = std::min(std::max(2 * m_read_ahead_pages, size_t(1)), max_pages);
+    }
+    else {
+        m_read_ahead_pages = 0;
+    }
+
+    size_t count = 1;
+    while (count <= m_read_ahead_pages && page + count < m_page_count) {
+        size_t next = page + count;
+        if (m_up_to_date_pages[next] || is_up_to_date_elsewhere(next))
+            break;
+        ++count;
+    }
+    m_next_sequential_page = page + count;
+    return count;
+}
+
 void EncryptedFileMapping::refresh_page(size_t i)
 {
-    char* addr = page_addr(i);
+    // Another thread may have refreshed the page, possibly by reading ahead,
+    // while this one was waiting for the lock
+    if (m_up_to_date_pages[i])
+        return;
 
-    if (!copy_up_to_date_page(i))
-        m_file.cryptor.read(m_file.fd, i << m_page_shift, addr, 1 << m_page_shift);
+    if (copy_up_to_date_page(i)) {
+        m_up_to_date_pages[i] = true;
+        m_next_sequential_page = i + 1;
+        return;
+    }
 
-    m_up_to_date_pages[i] = true;
+    size_t count = get_read_ahead_count(i);
+    m_file.cryptor.read(m_file.fd, i << m_page_shift, page_addr(i), count << m_page_shift); // Throws
+
+    for (size_t j = i; j < i + count; ++j)
+        m_up_to_date_pages[j] = true;
 }
 
 void EncryptedFileMapping::write_page(size_t page) noexcept
@@ -447,14 +645,22 @@ void EncryptedFileMapping::validate() noexcept
 
 void EncryptedFileMapping::flush() noexcept
 {
-    for (size_t i = 0; i < m_page_count; ++i) {
+    size_t i = 0;
+    while (i < m_page_count) {
         if (!m_dirty_pages[i]) {
             validate_page(i);
+            ++i;
             continue;
         }
 
-        m_file.cryptor.write(m_file.fd, i << m_page_shift, page_addr(i), 1 << m_page_shift);
-        m_dirty_pages[i] = false;
+        // Runs of dirty pages are written with a single call, which lets the
+        // cryptor batch the system calls and the encryption
+        size_t end = i + 1;
+        while (end < m_page_count && m_dirty_pages[end])
+            ++end;
+        m_file.cryptor.write(m_file.fd, i << m_page_shift, page_addr(i), (end - i) << m_page_shift);
+        for (; i < end; ++i)
+            m_dirty_pages[i] = false;
     }
 
     validate();
@@ -510,6 +716,8 @@ void EncryptedFileMapping::set(void* new_addr, size_t new_size, size_t new_file_
 
     m_up_to_date_pages.clear();
     m_dirty_pages.clear();
+    m_next_sequential_page = 0;
+    m_read_ahead_pages = 0;
 
     m_up_to_date_pages.resize(m_page_count, false);
     m_dirty_pages.resize(m_page_count, false);
@@ -49,7 +49,9 @@ public:
     void sync() noexcept;
 
     // Make sure that memory in the specified range is synchronized with any
-    // changes made globally visible through call to write_barrier
+    // changes made globally visible through call to write_barrier. When pages
+    // are found to be outdated in sequential order, the pages that follow them
+    // are refreshed as well, in increasingly large batches.
     void read_barrier(const void* addr, size_t size, UniqueLock& lock, Header_to_size header_to_size);
 
     // Ensures that any changes made to memory in the specified range
@@ -75,6 +77,10 @@ private:
     std::vector<char> m_up_to_date_pages;
     std::vector<bool> m_dirty_pages;
 
+    // Sequential access detection for read-ahead (see get_read_ahead_count())
+    size_t m_next_sequential_page = 0;
+    size_t m_read_ahead_pages = 0;
+
     File::AccessMode m_access;
 
 #ifdef REALM_DEBUG
@@ -88,6 +94,8 @@ private:
     void mark_unwritable(size_t i) noexcept;
 
     bool copy_up_to_date_page(size_t i) noexcept;
+    bool is_up_to_date_elsewhere(size_t i) const noexcept;
+    size_t get_read_ahead_count(size_t i) noexcept;
     void refresh_page(size_t i);
     void write_page(size_t i) noexcept;
 
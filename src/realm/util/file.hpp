@@ -311,6 +311,10 @@ public:
     /// \param key A 64-byte encryption key, or null to disable encryption.
     void set_encryption_key(const char* key);
 
+    /// Returns the key set by set_encryption_key(), or null if the file is
+    /// not encrypted.
+    const char* get_encryption_key() const noexcept;
+
     enum {
         /// If possible, disable opportunistic flushing of dirted
         /// pages of a memory mapped file to physical medium. On some
@@ -882,6 +886,11 @@ inline File& File::operator=(File&& f) noexcept
     return *this;
 }
 
+inline const char* File::get_encryption_key() const noexcept
+{
+    return m_encryption_key.get();
+}
+
 inline void File::open(const std::string& path, Mode m)
 {
     AccessMode a = access_ReadWrite;
@@ -62,6 +62,30 @@ inline unsigned long long _xgetbv(unsigned index)
 }
 
 #endif
+
+// Returns EBX of CPUID leaf 7, sub-leaf 0 (structured extended feature flags), or 0 if the CPU does not implement
+// that leaf
+int cpuid_extended_features()
+{
+#ifdef _MSC_VER
+    int CPUInfo[4];
+    __cpuid(CPUInfo, 0);
+    if (CPUInfo[0] < 7)
+        return 0;
+    __cpuidex(CPUInfo, 7, 0);
+    return CPUInfo[1];
+#else
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    __asm__ __volatile__("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+    if (eax < 7)
+        return 0;
+    eax = 7;
+    ecx = 0;
+    __asm__ __volatile__("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+    return int(ebx);
+#endif
+}
+
 #endif
 #endif
 
@@ -107,6 +131,8 @@ void cpuid_init()
     }
 
     bool avxSupported = false;
+    bool avx2Supported = false;
+    bool avx512Supported = false;
 
 // seems like in jenkins builds, __GNUC__ is defined for clang?! todo fixme
 #if !defined __clang__ && ((defined(_MSC_FULL_VER) && _MSC_FULL_VER >= 160040219) || defined __GNUC__)
@@ -117,18 +143,29 @@ void cpuid_init()
         // Check if the OS will save the YMM registers
         unsigned long long xcrFeatureMask = _xgetbv(_XCR_XFEATURE_ENABLED_MASK);
         avxSupported = (xcrFeatureMask & 0x6) || false;
+
+        // AVX2 is bit 5 of leaf 7 EBX. AVX-512 needs both F (bit 16) and BW (bit 30) since we compare bytes and
+        // words, and also needs the OS to save the opmask and upper ZMM registers (XCR0 bits 5-7).
+        int features = cpuid_extended_features();
+        avx2Supported = (xcrFeatureMask & 0x6) == 0x6 && (features & (1 << 5)) != 0;
+        avx512Supported = avx2Supported && (xcrFeatureMask & 0xe0) == 0xe0 && (features & (1 << 16)) != 0 &&
+                          (features & (1 << 30)) != 0;
     }
 #endif
 
-    if (avxSupported) {
+    if (avx512Supported) {
+        avx_support = 2; // AVX-512 F + BW supported
+    }
+    else if (avx2Supported) {
+        avx_support = 1; // AVX2 supported
+    }
+    else if (avxSupported) {
         avx_support = 0; // AVX1 supported
     }
     else {
         avx_support = -1; // No AVX supported
     }
 
-// 1 is reserved for AVX2
-
 #endif
 }
 
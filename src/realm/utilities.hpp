@@ -61,6 +61,27 @@
 #define REALM_COMPILER_AVX
 #endif
 
+// AVX2 and AVX-512 kernels are compiled per function through the target attribute instead of -mavx2/-mavx512f on
+// the command line, because those flags would let the compiler emit wide instructions in any function and the
+// binary would crash on older CPUs. The kernels are only entered after sseavx<2>() or sseavx<512>() has confirmed
+// runtime support.
+#if defined(REALM_COMPILER_AVX)
+#if defined(_MSC_VER) || defined(__clang__) || REALM_HAVE_AT_LEAST_GCC(4, 9)
+#define REALM_COMPILER_AVX2
+#endif
+#if (defined(_MSC_VER) && _MSC_VER >= 1911) || defined(__clang__) || REALM_HAVE_AT_LEAST_GCC(7, 0)
+#define REALM_COMPILER_AVX512
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define REALM_TARGET_AVX2 __attribute__((target("avx2")))
+#define REALM_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw")))
+#else
+#define REALM_TARGET_AVX2
+#define REALM_TARGET_AVX512
+#endif
+
 namespace realm {
 
 using StringCompareCallback = std::function<bool(const char* string1, const char* string2)>;
@@ -81,7 +102,8 @@ REALM_FORCEINLINE bool sseavx()
 
     avx_support = -1: No AVX support
     avx_support = 0: AVX1 supported
-    sse_support = 1: AVX2 supported (not yet implemented for detection in our cpuid_init(), todo)
+    avx_support = 1: AVX2 supported
+    avx_support = 2: AVX-512 F and BW supported (version = 512)
 
     This lets us test very rapidly at runtime because we just need 1 compare instruction (with 0) to test both for
     SSE 3 and 4.2 by caller (compiler optimizes if calls are concecutive), and can decide branch with ja/jl/je because
@@ -90,8 +112,9 @@ REALM_FORCEINLINE bool sseavx()
     We runtime-initialize sse_support in a constructor of a static variable which is not guaranteed to be called
     prior to cpu_sse(). So we compile-time initialize sse_support to -2 as fallback.
     */
-    static_assert(version == 1 || version == 2 || version == 30 || version == 42,
-                  "Only version == 1 (AVX), 2 (AVX2), 30 (SSE 3) and 42 (SSE 4.2) are supported for detection");
+    static_assert(version == 1 || version == 2 || version == 512 || version == 30 || version == 42,
+                  "Only version == 1 (AVX), 2 (AVX2), 512 (AVX-512), 30 (SSE 3) and 42 (SSE 4.2) are supported for "
+                  "detection");
 #ifdef REALM_COMPILER_SSE
     if (version == 30)
         return (sse_support >= 0);
@@ -101,6 +124,8 @@ REALM_FORCEINLINE bool sseavx()
         return (avx_support >= 0);
     else if (version == 2) // avx2
         return (avx_support > 0);
+    else if (version == 512) // avx-512 f + bw
+        return (avx_support > 1);
     else
         return false;
 #else
@@ -19,7 +19,11 @@
 #include <realm/views.hpp>
 
 #include <realm/column_link.hpp>
+#include <realm/column_string.hpp>
+#include <realm/column_string_enum.hpp>
+#include <realm/index_string.hpp>
 #include <realm/table.hpp>
+#include <realm/unicode.hpp>
 
 using namespace realm;
 
@@ -28,6 +32,65 @@ struct IndexPair {
     size_t index_in_column;
     size_t index_in_view;
 };
+
+// Walking the index of a column visits every row of the column, so it is only
+// used when the number of rows to sort is at least this fraction of it.
+const size_t index_sort_max_column_rows_per_row = 16;
+
+// Get the rank of the value of every row of the column from its ordered index
+// or its search index, such that comparing the ranks of two rows gives the same
+// result as ColumnBase::compare_values(). Nulls get the lowest rank. Returns
+// false if the column has no index, or if it has values that the index cannot
+// rank.
+bool get_ranks_from_index(const ColumnBase& column, std::vector<size_t>& ranks)
+{
+    size_t num_rows = column.size();
+    if (const OrderedIndex* index = column.get_ordered_index()) {
+        // Unindexed rows are null, or NaN, which compare_values() cannot order
+        ranks.assign(num_rows, 0);
+        size_t rank = 0;
+        OrderedIndex::Key prev_key = OrderedIndex::min_key(); // Not the key of any value
+        index->for_each(0, index->size(), [&](const OrderedIndex::Entry& entry) {
+            if (rank == 0 || entry.key != prev_key)
+                ++rank;
+            ranks[entry.row_ndx] = rank;
+            prev_key = entry.key;
+        });
+        for (size_t row_ndx = 0; row_ndx < num_rows; ++row_ndx) {
+            if (ranks[row_ndx] == 0 && !column.is_null(row_ndx))
+                return false;
+        }
+        return true;
+    }
+
+    if (const StringIndex* index = column.get_search_index()) {
+        // The search index groups equal values, but orders them by their binary
+        // representation, so the groups are ordered by comparing one row of
+        // each.
+        std::vector<size_t> groups(num_rows);
+        std::vector<size_t> first_rows;
+        index->group_rows(groups, first_rows); // Throws
+        std::vector<size_t> order(first_rows.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return column.compare_values(first_rows[a], first_rows[b]) > 0;
+        });
+        std::vector<size_t> group_ranks(order.size());
+        size_t rank = 0;
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (i > 0 && column.compare_values(first_rows[order[i - 1]], first_rows[order[i]]) != 0)
+                ++rank;
+            group_ranks[order[i]] = rank;
+        }
+        ranks.resize(num_rows);
+        for (size_t row_ndx = 0; row_ndx < num_rows; ++row_ndx)
+            ranks[row_ndx] = group_ranks[groups[row_ndx]];
+        return true;
+    }
+
+    return false;
+}
 } // anonymous namespace
 
 SortDescriptor::SortDescriptor(Table const& table, std::vector<std::vector<size_t>> column_indices,
@@ -99,6 +162,12 @@ public:
 
     bool operator()(IndexPair i, IndexPair j, bool total_ordering = true) const;
 
+    // Sort `v` by this ordering. When there is a single column, and it is
+    // ranked by an index, this is a counting sort on the ranks. When the first
+    // column is a string column, the rows are first ordered by a prefix of
+    // their values.
+    void sort(std::vector<IndexPair>& v) const;
+
     bool has_links() const
     {
         return std::any_of(m_columns.begin(), m_columns.end(),
@@ -117,8 +186,13 @@ private:
         std::vector<size_t> translated_row;
         const ColumnBase* column;
         bool ascending;
+        std::vector<size_t> rank; // Indexed by row of `column`, empty if not ranked
     };
     std::vector<SortColumn> m_columns;
+
+    bool less(IndexPair i, IndexPair j, size_t first_column, bool total_ordering) const;
+    void sort_by_rank(std::vector<IndexPair>& v) const;
+    bool sort_by_string_prefix(std::vector<IndexPair>& v) const;
 };
 
 SortDescriptor::Sorter::Sorter(std::vector<std::vector<const ColumnBase*>> const& columns,
@@ -129,8 +203,13 @@ SortDescriptor::Sorter::Sorter(std::vector<std::vector<const ColumnBase*>> const
 
     m_columns.reserve(columns.size());
     for (size_t i = 0; i < columns.size(); ++i) {
-        m_columns.push_back({{}, {}, columns[i].back(), ascending[i]});
+        m_columns.push_back({{}, {}, columns[i].back(), ascending[i], {}});
         REALM_ASSERT_EX(!columns[i].empty(), i);
+        const ColumnBase& column = *columns[i].back();
+        if (num_rows >= column.size() / index_sort_max_column_rows_per_row) {
+            if (!get_ranks_from_index(column, m_columns.back().rank)) // Throws
+                m_columns.back().rank.clear();
+        }
         if (columns[i].size() == 1) { // no link chain
             continue;
         }
@@ -163,7 +242,12 @@ SortDescriptor::Sorter SortDescriptor::sorter(IntegerColumn const& row_indexes)
 
 bool SortDescriptor::Sorter::operator()(IndexPair i, IndexPair j, bool total_ordering) const
 {
-    for (size_t t = 0; t < m_columns.size(); t++) {
+    return less(i, j, 0, total_ordering);
+}
+
+bool SortDescriptor::Sorter::less(IndexPair i, IndexPair j, size_t first_column, bool total_ordering) const
+{
+    for (size_t t = first_column; t < m_columns.size(); t++) {
         size_t index_i = i.index_in_column;
         size_t index_j = j.index_in_column;
 
@@ -183,6 +267,14 @@ bool SortDescriptor::Sorter::operator()(IndexPair i, IndexPair j, bool total_ord
             index_j = m_columns[t].translated_row[j.index_in_view];
         }
 
+        if (!m_columns[t].rank.empty()) {
+            size_t rank_i = m_columns[t].rank[index_i];
+            size_t rank_j = m_columns[t].rank[index_j];
+            if (rank_i != rank_j)
+                return m_columns[t].ascending ? rank_i < rank_j : rank_i > rank_j;
+            continue;
+        }
+
         if (int c = m_columns[t].column->compare_values(index_i, index_j))
             return m_columns[t].ascending ? c > 0 : c < 0;
     }
@@ -190,6 +282,99 @@ bool SortDescriptor::Sorter::operator()(IndexPair i, IndexPair j, bool total_ord
     return total_ordering ? i.index_in_view < j.index_in_view : 0;
 }
 
+void SortDescriptor::Sorter::sort(std::vector<IndexPair>& v) const
+{
+    const SortColumn& col = m_columns[0];
+    if (!col.rank.empty()) {
+        if (m_columns.size() == 1) {
+            sort_by_rank(v);
+            return;
+        }
+    }
+    else if (col.translated_row.empty()) {
+        if (sort_by_string_prefix(v)) // Throws
+            return;
+    }
+    std::sort(v.begin(), v.end(), std::ref(*this));
+}
+
+void SortDescriptor::Sorter::sort_by_rank(std::vector<IndexPair>& v) const
+{
+    const SortColumn& col = m_columns[0];
+
+    // Counting sort on the ranks. Rows with a null link are placed after all
+    // others when sorting in ascending order, and before them otherwise. Rows
+    // of equal rank keep their order in the view.
+    size_t num_ranks = 1 + *std::max_element(col.rank.begin(), col.rank.end());
+    auto get_bucket = [&](IndexPair i) -> size_t {
+        size_t index = i.index_in_column;
+        if (!col.translated_row.empty()) {
+            if (col.is_null[i.index_in_view])
+                return col.ascending ? num_ranks : 0;
+            index = col.translated_row[i.index_in_view];
+        }
+        size_t rank = col.rank[index];
+        return col.ascending ? rank : num_ranks - rank;
+    };
+
+    if (!std::is_sorted(v.begin(), v.end(), [](auto a, auto b) { return a.index_in_view < b.index_in_view; }))
+        std::sort(v.begin(), v.end(), [](auto a, auto b) { return a.index_in_view < b.index_in_view; });
+
+    std::vector<size_t> offsets(num_ranks + 2);
+    for (IndexPair i : v)
+        ++offsets[get_bucket(i) + 1];
+    for (size_t b = 1; b < offsets.size(); ++b)
+        offsets[b] += offsets[b - 1];
+    std::vector<IndexPair> sorted(v.size());
+    for (IndexPair i : v)
+        sorted[offsets[get_bucket(i)]++] = i;
+    v.swap(sorted);
+}
+
+bool SortDescriptor::Sorter::sort_by_string_prefix(std::vector<IndexPair>& v) const
+{
+    const SortColumn& col = m_columns[0];
+    auto string_col = dynamic_cast<const StringColumn*>(col.column);
+    auto enum_col = dynamic_cast<const StringEnumColumn*>(col.column);
+    if (!string_col && !enum_col)
+        return false;
+
+    // Sort a contiguous buffer of keys made from the first characters of the
+    // values, so that the values only need to be collated when their keys are
+    // equal. The values are fetched once, and refer directly to the column
+    // memory, which is not modified during the sort. Nulls come first in
+    // ascending order.
+    struct Keyed {
+        uint64_t key;
+        StringData value;
+        IndexPair index;
+    };
+    std::vector<Keyed> keyed;
+    keyed.reserve(v.size()); // Throws
+    for (IndexPair i : v) {
+        StringData value = string_col ? string_col->get(i.index_in_column) : enum_col->get(i.index_in_column);
+        uint64_t key = 0;
+        if (!value.is_null()) {
+            if (!utf8_sort_prefix(value, key))
+                return false;
+            key |= uint64_t(1) << 63;
+        }
+        keyed.push_back({col.ascending ? key : ~key, value, i});
+    }
+
+    bool ascending = col.ascending;
+    std::sort(keyed.begin(), keyed.end(), [this, ascending](const Keyed& a, const Keyed& b) {
+        if (a.key != b.key)
+            return a.key < b.key;
+        if (a.value != b.value)
+            return ascending ? utf8_compare(a.value, b.value) : utf8_compare(b.value, a.value);
+        return less(a.index, b.index, 1, true);
+    });
+    for (size_t j = 0; j < v.size(); ++j)
+        v[j] = keyed[j].index;
+    return true;
+}
+
 void RowIndexes::do_sort(const SortDescriptor& order, const SortDescriptor& distinct)
 {
     if (!order && !distinct)
@@ -226,7 +411,7 @@ void RowIndexes::do_sort(const SortDescriptor& order, const SortDescriptor& dist
         }
 
         // Sort by the columns to distinct on
-        std::sort(v.begin(), v.end(), std::ref(sorting_predicate));
+        sorting_predicate.sort(v);
 
         // Remove all duplicates
         v.erase(std::unique(v.begin(), v.end(),
@@ -244,7 +429,7 @@ void RowIndexes::do_sort(const SortDescriptor& order, const SortDescriptor& dist
 
     if (order) {
         auto sorting_predicate = order.sorter(m_row_indexes);
-        std::sort(v.begin(), v.end(), std::ref(sorting_predicate));
+        sorting_predicate.sort(v);
     }
 
     // Apply the results
@@ -162,37 +162,6 @@ long get_num_open_files()
 }
 
 
-void fix_async_daemon_path()
-{
-// `setenv()` is POSIX. _WIN32 has `_putenv_s()` instead.
-#ifndef _WIN32
-    const char* async_daemon;
-    // When running the unit-tests in Xcode, it runs them
-    // in its own temporary directory. So we have to make sure we
-    // look for the daemon there
-    const char* xcode_env = getenv("__XCODE_BUILT_PRODUCTS_DIR_PATHS");
-    if (xcode_env) {
-#ifdef REALM_DEBUG
-        async_daemon = "realmd-dbg-noinst";
-#else
-        async_daemon = "realmd-noinst";
-#endif
-    }
-    else {
-#ifdef REALM_COVER
-        async_daemon = "../src/realm/realmd-cov-noinst";
-#else
-#ifdef REALM_DEBUG
-        async_daemon = "../src/realm/realmd-dbg-noinst";
-#else
-        async_daemon = "../src/realm/realmd-noinst";
-#endif
-#endif
-    }
-    setenv("REALM_ASYNC_DAEMON", async_daemon, 0);
-#endif // _WIN32
-}
-
 void set_random_seed()
 {
     // Select random seed for the random generator that some of our unit tests are using
@@ -256,6 +225,8 @@ void display_build_config()
 
     const char* cpu_avx = realm::sseavx<1>() ? "Yes" : "No";
 
+    const char* cpu_avx_wide = realm::sseavx<512>() ? "AVX-512" : (realm::sseavx<2>() ? "AVX2" : "None");
+
     std::cout << std::endl
               << "Realm version: " << Version::get_version() << " with Debug " << with_debug << "\n"
               << "Encryption: " << encryption << "\n"
@@ -271,6 +242,7 @@ void display_build_config()
               << "This CPU supports SSE (auto detect):        " << cpu_sse << "\n"
               << "Compiler supported AVX (auto detect):       " << compiler_avx << "\n"
               << "This CPU supports AVX (AVX1) (auto detect): " << cpu_avx << "\n"
+              << "This CPU supports AVX2/AVX-512 (auto detect): " << cpu_avx_wide << "\n"
               << "\n"
               << "Unit test random seed:                      " << unit_test_random_seed << "\n"
               << std::endl;
@@ -533,7 +505,6 @@ int test_all(int argc, char* argv[], util::Logger* logger)
     set_always_encrypt();
 
     fix_max_open_files();
-    fix_async_daemon_path();
 
     display_build_config();
 
@@ -122,6 +122,57 @@ TEST(Alloc_1)
 }
 
 
+TEST(Alloc_FreeSpaceReuseAndStats)
+{
+    SlabAlloc alloc;
+    alloc.attach_empty();
+
+    // Carve the first slab into blocks of increasing size
+    const size_t sizes[] = {64, 128, 256, 512, 1024};
+    MemRef mr[5];
+    for (size_t i = 0; i < 5; ++i) {
+        mr[i] = alloc.alloc(sizes[i]);
+        set_capacity(mr[i].get_addr(), sizes[i]);
+    }
+    SlabAlloc::FreeSpaceStats stats = alloc.get_free_space_stats();
+    CHECK_EQUAL(5, stats.num_allocs);
+    CHECK_EQUAL(1, stats.num_slab_allocs);
+    CHECK_EQUAL(1, stats.num_chunks); // the rest of the slab
+    size_t tail = stats.free_bytes;
+    CHECK_EQUAL(tail, stats.largest_chunk);
+    CHECK_EQUAL(tail + 64 + 128 + 256 + 512 + 1024, stats.slab_bytes);
+
+    // Free every other block, leaving three separate holes
+    alloc.free_(mr[0].get_ref(), mr[0].get_addr());
+    alloc.free_(mr[2].get_ref(), mr[2].get_addr());
+    stats = alloc.get_free_space_stats();
+    CHECK_EQUAL(3, stats.num_chunks);
+    CHECK_EQUAL(tail + 64 + 256, stats.free_bytes);
+
+    // The smallest hole that fits is reused
+    MemRef mr2 = alloc.alloc(200);
+    CHECK_EQUAL(mr[2].get_ref(), mr2.get_ref());
+    set_capacity(mr2.get_addr(), 200);
+    stats = alloc.get_free_space_stats();
+    CHECK_EQUAL(3, stats.num_chunks); // 56 bytes left of the 256 byte hole
+    CHECK_EQUAL(1, stats.num_slab_allocs);
+
+    // Freeing the blocks around a hole merges them all into one chunk with the tail
+    alloc.free_(mr2.get_ref(), mr2.get_addr());
+    alloc.free_(mr[4].get_ref(), mr[4].get_addr());
+    alloc.free_(mr[3].get_ref(), mr[3].get_addr());
+    stats = alloc.get_free_space_stats();
+    CHECK_EQUAL(2, stats.num_chunks);
+    alloc.free_(mr[1].get_ref(), mr[1].get_addr());
+    stats = alloc.get_free_space_stats();
+    CHECK_EQUAL(1, stats.num_chunks);
+    CHECK_EQUAL(stats.slab_bytes, stats.free_bytes);
+    CHECK_EQUAL(stats.slab_bytes, stats.largest_chunk);
+
+    // SlabAlloc destructor will verify that all is free'd
+}
+
+
 TEST(Alloc_AttachFile)
 {
     GROUP_TEST_PATH(path);
@@ -24,8 +24,10 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <limits>
 
 #include <realm/array.hpp>
+#include <realm/alloc_slab.hpp>
 #include <realm/column.hpp>
 #include <realm/query_conditions.hpp>
 
@@ -903,6 +905,299 @@ TEST(Array_find_sse)
 }
 
 
+namespace {
+
+// Runs find() with 'action' and condition 'cond' over [start, size) and checks the result against a plain loop. The
+// arrays are long enough to reach the AVX2/AVX-512 kernels on CPUs that support them, and the varying start offsets
+// exercise the unaligned head and tail.
+template <class cond>
+void check_find_vectorized(TestContext& test_context, const Array& a, const std::vector<int64_t>& ref,
+                           int64_t value, size_t start)
+{
+    cond c;
+    size_t count = 0;
+    int64_t sum = 0;
+    int64_t max = std::numeric_limits<int64_t>::min();
+    int64_t min = std::numeric_limits<int64_t>::max();
+    size_t max_ndx = not_found, min_ndx = not_found, first = not_found;
+    for (size_t i = start; i < ref.size(); ++i) {
+        if (c(ref[i], value)) {
+            if (first == not_found)
+                first = i;
+            ++count;
+            sum += ref[i];
+            if (ref[i] > max) {
+                max = ref[i];
+                max_ndx = i;
+            }
+            if (ref[i] < min) {
+                min = ref[i];
+                min_ndx = i;
+            }
+        }
+    }
+
+    QueryState<int64_t> state;
+    state.init(act_Count, nullptr, size_t(-1));
+    a.find<cond>(act_Count, value, start, ref.size(), 0, &state);
+    CHECK_EQUAL(count, size_t(state.m_state));
+
+    state.init(act_Sum, nullptr, size_t(-1));
+    a.find<cond>(act_Sum, value, start, ref.size(), 0, &state);
+    CHECK_EQUAL(sum, state.m_state);
+    CHECK_EQUAL(count, state.m_match_count);
+
+    state.init(act_Max, nullptr, size_t(-1));
+    a.find<cond>(act_Max, value, start, ref.size(), 0, &state);
+    CHECK_EQUAL(max_ndx, state.m_minmax_index);
+    if (count > 0)
+        CHECK_EQUAL(max, state.m_state);
+
+    state.init(act_Min, nullptr, size_t(-1));
+    a.find<cond>(act_Min, value, start, ref.size(), 0, &state);
+    CHECK_EQUAL(min_ndx, state.m_minmax_index);
+    if (count > 0)
+        CHECK_EQUAL(min, state.m_state);
+
+    state.init(act_ReturnFirst, nullptr, 1);
+    a.find<cond>(act_ReturnFirst, value, start, ref.size(), 0, &state);
+    CHECK_EQUAL(first, size_t(state.m_state));
+
+    // A limit below the number of matches must stop counting exactly at the limit
+    if (count > 3) {
+        state.init(act_Count, nullptr, count - 3);
+        a.find<cond>(act_Count, value, start, ref.size(), 0, &state);
+        CHECK_EQUAL(count - 3, size_t(state.m_state));
+    }
+}
+
+} // anonymous namespace
+
+TEST(Array_FindVectorized)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const int64_t ranges[] = {100, 30000, 2000000000LL, 4000000000000LL}; // 8, 16, 32 and 64 bit widths
+
+    for (int64_t range : ranges) {
+        Array a(Allocator::get_default());
+        a.create(Array::type_Normal);
+        std::vector<int64_t> ref;
+        for (size_t i = 0; i < 700; ++i) {
+            int64_t v = random.draw_int<int64_t>(-range, range);
+            a.add(v);
+            ref.push_back(v);
+        }
+
+        for (size_t start : {size_t(0), size_t(1), size_t(5), size_t(17), size_t(63), size_t(100)}) {
+            int64_t value = ref[random.draw_int_mod(ref.size())];
+            check_find_vectorized<Equal>(test_context, a, ref, value, start);
+            check_find_vectorized<NotEqual>(test_context, a, ref, value, start);
+            check_find_vectorized<Greater>(test_context, a, ref, value, start);
+            check_find_vectorized<Less>(test_context, a, ref, value, start);
+        }
+
+        // Sum, maximum and minimum without a condition also have vectorized paths
+        int64_t max = ref[0], min = ref[0];
+        size_t max_ndx = 0, min_ndx = 0;
+        for (size_t i = 1; i < ref.size(); ++i) {
+            if (ref[i] > max) {
+                max = ref[i];
+                max_ndx = i;
+            }
+            if (ref[i] < min) {
+                min = ref[i];
+                min_ndx = i;
+            }
+        }
+        int64_t res;
+        size_t res_ndx;
+        CHECK(a.maximum(res, 0, size_t(-1), &res_ndx));
+        CHECK_EQUAL(max, res);
+        CHECK_EQUAL(max_ndx, res_ndx);
+        CHECK(a.minimum(res, 0, size_t(-1), &res_ndx));
+        CHECK_EQUAL(min, res);
+        CHECK_EQUAL(min_ndx, res_ndx);
+        int64_t sum = 0;
+        for (size_t i = 3; i < ref.size(); ++i)
+            sum += ref[i];
+        CHECK_EQUAL(sum, a.sum(3, size_t(-1)));
+
+        a.destroy();
+    }
+}
+
+
+TEST(Array_Encoded)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+
+    // Timestamps within a short period of time, ascending ids with gaps, and
+    // negative values close to each other
+    // Encoded leaves require file format version 7
+    SlabAlloc alloc;
+    alloc.attach_empty();
+    alloc.set_file_format_version(7);
+
+    for (int kind = 0; kind < 3; ++kind) {
+        Array a(alloc);
+        a.create(Array::type_Normal);
+        std::vector<int64_t> ref;
+        int64_t id = 4000000000LL;
+        for (size_t i = 0; i < 700; ++i) {
+            int64_t v;
+            if (kind == 0) {
+                v = 1480000000000LL + random.draw_int<int64_t>(0, 100000);
+            }
+            else if (kind == 1) {
+                id += random.draw_int<int64_t>(1, 5);
+                v = id;
+            }
+            else {
+                v = -3000000000LL + random.draw_int<int64_t>(-200, 200);
+            }
+            a.add(v);
+            ref.push_back(v);
+        }
+
+        size_t byte_size = a.get_byte_size();
+        CHECK(a.try_encode());
+        CHECK(a.is_encoded());
+        CHECK_LESS(a.get_byte_size(), byte_size);
+        CHECK(!a.try_encode());
+
+        for (size_t i = 0; i < ref.size(); ++i) {
+            CHECK_EQUAL(ref[i], a.get(i));
+            CHECK_EQUAL(ref[i], Array::get(a.get_mem().get_addr(), i));
+        }
+
+        for (size_t start : {size_t(0), size_t(1), size_t(17), size_t(100)}) {
+            int64_t value = ref[random.draw_int_mod(ref.size())];
+            check_find_vectorized<Equal>(test_context, a, ref, value, start);
+            check_find_vectorized<NotEqual>(test_context, a, ref, value, start);
+            check_find_vectorized<Greater>(test_context, a, ref, value, start);
+            check_find_vectorized<Less>(test_context, a, ref, value, start);
+            // Values outside the range of the array
+            check_find_vectorized<Equal>(test_context, a, ref, ref[0] - 1000000, start);
+            check_find_vectorized<Greater>(test_context, a, ref, ref[0] - 1000000, start);
+            check_find_vectorized<Less>(test_context, a, ref, ref[0] + 1000000, start);
+        }
+
+        int64_t value = ref[5];
+        CHECK_EQUAL(size_t(std::count(ref.begin(), ref.end(), value)), a.count(value));
+        CHECK_EQUAL(0, a.count(value + 1000000));
+
+        int64_t res;
+        size_t res_ndx;
+        CHECK(a.maximum(res, 10, 500, &res_ndx));
+        CHECK_EQUAL(*std::max_element(ref.begin() + 10, ref.begin() + 500), res);
+        CHECK_EQUAL(res, ref[res_ndx]);
+        CHECK(a.minimum(res, 0, size_t(-1), &res_ndx));
+        CHECK_EQUAL(*std::min_element(ref.begin(), ref.end()), res);
+        CHECK_EQUAL(res, ref[res_ndx]);
+        for (size_t start : {size_t(0), size_t(3), size_t(4)}) {
+            int64_t sum = 0;
+            for (size_t i = start; i < ref.size() - 1; ++i)
+                sum += ref[i];
+            CHECK_EQUAL(sum, a.sum(start, ref.size() - 1));
+        }
+
+        if (kind == 1) {
+            for (size_t i : {size_t(0), size_t(1), size_t(350), size_t(699)}) {
+                int64_t v = ref[i];
+                for (int64_t target : {v - 1, v, v + 1}) {
+                    size_t lower = std::lower_bound(ref.begin(), ref.end(), target) - ref.begin();
+                    size_t upper = std::upper_bound(ref.begin(), ref.end(), target) - ref.begin();
+                    CHECK_EQUAL(lower, a.lower_bound_int(target));
+                    CHECK_EQUAL(upper, a.upper_bound_int(target));
+                    CHECK_EQUAL(lower == ref.size() ? not_found : lower, a.find_gte(target, 0));
+                }
+            }
+        }
+
+        // Modifying the array decodes it
+        a.set(7, ref[7] + 1);
+        ++ref[7];
+        CHECK(!a.is_encoded());
+        for (size_t i = 0; i < ref.size(); ++i)
+            CHECK_EQUAL(ref[i], a.get(i));
+
+        a.destroy();
+    }
+}
+
+
+TEST(Array_EncodedModify)
+{
+    SlabAlloc alloc;
+    alloc.attach_empty();
+    alloc.set_file_format_version(7);
+
+    Array a(alloc);
+    a.create(Array::type_Normal);
+    std::vector<int64_t> ref;
+    for (size_t i = 0; i < 200; ++i) {
+        a.add(1000000000000LL + int64_t(i * 3));
+        ref.push_back(1000000000000LL + int64_t(i * 3));
+    }
+
+    // Not in files of an older file format version
+    {
+        Array b(Allocator::get_default());
+        b.init_from_mem(a.clone_deep(Allocator::get_default()));
+        CHECK(!b.try_encode());
+        b.destroy();
+    }
+
+    auto check_values = [&] {
+        CHECK_EQUAL(ref.size(), a.size());
+        for (size_t i = 0; i < ref.size(); ++i)
+            CHECK_EQUAL(ref[i], a.get(i));
+    };
+
+    CHECK(a.try_encode());
+    a.insert(50, 1000000000001LL);
+    ref.insert(ref.begin() + 50, 1000000000001LL);
+    CHECK(!a.is_encoded());
+    check_values();
+
+    CHECK(a.try_encode());
+    a.erase(10);
+    ref.erase(ref.begin() + 10);
+    CHECK(!a.is_encoded());
+    check_values();
+
+    CHECK(a.try_encode());
+    a.adjust_ge(1000000000300LL, 5);
+    for (int64_t& v : ref) {
+        if (v >= 1000000000300LL)
+            v += 5;
+    }
+    CHECK(!a.is_encoded());
+    check_values();
+
+    CHECK(a.try_encode());
+    a.truncate(100);
+    ref.resize(100);
+    CHECK(!a.is_encoded());
+    check_values();
+
+    CHECK(a.try_encode());
+    a.set_all_to_zero();
+    CHECK(!a.is_encoded());
+    for (size_t i = 0; i < a.size(); ++i)
+        CHECK_EQUAL(0, a.get(i));
+
+    // Values that do not fit in fewer bits are left alone
+    a.clear();
+    a.add(std::numeric_limits<int64_t>::min());
+    a.add(std::numeric_limits<int64_t>::max());
+    a.add(0);
+    CHECK(!a.try_encode());
+    CHECK(!a.is_encoded());
+
+    a.destroy();
+}
+
 TEST(Array_Greater)
 {
     Array a(Allocator::get_default());
@@ -181,5 +181,104 @@ TEST(EncryptedFile_LargePages)
     close(fd);
 }
 
+TEST(EncryptedFile_MultiBlockReads)
+{
+    TEST_PATH(path);
+
+    // Three blocks of IV tables, the last one partially filled
+    const size_t num_blocks = 64 * 2 + 10;
+    std::unique_ptr<char[]> data(new char[num_blocks * 4096]);
+    for (size_t i = 0; i < num_blocks * 4096; ++i)
+        data[i] = static_cast<char>(i * 7 + i / 4096);
+
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    {
+        AESCryptor cryptor(test_key);
+        cryptor.set_file_size(num_blocks * 4096);
+        cryptor.write(fd, 0, data.get(), num_blocks * 4096);
+    }
+
+    AESCryptor cryptor(test_key);
+    cryptor.set_file_size(num_blocks * 4096);
+    std::unique_ptr<char[]> buffer(new char[num_blocks * 4096]);
+    CHECK(cryptor.read(fd, 0, buffer.get(), num_blocks * 4096));
+    CHECK(memcmp(buffer.get(), data.get(), num_blocks * 4096) == 0);
+
+    // Ranges that start and end in the middle of an IV table
+    size_t first_block = 60, count = 10;
+    memset(buffer.get(), 0, num_blocks * 4096);
+    CHECK(cryptor.read(fd, first_block * 4096, buffer.get(), count * 4096));
+    CHECK(memcmp(buffer.get(), data.get() + first_block * 4096, count * 4096) == 0);
+    first_block = 100;
+    count = num_blocks - first_block;
+    CHECK(cryptor.read(fd, first_block * 4096, buffer.get(), count * 4096));
+    CHECK(memcmp(buffer.get(), data.get() + first_block * 4096, count * 4096) == 0);
+
+    // Reading beyond the written blocks fails, but still decrypts the ones
+    // that were written
+    memset(buffer.get(), 0, num_blocks * 4096);
+    cryptor.set_file_size((num_blocks + 16) * 4096);
+    first_block = num_blocks - 8;
+    CHECK_NOT(cryptor.read(fd, first_block * 4096, buffer.get(), 16 * 4096));
+    CHECK(memcmp(buffer.get(), data.get() + first_block * 4096, 8 * 4096) == 0);
+
+    close(fd);
+}
+
+TEST(EncryptedFile_MultiBlockWrites)
+{
+    TEST_PATH(path);
+
+    const size_t num_blocks = 64 * 2 + 10;
+    std::unique_ptr<char[]> data(new char[num_blocks * 4096]);
+    for (size_t i = 0; i < num_blocks * 4096; ++i)
+        data[i] = static_cast<char>(i * 7 + i / 4096);
+
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    AESCryptor cryptor(test_key);
+    cryptor.set_file_size(num_blocks * 4096);
+    cryptor.write(fd, 0, data.get(), num_blocks * 4096);
+
+    // Rewrite a range that starts and ends in the middle of an IV table
+    const size_t first_block = 60, count = 70;
+    for (size_t i = first_block * 4096; i < (first_block + count) * 4096; ++i)
+        data[i] = static_cast<char>(i * 3);
+    cryptor.write(fd, first_block * 4096, data.get() + first_block * 4096, count * 4096);
+
+    // Every block is written with a new IV, so a separate cryptor, which
+    // reads the IV tables from the file, sees the same data
+    std::unique_ptr<char[]> buffer(new char[num_blocks * 4096]);
+    {
+        AESCryptor cryptor_2(test_key);
+        cryptor_2.set_file_size(num_blocks * 4096);
+        CHECK(cryptor_2.read(fd, 0, buffer.get(), num_blocks * 4096));
+        CHECK(memcmp(buffer.get(), data.get(), num_blocks * 4096) == 0);
+    }
+
+    // A write that was interrupted after updating the IV tables, but before
+    // writing the data, is detected for each block, and the old data is read
+    auto raw_offset = [](size_t block) {
+        return off_t((block / 64 * 65 + 1 + block % 64) * 4096);
+    };
+    std::unique_ptr<char[]> old_raw(new char[count * 4096]);
+    for (size_t i = 0; i < count; ++i) {
+        ssize_t n = pread(fd, old_raw.get() + i * 4096, 4096, raw_offset(first_block + i));
+        CHECK_EQUAL(n, 4096);
+    }
+    cryptor.write(fd, first_block * 4096, data.get(), count * 4096);
+    for (size_t i = 0; i < count; ++i) {
+        ssize_t n = pwrite(fd, old_raw.get() + i * 4096, 4096, raw_offset(first_block + i));
+        CHECK_EQUAL(n, 4096);
+    }
+    {
+        AESCryptor cryptor_2(test_key);
+        cryptor_2.set_file_size(num_blocks * 4096);
+        CHECK(cryptor_2.read(fd, 0, buffer.get(), num_blocks * 4096));
+        CHECK(memcmp(buffer.get(), data.get(), num_blocks * 4096) == 0);
+    }
+
+    close(fd);
+}
+
 #endif // REALM_ENABLE_ENCRYPTION
 #endif // TEST_ENCRYPTED_FILE_MAPPING
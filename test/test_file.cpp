@@ -198,6 +198,60 @@ TEST(File_ReaderAndWriter)
     }
 }
 
+TEST(File_SequentialScanWithWriter)
+{
+    const size_t count = 4096 / sizeof(size_t) * 256 * 2;
+    const size_t count_per_page = page_size() / sizeof(size_t);
+
+    TEST_PATH(path);
+
+    File writer(path, File::mode_Write);
+    writer.set_encryption_key(crypt_key());
+    writer.resize(count * sizeof(size_t));
+    {
+        File::Map<size_t> write(writer, File::access_ReadWrite, count * sizeof(size_t));
+        realm::util::encryption_read_barrier(write, 0, count);
+        for (size_t i = 0; i < count; ++i)
+            write.get_addr()[i] = i;
+        realm::util::encryption_write_barrier(write, 0, count);
+    }
+
+    File reader(path, File::mode_Read);
+    reader.set_encryption_key(crypt_key());
+    File::Map<size_t> write(writer, File::access_ReadWrite, count * sizeof(size_t));
+    File::Map<size_t> read(reader, File::access_ReadOnly, count * sizeof(size_t));
+
+    // Scan page by page, as a query would, while the writer changes pages
+    // both ahead of the reader and ones that the reader has already seen
+    for (size_t i = 0; i < count; i += count_per_page) {
+        size_t ahead = i + 3 * count_per_page;
+        if (ahead < count) {
+            realm::util::encryption_read_barrier(write, ahead);
+            write.get_addr()[ahead] = ahead + 1;
+            realm::util::encryption_write_barrier(write, ahead);
+        }
+        if (i >= count_per_page) {
+            size_t behind = i - count_per_page + 1;
+            realm::util::encryption_read_barrier(write, behind);
+            write.get_addr()[behind] = behind + 1;
+            realm::util::encryption_write_barrier(write, behind);
+        }
+
+        realm::util::encryption_read_barrier(read, i, count_per_page);
+        for (size_t j = i; j < i + count_per_page; ++j) {
+            size_t expected = j >= 3 * count_per_page && j % count_per_page == 0 ? j + 1 : j;
+            if (!CHECK_EQUAL(read.get_addr()[j], expected))
+                return;
+        }
+        if (i >= count_per_page) {
+            size_t behind = i - count_per_page + 1;
+            realm::util::encryption_read_barrier(read, behind);
+            if (!CHECK_EQUAL(read.get_addr()[behind], behind + 1))
+                return;
+        }
+    }
+}
+
 TEST(File_Offset)
 {
     const size_t size = page_size();
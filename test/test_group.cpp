@@ -1259,6 +1259,70 @@ TEST(Group_Serialize_Optimized)
 }
 
 
+TEST(Group_Serialize_EncodedIntegers)
+{
+    // Timestamps within a short period of time, and ascending ids with gaps,
+    // both of which are stored more compactly once the leaves are encoded
+    Group to_mem;
+    TableRef table = to_mem.add_table("test");
+    table->add_column(type_Int, "time");
+    table->add_column(type_Int, "id");
+    table->add_empty_row(3000);
+    int64_t id = 1000000000;
+    for (size_t i = 0; i < 3000; ++i) {
+        table->set_int(0, i, 1480000000000LL + int64_t(i * 7919 % 3000));
+        table->set_int(1, i, id);
+        id += 1 + int64_t(i % 3);
+    }
+    int64_t sum = table->sum_int(0);
+    size_t count = table->where().greater(0, int64_t(1480000001500LL)).count();
+
+    // The file format version is only raised once a leaf is encoded
+    using gf = _impl::GroupFriend;
+    CHECK_EQUAL(6, gf::get_file_format_version(to_mem));
+    BinaryData plain = to_mem.write_to_mem();
+    bool any_encoded = table->encode_integer_columns();
+    CHECK_EQUAL(any_encoded ? 7 : 6, gf::get_file_format_version(to_mem));
+    BinaryData encoded = to_mem.write_to_mem();
+    // The prefix of an encoded leaf outweighs the savings in tiny leaves
+    if (REALM_MAX_BPNODE_SIZE >= 100) {
+        CHECK(any_encoded);
+        CHECK_LESS(encoded.size(), plain.size() / 2);
+    }
+    std::free(const_cast<char*>(plain.data()));
+
+#ifdef REALM_DEBUG
+    to_mem.verify();
+#endif
+
+    // Load the table
+    Group from_mem(encoded);
+    CHECK_EQUAL(any_encoded ? 7 : 6, gf::get_file_format_version(from_mem));
+    ConstTableRef t = from_mem.get_table("test");
+    CHECK(*table == *t);
+    CHECK_EQUAL(sum, t->sum_int(0));
+    CHECK_EQUAL(count, t->where().greater(0, int64_t(1480000001500LL)).count());
+    CHECK_EQUAL(1480000000000LL, t->minimum_int(0));
+    CHECK_EQUAL(1480000002999LL, t->maximum_int(0));
+    CHECK_EQUAL(2000, t->find_first_int(1, t->get_int(1, 2000)));
+    CHECK_EQUAL(not_found, t->find_first_int(1, 1000000002));
+
+    // Modifying encoded leaves decodes them
+    table->set_int(0, 10, -1);
+    table->insert_empty_row(20);
+    table->set_int(1, 20, 7);
+    table->remove(30);
+    CHECK_EQUAL(-1, table->get_int(0, 10));
+    CHECK_EQUAL(7, table->get_int(1, 20));
+    CHECK_EQUAL(t->get_int(1, 31), table->get_int(1, 31));
+    CHECK_EQUAL(t->get_int(0, 2999), table->get_int(0, 2999));
+
+#ifdef REALM_DEBUG
+    to_mem.verify();
+    from_mem.verify();
+#endif
+}
+
 TEST(Group_Serialize_All)
 {
     // Create group with one table
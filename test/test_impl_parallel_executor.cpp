@@ -0,0 +1,136 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+#include <realm/impl/parallel_executor.hpp>
+
+#include "test.hpp"
+
+using namespace realm;
+using namespace realm::_impl;
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+//
+// Another way to debug a particular test, is to copy that test into
+// `experiments/testcase.cpp` and then run `sh build.sh
+// check-testcase` (or one of its friends) from the command line.
+
+namespace {
+
+TEST(Impl_ParallelExecutor_EveryTaskOnce)
+{
+    const size_t num_threads = 4;
+    ParallelExecutor executor(num_threads);
+    CHECK_EQUAL(num_threads, executor.get_num_threads());
+
+    // Several batches of different sizes, including fewer tasks than threads
+    const size_t batch_sizes[] = {0, 1, 3, 4, 5, 100, 1000};
+    for (size_t num_tasks : batch_sizes) {
+        std::unique_ptr<std::atomic<int>[]> runs(new std::atomic<int>[num_tasks]);
+        for (size_t i = 0; i < num_tasks; ++i)
+            runs[i] = 0;
+        std::atomic<bool> bad_thread_ndx(false);
+        auto task = [&](size_t task_ndx, size_t thread_ndx) {
+            if (thread_ndx >= num_threads)
+                bad_thread_ndx = true;
+            ++runs[task_ndx];
+        };
+        executor.run(num_tasks, task);
+        CHECK(!bad_thread_ndx);
+        for (size_t i = 0; i < num_tasks; ++i)
+            CHECK_EQUAL(1, runs[i].load());
+    }
+}
+
+
+TEST(Impl_ParallelExecutor_MaxThreads)
+{
+    ParallelExecutor executor(4);
+    std::atomic<size_t> max_thread_ndx(0);
+    std::atomic<size_t> num_runs(0);
+    auto task = [&](size_t, size_t thread_ndx) {
+        size_t prev = max_thread_ndx;
+        while (thread_ndx > prev && !max_thread_ndx.compare_exchange_weak(prev, thread_ndx)) {
+        }
+        ++num_runs;
+    };
+
+    // Only the calling thread
+    executor.run(100, task, 1);
+    CHECK_EQUAL(0, max_thread_ndx.load());
+    CHECK_EQUAL(100, num_runs.load());
+
+    executor.run(100, task, 2);
+    CHECK_LESS_EQUAL(max_thread_ndx.load(), 1);
+    CHECK_EQUAL(200, num_runs.load());
+
+    // An executor with a single thread never starts any worker threads
+    ParallelExecutor serial_executor(0);
+    CHECK_EQUAL(1, serial_executor.get_num_threads());
+    max_thread_ndx = 0;
+    serial_executor.run(100, task);
+    CHECK_EQUAL(0, max_thread_ndx.load());
+    CHECK_EQUAL(300, num_runs.load());
+}
+
+
+TEST(Impl_ParallelExecutor_Exception)
+{
+    ParallelExecutor executor(3);
+    std::atomic<size_t> num_runs(0);
+    auto task = [&](size_t task_ndx, size_t) {
+        ++num_runs;
+        if (task_ndx == 17)
+            throw std::runtime_error("task 17");
+    };
+    CHECK_THROW(executor.run(1000, task), std::runtime_error);
+    CHECK_GREATER_EQUAL(num_runs.load(), 1);
+
+    // The executor remains usable after a failed batch
+    num_runs = 0;
+    executor.run(1000, [&](size_t, size_t) { ++num_runs; });
+    CHECK_EQUAL(1000, num_runs.load());
+}
+
+} // unnamed namespace
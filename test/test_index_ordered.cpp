@@ -0,0 +1,538 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include "testsettings.hpp"
+#ifdef TEST_INDEX_ORDERED
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <realm.hpp>
+#include <realm/history.hpp>
+#include <realm/index_ordered.hpp>
+#include <realm/lang_bind_helper.hpp>
+
+#include "test.hpp"
+#include "util/crypt_key.hpp"
+#include "util/random.hpp"
+
+using namespace realm;
+using namespace realm::util;
+using namespace realm::test_util;
+using unit_test::TestContext;
+
+// Test independence and thread-safety
+// -----------------------------------
+//
+// All tests must be thread safe and independent of each other. This
+// is required because it allows for both shuffling of the execution
+// order and for parallelized testing.
+//
+// In particular, avoid using std::rand() since it is not guaranteed
+// to be thread safe. Instead use the API offered in
+// `test/util/random.hpp`.
+//
+// All files created in tests must use the TEST_PATH macro (or one of
+// its friends) to obtain a suitable file system path. See
+// `test/util/test_path.hpp`.
+//
+//
+// Debugging and the ONLY() macro
+// ------------------------------
+//
+// A simple way of disabling all tests except one called `Foo`, is to
+// replace TEST(Foo) with ONLY(Foo) and then recompile and rerun the
+// test suite. Note that you can also use filtering by setting the
+// environment varible `UNITTEST_FILTER`. See `README.md` for more on
+// this.
+//
+// Another way to debug a particular test, is to copy that test into
+// `experiments/testcase.cpp` and then run `sh build.sh
+// check-testcase` (or one of its friends) from the command line.
+
+
+namespace {
+
+enum { col_int, col_int_null, col_double, col_timestamp, num_cols };
+
+void add_columns(Table& table)
+{
+    table.add_column(type_Int, "int");
+    table.add_column(type_Int, "int_null", true);
+    table.add_column(type_Double, "double", true);
+    table.add_column(type_Timestamp, "timestamp", true);
+    for (size_t col_ndx = 0; col_ndx < num_cols; ++col_ndx)
+        table.add_ordered_index(col_ndx);
+}
+
+bool get_key(const Table& table, size_t col_ndx, size_t row_ndx, OrderedIndex::Key& key)
+{
+    if (table.is_null(col_ndx, row_ndx))
+        return false;
+    switch (col_ndx) {
+        case col_int:
+        case col_int_null:
+            return OrderedIndex::get_key(table.get_int(col_ndx, row_ndx), key);
+        case col_double:
+            return OrderedIndex::get_key(table.get_double(col_ndx, row_ndx), key);
+        default:
+            return OrderedIndex::get_key(table.get_timestamp(col_ndx, row_ndx), key);
+    }
+}
+
+// Check that the index of each column has exactly one entry for each non-null
+// row, with the key of its value.
+void check_indexes(TestContext& test_context, const Table& table)
+{
+    for (size_t col_ndx = 0; col_ndx < num_cols; ++col_ndx) {
+        const OrderedIndex* index = table.get_ordered_index(col_ndx);
+        if (!CHECK(index))
+            return;
+        index->verify(table.size());
+        size_t num_indexed = 0;
+        for (size_t row_ndx = 0; row_ndx < table.size(); ++row_ndx) {
+            OrderedIndex::Key key;
+            if (get_key(table, col_ndx, row_ndx, key))
+                ++num_indexed;
+        }
+        CHECK_EQUAL(num_indexed, index->size());
+        index->for_each(0, index->size(), [&](const OrderedIndex::Entry& entry) {
+            OrderedIndex::Key key;
+            CHECK(get_key(table, col_ndx, entry.row_ndx, key));
+            CHECK(key == entry.key);
+        });
+    }
+}
+
+void set_row(Table& table, size_t row_ndx, int64_t value, bool is_null = false)
+{
+    table.set_int(col_int, row_ndx, value);
+    if (is_null) {
+        table.set_null(col_int_null, row_ndx);
+        table.set_null(col_double, row_ndx);
+        table.set_null(col_timestamp, row_ndx);
+    }
+    else {
+        table.set_int(col_int_null, row_ndx, value);
+        table.set_double(col_double, row_ndx, value / 4.0);
+        table.set_timestamp(col_timestamp, row_ndx, Timestamp(value / 3, int32_t(value % 3) * 1000));
+    }
+}
+
+void set_row(Table& table, size_t row_ndx, Random& random)
+{
+    int64_t value = random.draw_int<int64_t>(-10, 10);
+    bool is_null = random.chance(1, 5);
+    set_row(table, row_ndx, value, is_null);
+}
+
+} // anonymous namespace
+
+
+TEST(OrderedIndex_Keys)
+{
+    auto key = [](double value) {
+        OrderedIndex::Key k;
+        bool indexed = OrderedIndex::get_key(value, k);
+        REALM_ASSERT(indexed);
+        static_cast<void>(indexed);
+        return k;
+    };
+    double values[] = {-std::numeric_limits<double>::infinity(),
+                       -1e300,
+                       -2.5,
+                       -1,
+                       -std::numeric_limits<double>::denorm_min(),
+                       0,
+                       std::numeric_limits<double>::denorm_min(),
+                       1,
+                       2.5,
+                       1e300,
+                       std::numeric_limits<double>::infinity()};
+    for (size_t i = 1; i < sizeof values / sizeof values[0]; ++i)
+        CHECK(key(values[i - 1]) < key(values[i]));
+    CHECK(key(-0.0) == key(0.0));
+
+    OrderedIndex::Key k;
+    CHECK(!OrderedIndex::get_key(std::numeric_limits<double>::quiet_NaN(), k));
+    CHECK(!OrderedIndex::get_key(null::get_null_float<double>(), k));
+    CHECK(!OrderedIndex::get_key(null::get_null_float<float>(), k));
+    CHECK(!OrderedIndex::get_key(util::Optional<int64_t>(), k));
+    CHECK(!OrderedIndex::get_key(Timestamp(), k));
+
+    OrderedIndex::Key a, b;
+    OrderedIndex::get_key(Timestamp(-1, -1), a);
+    OrderedIndex::get_key(Timestamp(-1, 0), b);
+    CHECK(a < b);
+    OrderedIndex::get_key(Timestamp(0, -1), a);
+    CHECK(b < a);
+    CHECK(OrderedIndex::next(a) == OrderedIndex::prev(OrderedIndex::next(OrderedIndex::next(a))));
+    OrderedIndex::get_key(Timestamp(0, 0), b);
+    CHECK(a < b);
+    CHECK(OrderedIndex::next(a) == b);
+    OrderedIndex::get_key(Timestamp(0, 1), a);
+    CHECK(b < a);
+    CHECK(OrderedIndex::next(b) == a);
+    CHECK(OrderedIndex::prev(a) == b);
+
+    OrderedIndex::get_key(int64_t(5), a);
+    CHECK(OrderedIndex::prev(a) < a);
+    CHECK(a < OrderedIndex::next(a));
+    OrderedIndex::get_key(int64_t(4), b);
+    CHECK(b < OrderedIndex::prev(a));
+}
+
+
+TEST(OrderedIndex_Maintenance)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+
+    Table table;
+    add_columns(table);
+    CHECK(table.has_ordered_index(col_int));
+    CHECK(!table.has_ordered_index(num_cols));
+    CHECK(!table.get_ordered_index(num_cols));
+
+    // Unsupported column types
+    table.add_column(type_String, "string");
+    CHECK_LOGIC_ERROR(table.add_ordered_index(num_cols), LogicError::illegal_combination);
+    CHECK_LOGIC_ERROR(table.add_ordered_index(num_cols + 1), LogicError::column_index_out_of_range);
+
+    for (int i = 0; i < 200; ++i) {
+        size_t size = table.size();
+        switch (random.draw_int_mod(8)) {
+            case 0:
+            case 1: {
+                size_t row_ndx = table.add_empty_row(random.draw_int<size_t>(1, 3));
+                set_row(table, row_ndx, random);
+                break;
+            }
+            case 2: {
+                size_t row_ndx = random.draw_int<size_t>(0, size);
+                table.insert_empty_row(row_ndx, random.draw_int<size_t>(1, 3));
+                set_row(table, row_ndx, random);
+                break;
+            }
+            case 3:
+                if (size > 0)
+                    set_row(table, random.draw_int_mod(size), random);
+                break;
+            case 4:
+                if (size > 0)
+                    table.remove(random.draw_int_mod(size));
+                break;
+            case 5:
+                if (size > 0)
+                    table.move_last_over(random.draw_int_mod(size));
+                break;
+            case 6:
+                if (size > 1) {
+                    size_t row_ndx_1 = random.draw_int_mod(size);
+                    size_t row_ndx_2 = (row_ndx_1 + 1 + random.draw_int_mod(size - 1)) % size;
+                    table.swap_rows(row_ndx_1, row_ndx_2);
+                }
+                break;
+            case 7:
+                if (size > 0)
+                    table.add_int(col_int, random.draw_int_mod(size), 3);
+                break;
+        }
+        check_indexes(test_context, table);
+    }
+
+    table.clear();
+    check_indexes(test_context, table);
+    table.add_empty_row(10);
+    check_indexes(test_context, table);
+
+    table.remove_ordered_index(col_int);
+    CHECK(!table.has_ordered_index(col_int));
+    CHECK(!table.get_ordered_index(col_int));
+}
+
+
+TEST(OrderedIndex_SortedIteration)
+{
+    Table table;
+    table.add_column(type_Double, "double");
+    table.add_ordered_index(0);
+    double values[] = {3.5, -1, 7, 0, -1, 2};
+    for (double value : values)
+        table.set_double(0, table.add_empty_row(), value);
+
+    const OrderedIndex* index = table.get_ordered_index(0);
+    size_t expected[] = {1, 4, 3, 5, 0, 2};
+    if (CHECK_EQUAL(6, index->size())) {
+        for (size_t i = 0; i < 6; ++i)
+            CHECK_EQUAL(expected[i], index->get(i).row_ndx);
+    }
+    size_t i = 2;
+    index->for_each(2, 4, [&](const OrderedIndex::Entry& entry) {
+        CHECK_EQUAL(expected[i], entry.row_ndx);
+        ++i;
+    });
+    CHECK_EQUAL(4, i);
+
+    OrderedIndex::Key first, last;
+    OrderedIndex::get_key(-1.0, first);
+    OrderedIndex::get_key(2.0, last);
+    CHECK_EQUAL(4, index->count(first, last));
+    CHECK_EQUAL(0, index->lower_bound(first));
+    CHECK_EQUAL(4, index->upper_bound(last));
+    std::vector<size_t> rows;
+    index->find_all(first, last, rows);
+    std::vector<size_t> expected_rows = {1, 3, 4, 5};
+    CHECK(rows == expected_rows);
+    CHECK_EQUAL(0, index->count(last, first));
+}
+
+
+TEST(OrderedIndex_Query)
+{
+    const size_t num_rows = 2000;
+
+    Table table;
+    add_columns(table);
+    table.add_column(type_Float, "float");
+    table.add_ordered_index(num_cols);
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        int64_t value = int64_t(i * 7919 % num_rows); // A permutation
+        table.set_int(col_int, i, value);
+        if (i % 10 != 0)
+            table.set_int(col_int_null, i, value);
+        table.set_double(col_double, i, value - 0.5);
+        table.set_timestamp(col_timestamp, i, Timestamp(value, int32_t(i)));
+        table.set_float(num_cols, i, float(value));
+    }
+
+    // The same queries with and without the ordered indexes
+    std::vector<size_t> counts;
+    std::vector<int64_t> sums;
+    for (int with_index = 1; with_index >= 0; --with_index) {
+        if (!with_index) {
+            for (size_t col_ndx = 0; col_ndx <= num_cols; ++col_ndx)
+                table.remove_ordered_index(col_ndx);
+        }
+        std::vector<size_t> c;
+        std::vector<int64_t> s;
+        c.push_back(table.where().greater(col_int, 1990).count());
+        c.push_back(table.where().less_equal(col_int, 5).count());
+        c.push_back(table.where().between(col_int, 100, 130).count());
+        c.push_back(table.where().between(col_int, 130, 100).count());
+        c.push_back(table.where().equal(col_int, 77).count());
+        c.push_back(table.where().between(col_int_null, 500, 540).count());
+        c.push_back(table.where().greater_equal(col_double, 1995.5).count());
+        c.push_back(table.where().less(col_double, 3.0).count());
+        c.push_back(table.where().between(col_double, 10.0, 20.0).count());
+        c.push_back(table.where().greater(col_timestamp, Timestamp(1990, 0)).count());
+        c.push_back(table.where().less(col_timestamp, Timestamp(3, 0)).count());
+        c.push_back(table.where().greater(num_cols, 1995.5f).count());
+        c.push_back(table.where().between(col_int, 100, 400).equal(col_int_null, null()).count());
+        c.push_back(table.where().less(col_int, 50).greater(col_double, 20.0).count());
+        c.push_back(table.where().less(col_int, 50).Or().greater(col_int, 1950).count());
+        s.push_back(table.where().between(col_int, 100, 130).sum_int(col_int));
+        s.push_back(table.where().less(col_double, 10.0).sum_int(col_int));
+        s.push_back(table.where().less(col_int, 10).maximum_int(col_int_null));
+
+        TableView tv = table.where().between(col_int, 1000, 1010).find_all();
+        CHECK_EQUAL(11, tv.size());
+        for (size_t i = 1; i < tv.size(); ++i)
+            CHECK_LESS(tv.get_source_ndx(i - 1), tv.get_source_ndx(i));
+        size_t row_ndx = table.where().equal(col_int, 1234).find();
+        CHECK_EQUAL(1234, table.get_int(col_int, row_ndx));
+
+        if (with_index) {
+            counts = c;
+            sums = s;
+        }
+        else {
+            CHECK(counts == c);
+            CHECK(sums == s);
+        }
+    }
+    CHECK_EQUAL(9, counts[0]);
+    CHECK_EQUAL(6, counts[1]);
+    CHECK_EQUAL(31, counts[2]);
+    CHECK_EQUAL(0, counts[3]);
+    CHECK_EQUAL(1, counts[4]);
+    CHECK_EQUAL(115 * 31, sums[0]);
+}
+
+
+TEST(OrderedIndex_SearchIndexExclusive)
+{
+    Table table;
+    table.add_column(type_Int, "a");
+    table.add_column(type_Int, "b");
+    table.add_search_index(0);
+    CHECK_LOGIC_ERROR(table.add_ordered_index(0), LogicError::illegal_combination);
+    CHECK(!table.has_ordered_index(0));
+    table.add_ordered_index(1);
+    CHECK_LOGIC_ERROR(table.add_search_index(1), LogicError::illegal_combination);
+    CHECK(!table.has_search_index(1));
+
+    table.remove_search_index(0);
+    table.add_ordered_index(0);
+    CHECK(table.has_ordered_index(0));
+    CHECK(table.has_ordered_index(1));
+}
+
+
+TEST(OrderedIndex_InsertRemoveColumns)
+{
+    Table table;
+    table.add_column(type_Int, "a");
+    table.add_column(type_Double, "b");
+    table.add_ordered_index(0);
+    table.add_ordered_index(1);
+    table.add_empty_row(10);
+    for (size_t i = 0; i < 10; ++i) {
+        table.set_int(0, i, int64_t(10 - i));
+        table.set_double(1, i, double(i));
+    }
+
+    // The indexes follow their columns to their new positions
+    table.insert_column(0, type_Int, "c");
+    table.add_search_index(0);
+    table.insert_column(2, type_String, "d");
+    CHECK(!table.has_ordered_index(0));
+    CHECK(table.has_ordered_index(1));
+    CHECK(table.has_ordered_index(3));
+    table.verify();
+    CHECK_EQUAL(3, table.where().less(1, 4).count());
+    CHECK_EQUAL(4, table.where().less(3, 4.0).count());
+
+    table.remove_column(1);
+    CHECK(table.has_search_index(0));
+    CHECK(!table.has_ordered_index(1));
+    CHECK(table.has_ordered_index(2));
+    table.verify();
+    CHECK_EQUAL(5, table.where().greater_equal(2, 5.0).count());
+    table.add_empty_row();
+    CHECK_EQUAL(11, table.get_ordered_index(2)->size());
+}
+
+
+TEST(OrderedIndex_Persistence)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    using sgf = _impl::SharedGroupFriend;
+    {
+        SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+        {
+            WriteTransaction wt(sg);
+            TableRef table = wt.add_table("table");
+            add_columns(*table);
+            table->add_empty_row(100);
+            for (size_t i = 0; i < 100; ++i)
+                set_row(*table, i, int64_t(99 - i), i % 10 == 0);
+            wt.commit();
+        }
+        // Older versions of the library cannot read files with ordered indexes
+        CHECK_EQUAL(7, sgf::get_file_format_version(sg));
+        {
+            WriteTransaction wt(sg);
+            TableRef table = wt.get_table("table");
+            table->remove(0);
+            table->insert_empty_row(50);
+            set_row(*table, 50, 1000);
+            table->move_last_over(10);
+            wt.commit();
+        }
+    }
+
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    CHECK_EQUAL(7, sgf::get_file_format_version(sg));
+    ReadTransaction rt(sg);
+    ConstTableRef table = rt.get_table("table");
+    for (size_t col_ndx = 0; col_ndx < num_cols; ++col_ndx)
+        CHECK(table->has_ordered_index(col_ndx));
+    check_indexes(test_context, *table);
+    CHECK_EQUAL(50, table->where().equal(col_int, 1000).find());
+    CHECK_EQUAL(10, table->where().less(col_int, 10).count());
+}
+
+
+TEST(OrderedIndex_AdvanceRead)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+    std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+    SharedGroup sg_w(*hist_w, SharedGroupOptions(crypt_key()));
+    {
+        WriteTransaction wt(sg_w);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_Int, "a");
+        table->add_column(type_Int, "b");
+        table->add_empty_row(100);
+        for (size_t i = 0; i < 100; ++i) {
+            table->set_int(0, i, int64_t(i));
+            table->set_int(1, i, int64_t(i));
+        }
+        wt.commit();
+    }
+
+    ReadTransaction rt(sg);
+    ConstTableRef table = rt.get_table("table");
+    CHECK(!table->has_ordered_index(0));
+
+    // The index added by another session is found in the file
+    {
+        WriteTransaction wt(sg_w);
+        wt.get_table("table")->add_ordered_index(0);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    CHECK(table->has_ordered_index(0));
+    CHECK_EQUAL(5, table->where().less(0, 5).count());
+    CHECK_EQUAL(5, table->where().less(1, 5).count());
+
+    {
+        WriteTransaction wt(sg_w);
+        TableRef table_w = wt.get_table("table");
+        for (size_t i = 0; i < 10; ++i)
+            table_w->set_int(0, i, 1000);
+        table_w->insert_empty_row(0);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    CHECK_EQUAL(1, table->where().less(0, 5).count());
+    CHECK_EQUAL(10, table->where().equal(0, 1000).count());
+    CHECK_EQUAL(1, table->where().equal(0, 1000).find());
+    CHECK_EQUAL(6, table->where().less(1, 5).count());
+    const OrderedIndex* index = table->get_ordered_index(0);
+    if (CHECK(index)) {
+        index->verify(table->size());
+        CHECK_EQUAL(table->size(), index->size());
+    }
+
+    {
+        WriteTransaction wt(sg_w);
+        wt.get_table("table")->remove_ordered_index(0);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    CHECK(!table->has_ordered_index(0));
+    CHECK_EQUAL(10, table->where().equal(0, 1000).count());
+    table->verify();
+}
+
+#endif // TEST_INDEX_ORDERED
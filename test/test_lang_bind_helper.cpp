@@ -34,6 +34,7 @@
 #include <realm/util/to_string.hpp>
 #include <realm/replication.hpp>
 #include <realm/history.hpp>
+#include <realm/changeset_cursor.hpp>
 
 // Need fork() and waitpid() for Shared_RobustAgainstDeathDuringWrite
 #ifndef _WIN32
@@ -1289,6 +1290,270 @@ TEST(LangBindHelper_AdvanceReadTransact_EnumeratedStrings)
 }
 
 
+TEST(LangBindHelper_AdvanceReadTransact_AutoOptimize)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    ShortCircuitHistory hist(path);
+    SharedGroup sg(hist, SharedGroupOptions(crypt_key()));
+    SharedGroupOptions options(crypt_key());
+    options.auto_optimize = true;
+    SharedGroup sg_w(hist, options);
+
+    // Start a read transaction (to be repeatedly advanced)
+    ReadTransaction rt(sg);
+    const Group& group = rt.get_group();
+
+    // Tables that are too small are left alone
+    {
+        WriteTransaction wt(sg_w);
+        TableRef table_w = wt.add_table("small");
+        table_w->add_column(type_String, "a");
+        table_w->add_empty_row(10);
+        wt.commit();
+    }
+
+    const size_t num_rows = 2000;
+    {
+        WriteTransaction wt(sg_w);
+        TableRef table_w = wt.add_table("t");
+        table_w->add_column(type_String, "a");
+        table_w->add_column(type_String, "b");
+        table_w->add_column(type_String, "c");
+        table_w->add_search_index(1);
+        table_w->add_empty_row(num_rows);
+        for (size_t i = 0; i < num_rows; ++i) {
+            std::string str = util::to_string(i);
+            table_w->set_string(0, i, str);
+            table_w->set_string(1, i, i % 3 == 0 ? "foo" : "bar");
+            table_w->set_string(2, i, "baz");
+        }
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    group.verify();
+    ConstTableRef table = group.get_table("t");
+    ConstDescriptorRef desc = table->get_descriptor();
+    CHECK_EQUAL(0, group.get_table("small")->get_descriptor()->get_num_unique_values(0));
+    CHECK_EQUAL(0, desc->get_num_unique_values(0));
+    CHECK_EQUAL(2, desc->get_num_unique_values(1));
+    CHECK_EQUAL(1, desc->get_num_unique_values(2));
+
+    // A few writes are not enough to reconsider the table
+    {
+        WriteTransaction wt(sg_w);
+        TableRef table_w = wt.get_table("t");
+        for (size_t i = 0; i < 10; ++i) {
+            std::string str = util::to_string(i);
+            table_w->set_string(1, i, str);
+        }
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    group.verify();
+    CHECK_EQUAL(12, desc->get_num_unique_values(1));
+
+    // As the values become distinct, the column is no longer enumerated. The
+    // writes of several transactions add up, and the table is reconsidered
+    // after the second and the fourth one. They still add up when the index of
+    // the table changes in between.
+    for (size_t k = 0; k < 4; ++k) {
+        {
+            WriteTransaction wt(sg_w);
+            if (k == 3)
+                wt.get_group().remove_table("small");
+            TableRef table_w = wt.get_table("t");
+            for (size_t i = k * 400; i < (k + 1) * 400; ++i) {
+                std::string str = util::to_string(num_rows - i);
+                table_w->set_string(1, i, str);
+            }
+            wt.commit();
+        }
+        LangBindHelper::advance_read(sg);
+        group.verify();
+        if (k < 3) {
+            CHECK_EQUAL(12 + (k + 1) * 400, desc->get_num_unique_values(1));
+        }
+        else {
+            CHECK_EQUAL(0, desc->get_num_unique_values(1));
+        }
+    }
+    CHECK_EQUAL(0, desc->get_num_unique_values(0));
+    CHECK_EQUAL(1, desc->get_num_unique_values(2));
+    CHECK_EQUAL(5, table->find_first_string(1, "1995"));
+    CHECK_EQUAL(1602, table->find_first_string(1, "foo"));
+    CHECK_EQUAL("baz", table->get_string(2, 7));
+
+    // Table::add_rows() only counts the values of the string columns that it
+    // is given
+    {
+        WriteTransaction wt(sg_w);
+        TableRef table_w = wt.add_table("bulk");
+        table_w->add_column(type_Int, "int");
+        table_w->add_column(type_String, "string");
+        table_w->add_empty_row(num_rows);
+        for (size_t i = 0; i < num_rows; ++i) {
+            std::string str = util::to_string(i);
+            table_w->set_string(1, i, str);
+        }
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg_w);
+        wt.get_table("bulk")->optimize(true);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    ConstDescriptorRef bulk_desc = group.get_table("bulk")->get_descriptor();
+    CHECK_EQUAL(num_rows, bulk_desc->get_num_unique_values(1));
+    std::vector<int64_t> ints(num_rows / 2, 7);
+    std::vector<std::string> string_values;
+    std::vector<StringData> strings;
+    for (size_t i = 0; i < num_rows / 2; ++i)
+        string_values.push_back("x" + util::to_string(i));
+    for (const std::string& str : string_values)
+        strings.push_back(str);
+    {
+        WriteTransaction wt(sg_w);
+        std::vector<BulkColumn> columns;
+        columns.emplace_back(0, ints.data());
+        wt.get_table("bulk")->add_rows(num_rows / 2, columns);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    group.verify();
+    CHECK_EQUAL(num_rows + 1, bulk_desc->get_num_unique_values(1));
+    {
+        WriteTransaction wt(sg_w);
+        std::vector<BulkColumn> columns;
+        columns.emplace_back(0, ints.data());
+        columns.emplace_back(1, strings.data());
+        wt.get_table("bulk")->add_rows(num_rows / 2, columns);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    group.verify();
+    CHECK_EQUAL(0, bulk_desc->get_num_unique_values(1));
+}
+
+
+TEST(LangBindHelper_ChangesetCursor)
+{
+    using Kind = ChangesetBatch::Kind;
+
+    SHARED_GROUP_TEST_PATH(path);
+    ShortCircuitHistory hist(path);
+    SharedGroup sg(hist, SharedGroupOptions(crypt_key()));
+    SharedGroup sg_w(hist, SharedGroupOptions(crypt_key()));
+
+    ReadTransaction rt(sg);
+    auto version_1 = sg.get_version_of_current_transaction().version;
+
+    {
+        WriteTransaction wt(sg_w);
+        TableRef table_w = wt.add_table("t");
+        table_w->add_column(type_Int, "i");
+        table_w->add_column_link(type_LinkList, "l", *table_w);
+        DescriptorRef subdesc;
+        table_w->add_column(type_Table, "s", &subdesc);
+        subdesc->add_column(type_Int, "x");
+        table_w->add_empty_row(10);
+        for (size_t i = 2; i < 6; ++i)
+            table_w->set_int(0, i, 7);
+        table_w->set_int(0, 2, 8);
+        LinkViewRef links = table_w->get_linklist(1, 3);
+        links->add(0);
+        links->add(1);
+        TableRef subtable_w = table_w->get_subtable(2, 4);
+        subtable_w->add_empty_row();
+        subtable_w->set_int(0, 0, 1);
+        table_w->move_last_over(8);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    auto version_2 = sg.get_version_of_current_transaction().version;
+
+    std::unique_ptr<ChangesetBatch> batch(new ChangesetBatch);
+    {
+        ChangesetCursor cursor(hist, version_1, version_2);
+        CHECK(cursor.next(*batch));
+        CHECK_EQUAL(10, batch->size);
+
+        CHECK(batch->kind[0] == Kind::insert_table);
+        CHECK_EQUAL(0, batch->table[0]);
+
+        CHECK(batch->kind[1] == Kind::insert_column);
+        CHECK_EQUAL(0, batch->col[1]);
+        CHECK(batch->kind[2] == Kind::insert_column);
+        CHECK_EQUAL(1, batch->col[2]);
+        CHECK(batch->kind[3] == Kind::insert_column);
+        CHECK_EQUAL(2, batch->col[3]);
+
+        CHECK(batch->kind[4] == Kind::subtable);
+        CHECK_EQUAL(2, batch->col[4]);
+        CHECK_EQUAL(npos, batch->row[4]);
+
+        CHECK(batch->kind[5] == Kind::insert_rows);
+        CHECK_EQUAL(0, batch->row[5]);
+        CHECK_EQUAL(10, batch->count[5]);
+
+        CHECK(batch->kind[6] == Kind::set);
+        CHECK_EQUAL(0, batch->col[6]);
+        CHECK_EQUAL(2, batch->row[6]);
+        CHECK_EQUAL(4, batch->count[6]);
+
+        CHECK(batch->kind[7] == Kind::link_list);
+        CHECK_EQUAL(1, batch->col[7]);
+        CHECK_EQUAL(3, batch->row[7]);
+
+        CHECK(batch->kind[8] == Kind::subtable);
+        CHECK_EQUAL(2, batch->col[8]);
+        CHECK_EQUAL(4, batch->row[8]);
+
+        CHECK(batch->kind[9] == Kind::move_last_over);
+        CHECK_EQUAL(8, batch->row[9]);
+        CHECK_EQUAL(9, batch->other[9]);
+
+        for (size_t i = 1; i < batch->size; ++i)
+            CHECK_EQUAL(0, batch->table[i]);
+
+        CHECK_NOT(cursor.next(*batch));
+        CHECK_EQUAL(0, batch->size);
+    }
+
+    // Changes that do not fit in one batch are spread over several
+    const size_t num_sets = ChangesetBatch::capacity + 100;
+    {
+        WriteTransaction wt(sg_w);
+        TableRef table_w = wt.get_table("t");
+        size_t num_rows = table_w->size();
+        table_w->add_empty_row(2 * num_sets);
+        for (size_t i = 0; i < num_sets; ++i)
+            table_w->set_int(0, num_rows + 2 * i, 1);
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    auto version_3 = sg.get_version_of_current_transaction().version;
+    {
+        ChangesetCursor cursor(hist, version_2, version_3);
+        size_t num_changes = 0;
+        while (cursor.next(*batch)) {
+            CHECK(batch->size <= ChangesetBatch::capacity);
+            num_changes += batch->size;
+        }
+        CHECK_EQUAL(1 + num_sets, num_changes);
+    }
+
+    // Several changesets at once
+    {
+        ChangesetCursor cursor(hist, version_1, version_3);
+        size_t num_changes = 0;
+        while (cursor.next(*batch))
+            num_changes += batch->size;
+        CHECK_EQUAL(10 + 1 + num_sets, num_changes);
+    }
+}
+
+
 TEST(LangBindHelper_AdvanceReadTransact_SearchIndex)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -7718,6 +7983,14 @@ public:
     {
         return false;
     }
+    bool add_ordered_index(size_t)
+    {
+        return false;
+    }
+    bool remove_ordered_index(size_t)
+    {
+        return false;
+    }
     bool add_primary_key(size_t)
     {
         return false;
@@ -7846,6 +8119,10 @@ public:
     {
         return false;
     }
+    bool unenumerate_string_columns()
+    {
+        return false;
+    }
 };
 
 struct AdvanceReadTransact {
@@ -20,6 +20,7 @@
 #ifdef TEST_QUERY
 
 #include <cstdlib> // itoa()
+#include <functional>
 #include <initializer_list>
 #include <limits>
 #include <vector>
@@ -5230,6 +5231,56 @@ TEST(Query_Enums)
 }
 
 
+// String conditions on an enumerated column are evaluated per key, and must
+// give the same results as on a plain string column
+TEST(Query_EnumStringConditions)
+{
+    const char* values[] = {"apple", "Pineapple", "APPLE pie", "banana", "", "cherry", "Applet"};
+    size_t num_values = sizeof values / sizeof values[0];
+
+    Table plain;
+    plain.add_column(type_String, "s", true);
+    size_t num_rows = REALM_MAX_BPNODE_SIZE * 3 + 17;
+    plain.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (i % 11 == 3)
+            plain.set_null(0, i);
+        else
+            plain.set_string(0, i, values[(i * 7 + i / 5) % num_values]);
+    }
+    Table enumerated = plain;
+    enumerated.optimize(true);
+
+    auto check = [&](Query (*make)(Table&, StringData), StringData value) {
+        Query q1 = make(plain, value);
+        Query q2 = make(enumerated, value);
+        CHECK_EQUAL(q1.count(), q2.count());
+        TableView tv1 = q1.find_all();
+        TableView tv2 = q2.find_all();
+        CHECK_EQUAL(tv1.size(), tv2.size());
+        for (size_t i = 0; i < tv1.size() && i < tv2.size(); ++i)
+            CHECK_EQUAL(tv1.get_source_ndx(i), tv2.get_source_ndx(i));
+        size_t start = REALM_MAX_BPNODE_SIZE + 5;
+        CHECK_EQUAL(q1.find(start), q2.find(start));
+    };
+
+    const char* needles[] = {"apple", "APPLE", "App", "le", "banana", "", "kiwi"};
+    for (StringData needle : needles) {
+        check([](Table& t, StringData v) { return t.where().contains(0, v); }, needle);
+        check([](Table& t, StringData v) { return t.where().contains(0, v, false); }, needle);
+        check([](Table& t, StringData v) { return t.where().begins_with(0, v); }, needle);
+        check([](Table& t, StringData v) { return t.where().begins_with(0, v, false); }, needle);
+        check([](Table& t, StringData v) { return t.where().ends_with(0, v); }, needle);
+        check([](Table& t, StringData v) { return t.where().ends_with(0, v, false); }, needle);
+        check([](Table& t, StringData v) { return t.where().equal(0, v, false); }, needle);
+        check([](Table& t, StringData v) { return t.where().not_equal(0, v); }, needle);
+        check([](Table& t, StringData v) { return t.where().not_equal(0, v, false); }, needle);
+    }
+    check([](Table& t, StringData v) { return t.where().not_equal(0, v); }, realm::null());
+    check([](Table& t, StringData v) { return t.where().contains(0, v).Or().equal(0, "cherry"); }, "pie");
+}
+
+
 #define uY "\x0CE\x0AB"            // greek capital letter upsilon with dialytika (U+03AB)
 #define uYd "\x0CE\x0A5\x0CC\x088" // decomposed form (Y followed by two dots)
 #define uy "\x0CF\x08B"            // greek small letter upsilon with dialytika (U+03AB)
@@ -5696,6 +5747,605 @@ TEST(Query_SumMinMaxAvg_where)
     CHECK_EQUAL(9, cnt);
 }
 
+
+namespace {
+
+// Checks that parallel execution of `query` gives the same results as serial
+// execution
+void check_parallel_query(unit_test::TestContext& test_context, const Query& query)
+{
+    Query serial = query;
+    Query parallel = query;
+    parallel.set_threads(0);
+
+    CHECK_EQUAL(serial.count(), parallel.count());
+
+    TableView serial_tv = serial.find_all();
+    TableView parallel_tv = parallel.find_all();
+    CHECK_EQUAL(serial_tv.size(), parallel_tv.size());
+    if (serial_tv.size() == parallel_tv.size()) {
+        for (size_t i = 0; i < serial_tv.size(); ++i)
+            CHECK_EQUAL(serial_tv.get_source_ndx(i), parallel_tv.get_source_ndx(i));
+    }
+
+    size_t serial_cnt, parallel_cnt, serial_ndx, parallel_ndx;
+    CHECK_EQUAL(serial.sum_int(0, &serial_cnt), parallel.sum_int(0, &parallel_cnt));
+    CHECK_EQUAL(serial_cnt, parallel_cnt);
+    CHECK_EQUAL(serial.sum_int(1, &serial_cnt), parallel.sum_int(1, &parallel_cnt));
+    CHECK_EQUAL(serial_cnt, parallel_cnt);
+    CHECK_EQUAL(serial.average_int(1), parallel.average_int(1));
+
+    CHECK_EQUAL(serial.maximum_int(0, &serial_cnt, 0, size_t(-1), size_t(-1), &serial_ndx),
+                parallel.maximum_int(0, &parallel_cnt, 0, size_t(-1), size_t(-1), &parallel_ndx));
+    CHECK_EQUAL(serial_cnt, parallel_cnt);
+    CHECK_EQUAL(serial_ndx, parallel_ndx);
+    CHECK_EQUAL(serial.minimum_int(1, &serial_cnt, 0, size_t(-1), size_t(-1), &serial_ndx),
+                parallel.minimum_int(1, &parallel_cnt, 0, size_t(-1), size_t(-1), &parallel_ndx));
+    CHECK_EQUAL(serial_cnt, parallel_cnt);
+    CHECK_EQUAL(serial_ndx, parallel_ndx);
+
+    // The float and double values are small integers, so the sums are exact
+    CHECK_EQUAL(serial.sum_float(2), parallel.sum_float(2));
+    CHECK_EQUAL(serial.sum_double(3), parallel.sum_double(3));
+    CHECK_EQUAL(serial.maximum_float(2, nullptr, 0, size_t(-1), size_t(-1), &serial_ndx),
+                parallel.maximum_float(2, nullptr, 0, size_t(-1), size_t(-1), &parallel_ndx));
+    CHECK_EQUAL(serial_ndx, parallel_ndx);
+    CHECK_EQUAL(serial.minimum_double(3, nullptr, 0, size_t(-1), size_t(-1), &serial_ndx),
+                parallel.minimum_double(3, nullptr, 0, size_t(-1), size_t(-1), &parallel_ndx));
+    CHECK_EQUAL(serial_ndx, parallel_ndx);
+    CHECK_EQUAL(serial.average_double(3), parallel.average_double(3));
+
+    // Groups are in the order of their first rows in both cases
+    std::vector<GroupAggregate> aggregates = {
+        {Table::aggr_count, 0}, {Table::aggr_sum, 0}, {Table::aggr_max, 2}, {Table::aggr_avg, 3}};
+    Table serial_groups, parallel_groups, view_groups;
+    serial.group_by({4, 1}, aggregates, serial_groups);
+    parallel.group_by({4, 1}, aggregates, parallel_groups);
+    serial_tv.group_by({4, 1}, aggregates, view_groups);
+    CHECK(serial_groups == parallel_groups);
+    CHECK(serial_groups == view_groups);
+
+    // Restricted range
+    size_t start = REALM_MAX_BPNODE_SIZE + 3;
+    size_t end = serial.get_table()->size() - 5;
+    CHECK_EQUAL(serial.count(start, end), parallel.count(start, end));
+    CHECK_EQUAL(serial.find_all(start, end).size(), parallel.find_all(start, end).size());
+    CHECK_EQUAL(serial.sum_int(0, nullptr, start, end), parallel.sum_int(0, nullptr, start, end));
+    Table serial_range_groups, parallel_range_groups;
+    serial.group_by({4}, aggregates, serial_range_groups, start, end);
+    parallel.group_by({4}, aggregates, parallel_range_groups, start, end);
+    CHECK(serial_range_groups == parallel_range_groups);
+}
+
+} // anonymous namespace
+
+
+TEST(Query_Parallel)
+{
+    // Large enough to be divided into several partitions
+    const size_t num_rows = 20 * REALM_MAX_BPNODE_SIZE + 17;
+
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_column(type_Int, "int_null", true);
+    table.add_column(type_Float, "float");
+    table.add_column(type_Double, "double");
+    table.add_column(type_String, "string");
+    table.add_empty_row(num_rows);
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    for (size_t i = 0; i < num_rows; ++i) {
+        table.set_int(0, i, random.draw_int<int64_t>(-1000, 1000));
+        if (i % 7 != 0)
+            table.set_int(1, i, random.draw_int<int64_t>(-100, 100));
+        table.set_float(2, i, float(random.draw_int<int>(-50, 50)));
+        table.set_double(3, i, double(random.draw_int<int>(-50, 50)));
+        table.set_string(4, i, i % 3 == 0 ? "bar" : "foo");
+    }
+
+    check_parallel_query(test_context, table.where().greater(0, 100));
+    check_parallel_query(test_context, table.where().equal(4, "foo").less(2, 10.0f));
+    check_parallel_query(test_context, table.where().group().less(0, -900).Or().greater(3, 40.0).end_group());
+    check_parallel_query(test_context, table.where().Not().equal(4, "bar").not_equal(1, null()));
+    check_parallel_query(test_context, table.where().equal(0, 5000)); // No matches
+
+    // Conditions on query expressions are executed serially
+    check_parallel_query(test_context, table.where().and_query(table.column<Int>(0) > 100));
+
+    // Search index and enumerated strings
+    table.add_search_index(4);
+    check_parallel_query(test_context, table.where().equal(4, "bar").greater(1, 0));
+    table.optimize();
+    check_parallel_query(test_context, table.where().equal(4, "foo").less(0, 0));
+}
+
+
+TEST(Query_ColumnStatistics)
+{
+    const size_t num_rows = 20000;
+
+    Group group;
+    TableRef table = group.add_table("table");
+    table->add_column(type_Int, "int");
+    table->add_column(type_Int, "int_null", true);
+    table->add_column(type_String, "string");
+    table->add_column(type_Timestamp, "timestamp");
+    table->add_column(type_Double, "double");
+    table->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        // Mostly zero, the rest unique
+        table->set_int(0, i, i % 20 == 0 ? int64_t(i) : 0);
+        if (i % 2 == 0)
+            table->set_int(1, i, int64_t(i % 10));
+        table->set_string(2, i, i % 100 == 0 ? "rare" : "common");
+        table->set_timestamp(3, i, Timestamp(int64_t(i), 0));
+    }
+
+    using _impl::ColumnStatistics;
+    const ColumnStatistics& ints = table->get_column_statistics(0);
+    CHECK(ints.is_supported());
+    CHECK(ints.is_ordered());
+    CHECK_EQUAL(num_rows, ints.num_rows());
+    CHECK_EQUAL(0, ints.null_fraction());
+    CHECK_GREATER(ints.estimate_equal(0), 0.9);
+    CHECK_LESS(ints.estimate_equal(-1), 0.001);
+    CHECK_GREATER(ints.estimate_range(1, std::numeric_limits<int64_t>::max()), 0.01);
+    CHECK_LESS(ints.estimate_range(1, std::numeric_limits<int64_t>::max()), 0.1);
+    CHECK_GREATER(ints.distinct_estimate(), 100);
+    CHECK_LESS_EQUAL(ints.distinct_estimate(), num_rows);
+
+    const ColumnStatistics& nullable_ints = table->get_column_statistics(1);
+    CHECK_GREATER(nullable_ints.null_fraction(), 0.4);
+    CHECK_LESS(nullable_ints.null_fraction(), 0.6);
+    CHECK_EQUAL(0, nullable_ints.min());
+    CHECK_EQUAL(8, nullable_ints.max());
+
+    const ColumnStatistics& strings = table->get_column_statistics(2);
+    CHECK(strings.is_supported());
+    CHECK(!strings.is_ordered());
+    CHECK_LESS(strings.estimate_equal(ColumnStatistics::string_key("rare")), 0.05);
+    CHECK_GREATER(strings.estimate_equal(ColumnStatistics::string_key("common")), 0.95);
+
+    const ColumnStatistics& timestamps = table->get_column_statistics(3);
+    CHECK_APPROXIMATELY_EQUAL(0.25, timestamps.estimate_range(15000, 20000), 0.01);
+
+    CHECK(!table->get_column_statistics(4).is_supported());
+
+    // Statistics are cached until the table changes
+    CHECK_EQUAL(&ints, &table->get_column_statistics(0));
+    table->add_empty_row();
+    CHECK_EQUAL(num_rows + 1, table->get_column_statistics(0).num_rows());
+
+    // Small columns are sampled completely, so the estimates are exact
+    TableRef small = group.add_table("small");
+    small->add_column(type_Int, "int");
+    small->add_empty_row(10);
+    for (size_t i = 0; i < 10; ++i)
+        small->set_int(0, i, int64_t(i % 5));
+    const ColumnStatistics& small_ints = small->get_column_statistics(0);
+    CHECK_EQUAL(5, small_ints.distinct_estimate());
+    CHECK_EQUAL(0.2, small_ints.estimate_equal(3));
+    CHECK_EQUAL(0, small_ints.estimate_equal(5));
+    CHECK_EQUAL(0.4, small_ints.estimate_range(3, 4));
+}
+
+
+TEST(Query_ColumnSummariesSurviveDetach)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(SharedGroupOptions::Durability::MemOnly);
+    SharedGroup sg(path, false, options);
+
+    using _impl::ColumnStatistics;
+    std::shared_ptr<const _impl::ZoneMap> zone_map;
+    const ColumnStatistics* statistics;
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_Int, "int");
+        table->add_column(type_Int, "other");
+        table->add_empty_row(100);
+        for (size_t i = 0; i < 100; ++i)
+            table->set_int(0, i, int64_t(i));
+        table->get_zone_map(0);
+        zone_map = table->get_zone_map(0);
+        CHECK(zone_map);
+        statistics = &table->get_column_statistics(1);
+        wt.commit();
+    }
+
+    // The summaries computed before the commit describe the new version, and
+    // are kept while the accessors are detached between transactions
+    for (int i = 0; i < 2; ++i) {
+        ReadTransaction rt(sg);
+        ConstTableRef table = rt.get_table("table");
+        CHECK_EQUAL(zone_map, table->get_zone_map(0));
+        CHECK_EQUAL(statistics, &table->get_column_statistics(1));
+    }
+
+    // They are not used for other versions
+    {
+        SharedGroup sg_2(path, false, options);
+        WriteTransaction wt(sg_2);
+        wt.get_table("table")->set_int(1, 0, 1);
+        wt.commit();
+    }
+    {
+        ReadTransaction rt(sg);
+        CHECK(!rt.get_table("table")->get_zone_map(0));
+    }
+
+    // Nor are the summaries of a transaction that was rolled back
+    std::shared_ptr<const _impl::ZoneMap> rolled_back;
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.get_table("table");
+        table->set_int(0, 0, 1000);
+        table->get_zone_map(0);
+        rolled_back = table->get_zone_map(0);
+        CHECK(rolled_back);
+    }
+    {
+        ReadTransaction rt(sg);
+        ConstTableRef table = rt.get_table("table");
+        std::shared_ptr<const _impl::ZoneMap> current = table->get_zone_map(0);
+        CHECK(current);
+        CHECK(current != rolled_back);
+        CHECK_EQUAL(0, table->where().equal(0, 1000).count());
+    }
+}
+
+
+TEST(Query_StatisticsDrivenCost)
+{
+    const size_t num_rows = 20000;
+
+    Group group;
+    TableRef table = group.add_table("table");
+    table->add_column(type_Int, "int");
+    table->add_column(type_String, "string");
+    table->add_column(type_Timestamp, "timestamp");
+    table->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        table->set_int(0, i, i % 1000 == 0 ? 1 : 0);
+        table->set_string(1, i, i % 2 == 0 ? "even" : "odd");
+        table->set_timestamp(2, i, Timestamp(int64_t(i), 0));
+    }
+
+    // The fixed guesses give all integer conditions the same cost, while the
+    // statistics tell which condition is the most selective
+    IntegerNode<IntegerColumn, Equal> rare(1, 0);
+    IntegerNode<IntegerColumn, Equal> common(0, 0);
+    IntegerNode<IntegerColumn, Greater> none(1, 0);
+    StringNode<Equal> half("even", 1);
+    TimestampNode<Less> early(Timestamp(100, 0), 2);
+    ParentNode* nodes[] = {&rare, &common, &none, &half, &early};
+    for (ParentNode* node : nodes) {
+        node->set_table(*table);
+        node->init();
+        node->init_cost_from_statistics();
+    }
+    CHECK_LESS(rare.cost(), common.cost());
+    CHECK_LESS_EQUAL(none.cost(), rare.cost());
+    CHECK_LESS(rare.cost(), half.cost());
+    CHECK_LESS(early.cost(), half.cost());
+    CHECK_GREATER(none.m_dD, 1000);
+
+    // Unsupported conditions keep the guess made by init()
+    FloatDoubleNode<DoubleColumn, Equal> unsupported(1.0, 0);
+    CHECK(!unsupported.estimate_selectivity());
+
+    // The order of evaluation does not change the results
+    CHECK_EQUAL(20, table->where().equal(1, "even").equal(0, 1).count());
+    CHECK_EQUAL(20, table->where().equal(0, 1).equal(1, "even").count());
+    CHECK_EQUAL(50, table->where().equal(1, "even").less(2, Timestamp(100, 0)).count());
+    CHECK_EQUAL(0, table->where().equal(1, "odd").greater(0, 1).count());
+    TableView tv = table->where().equal(1, "even").equal(0, 1).find_all();
+    CHECK_EQUAL(20, tv.size());
+    for (size_t i = 0; i < tv.size(); ++i)
+        CHECK_EQUAL(i * 1000, tv.get_source_ndx(i));
+}
+
+TEST(Query_ZoneMap)
+{
+    const size_t num_rows = 10 * REALM_MAX_BPNODE_SIZE;
+    const int64_t half = int64_t(num_rows / 2);
+
+    Group group;
+    TableRef table = group.add_table("table");
+    table->add_column(type_Int, "int");
+    table->add_column(type_Int, "nullable", true);
+    table->add_column(type_Timestamp, "timestamp");
+    table->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        table->set_int(0, i, int64_t(i));
+        if (int64_t(i) >= half)
+            table->set_int(1, i, int64_t(i));
+        table->set_timestamp(2, i, Timestamp(int64_t(i), 0));
+    }
+
+    // The zone map is only computed when it is requested a second time for
+    // the same version of the table
+    CHECK(!table->get_zone_map(0));
+    std::shared_ptr<const _impl::ZoneMap> zone_map = table->get_zone_map(0);
+    CHECK(zone_map);
+    CHECK_EQUAL(zone_map, table->get_zone_map(0));
+    CHECK_GREATER_EQUAL(zone_map->size(), 10);
+
+    // The values are ascending, so the leaf that contains the value `k` is the
+    // only candidate
+    int64_t k = half + 3;
+    size_t begin = zone_map->skip(0, num_rows, k, k);
+    size_t end = zone_map->skip_candidates(begin, num_rows, k, k);
+    CHECK_LESS_EQUAL(begin, size_t(k));
+    CHECK_GREATER(end, size_t(k));
+    CHECK_LESS(end - begin, num_rows / 2);
+    CHECK_EQUAL(num_rows, zone_map->skip(end, num_rows, k, k));
+    CHECK_EQUAL(num_rows, zone_map->skip(0, num_rows, int64_t(num_rows), int64_t(num_rows) + 10));
+    CHECK_EQUAL(5, zone_map->skip(5, num_rows, 0, int64_t(num_rows)));
+    CHECK_EQUAL(7, zone_map->skip(0, 7, int64_t(num_rows) - 1, int64_t(num_rows) - 1));
+
+    // Leaves with only nulls never intersect a range
+    table->get_zone_map(1);
+    std::shared_ptr<const _impl::ZoneMap> nullable_map = table->get_zone_map(1);
+    CHECK(nullable_map);
+    CHECK_EQUAL(num_rows, nullable_map->skip(0, num_rows, 0, half - 1));
+    CHECK_GREATER_EQUAL(nullable_map->skip(0, num_rows, half, half), size_t(half) - REALM_MAX_BPNODE_SIZE);
+
+    // Each query is run three times, so that the last run uses the zone maps
+    for (int run = 0; run < 3; ++run) {
+        CHECK_EQUAL(1, table->where().equal(0, k).count());
+        CHECK_EQUAL(0, table->where().equal(0, int64_t(num_rows)).count());
+        CHECK_EQUAL(size_t(k), table->where().less(0, k).count());
+        CHECK_EQUAL(size_t(k) + 1, table->where().less_equal(0, k).count());
+        CHECK_EQUAL(num_rows - size_t(k) - 1, table->where().greater(0, k).count());
+        CHECK_EQUAL(num_rows - size_t(k), table->where().greater_equal(0, k).count());
+        CHECK_EQUAL(size_t(k), table->where().equal(0, k).find());
+        CHECK_EQUAL(not_found, table->where().less(0, 0).find());
+
+        CHECK_EQUAL(0, table->where().less(1, half).count());
+        CHECK_EQUAL(size_t(half) - 3, table->where().greater(1, k - 1).count());
+        CHECK_EQUAL(size_t(half), table->where().equal(1, null()).count());
+        CHECK_EQUAL(size_t(k), table->where().equal(1, k).find());
+
+        CHECK_EQUAL(size_t(k), table->where().less(2, Timestamp(k, 0)).count());
+        CHECK_EQUAL(1, table->where().equal(2, Timestamp(k, 0)).count());
+        CHECK_EQUAL(0, table->where().equal(2, Timestamp(k, 1)).count());
+        CHECK_EQUAL(num_rows - size_t(k), table->where().greater_equal(2, Timestamp(k, 0)).count());
+        CHECK_EQUAL(size_t(k), table->where().greater(2, Timestamp(k - 1, 999)).find());
+
+        TableView tv = table->where().greater(0, k).less(0, k + 10).find_all();
+        CHECK_EQUAL(9, tv.size());
+        for (size_t i = 0; i < tv.size(); ++i)
+            CHECK_EQUAL(size_t(k) + 1 + i, tv.get_source_ndx(i));
+        CHECK_EQUAL(2 * k + 1, table->where().greater(0, k - 1).less(0, k + 2).sum_int(0));
+    }
+
+    // Setting values updates the zone maps. The one that is still referenced
+    // here is copied rather than modified.
+    table->set_int(0, 0, k);
+    table->set_null(1, size_t(k));
+    std::shared_ptr<const _impl::ZoneMap> updated_map = table->get_zone_map(0);
+    CHECK(updated_map);
+    CHECK(updated_map != zone_map);
+    CHECK_EQUAL(0, updated_map->skip(0, num_rows, k, k));
+    CHECK_GREATER(zone_map->skip(0, num_rows, k, k), 0);
+
+    // So does appending rows, with default or given values
+    table->add_empty_row();
+    table->set_int(0, num_rows, -1);
+    int64_t values[] = {-2, -3};
+    bool nulls[] = {false, true};
+    std::vector<BulkColumn> columns = {{0, values}, {1, values, nulls}};
+    table->add_rows(2, columns);
+    CHECK(table->get_zone_map(0));
+    CHECK(table->get_zone_map(1));
+    CHECK(table->get_zone_map(2));
+    CHECK_GREATER_EQUAL(table->get_zone_map(0)->skip(0, num_rows + 3, -3, -1), num_rows - REALM_MAX_BPNODE_SIZE);
+    for (int run = 0; run < 3; ++run) {
+        CHECK_EQUAL(2, table->where().equal(0, k).count());
+        CHECK_EQUAL(0, table->where().equal(0, k).find());
+        CHECK_EQUAL(num_rows, table->where().equal(0, -1).find());
+        CHECK_EQUAL(3, table->where().less(0, 0).count());
+        CHECK_EQUAL(0, table->where().equal(1, k).count());
+        CHECK_EQUAL(1, table->where().equal(1, -2).count());
+        CHECK_EQUAL(size_t(half) + 3, table->where().equal(1, null()).count());
+        CHECK_EQUAL(4, table->where().equal(2, Timestamp(0, 0)).count());
+    }
+
+    // Other modifications discard them
+    table->remove(1);
+    CHECK(!table->get_zone_map(0));
+    for (int run = 0; run < 3; ++run) {
+        CHECK_EQUAL(2, table->where().equal(0, k).count());
+        CHECK_EQUAL(0, table->where().equal(0, k).find());
+        CHECK_EQUAL(num_rows - 1, table->where().equal(0, -1).find());
+    }
+}
+
+TEST(Query_Parameters)
+{
+    const size_t num_rows = 20000;
+
+    Group group;
+    TableRef table = group.add_table("table");
+    table->add_column(type_Int, "int");
+    table->add_column(type_Int, "nullable", true);
+    table->add_column(type_Float, "float");
+    table->add_column(type_Double, "double");
+    table->add_column(type_String, "string", true);
+    table->add_column(type_Timestamp, "timestamp");
+    table->add_column(type_Bool, "bool");
+    table->add_ordered_index(0);
+    table->add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        int64_t value = int64_t(i % 1000);
+        table->set_int(0, i, value);
+        if (i % 10 != 0)
+            table->set_int(1, i, value);
+        table->set_float(2, i, float(value));
+        table->set_double(3, i, value + 0.5);
+        table->set_string(4, i, i % 3 == 0 ? "foo" : "bar");
+        table->set_timestamp(5, i, Timestamp(value, 0));
+        table->set_bool(6, i, i % 2 == 0);
+    }
+
+    Query q = table->where()
+                  .greater_equal(0, int64_t(0)).parameter(0)
+                  .less_equal(0, int64_t(0)).parameter(1)
+                  .equal(4, "foo").parameter(2);
+    for (int64_t first = 0; first < 1000; first += 97) {
+        for (int64_t last = first; last < first + 300; last += 41) {
+            q.bind(0, first).bind(1, last);
+            for (const char* s : {"foo", "bar", "baz"}) {
+                q.bind(2, s);
+                size_t expected = table->where().between(0, first, last).equal(4, s).count();
+                CHECK_EQUAL(expected, q.count());
+                CHECK_EQUAL(expected, q.find_all().size());
+            }
+        }
+    }
+
+    // Executing a query again reuses its plan until the table changes
+    q.bind(0, 5).bind(1, 5).bind(2, "bar");
+    CHECK_EQUAL(13, q.count());
+    CHECK_EQUAL(13, q.count());
+    table->set_string(4, 5, "foo");
+    CHECK_EQUAL(12, q.count());
+    table->set_int(0, 2005, 7);
+    CHECK_EQUAL(11, q.count());
+    table->set_int(0, 2005, 5);
+    table->set_string(4, 5, "bar");
+    CHECK_EQUAL(13, q.count());
+
+    // Other types of values, and conditions nested in groups and negations
+    Query q2 = table->where()
+                   .group()
+                   .equal(1, null()).parameter(0)
+                   .Or()
+                   .less(2, 10.0f).parameter(1)
+                   .end_group()
+                   .Not()
+                   .greater(3, 0.0).parameter(2);
+    q2.bind(0, null()).bind(1, 10.0f).bind(2, 999.0);
+    CHECK_EQUAL(table->where().group().equal(1, null()).Or().less(2, 10.0f).end_group().Not().greater(3, 999.0).count(),
+                q2.count());
+    q2.bind(0, 5).bind(1, 0.0f).bind(2, 4.0);
+    CHECK_EQUAL(table->where().group().equal(1, 5).Or().less(2, 0.0f).end_group().Not().greater(3, 4.0).count(),
+                q2.count());
+
+    Query q3 = table->where().less(5, Timestamp(0, 0)).parameter(0).equal(6, true).parameter(1);
+    q3.bind(0, Timestamp(10, 0)).bind(1, false);
+    CHECK_EQUAL(table->where().less(5, Timestamp(10, 0)).equal(6, false).count(), q3.count());
+
+    Query q4 = table->where().contains(4, "x", false).parameter(0).Or().equal(4, "x").parameter(0);
+    q4.bind(0, "OO");
+    CHECK_EQUAL(num_rows / 3 + 1, q4.count());
+    q4.bind(0, "bA");
+    CHECK_EQUAL(num_rows - num_rows / 3 - 1, q4.count());
+
+    // Parameters survive copying
+    Query copy = q;
+    copy.bind(0, 0).bind(1, 999).bind(2, "foo");
+    CHECK_EQUAL(num_rows / 3 + 1, copy.count());
+    CHECK_EQUAL(13, q.count());
+
+    // Errors
+    CHECK_LOGIC_ERROR(q.bind(3, 0), LogicError::illegal_combination);
+    CHECK_LOGIC_ERROR(q.bind(0, 1.0), LogicError::type_mismatch);
+    CHECK_LOGIC_ERROR(q.bind(2, 0), LogicError::type_mismatch);
+    CHECK_LOGIC_ERROR(q.bind(0, std::numeric_limits<int64_t>::min()), LogicError::illegal_combination);
+    CHECK_LOGIC_ERROR(q.bind(1, std::numeric_limits<int64_t>::max()), LogicError::illegal_combination);
+    CHECK_LOGIC_ERROR(table->where().equal(0, 1).parameter(0).bind(0, null()), LogicError::type_mismatch);
+    CHECK_EQUAL("Parameter without condition", table->where().between(0, 1, 2).parameter(0).validate());
+}
+
+TEST(Query_ExpressionBatches)
+{
+    // Arithmetic expressions over columns without links are evaluated a batch of rows at a time. Compare the
+    // results with a row-by-row evaluation on a table that spans many leaves and contains nulls.
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_column(type_Int, "nullable_int", true);
+    table.add_column(type_Float, "float", true);
+    table.add_column(type_Double, "double");
+
+    const size_t num_rows = 3 * REALM_MAX_BPNODE_SIZE + 17;
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        table.set_int(0, i, int64_t(i % 97) - 40);
+        int64_t divisor = int64_t(i % 12) - 6;
+        if (i % 5 != 0)
+            table.set_int(1, i, divisor >= 0 ? divisor + 1 : divisor);
+        if (i % 7 != 0)
+            table.set_float(2, i, float(i % 11) / 2);
+        table.set_double(3, i, double(i % 23) - 11.5);
+    }
+
+    Columns<Int> col_int = table.column<Int>(0);
+    Columns<Int> col_nullable_int = table.column<Int>(1);
+    Columns<Float> col_float = table.column<Float>(2);
+    Columns<Double> col_double = table.column<Double>(3);
+
+    auto check = [&](Query query, std::function<bool(size_t)> expected) {
+        TableView tv = query.find_all();
+        size_t count = 0;
+        for (size_t i = 0; i < table.size(); ++i) {
+            if (expected(i)) {
+                if (count < tv.size())
+                    CHECK_EQUAL(tv.get_source_ndx(count), i);
+                ++count;
+            }
+        }
+        CHECK_EQUAL(tv.size(), count);
+        CHECK_EQUAL(query.count(), count);
+        CHECK_EQUAL(query.find(), count ? tv.get_source_ndx(0) : not_found);
+    };
+    auto get_int = [&](size_t i) { return table.get_int(0, i); };
+    auto is_null_int = [&](size_t i) { return table.is_null(1, i); };
+    auto get_nullable_int = [&](size_t i) { return table.get_int(1, i); };
+    auto is_null_float = [&](size_t i) { return table.is_null(2, i); };
+    auto get_float = [&](size_t i) { return table.get_float(2, i); };
+    auto get_double = [&](size_t i) { return table.get_double(3, i); };
+
+    check(col_int * 2 + 3 > col_int + 10, [&](size_t i) { return get_int(i) * 2 + 3 > get_int(i) + 10; });
+    check(col_int - col_nullable_int >= 5,
+          [&](size_t i) { return !is_null_int(i) && get_int(i) - get_nullable_int(i) >= 5; });
+    check(col_int / col_nullable_int == 2, [&](size_t i) {
+        return !is_null_int(i) && get_int(i) / get_nullable_int(i) == 2;
+    });
+    check(col_nullable_int * col_nullable_int < 10,
+          [&](size_t i) { return !is_null_int(i) && get_nullable_int(i) * get_nullable_int(i) < 10; });
+    check(col_nullable_int + 1 == null(), [&](size_t i) { return is_null_int(i); });
+    check(col_nullable_int + 1 != null(), [&](size_t i) { return !is_null_int(i); });
+    check(col_float * 2 > col_double, [&](size_t i) { return !is_null_float(i) && get_float(i) * 2 > get_double(i); });
+    check(col_int + col_float <= 0.5f,
+          [&](size_t i) { return !is_null_float(i) && get_int(i) + get_float(i) <= 0.5f; });
+    check(col_double * col_int != 11.5, [&](size_t i) { return get_double(i) * get_int(i) != 11.5; });
+    check(col_double / 2 + col_nullable_int > 1.0, [&](size_t i) {
+        return !is_null_int(i) && get_double(i) / 2 + get_nullable_int(i) > 1.0;
+    });
+    check(col_int > col_double, [&](size_t i) { return get_int(i) > get_double(i); });
+    check(col_int == col_int, [&](size_t) { return true; });
+    check(col_int != col_int, [&](size_t) { return false; });
+
+    // Combined with other conditions
+    check(col_int * 2 > 10 && col_int < 50, [&](size_t i) { return get_int(i) * 2 > 10 && get_int(i) < 50; });
+    check(col_int * 2 > 10 || col_double < 0.0,
+          [&](size_t i) { return get_int(i) * 2 > 10 || get_double(i) < 0.0; });
+
+    // Matches found in a batch must not survive modifications of the table
+    Query query = col_int + col_nullable_int > 50;
+    auto expected = [&](size_t i) { return !is_null_int(i) && get_int(i) + get_nullable_int(i) > 50; };
+    check(query, expected);
+    for (size_t i = 0; i < num_rows; i += 3)
+        table.set_int(0, i, 100);
+    check(query, expected);
+    table.remove(0);
+    check(query, expected);
+}
+
+
 TEST(Query_Avg)
 {
     TupleTableType t;
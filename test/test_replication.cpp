@@ -3439,6 +3439,106 @@ TEST(Replication_NullInteger)
     }
 }
 
+TEST(Replication_AddRows)
+{
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+
+    util::Logger& replay_logger = test_context.logger;
+
+    MyTrivialReplication repl(path_1);
+    SharedGroup sg_1(repl);
+    SharedGroup sg_2(path_2);
+
+    {
+        WriteTransaction wt(sg_1);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_Int, "int");
+        table->add_column(type_Int, "int_null", true);
+        table->add_column(type_Bool, "bool");
+        table->add_column(type_Double, "double", true);
+        table->add_column(type_String, "string");
+        table->add_column(type_String, "string_null", true);
+        table->add_empty_row();
+
+        int64_t ints[] = {0, 1, -1, 0};
+        bool bools[] = {false, true, false, true};
+        bool nulls[] = {true, false, false, true};
+        double doubles[] = {0, 0, 2.5, 1};
+        StringData strings[] = {"", "a", "", "b"};
+        StringData null_strings[] = {StringData(), "", "c", StringData()};
+        std::vector<BulkColumn> columns;
+        columns.emplace_back(0, ints);
+        columns.emplace_back(1, ints, nulls);
+        columns.emplace_back(2, bools);
+        columns.emplace_back(3, doubles, nulls);
+        columns.emplace_back(4, strings);
+        columns.emplace_back(5, null_strings);
+        table->add_rows(4, columns);
+        wt.commit();
+    }
+    repl.replay_transacts(sg_2, replay_logger);
+    {
+        ReadTransaction rt_1(sg_1);
+        ReadTransaction rt_2(sg_2);
+        rt_1.get_group().verify();
+        rt_2.get_group().verify();
+        CHECK(rt_1.get_group() == rt_2.get_group());
+        ConstTableRef table = rt_2.get_table("table");
+        CHECK_EQUAL(5, table->size());
+        CHECK(table->is_null(1, 1));
+        CHECK_EQUAL(1, table->get_int(1, 2));
+        CHECK(!table->is_null(5, 2));
+        CHECK_EQUAL("c", table->get_string(5, 3));
+    }
+}
+
+
+TEST(Replication_UnenumerateStringColumns)
+{
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+
+    util::Logger& replay_logger = test_context.logger;
+
+    MyTrivialReplication repl(path_1);
+    SharedGroup sg_1(repl);
+    SharedGroup sg_2(path_2);
+
+    {
+        WriteTransaction wt(sg_1);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_String, "unique");
+        table->add_column(type_String, "few");
+        table->add_empty_row(100);
+        for (size_t i = 0; i < 100; ++i) {
+            std::string str = util::to_string(i);
+            table->set_string(0, i, str);
+            table->set_string(1, i, i % 2 == 0 ? "even" : "odd");
+        }
+        table->optimize(true);
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg_1);
+        wt.get_table("table")->unenumerate_string_columns();
+        wt.commit();
+    }
+    repl.replay_transacts(sg_2, replay_logger);
+    {
+        ReadTransaction rt_1(sg_1);
+        ReadTransaction rt_2(sg_2);
+        rt_1.get_group().verify();
+        rt_2.get_group().verify();
+        CHECK(rt_1.get_group() == rt_2.get_group());
+        ConstTableRef table = rt_2.get_table("table");
+        ConstDescriptorRef desc = table->get_descriptor();
+        CHECK_EQUAL(0, desc->get_num_unique_values(0));
+        CHECK_EQUAL(2, desc->get_num_unique_values(1));
+        CHECK_EQUAL("42", table->get_string(0, 42));
+    }
+}
+
 
 TEST(Replication_SetUnique)
 {
@@ -3486,6 +3586,51 @@ TEST(Replication_SetUnique)
 }
 
 
+TEST(Replication_OrderedIndex)
+{
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+
+    util::Logger& replay_logger = test_context.logger;
+
+    MyTrivialReplication repl(path_1);
+    SharedGroup sg_1(repl);
+    SharedGroup sg_2(path_2);
+
+    {
+        WriteTransaction wt(sg_1);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_Int, "a");
+        table->add_column(type_Double, "b");
+        table->add_ordered_index(0);
+        table->add_ordered_index(1);
+        table->add_empty_row(10);
+        for (size_t i = 0; i < 10; ++i) {
+            table->set_int(0, i, int64_t(10 - i));
+            table->set_double(1, i, double(i));
+        }
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg_1);
+        TableRef table = wt.get_table("table");
+        table->remove_ordered_index(1);
+        table->move_last_over(0);
+        wt.commit();
+    }
+    repl.replay_transacts(sg_2, replay_logger);
+    {
+        ReadTransaction rt(sg_2);
+        ConstTableRef table = rt.get_table("table");
+        CHECK(table->has_ordered_index(0));
+        CHECK(!table->has_ordered_index(1));
+        table->verify();
+        CHECK_EQUAL(9, table->get_ordered_index(0)->size());
+        CHECK_EQUAL(3, table->where().less(0, 4).count());
+        CHECK_EQUAL(0, table->where().equal(0, 1).find());
+    }
+}
+
 TEST(Replication_RenameGroupLevelTable_MoveGroupLevelTable_RenameColumn_MoveColumn)
 {
     SHARED_GROUP_TEST_PATH(path_1);
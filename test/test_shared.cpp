@@ -19,9 +19,11 @@
 #include "testsettings.hpp"
 #ifdef TEST_SHARED
 
+#include <chrono>
 #include <streambuf>
 #include <fstream>
 #include <tuple>
+#include <algorithm>
 
 // Need fork() and waitpid() for Shared_RobustAgainstDeathDuringWrite
 #ifndef _WIN32
@@ -37,6 +39,7 @@
 #endif
 
 #include <realm.hpp>
+#include <realm/group_shared_pool.hpp>
 #include <realm/util/features.h>
 #include <realm/util/safe_int_ops.hpp>
 #include <memory>
@@ -96,8 +99,8 @@ TEST(Shared_Unattached)
 
 namespace {
 
-// async deamon does not start when launching unit tests from osx, so async is currently disabled on osx.
-// Also: async requires interprocess communication, which does not work with our current encryption support.
+// The multiprocess async test relies on fork(), and encrypted files cannot be
+// shared between processes.
 #if !defined(_WIN32) && !REALM_PLATFORM_APPLE
 #if REALM_ANDROID || defined DISABLE_ASYNC || REALM_ENABLE_ENCRYPTION
 bool allow_async = false;
@@ -1221,6 +1224,80 @@ TEST(Shared_WriterThreads)
 }
 
 
+TEST(Shared_GroupCommit)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(crypt_key());
+    options.group_commit = true;
+    const size_t thread_count = 8;
+    const size_t num_commits = 50;
+    {
+        SharedGroup sg(path, false, options);
+        {
+            WriteTransaction wt(sg);
+            TableRef table = wt.add_table("test");
+            table->add_column(type_Int, "value");
+            table->add_empty_row(thread_count);
+            wt.commit();
+        }
+
+        // Every commit gets its own version, also when the commits are made
+        // durable together
+        std::vector<SharedGroup::version_type> versions[thread_count];
+        Thread threads[thread_count];
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads[i].start([&path, &options, &versions, i] {
+                SharedGroup sg_2(path, false, options);
+                for (size_t j = 0; j < num_commits; ++j) {
+                    WriteTransaction wt(sg_2);
+                    TableRef table = wt.get_table("test");
+                    table->set_int(0, i, table->get_int(0, i) + 1);
+                    versions[i].push_back(wt.commit());
+                }
+            });
+        }
+        for (size_t i = 0; i < thread_count; ++i)
+            threads[i].join();
+
+        std::vector<SharedGroup::version_type> all_versions;
+        for (size_t i = 0; i < thread_count; ++i) {
+            CHECK_EQUAL(num_commits, versions[i].size());
+            CHECK(std::is_sorted(versions[i].begin(), versions[i].end()));
+            all_versions.insert(all_versions.end(), versions[i].begin(), versions[i].end());
+        }
+        std::sort(all_versions.begin(), all_versions.end());
+        CHECK(std::adjacent_find(all_versions.begin(), all_versions.end()) == all_versions.end());
+
+        // A commit returns only once it is durable, so the file header must
+        // already refer to the latest version, and none of its space may have
+        // been reused by the commits that were not yet durable in between
+        {
+            Group group(path, crypt_key());
+            group.verify();
+            ConstTableRef table = group.get_table("test");
+            for (size_t i = 0; i < thread_count; ++i)
+                CHECK_EQUAL(num_commits, table->get_int(0, i));
+        }
+
+        // Let the file go through compaction and a few more commits
+        CHECK(sg.compact());
+        for (int i = 0; i < 3; ++i) {
+            WriteTransaction wt(sg);
+            TableRef table = wt.get_table("test");
+            table->set_int(0, 0, table->get_int(0, 0) + 1);
+            wt.commit();
+        }
+    }
+
+    // The file header must refer to the latest version
+    Group group(path, crypt_key());
+    ConstTableRef table = group.get_table("test");
+    CHECK_EQUAL(num_commits + 3, table->get_int(0, 0));
+    for (size_t i = 1; i < thread_count; ++i)
+        CHECK_EQUAL(num_commits, table->get_int(0, i));
+}
+
+
 #if !REALM_ENABLE_ENCRYPTION && defined(ENABLE_ROBUST_AGAINST_DEATH_DURING_WRITE)
 // this unittest has issues that has not been fully understood, but could be
 // related to interaction between posix robust mutexes and the fork() system call.
@@ -1722,21 +1799,16 @@ TEST(Shared_ClearColumnWithBasicArrayRootLeaf)
     }
 }
 
-// disable shared async on windows and any Apple operating system
-// TODO: enable async daemon for OS X - think how to do it in XCode (no issue for build.sh)
-#if !defined(_WIN32) && !REALM_PLATFORM_APPLE
-// Todo. Keywords: winbug
-TEST_IF(Shared_Async, allow_async)
+TEST(Shared_Async)
 {
     SHARED_GROUP_TEST_PATH(path);
 
     // Do some changes in a async db
     {
         bool no_create = false;
-        SharedGroup db(path, no_create, SharedGroupOptions(SharedGroupOptions::Durability::Async));
+        SharedGroup db(path, no_create, SharedGroupOptions(SharedGroupOptions::Durability::Async, crypt_key()));
 
         for (size_t i = 0; i < 100; ++i) {
-            //            std::cout << "t "<<n<<"\n";
             WriteTransaction wt(db);
             wt.get_group().verify();
             TestTableShared::Ref t1 = wt.get_or_add_table<TestTableShared>("test");
@@ -1745,13 +1817,18 @@ TEST_IF(Shared_Async, allow_async)
         }
     }
 
-    // Wait for async_commit process to shutdown
-    // FIXME: we need a way to determine properly if the daemon has shot down instead of just sleeping
-    sleep(1);
+    // Closing the last session flushes all commits, so the file must be
+    // complete when read without a lock file
+    {
+        Group g(path, crypt_key());
+        g.verify();
+        TestTableShared::ConstRef t1 = g.get_table<TestTableShared>("test");
+        CHECK_EQUAL(100, t1->size());
+    }
 
     // Read the db again in normal mode to verify
     {
-        SharedGroup db(path);
+        SharedGroup db(path, false, SharedGroupOptions(crypt_key()));
 
         ReadTransaction rt(db);
         rt.get_group().verify();
@@ -1761,6 +1838,100 @@ TEST_IF(Shared_Async, allow_async)
 }
 
 
+TEST(Shared_AsyncWaitUntilDurable)
+{
+    SHARED_GROUP_TEST_PATH(path);
+
+    // Make sure that the flusher never runs on its own, so that only
+    // wait_until_durable() can make the commits durable
+    SharedGroupOptions options(SharedGroupOptions::Durability::Async, crypt_key());
+    options.async_flush_interval = std::chrono::hours(1);
+    options.async_flush_threshold = size_t(-1);
+
+    SharedGroup sg(path, false, options);
+    SharedGroup::version_type version;
+    {
+        WriteTransaction wt(sg);
+        TableRef t = wt.add_table("test");
+        t->add_column(type_Int, "i");
+        t->add_empty_row();
+        t->set_int(0, 0, 7);
+        version = wt.commit();
+    }
+    {
+        // Not durable yet, so the file contains only the initial empty group
+        Group g(path, crypt_key());
+        CHECK_EQUAL(0, g.size());
+    }
+
+    sg.wait_until_durable(version);
+    {
+        Group g(path, crypt_key());
+        ConstTableRef t = g.get_table("test");
+        CHECK(t);
+        CHECK_EQUAL(7, t->get_int(0, 0));
+    }
+
+    // Waiting for an older version is a no-op
+    {
+        WriteTransaction wt(sg);
+        wt.get_table("test")->set_int(0, 0, 8);
+        wt.commit();
+    }
+    sg.wait_until_durable(version);
+    {
+        Group g(path, crypt_key());
+        CHECK_EQUAL(7, g.get_table("test")->get_int(0, 0));
+    }
+
+    // Durability::Full commits are durable when commit() returns
+    SHARED_GROUP_TEST_PATH(path_2);
+    SharedGroup sg_2(path_2, false, SharedGroupOptions(crypt_key()));
+    {
+        WriteTransaction wt(sg_2);
+        wt.add_table("test");
+        version = wt.commit();
+    }
+    sg_2.wait_until_durable(version);
+}
+
+
+TEST(Shared_AsyncFlusherIsPerFile)
+{
+    SHARED_GROUP_TEST_PATH(path);
+
+    // The same file through a different path
+    std::string path_1 = path;
+    std::string::size_type slash = path_1.find_last_of('/');
+    std::string path_2 = (slash == std::string::npos ? "./" + path_1
+                                                     : path_1.substr(0, slash) + "/." + path_1.substr(slash));
+
+    // The flusher is created with the options of the first SharedGroup, and
+    // then never runs on its own
+    SharedGroupOptions options(SharedGroupOptions::Durability::Async);
+    options.async_flush_interval = std::chrono::hours(1);
+    options.async_flush_threshold = size_t(-1);
+    SharedGroup sg(path, false, options);
+
+    // Had it got a flusher of its own, the commit of this SharedGroup would be
+    // made durable within the default flush interval
+    SharedGroup sg_2(path_2, true, SharedGroupOptions(SharedGroupOptions::Durability::Async));
+    {
+        WriteTransaction wt(sg_2);
+        wt.add_table("test");
+        wt.commit();
+    }
+    millisleep(100);
+    {
+        Group g(path);
+        CHECK_EQUAL(0, g.size());
+    }
+}
+
+
+// disable multiprocess async on windows and any Apple operating system
+#if !defined(_WIN32) && !REALM_PLATFORM_APPLE
+
 namespace {
 
 #define multiprocess_increments 100
@@ -1857,9 +2028,6 @@ void multiprocess_make_table(std::string path, std::string lock_path, std::strin
     }
 #endif
 #endif
-    // Wait for async_commit process to shutdown
-    // FIXME: No good way of doing this
-    sleep(1);
 #else
     {
         Group g(alone_path, Group::mode_ReadWrite);
@@ -1912,10 +2080,7 @@ void multiprocess_threaded(TestContext& test_context, std::string path, size_t n
 void multiprocess_validate_and_clear(TestContext& test_context, std::string path, std::string lock_path, size_t rows,
                                      int result)
 {
-    // Wait for async_commit process to shutdown
-    // FIXME: this is not apropriate
     static_cast<void>(lock_path);
-    sleep(1);
 
     // Verify - once more, in sync mode - that the changes were made
     {
@@ -1956,9 +2121,6 @@ TEST_IF(Shared_AsyncMultiprocess, allow_async)
     SHARED_GROUP_TEST_PATH(path);
     SHARED_GROUP_TEST_PATH(alone_path);
 
-    // wait for any daemon hanging around to exit
-    usleep(100); // FIXME: Is this really acceptable?
-
 #if TEST_DURATION < 1
     multiprocess_make_table(path, path.get_lock_path(), alone_path, 4);
 
@@ -2747,6 +2909,14 @@ TEST(Shared_SessionDurabilityConsistency)
         CHECK_LOGIC_ERROR(SharedGroup(path, no_create, SharedGroupOptions(durability_2)),
                           LogicError::mixed_durability);
     }
+    {
+        bool no_create = false;
+        SharedGroup sg(path, no_create);
+
+        SharedGroupOptions options;
+        options.group_commit = true;
+        CHECK_LOGIC_ERROR(SharedGroup(path, no_create, options), LogicError::mixed_durability);
+    }
 }
 
 
@@ -2772,6 +2942,214 @@ TEST(Shared_CompactEmpty)
 }
 
 
+namespace {
+
+// Encrypted files are never truncated, and neither are files on Windows (see
+// SlabAlloc::shrink_file()).
+bool file_can_shrink()
+{
+#ifdef _WIN32
+    return false;
+#else
+    return !crypt_key();
+#endif
+}
+
+} // anonymous namespace
+
+
+TEST(Shared_CompactStep)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    const size_t num_rows = 20000;
+    {
+        WriteTransaction wt(sg);
+        TableRef keep = wt.add_table("keep");
+        keep->add_column(type_Int, "int");
+        keep->add_column(type_String, "string");
+        TableRef drop = wt.add_table("drop");
+        drop->add_column(type_String, "string");
+        drop->add_empty_row(num_rows);
+        for (size_t i = 0; i < num_rows; ++i)
+            drop->set_string(0, i, "a fairly long string, to take up some space");
+        wt.commit();
+    }
+    {
+        // Takes up whatever free space is left below the data that is about
+        // to be deleted
+        WriteTransaction wt(sg);
+        TableRef keep = wt.get_table("keep");
+        keep->add_empty_row(num_rows);
+        for (size_t i = 0; i < num_rows; ++i) {
+            std::string value = "VALUE " + util::to_string(i);
+            keep->set_int(0, i, int64_t(num_rows + i));
+            keep->set_string(1, i, value);
+        }
+        wt.commit();
+    }
+    {
+        // Puts live data after the data that is about to be deleted, since
+        // the space freed by this transaction cannot be reused by it
+        WriteTransaction wt(sg);
+        TableRef keep = wt.get_table("keep");
+        for (size_t i = 0; i < num_rows; ++i) {
+            std::string value = "value " + util::to_string(i);
+            keep->set_int(0, i, int64_t(i));
+            keep->set_string(1, i, value);
+        }
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg);
+        wt.get_group().remove_table("drop");
+        wt.commit();
+    }
+    // Make the deleted space reusable
+    for (int i = 0; i < 2; ++i) {
+        WriteTransaction wt(sg);
+        wt.commit();
+    }
+    size_t size_before = size_t(File(path).get_size());
+
+    auto check_keep = [&](const Group& group) {
+        ConstTableRef keep = group.get_table("keep");
+        if (!CHECK(keep) || !CHECK_EQUAL(keep->size(), num_rows))
+            return;
+        for (size_t i = 0; i < num_rows; ++i) {
+            CHECK_EQUAL(keep->get_int(0, i), int64_t(i));
+            CHECK_EQUAL(keep->get_string(1, i), std::string("value ") + util::to_string(i));
+        }
+    };
+
+    // A reader bound to a snapshot from before the compaction is unaffected
+    SharedGroup sg_r(path, false, SharedGroupOptions(crypt_key()));
+    const Group& group_r = sg_r.begin_read();
+
+    CHECK_THROW(sg_r.compact_step(), LogicError);
+    size_t num_steps = 0;
+    size_t relocated = 0;
+    while (size_t n = sg.compact_step(64 * 1024)) {
+        CHECK_LESS_EQUAL(n, 64 * 1024);
+        relocated += n;
+        ++num_steps;
+        if (!CHECK_LESS(num_steps, 1000))
+            break;
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+    }
+    CHECK_GREATER(num_steps, 1);
+    CHECK_GREATER(relocated, 64 * 1024);
+    check_keep(group_r);
+    sg_r.end_read();
+
+    // Once no reader uses the old snapshots, the free space at the end of the
+    // file is removed
+    for (int i = 0; i < 3; ++i)
+        sg.compact_step(64 * 1024);
+    size_t size_after = size_t(File(path).get_size());
+    if (file_can_shrink())
+        CHECK_LESS(size_after, size_before / 2);
+    {
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+        check_keep(rt.get_group());
+    }
+
+    // The file grows again when needed
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("more");
+        table->add_column(type_String, "string");
+        table->add_empty_row(num_rows);
+        for (size_t i = 0; i < num_rows; ++i)
+            table->set_string(0, i, "a fairly long string, to take up some space");
+        wt.commit();
+    }
+    {
+        SharedGroup sg_2(path, false, SharedGroupOptions(crypt_key()));
+        ReadTransaction rt(sg_2);
+        rt.get_group().verify();
+        check_keep(rt.get_group());
+        CHECK_EQUAL(rt.get_table("more")->size(), num_rows);
+    }
+}
+
+
+TEST(Shared_FileShrinksAfterDelete)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("small");
+        table->add_column(type_Int, "int");
+        table->add_empty_row(10);
+        wt.commit();
+    }
+    auto fill = [&] {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("big");
+        table->add_column(type_String, "string");
+        table->add_empty_row(20000);
+        for (size_t i = 0; i < 20000; ++i)
+            table->set_string(0, i, "a fairly long string, to take up some space");
+        wt.commit();
+    };
+    auto remove = [&] {
+        WriteTransaction wt(sg);
+        wt.get_group().remove_table("big");
+        wt.commit();
+    };
+    auto commit_empty = [&](int n) {
+        for (int i = 0; i < n; ++i) {
+            WriteTransaction wt(sg);
+            wt.commit();
+        }
+    };
+    auto get_file_size = [&] {
+        return size_t(File(path).get_size());
+    };
+
+    fill();
+    size_t peak_size = get_file_size();
+
+    // The free space at the end of the file cannot be released while a
+    // reader uses a snapshot in which it is not free
+    SharedGroup sg_r(path, false, SharedGroupOptions(crypt_key()));
+    const Group& group_r = sg_r.begin_read();
+    remove();
+    commit_empty(3);
+    CHECK_EQUAL(get_file_size(), peak_size);
+    CHECK_EQUAL(group_r.get_table("big")->size(), 20000);
+    sg_r.end_read();
+
+    commit_empty(3);
+    if (file_can_shrink())
+        CHECK_LESS(get_file_size(), peak_size / 4);
+    {
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+        CHECK_EQUAL(rt.get_table("small")->size(), 10);
+        CHECK_NOT(rt.has_table("big"));
+    }
+
+    // Free space is reused from the beginning of the file, so the same
+    // amount of data fits in about the same space again
+    fill();
+    CHECK_LESS_EQUAL(get_file_size(), peak_size);
+    remove();
+    commit_empty(3);
+    if (file_can_shrink())
+        CHECK_LESS(get_file_size(), peak_size / 4);
+    {
+        ReadTransaction rt(sg);
+        rt.get_group().verify();
+        CHECK_EQUAL(rt.get_table("small")->size(), 10);
+    }
+}
+
+
 TEST(Shared_VersionOfBoundSnapshot)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -3061,4 +3439,297 @@ TEST(Shared_Bptree_insert_failure)
     g.get_table(0)->add_empty_row(396);
 }
 
+
+TEST(Shared_EncodedIntegerColumnsFileFormat)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    using sgf = _impl::SharedGroupFriend;
+
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    SharedGroup sg_2(path, false, SharedGroupOptions(crypt_key()));
+    {
+        WriteTransaction wt(sg);
+        TableRef t = wt.add_table("test");
+        t->add_column(type_Int, "id");
+        t->add_empty_row(1000);
+        for (size_t i = 0; i < 1000; ++i)
+            t->set_int(0, i, 1000000000 + int64_t(i));
+        wt.commit();
+    }
+    CHECK_EQUAL(6, sgf::get_file_format_version(sg));
+
+    // The file switches to version 7 when the first leaf is encoded
+    bool any_encoded;
+    {
+        WriteTransaction wt(sg);
+        any_encoded = wt.get_table("test")->encode_integer_columns();
+        wt.commit();
+    }
+    // The prefix of an encoded leaf outweighs the savings in tiny leaves
+    if (REALM_MAX_BPNODE_SIZE >= 100)
+        CHECK(any_encoded);
+    int file_format_version = (any_encoded ? 7 : 6);
+    CHECK_EQUAL(file_format_version, sgf::get_file_format_version(sg));
+
+    // A session that was opened before the switch must not switch back
+    {
+        WriteTransaction wt(sg_2);
+        wt.get_table("test")->add_empty_row();
+        wt.commit();
+    }
+    CHECK_EQUAL(file_format_version, sgf::get_file_format_version(sg_2));
+    sg.close();
+    sg_2.close();
+
+    SharedGroup sg_3(path, true, SharedGroupOptions(crypt_key()));
+    CHECK_EQUAL(file_format_version, sgf::get_file_format_version(sg_3));
+    ReadTransaction rt(sg_3);
+    ConstTableRef t = rt.get_table("test");
+    CHECK_EQUAL(1001, t->size());
+    CHECK_EQUAL(1000000000, t->get_int(0, 0));
+    CHECK_EQUAL(1000000999, t->get_int(0, 999));
+    CHECK_EQUAL(0, t->get_int(0, 1000));
+}
+
+
+TEST(Shared_TranslationCacheIsShared)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg_1(path);
+    {
+        WriteTransaction wt(sg_1);
+        TableRef table = wt.add_table("table");
+        table->add_column(type_Int, "int");
+        table->add_column(type_String, "string");
+        for (int i = 0; i < 1000; ++i) {
+            table->add_empty_row();
+            table->set_int(0, i, i);
+            table->set_string(1, i, "foo");
+        }
+        wt.commit();
+    }
+
+    auto read_all = [&](SharedGroup& sg) {
+        ReadTransaction rt(sg);
+        ConstTableRef table = rt.get_table("table");
+        int64_t sum = 0;
+        for (size_t i = 0; i < table->size(); ++i)
+            sum += table->get_int(0, i) + int64_t(table->get_string(1, i).size());
+        CHECK_EQUAL(sum, 999 * 1000 / 2 + 3 * 1000);
+    };
+
+    // The first reader fills the shared cache
+    read_all(sg_1);
+    SlabAlloc::TranslationCacheStats stats_1 = sg_1.get_translation_cache_stats();
+    CHECK_LESS(0, stats_1.misses);
+
+    // A second SharedGroup on the same file finds the translations made by the
+    // first one, even though its own cache is cold
+    SharedGroup sg_2(path);
+    read_all(sg_2);
+    SlabAlloc::TranslationCacheStats stats_2 = sg_2.get_translation_cache_stats();
+    CHECK_LESS(0, stats_2.hits);
+    CHECK_LESS(stats_2.misses, stats_1.misses);
+
+    // Translations remain valid when the file grows
+    {
+        WriteTransaction wt(sg_2);
+        TableRef table = wt.get_table("table");
+        table->add_column(type_Binary, "binary");
+        std::string blob(1000, 'x');
+        for (size_t i = 0; i < table->size(); ++i)
+            table->set_binary(2, i, BinaryData(blob));
+        wt.commit();
+    }
+    read_all(sg_1);
+    read_all(sg_2);
+
+    // Encrypted files do not share translations
+    if (crypt_key(true)) {
+        SHARED_GROUP_TEST_PATH(encrypted_path);
+        SharedGroup sg_3(encrypted_path, false, SharedGroupOptions(crypt_key(true)));
+        {
+            WriteTransaction wt(sg_3);
+            wt.add_table("table")->add_column(type_Int, "int");
+            wt.commit();
+        }
+        ReadTransaction rt(sg_3);
+        CHECK_EQUAL(rt.get_table("table")->size(), 0);
+        CHECK_EQUAL(sg_3.get_translation_cache_stats().hits, 0);
+        CHECK_EQUAL(sg_3.get_translation_cache_stats().misses, 0);
+    }
+}
+
+
+TEST(Shared_GroupPool)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg_w(path, false, SharedGroupOptions(crypt_key()));
+    auto commit_value = [&](int64_t value) {
+        WriteTransaction wt(sg_w);
+        TableRef table = wt.get_or_add_table("table");
+        if (table->get_column_count() == 0) {
+            table->add_column(type_Int, "int");
+            table->add_empty_row();
+        }
+        table->set_int(0, 0, value);
+        return wt.commit();
+    };
+    commit_value(1);
+
+    SharedGroupPool pool(path, 2, false, SharedGroupOptions(crypt_key()));
+    VersionID version_1;
+    {
+        SharedGroupPool::ReadSession session = pool.start_read();
+        CHECK_EQUAL(session.get_table("table")->get_int(0, 0), 1);
+        version_1 = session.get_version();
+    }
+
+    // Nothing has been committed, so the read transaction is reused
+    {
+        SharedGroupPool::ReadSession session = pool.start_read();
+        CHECK(session.get_version() == version_1);
+        CHECK_EQUAL(session.get_table("table")->get_int(0, 0), 1);
+    }
+    SharedGroupPool::Stats stats = pool.get_stats();
+    CHECK_EQUAL(stats.num_shared_groups, 1);
+    CHECK_EQUAL(stats.num_idle, 1);
+    CHECK_EQUAL(stats.num_sessions, 2);
+    CHECK_EQUAL(stats.num_reused_snapshots, 1);
+
+    // A new session sees the latest commit
+    commit_value(2);
+    {
+        SharedGroupPool::ReadSession session = pool.start_read();
+        CHECK(session.get_version() != version_1);
+        CHECK_EQUAL(session.get_table("table")->get_int(0, 0), 2);
+    }
+    CHECK_EQUAL(pool.get_stats().num_reused_snapshots, 1);
+
+    // Sessions can be bound to a specific version, as long as it is available
+    {
+        SharedGroupPool::ReadSession session_2 = pool.start_read();
+        VersionID version_2 = session_2.get_version();
+        commit_value(3);
+        {
+            SharedGroupPool::ReadSession session_3 = pool.start_read();
+            CHECK_EQUAL(session_3.get_table("table")->get_int(0, 0), 3);
+        }
+        SharedGroupPool::ReadSession session_3 = pool.start_read(version_2);
+        CHECK(session_3.get_version() == version_2);
+        CHECK_EQUAL(session_3.get_table("table")->get_int(0, 0), 2);
+        CHECK_EQUAL(pool.get_stats().num_shared_groups, 2);
+    }
+    // Both snapshots were stale when the sessions ended, so they were released
+    commit_value(4);
+    CHECK_THROW(pool.start_read(version_1), SharedGroup::BadVersion);
+    CHECK_EQUAL(pool.get_stats().num_idle, 2);
+
+    // When all SharedGroups are in use, start_read() waits for a session to end
+    {
+        SharedGroupPool::ReadSession session_1 = pool.start_read();
+        std::unique_ptr<SharedGroupPool::ReadSession> session_2(new SharedGroupPool::ReadSession(pool.start_read()));
+        std::atomic<bool> started(false);
+        Thread thread;
+        thread.start([&] {
+            SharedGroupPool::ReadSession session_3 = pool.start_read();
+            started = true;
+            CHECK_EQUAL(session_3.get_table("table")->get_int(0, 0), 4);
+        });
+        millisleep(100);
+        CHECK(!started);
+        session_2.reset();
+        thread.join();
+        CHECK(started);
+        CHECK_EQUAL(pool.get_stats().num_shared_groups, 2);
+    }
+
+    // Concurrent readers and a writer
+    const int num_readers = 8;
+    const int num_commits = 50;
+    Thread readers[num_readers];
+    for (int i = 0; i < num_readers; ++i) {
+        readers[i].start([&] {
+            int64_t last = 0;
+            for (;;) {
+                SharedGroupPool::ReadSession session = pool.start_read();
+                int64_t value = session.get_table("table")->get_int(0, 0);
+                CHECK_LESS_EQUAL(last, value);
+                last = value;
+                if (value == 4 + num_commits)
+                    break;
+            }
+        });
+    }
+    for (int i = 1; i <= num_commits; ++i)
+        commit_value(4 + i);
+    for (int i = 0; i < num_readers; ++i)
+        readers[i].join();
+    CHECK_EQUAL(pool.get_stats().num_shared_groups, 2);
+
+    pool.close_idle();
+    CHECK_EQUAL(pool.get_stats().num_shared_groups, 0);
+}
+
+
+TEST(Shared_GroupPool_StaleIdle)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg_w(path, false, SharedGroupOptions(crypt_key()));
+    auto commit_value = [&](int64_t value) {
+        WriteTransaction wt(sg_w);
+        TableRef table = wt.get_or_add_table("table");
+        if (table->get_column_count() == 0) {
+            table->add_column(type_Int, "int");
+            table->add_empty_row();
+        }
+        table->set_int(0, 0, value);
+        return wt.commit();
+    };
+    commit_value(1);
+
+    SharedGroupPool pool(path, 2, false, SharedGroupOptions(crypt_key()));
+    SharedGroup sg_r(path, false, SharedGroupOptions(crypt_key()));
+    VersionID version_1;
+    {
+        SharedGroupPool::ReadSession session_1 = pool.start_read();
+        SharedGroupPool::ReadSession session_2 = pool.start_read();
+        version_1 = session_1.get_version();
+    }
+    CHECK_EQUAL(pool.get_stats().num_idle, 2);
+
+    // Commits that land while every SharedGroup is idle leave them holding
+    // on to the previous version
+    commit_value(2);
+    commit_value(3);
+    {
+        const Group& group = sg_r.begin_read(version_1);
+        CHECK_EQUAL(group.get_table("table")->get_int(0, 0), 1);
+        sg_r.end_read();
+    }
+
+    // Until they are released explicitly
+    pool.release_stale();
+    commit_value(4);
+    CHECK_THROW(sg_r.begin_read(version_1), SharedGroup::BadVersion);
+    CHECK_EQUAL(pool.get_stats().num_shared_groups, 2);
+
+    // Or until the next session starts
+    VersionID version_4;
+    {
+        SharedGroupPool::ReadSession session_1 = pool.start_read();
+        SharedGroupPool::ReadSession session_2 = pool.start_read();
+        version_4 = session_1.get_version();
+    }
+    commit_value(5);
+    {
+        SharedGroupPool::ReadSession session = pool.start_read();
+        CHECK(session.get_version() != version_4);
+        CHECK_EQUAL(session.get_table("table")->get_int(0, 0), 5);
+        commit_value(6);
+        CHECK_THROW(sg_r.begin_read(version_4), SharedGroup::BadVersion);
+    }
+    CHECK_EQUAL(pool.get_stats().num_idle, 2);
+}
+
 #endif // TEST_SHARED
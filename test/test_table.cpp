@@ -2667,6 +2667,212 @@ TEST(Table_OptimizeCompare)
 }
 
 
+TEST(Table_OptimizeUnenumerate)
+{
+    Table t;
+    t.add_column(type_String, "unique");
+    t.add_column(type_String, "indexed", true);
+    t.add_column(type_String, "stale");
+    t.add_column(type_String, "few");
+    t.add_search_index(1);
+    t.add_empty_row(100);
+    for (size_t i = 0; i < 100; ++i) {
+        std::string str = util::to_string(i);
+        t.set_string(0, i, str);
+        t.set_string(1, i, i % 10 == 0 ? StringData() : StringData(str));
+        t.set_string(2, i, str);
+        t.set_string(3, i, i % 2 == 0 ? "even" : "odd");
+    }
+    t.optimize(true);
+    ConstDescriptorRef desc = t.get_descriptor();
+    for (size_t i = 0; i < 4; ++i)
+        CHECK_NOT_EQUAL(0, desc->get_num_unique_values(i));
+
+    // The keys of values that are no longer used are still in the key list
+    for (size_t i = 0; i < 100; ++i)
+        t.set_string(2, i, i % 3 == 0 ? "a" : "b");
+    CHECK_EQUAL(102, desc->get_num_unique_values(2));
+
+    // Enumerated columns are left alone by optimize()
+    t.optimize();
+    for (size_t i = 0; i < 4; ++i)
+        CHECK_NOT_EQUAL(0, desc->get_num_unique_values(i));
+
+    t.unenumerate_string_columns();
+    CHECK_EQUAL(0, desc->get_num_unique_values(0));
+    CHECK_EQUAL(0, desc->get_num_unique_values(1));
+    CHECK_EQUAL(102, desc->get_num_unique_values(2));
+    CHECK_EQUAL(2, desc->get_num_unique_values(3));
+#ifdef REALM_DEBUG
+    t.verify();
+#endif
+
+    for (size_t i = 0; i < 100; ++i) {
+        std::string str = util::to_string(i);
+        CHECK_EQUAL(str, t.get_string(0, i));
+        if (i % 10 == 0) {
+            CHECK(t.is_null(1, i));
+        }
+        else {
+            CHECK_EQUAL(str, t.get_string(1, i));
+        }
+        CHECK_EQUAL(i % 3 == 0 ? "a" : "b", t.get_string(2, i));
+        CHECK_EQUAL(i % 2 == 0 ? "even" : "odd", t.get_string(3, i));
+    }
+
+    // The search index now refers to the plain string column
+    CHECK(t.has_search_index(1));
+    CHECK_EQUAL(42, t.find_first_string(1, "42"));
+    CHECK_EQUAL(10, t.count_string(1, realm::null()));
+    t.set_string(1, 42, "forty-two");
+    CHECK_EQUAL(not_found, t.find_first_string(1, "42"));
+    CHECK_EQUAL(42, t.find_first_string(1, "forty-two"));
+
+    // Once the values repeat again, the column is enumerated again
+    for (size_t i = 0; i < 100; ++i)
+        t.set_string(0, i, i % 2 == 0 ? "even" : "odd");
+    t.optimize();
+    CHECK_EQUAL(2, desc->get_num_unique_values(0));
+    CHECK_EQUAL(0, desc->get_num_unique_values(1));
+#ifdef REALM_DEBUG
+    t.verify();
+#endif
+}
+
+
+TEST(Table_AddRows)
+{
+    Table table;
+    table.add_column(type_Int, "int");
+    table.add_column(type_Int, "int_null", true);
+    table.add_column(type_Bool, "bool");
+    table.add_column(type_Float, "float", true);
+    table.add_column(type_Double, "double");
+    table.add_column(type_String, "string");
+    table.add_column(type_String, "string_null", true);
+    table.add_column(type_Timestamp, "timestamp");
+    table.add_search_index(0);
+    table.add_search_index(5);
+    table.add_empty_row(2);
+
+    // Enough rows to fill several leaves
+    const size_t num_rows = 3 * REALM_MAX_BPNODE_SIZE + 17;
+    std::vector<int64_t> ints(num_rows);
+    std::unique_ptr<bool[]> bools(new bool[num_rows]);
+    std::unique_ptr<bool[]> nulls(new bool[num_rows]);
+    std::vector<float> floats(num_rows);
+    std::vector<double> doubles(num_rows);
+    std::vector<std::string> strings(num_rows);
+    std::vector<StringData> string_refs(num_rows);
+    std::vector<StringData> null_string_refs(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        ints[i] = int64_t(i % 7) - 3;
+        bools[i] = i % 3 == 0;
+        nulls[i] = i % 5 == 0;
+        floats[i] = float(i) / 2;
+        doubles[i] = double(i) * 3;
+        strings[i] = "s" + util::to_string(i % 11);
+        string_refs[i] = strings[i];
+        null_string_refs[i] = i % 4 == 0 ? StringData() : StringData(strings[i]);
+    }
+
+    std::vector<BulkColumn> columns;
+    columns.emplace_back(0, ints.data());
+    columns.emplace_back(1, ints.data(), nulls.get());
+    columns.emplace_back(2, bools.get());
+    columns.emplace_back(3, floats.data(), nulls.get());
+    columns.emplace_back(4, doubles.data());
+    columns.emplace_back(5, string_refs.data());
+    columns.emplace_back(6, null_string_refs.data());
+    CHECK_EQUAL(2, table.add_rows(num_rows, columns));
+    CHECK_EQUAL(2 + num_rows, table.size());
+    table.verify();
+
+    for (size_t i = 0; i < num_rows; ++i) {
+        size_t row_ndx = 2 + i;
+        CHECK_EQUAL(ints[i], table.get_int(0, row_ndx));
+        CHECK_EQUAL(nulls[i], table.is_null(1, row_ndx));
+        if (!nulls[i]) {
+            CHECK_EQUAL(ints[i], table.get_int(1, row_ndx));
+            CHECK_EQUAL(floats[i], table.get_float(3, row_ndx));
+        }
+        CHECK_EQUAL(nulls[i], table.is_null(3, row_ndx));
+        CHECK_EQUAL(bools[i], table.get_bool(2, row_ndx));
+        CHECK_EQUAL(doubles[i], table.get_double(4, row_ndx));
+        CHECK_EQUAL(string_refs[i], table.get_string(5, row_ndx));
+        CHECK_EQUAL(null_string_refs[i].is_null(), table.is_null(6, row_ndx));
+        CHECK_EQUAL(null_string_refs[i], table.get_string(6, row_ndx));
+        CHECK(table.get_timestamp(7, row_ndx) == Timestamp(0, 0));
+    }
+
+    // The search indexes were kept up to date
+    CHECK_EQUAL(2 + 1, table.find_first_int(0, -2));
+    CHECK_EQUAL(table.where().equal(5, "s3").count(), table.count_string(5, "s3"));
+    CHECK_EQUAL(2 + 3, table.find_first_string(5, "s3"));
+
+    // Appending again starts by filling the last leaf, which is partly filled
+    columns.clear();
+    columns.emplace_back(0, ints.data());
+    columns.emplace_back(1, ints.data(), nulls.get());
+    CHECK_EQUAL(2 + num_rows, table.add_rows(num_rows, columns));
+    CHECK_EQUAL(2 + 2 * num_rows, table.size());
+    table.verify();
+    for (size_t i = 0; i < num_rows; ++i) {
+        size_t row_ndx = 2 + num_rows + i;
+        CHECK_EQUAL(ints[i], table.get_int(0, row_ndx));
+        CHECK_EQUAL(nulls[i], table.is_null(1, row_ndx));
+        if (!nulls[i])
+            CHECK_EQUAL(ints[i], table.get_int(1, row_ndx));
+    }
+    {
+        // The index lists the rows of each value in ascending order
+        size_t count = 0;
+        for (size_t i = 0; i < table.size(); ++i) {
+            if (table.get_int(0, i) == 2)
+                ++count;
+        }
+        TableView view = table.find_all_int(0, 2);
+        CHECK_EQUAL(count, view.size());
+        for (size_t i = 1; i < view.size(); ++i)
+            CHECK_LESS(view.get_source_ndx(i - 1), view.get_source_ndx(i));
+    }
+
+    // Enumerated string columns are appended to as well
+    table.optimize(true);
+    CHECK_NOT_EQUAL(0, table.get_descriptor()->get_num_unique_values(5));
+    std::vector<StringData> more_strings = {"s5", "new"};
+    columns.clear();
+    columns.emplace_back(5, more_strings.data());
+    size_t row_ndx = table.add_rows(2, columns);
+    CHECK_EQUAL("s5", table.get_string(5, row_ndx));
+    CHECK_EQUAL("new", table.get_string(5, row_ndx + 1));
+    CHECK_EQUAL(row_ndx + 1, table.find_first_string(5, "new"));
+    CHECK(table.is_null(1, row_ndx));
+    CHECK_EQUAL(0, table.get_int(0, row_ndx));
+
+    // Arguments are validated before anything is modified
+    size_t size = table.size();
+    columns.clear();
+    columns.emplace_back(8, ints.data());
+    CHECK_LOGIC_ERROR(table.add_rows(1, columns), LogicError::column_index_out_of_range);
+    columns.clear();
+    columns.emplace_back(0, doubles.data());
+    CHECK_LOGIC_ERROR(table.add_rows(1, columns), LogicError::type_mismatch);
+    columns.clear();
+    columns.emplace_back(0, ints.data());
+    columns.emplace_back(0, ints.data());
+    CHECK_LOGIC_ERROR(table.add_rows(1, columns), LogicError::illegal_combination);
+    columns.clear();
+    columns.emplace_back(0, ints.data(), nulls.get());
+    CHECK_LOGIC_ERROR(table.add_rows(1, columns), LogicError::column_not_nullable);
+    columns.clear();
+    columns.emplace_back(5, null_string_refs.data());
+    CHECK_LOGIC_ERROR(table.add_rows(1, columns), LogicError::column_not_nullable);
+    CHECK_EQUAL(size, table.size());
+    table.verify();
+}
+
+
 TEST(Table_SlabAlloc)
 {
     SlabAlloc alloc;
@@ -4463,6 +4669,244 @@ TEST(Table_Pivot)
 }
 
 
+TEST(Table_GroupBy)
+{
+    Table table;
+    table.add_column(type_String, "city", true);
+    table.add_column(type_Int, "year", true);
+    table.add_column(type_Bool, "flag");
+    table.add_column(type_Timestamp, "ts", true);
+    table.add_column(type_Int, "amount", true);
+    table.add_column(type_Double, "price");
+    table.add_column(type_Float, "weight", true);
+
+    const char* cities[] = {"Oslo", "Bergen", "", "Trondheim"};
+    size_t num_rows = 1717;
+    table.add_empty_row(num_rows);
+    for (size_t i = 0; i < num_rows; ++i) {
+        if (i % 7 == 3)
+            table.set_null(0, i);
+        else
+            table.set_string(0, i, cities[i % 4]);
+        if (i % 11 == 5)
+            table.set_null(1, i);
+        else
+            table.set_int(1, i, 2000 + int64_t(i % 3));
+        table.set_bool(2, i, i % 5 < 2);
+        if (i % 13 == 0)
+            table.set_null(3, i);
+        else
+            table.set_timestamp(3, i, Timestamp(int64_t(i % 2), int32_t(i % 2 * 7)));
+        // Some groups have only null amounts
+        if (i % 9 == 4 || (i % 7 == 3 && i % 13 == 0))
+            table.set_null(4, i);
+        else
+            table.set_int(4, i, int64_t(i % 17) - 8);
+        table.set_double(5, i, double(i % 23) / 4);
+        if (i % 3 != 0)
+            table.set_float(6, i, float(i % 19) / 2);
+    }
+
+    auto same_group = [&](const Table& result, size_t group_ndx, size_t row_ndx) {
+        for (size_t col_ndx = 0; col_ndx < 4; ++col_ndx) {
+            if (result.is_null(col_ndx, group_ndx) || table.is_null(col_ndx, row_ndx)) {
+                if (result.is_null(col_ndx, group_ndx) != table.is_null(col_ndx, row_ndx))
+                    return false;
+                continue;
+            }
+            bool equal;
+            switch (col_ndx) {
+                case 0:
+                    equal = result.get_string(0, group_ndx) == table.get_string(0, row_ndx);
+                    break;
+                case 1:
+                    equal = result.get_int(1, group_ndx) == table.get_int(1, row_ndx);
+                    break;
+                case 2:
+                    equal = result.get_bool(2, group_ndx) == table.get_bool(2, row_ndx);
+                    break;
+                default:
+                    equal = result.get_timestamp(3, group_ndx) == table.get_timestamp(3, row_ndx);
+                    break;
+            }
+            if (!equal)
+                return false;
+        }
+        return true;
+    };
+
+    std::vector<GroupAggregate> aggregates = {{Table::aggr_count, 0},
+                                              {Table::aggr_sum, 4},
+                                              {Table::aggr_avg, 4},
+                                              {Table::aggr_min, 4},
+                                              {Table::aggr_max, 5},
+                                              {Table::aggr_sum, 5},
+                                              {Table::aggr_min, 6},
+                                              {Table::aggr_avg, 6}};
+
+    for (int i = 0; i < 2; ++i) {
+        Table result;
+        table.group_by({0, 1, 2, 3}, aggregates, result);
+        CHECK_EQUAL(12, result.get_column_count());
+        CHECK_EQUAL("city", result.get_column_name(0));
+        CHECK_EQUAL(type_String, result.get_column_type(0));
+        CHECK_EQUAL(type_Timestamp, result.get_column_type(3));
+        CHECK_EQUAL("COUNT()", result.get_column_name(4));
+        CHECK_EQUAL("SUM(amount)", result.get_column_name(5));
+        CHECK_EQUAL(type_Int, result.get_column_type(5));
+        CHECK_EQUAL("AVG(amount)", result.get_column_name(6));
+        CHECK_EQUAL(type_Double, result.get_column_type(9));
+        CHECK_EQUAL(type_Float, result.get_column_type(10));
+        CHECK(result.is_nullable(7));
+        CHECK(!result.is_nullable(8));
+
+        // Every row belongs to exactly one group, and the groups are in the
+        // order of their first rows
+        size_t total = 0;
+        size_t prev_first_row = 0;
+        bool some_null_avg = false;
+        for (size_t g = 0; g < result.size(); ++g) {
+            int64_t count = 0, amount_count = 0, amount_sum = 0, amount_min = 0, weight_count = 0;
+            double price_max = 0, price_sum = 0, weight_min = 0, weight_sum = 0;
+            size_t first_row = not_found;
+            for (size_t r = 0; r < num_rows; ++r) {
+                if (!same_group(result, g, r))
+                    continue;
+                if (first_row == not_found)
+                    first_row = r;
+                ++count;
+                if (!table.is_null(4, r)) {
+                    int64_t amount = table.get_int(4, r);
+                    if (amount_count == 0 || amount < amount_min)
+                        amount_min = amount;
+                    amount_sum += amount;
+                    ++amount_count;
+                }
+                double price = table.get_double(5, r);
+                if (count == 1 || price > price_max)
+                    price_max = price;
+                price_sum += price;
+                if (!table.is_null(6, r)) {
+                    double weight = table.get_float(6, r);
+                    if (weight_count == 0 || weight < weight_min)
+                        weight_min = weight;
+                    weight_sum += weight;
+                    ++weight_count;
+                }
+            }
+            CHECK(g == 0 || first_row > prev_first_row);
+            prev_first_row = first_row;
+            total += size_t(count);
+
+            CHECK_EQUAL(count, result.get_int(4, g));
+            CHECK_EQUAL(amount_sum, result.get_int(5, g));
+            if (amount_count == 0) {
+                CHECK(result.is_null(6, g));
+                CHECK(result.is_null(7, g));
+                some_null_avg = true;
+            }
+            else {
+                CHECK_APPROXIMATELY_EQUAL(double(amount_sum) / amount_count, result.get_double(6, g), 1e-12);
+                CHECK_EQUAL(amount_min, result.get_int(7, g));
+            }
+            CHECK_EQUAL(price_max, result.get_double(8, g));
+            CHECK_APPROXIMATELY_EQUAL(price_sum, result.get_double(9, g), 1e-12);
+            if (weight_count == 0) {
+                CHECK(result.is_null(10, g));
+                CHECK(result.is_null(11, g));
+            }
+            else {
+                CHECK_EQUAL(weight_min, result.get_float(10, g));
+                CHECK_APPROXIMATELY_EQUAL(weight_sum / weight_count, result.get_double(11, g), 1e-12);
+            }
+        }
+        CHECK_EQUAL(num_rows, total);
+        CHECK(some_null_avg);
+
+        // A single string column
+        Table cities_result;
+        table.group_by({0}, {{Table::aggr_count, 0}, {Table::aggr_max, 1}}, cities_result);
+        CHECK_EQUAL(5, cities_result.size());
+        CHECK_EQUAL("Oslo", cities_result.get_string(0, 0));
+        CHECK_EQUAL("", cities_result.get_string(0, 2));
+        CHECK(!cities_result.is_null(0, 2));
+        CHECK(cities_result.is_null(0, 3));
+        CHECK_EQUAL("Trondheim", cities_result.get_string(0, 4));
+        CHECK_EQUAL(int64_t(table.where().equal(0, "").count()), cities_result.get_int(1, 2));
+        CHECK_EQUAL(int64_t(table.where().equal(0, realm::null()).count()), cities_result.get_int(1, 3));
+        CHECK_EQUAL(2002, cities_result.get_int(2, 0));
+
+        // No grouping columns
+        Table all_result;
+        table.group_by({}, {{Table::aggr_count, 0}, {Table::aggr_sum, 5}}, all_result);
+        CHECK_EQUAL(1, all_result.size());
+        CHECK_EQUAL(int64_t(num_rows), all_result.get_int(0, 0));
+        CHECK_APPROXIMATELY_EQUAL(table.sum_double(5), all_result.get_double(1, 0), 1e-12);
+
+        // Group a view
+        TableView view = table.where().equal(2, true).find_all();
+        Table view_result;
+        view.group_by({2}, {{Table::aggr_count, 0}}, view_result);
+        CHECK_EQUAL(1, view_result.size());
+        CHECK_EQUAL(true, view_result.get_bool(0, 0));
+        CHECK_EQUAL(int64_t(view.size()), view_result.get_int(1, 0));
+
+        // Test with enumerated strings in second loop
+        table.optimize();
+    }
+
+    Table result;
+    std::vector<GroupAggregate> sum_timestamp = {{Table::aggr_sum, 3}};
+    std::vector<GroupAggregate> min_out_of_range = {{Table::aggr_min, 7}};
+    CHECK_LOGIC_ERROR(table.group_by({5}, {}, result), LogicError::type_mismatch);
+    CHECK_LOGIC_ERROR(table.group_by({0}, sum_timestamp, result), LogicError::type_mismatch);
+    CHECK_LOGIC_ERROR(table.group_by({7}, {}, result), LogicError::column_index_out_of_range);
+    CHECK_LOGIC_ERROR(table.group_by({0}, min_out_of_range, result), LogicError::column_index_out_of_range);
+    CHECK_EQUAL(0, result.get_column_count());
+}
+
+
+TEST(Table_GroupBySubtable)
+{
+    Table parent;
+    DescriptorRef subdesc;
+    parent.add_column(type_Table, "sub", &subdesc);
+    subdesc->add_column(type_String, "name");
+    subdesc->add_column(type_Int, "value", nullptr, true);
+    parent.add_empty_row();
+
+    // A degenerate subtable has no groups, but the result still gets its
+    // columns
+    {
+        ConstTableRef subtable = parent.get_subtable(0, 0);
+        CHECK(subtable->is_degenerate());
+        Table result;
+        subtable->group_by({0, 1}, {{Table::aggr_count, 0}, {Table::aggr_sum, 1}}, result);
+        CHECK_EQUAL(4, result.get_column_count());
+        CHECK_EQUAL("name", result.get_column_name(0));
+        CHECK_EQUAL("SUM(value)", result.get_column_name(3));
+        CHECK_EQUAL(0, result.size());
+    }
+
+    TableRef subtable = parent.get_subtable(0, 0);
+    subtable->add_empty_row(2);
+    subtable->set_string(0, 0, "a");
+    subtable->set_int(1, 0, 5);
+    subtable->set_string(0, 1, "a");
+    {
+        Table result;
+        subtable->group_by({0}, {{Table::aggr_sum, 1}}, result);
+        CHECK_EQUAL(1, result.size());
+        CHECK_EQUAL(5, result.get_int(1, 0));
+    }
+
+    parent.remove(0);
+    CHECK(!subtable->is_attached());
+    Table result;
+    CHECK_LOGIC_ERROR(subtable->group_by({0}, {}, result), LogicError::detached_accessor);
+}
+
+
 namespace {
 
 void compare_table_with_slice(TestContext& test_context, const Table& table, const Table& slice, size_t offset,
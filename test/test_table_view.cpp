@@ -28,6 +28,7 @@
 #include <realm/table_macros.hpp>
 
 #include "util/misc.hpp"
+#include "util/random.hpp"
 
 #include "test.hpp"
 
@@ -2162,6 +2163,138 @@ TEST(TableView_DistinctOverNullLink)
     CHECK_EQUAL(tv.get_source_ndx(1), 1);
 }
 
+TEST(TableView_SortIndexed)
+{
+    // Sorting and distinct by indexed columns must give the same result as
+    // without the indexes
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+
+    Group g;
+    TableRef tables[2];
+    const char* target_names[] = {"target_0", "target_1"};
+    const char* table_names[] = {"table_0", "table_1"};
+    for (int i = 0; i < 2; ++i) {
+        TableRef target = g.add_table(target_names[i]);
+        target->add_column(type_String, "name", true);
+        TableRef table = g.add_table(table_names[i]);
+        table->add_column(type_String, "string", true);
+        table->add_column(type_Int, "int", true);
+        table->add_column(type_Double, "double", true);
+        table->add_column(type_Timestamp, "timestamp", true);
+        table->add_column(type_Int, "plain");
+        table->add_column_link(type_Link, "link", *target);
+        if (i == 1) {
+            target->add_search_index(0);
+            table->add_search_index(0);
+            table->add_search_index(1);
+            table->add_ordered_index(2);
+            table->add_ordered_index(3);
+        }
+        tables[i] = table;
+    }
+    const char* strings[] = {"", "a", "B", "b", "abcdef", "abcdeg", "abcd", "\xc3\xa6", "Z", "z"};
+    const size_t num_strings = sizeof strings / sizeof strings[0];
+    for (size_t i = 0; i < 20; ++i) {
+        StringData value = random.chance(1, 10) ? StringData() : StringData(strings[random.draw_int_mod(num_strings)]);
+        for (int j = 0; j < 2; ++j)
+            tables[j]->get_link_target(5)->set_string(0, tables[j]->get_link_target(5)->add_empty_row(), value);
+    }
+    for (size_t i = 0; i < 500; ++i) {
+        bool is_null = random.chance(1, 10);
+        StringData string = strings[random.draw_int_mod(num_strings)];
+        int64_t value = random.draw_int<int64_t>(-20, 20);
+        size_t link = random.draw_int_mod<size_t>(21);
+        for (int j = 0; j < 2; ++j) {
+            Table& table = *tables[j];
+            size_t row_ndx = table.add_empty_row();
+            table.set_int(4, row_ndx, value % 3);
+            if (link < 20)
+                table.set_link(5, row_ndx, link);
+            if (is_null)
+                continue;
+            table.set_string(0, row_ndx, string);
+            table.set_int(1, row_ndx, value);
+            table.set_double(2, row_ndx, value / 2.0);
+            table.set_timestamp(3, row_ndx, Timestamp(value, int32_t(value % 2) * 1000));
+        }
+    }
+
+    std::vector<std::vector<std::vector<size_t>>> columns = {
+        {{0}}, {{1}}, {{2}}, {{3}}, {{5, 0}}, {{0}, {4}}, {{4}, {2}}, {{2}, {0}, {4}}};
+    for (auto& cols : columns) {
+        for (bool ascending : {true, false}) {
+            for (int mode = 0; mode < 3; ++mode) {
+                std::vector<size_t> results[2];
+                for (int j = 0; j < 2; ++j) {
+                    Table& table = *tables[j];
+                    TableView tv = table.where().greater(4, 0).Or().less(1, -10).find_all();
+                    std::vector<bool> order(cols.size(), ascending);
+                    if (mode == 0) {
+                        tv.sort(SortDescriptor(table, cols, order));
+                    }
+                    else if (mode == 1) {
+                        tv.distinct(SortDescriptor(table, cols, order));
+                    }
+                    else {
+                        tv.distinct(SortDescriptor(table, cols, order));
+                        tv.sort(SortDescriptor(table, cols, order));
+                    }
+                    for (size_t i = 0; i < tv.size(); ++i)
+                        results[j].push_back(tv.get_source_ndx(i));
+                }
+                CHECK(results[0] == results[1]);
+            }
+        }
+    }
+}
+
+
+TEST(TableView_SortStringPrefix)
+{
+    // Strings with long common prefixes, so that most keys are equal
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const char* prefixes[] = {"", "a", "abcdefgh", "abcdefgi", "ABCDEFGH", "\xc3\xa6\xc3\xa6\xc3\xa6"};
+    Table table;
+    table.add_column(type_String, "string", true);
+    table.add_column(type_Int, "int");
+    table.add_empty_row(300);
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (random.chance(1, 10))
+            continue;
+        std::string value = prefixes[random.draw_int_mod(sizeof prefixes / sizeof prefixes[0])];
+        value += char('a' + random.draw_int_mod(3));
+        table.set_string(0, i, value);
+        table.set_int(1, i, random.draw_int_mod(3));
+    }
+
+    for (int enumerate = 0; enumerate < 2; ++enumerate) {
+        if (enumerate)
+            table.optimize(true);
+        for (bool ascending : {true, false}) {
+            TableView tv = table.where().find_all();
+            tv.sort(SortDescriptor(table, {{0}, {1}}, {ascending, true}));
+            CHECK_EQUAL(table.size(), tv.size());
+            for (size_t i = 1; i < tv.size(); ++i) {
+                StringData a = tv.get_string(0, i - 1);
+                StringData b = tv.get_string(0, i);
+                if (!ascending)
+                    std::swap(a, b);
+                if (a.is_null() || b.is_null()) {
+                    CHECK(a.is_null());
+                    continue;
+                }
+                CHECK(!utf8_compare(b, a));
+                if (a == b) {
+                    // Ties are ordered by the next column, and then by position
+                    CHECK_LESS_EQUAL(tv.get_int(1, i - 1), tv.get_int(1, i));
+                    if (tv.get_int(1, i - 1) == tv.get_int(1, i))
+                        CHECK_LESS(tv.get_source_ndx(i - 1), tv.get_source_ndx(i));
+                }
+            }
+        }
+    }
+}
+
 TEST(TableView_IsRowAttachedAfterClear)
 {
     Table t;
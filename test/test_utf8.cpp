@@ -20,10 +20,12 @@
 #ifdef TEST_UTF8
 
 #include <cstddef>
+#include <cstring>
 #include <limits>
 #include <stdexcept>
 #include <string>
 #include <iostream>
+#include <vector>
 
 #include <realm/util/assert.hpp>
 #include <memory>
@@ -31,6 +33,7 @@
 #include <realm/unicode.hpp>
 
 #include "test.hpp"
+#include "util/random.hpp"
 
 using namespace realm;
 using namespace realm::util;
@@ -268,6 +271,54 @@ TEST(UTF8_Compare_Core_utf8_zero)
     CHECK_EQUAL(false, utf8_compare(StringData("a\0\0", 3), StringData("a\0", 2)));
 }
 
+NONCONCURRENT_TEST(UTF8_SortPrefix)
+{
+    // Keys that differ must order the strings like utf8_compare()
+    const char* chars[] = {"a", "A", "b", "B", "z", "0", " ", "-", uA, ua, uAE, uae, u16sur, u16sur2,
+                           "\xe2\x82\xac" /* euro sign */, "\xc8\xb3" /* last of latin extended 2 */};
+    const size_t num_chars = sizeof chars / sizeof chars[0];
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    std::vector<std::string> strings;
+    strings.push_back("");
+    strings.push_back(std::string("\0", 1));
+    for (int i = 0; i < 300; ++i) {
+        std::string str;
+        size_t size = random.draw_int<size_t>(1, 9);
+        for (size_t j = 0; j < size; ++j)
+            str += chars[random.draw_int_mod(random.chance(1, 2) ? size_t(4) : num_chars)];
+        strings.push_back(str);
+    }
+
+    for (auto method : {STRING_COMPARE_CORE, STRING_COMPARE_CORE_SIMILAR}) {
+        set_string_compare_method(method, nullptr);
+        std::vector<uint64_t> keys;
+        for (const std::string& str : strings) {
+            uint64_t key;
+            CHECK(utf8_sort_prefix(str, key));
+            CHECK_LESS(key, uint64_t(1) << 60);
+            keys.push_back(key);
+        }
+        for (size_t i = 0; i < strings.size(); ++i) {
+            for (size_t j = 0; j < strings.size(); ++j) {
+                if (keys[i] != keys[j])
+                    CHECK_EQUAL(keys[i] < keys[j], utf8_compare(strings[i], strings[j]));
+                if (strings[i] == strings[j])
+                    CHECK_EQUAL(keys[i], keys[j]);
+            }
+        }
+    }
+    set_string_compare_method(STRING_COMPARE_CORE, nullptr);
+
+    // Invalid utf8 is not ordered by utf8_compare()
+    uint64_t key;
+    CHECK(!utf8_sort_prefix("a\xc3", key));
+    CHECK(utf8_sort_prefix("abcdef\xc3", key));
+
+    set_string_compare_method(STRING_COMPARE_CALLBACK, [](const char* a, const char* b) { return strcmp(a, b) < 0; });
+    CHECK(!utf8_sort_prefix("a", key));
+    set_string_compare_method(STRING_COMPARE_CORE, nullptr);
+}
+
 template <class Int>
 struct IntChar {
     typedef Int int_type;